@@ -0,0 +1,381 @@
+﻿#include "MyAABBTree.h"
+#include <algorithm>
+
+/// <summary>
+/// コンストラクタ
+/// </summary>
+/// <param name="margin">葉のAABBに持たせる余白</param>
+MyAABBTree::MyAABBTree(float margin) : margin_(margin) {
+}
+
+/// <summary>
+/// 要素を登録する関数
+/// </summary>
+/// <param name="aabb">要素のAABB</param>
+/// <param name="userData">要素の識別番号 (配列の番号など)</param>
+/// <returns>要素の番号</returns>
+int32_t MyAABBTree::CreateProxy(const AABB& aabb, uint32_t userData) {
+
+	int32_t proxyId = AllocateNode();
+
+	// 余白を持たせた太いAABBを登録する
+	Vector3 extent = { margin_, margin_, margin_ };
+	nodes_[proxyId].aabb = { aabb.min - extent, aabb.max + extent };
+	nodes_[proxyId].userData = userData;
+	nodes_[proxyId].height = 0;
+
+	InsertLeaf(proxyId);
+
+	return proxyId;
+
+}
+
+/// <summary>
+/// 要素を削除する関数
+/// </summary>
+/// <param name="proxyId">要素の番号</param>
+void MyAABBTree::DestroyProxy(int32_t proxyId) {
+
+	assert(nodes_[proxyId].child1 == kNullNode);
+
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+
+}
+
+/// <summary>
+/// 要素を移動する関数
+/// 新しいAABBが太いAABBに収まっている場合は何もしない
+/// </summary>
+/// <param name="proxyId">要素の番号</param>
+/// <param name="aabb">移動後のAABB</param>
+/// <param name="displacement">移動量 (移動方向に太いAABBを伸ばす)</param>
+/// <returns>木を組み替えたか</returns>
+bool MyAABBTree::MoveProxy(int32_t proxyId, const AABB& aabb, const Vector3& displacement) {
+
+	assert(nodes_[proxyId].child1 == kNullNode);
+
+	// 太いAABBに収まっていれば組み替えない
+	if (Contains(nodes_[proxyId].aabb, aabb)) {
+		return false;
+	}
+
+	RemoveLeaf(proxyId);
+
+	// 余白を持たせ、さらに移動方向に伸ばす
+	Vector3 extent = { margin_, margin_, margin_ };
+	AABB fat = { aabb.min - extent, aabb.max + extent };
+	Vector3 predict = MyMath::Multiply(kDisplacementMultiplier, displacement);
+	if (predict.x < 0.0f) { fat.min.x += predict.x; } else { fat.max.x += predict.x; }
+	if (predict.y < 0.0f) { fat.min.y += predict.y; } else { fat.max.y += predict.y; }
+	if (predict.z < 0.0f) { fat.min.z += predict.z; } else { fat.max.z += predict.z; }
+	nodes_[proxyId].aabb = fat;
+
+	InsertLeaf(proxyId);
+
+	return true;
+
+}
+
+/// <summary>
+/// 太いAABB同士が重なっている要素の組を全て求める関数
+/// 各組は MyCollision の詳細な判定に渡して確認すること
+/// </summary>
+/// <param name="pairs">識別番号の組の格納先 (末尾に追加される)</param>
+void MyAABBTree::QueryPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const {
+
+	for (int32_t proxyId = 0; proxyId < int32_t(nodes_.size()); proxyId++) {
+		const TreeNode& node = nodes_[proxyId];
+
+		// 使用中の葉だけを調べる
+		if (node.height != 0) {
+			continue;
+		}
+
+		// 同じ組を2回追加しないように番号の大きい相手だけを追加する
+		Query(node.aabb, [&](int32_t otherId) {
+			if (proxyId < otherId) {
+				pairs.push_back({ node.userData, nodes_[otherId].userData });
+			}
+			return true;
+		});
+	}
+
+}
+
+/// <summary>
+/// ノードを確保する関数
+/// </summary>
+/// <returns>ノード番号</returns>
+int32_t MyAABBTree::AllocateNode() {
+
+	int32_t nodeId;
+
+	if (freeList_ != kNullNode) {
+		// 未使用ノードを再利用する
+		nodeId = freeList_;
+		freeList_ = nodes_[nodeId].parent;
+	}
+	else {
+		// 足りなければ追加する
+		nodeId = int32_t(nodes_.size());
+		nodes_.push_back({});
+	}
+
+	TreeNode& node = nodes_[nodeId];
+	node.parent = kNullNode;
+	node.child1 = kNullNode;
+	node.child2 = kNullNode;
+	node.height = 0;
+	node.userData = 0;
+
+	return nodeId;
+
+}
+
+/// <summary>
+/// ノードを解放する関数
+/// </summary>
+/// <param name="nodeId">ノード番号</param>
+void MyAABBTree::FreeNode(int32_t nodeId) {
+
+	nodes_[nodeId].parent = freeList_;
+	nodes_[nodeId].height = -1;
+	freeList_ = nodeId;
+
+}
+
+/// <summary>
+/// 葉を木に挿入する関数
+/// </summary>
+/// <param name="leaf">葉のノード番号</param>
+void MyAABBTree::InsertLeaf(int32_t leaf) {
+
+	// 空の木なら根にする
+	if (root_ == kNullNode) {
+		root_ = leaf;
+		nodes_[root_].parent = kNullNode;
+		return;
+	}
+
+	// 表面積の増加が最も小さくなる兄弟ノードを探す
+	const AABB leafAABB = nodes_[leaf].aabb;
+	int32_t index = root_;
+	while (nodes_[index].child1 != kNullNode) {
+		const TreeNode& node = nodes_[index];
+
+		float area = HalfArea(node.aabb);
+		float combinedArea = HalfArea(Union(node.aabb, leafAABB));
+
+		// ここで新しい親を作る場合のコスト
+		float cost = 2.0f * combinedArea;
+		// さらに下に降りる場合に祖先が広がる分のコスト
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		// 子の下に降りる場合のコスト
+		float childCost[2];
+		const int32_t child[2] = { node.child1, node.child2 };
+		for (uint32_t i = 0; i < 2; i++) {
+			const TreeNode& childNode = nodes_[child[i]];
+			float newArea = HalfArea(Union(childNode.aabb, leafAABB));
+			if (childNode.child1 == kNullNode) {
+				childCost[i] = newArea + inheritanceCost;
+			}
+			else {
+				childCost[i] = (newArea - HalfArea(childNode.aabb)) + inheritanceCost;
+			}
+		}
+
+		// ここが最も安ければ降りるのをやめる
+		if (cost < childCost[0] && cost < childCost[1]) {
+			break;
+		}
+
+		index = childCost[0] < childCost[1] ? child[0] : child[1];
+	}
+	int32_t sibling = index;
+
+	// 兄弟ノードと葉をまとめる親を作る
+	int32_t oldParent = nodes_[sibling].parent;
+	int32_t newParent = AllocateNode();
+	nodes_[newParent].parent = oldParent;
+	nodes_[newParent].aabb = Union(leafAABB, nodes_[sibling].aabb);
+	nodes_[newParent].height = nodes_[sibling].height + 1;
+	nodes_[newParent].child1 = sibling;
+	nodes_[newParent].child2 = leaf;
+	nodes_[sibling].parent = newParent;
+	nodes_[leaf].parent = newParent;
+
+	if (oldParent != kNullNode) {
+		// 元の親の子を付け替える
+		if (nodes_[oldParent].child1 == sibling) {
+			nodes_[oldParent].child1 = newParent;
+		}
+		else {
+			nodes_[oldParent].child2 = newParent;
+		}
+	}
+	else {
+		// 兄弟ノードが根だった場合
+		root_ = newParent;
+	}
+
+	// 祖先のAABBと高さを更新する
+	RefitAncestors(oldParent);
+
+}
+
+/// <summary>
+/// 葉を木から取り除く関数
+/// </summary>
+/// <param name="leaf">葉のノード番号</param>
+void MyAABBTree::RemoveLeaf(int32_t leaf) {
+
+	if (leaf == root_) {
+		root_ = kNullNode;
+		return;
+	}
+
+	int32_t parent = nodes_[leaf].parent;
+	int32_t grandParent = nodes_[parent].parent;
+	int32_t sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+	if (grandParent != kNullNode) {
+		// 親を取り除いて兄弟ノードを祖父につなぐ
+		if (nodes_[grandParent].child1 == parent) {
+			nodes_[grandParent].child1 = sibling;
+		}
+		else {
+			nodes_[grandParent].child2 = sibling;
+		}
+		nodes_[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		// 祖先のAABBと高さを更新する
+		RefitAncestors(grandParent);
+	}
+	else {
+		// 親が根だった場合は兄弟ノードを根にする
+		root_ = sibling;
+		nodes_[sibling].parent = kNullNode;
+		FreeNode(parent);
+	}
+
+}
+
+/// <summary>
+/// 指定したノードから根までのAABBと高さを更新し、回転で釣り合いをとる関数
+/// </summary>
+/// <param name="nodeId">開始するノード番号</param>
+void MyAABBTree::RefitAncestors(int32_t nodeId) {
+
+	int32_t index = nodeId;
+	while (index != kNullNode) {
+		index = Balance(index);
+
+		TreeNode& node = nodes_[index];
+		node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+		node.aabb = Union(nodes_[node.child1].aabb, nodes_[node.child2].aabb);
+
+		index = node.parent;
+	}
+
+}
+
+/// <summary>
+/// ノードの子の高さの差が2以上なら回転する関数
+/// </summary>
+/// <param name="nodeId">ノード番号</param>
+/// <returns>回転後にその位置にあるノード番号</returns>
+int32_t MyAABBTree::Balance(int32_t nodeId) {
+
+	int32_t iA = nodeId;
+	TreeNode& a = nodes_[iA];
+	if (a.child1 == kNullNode || a.height < 2) {
+		return iA;
+	}
+
+	int32_t iB = a.child1;
+	int32_t iC = a.child2;
+	int32_t balance = nodes_[iC].height - nodes_[iB].height;
+
+	// 高い方の子 (iUp) を A の位置に持ち上げる
+	if (balance > 1 || balance < -1) {
+		bool isRight = balance > 1;
+		int32_t iUp = isRight ? iC : iB;
+		int32_t iOther = isRight ? iB : iC;
+		TreeNode& up = nodes_[iUp];
+		int32_t iF = up.child1;
+		int32_t iG = up.child2;
+
+		// 持ち上げた子と A を入れ替える
+		up.child1 = iA;
+		up.parent = a.parent;
+		a.parent = iUp;
+		if (up.parent != kNullNode) {
+			if (nodes_[up.parent].child1 == iA) {
+				nodes_[up.parent].child1 = iUp;
+			}
+			else {
+				nodes_[up.parent].child2 = iUp;
+			}
+		}
+		else {
+			root_ = iUp;
+		}
+
+		// 持ち上げた子の高い方の孫を残し、低い方の孫を A に渡す
+		int32_t iKeep = nodes_[iF].height > nodes_[iG].height ? iF : iG;
+		int32_t iGive = iKeep == iF ? iG : iF;
+		up.child2 = iKeep;
+		if (isRight) {
+			a.child2 = iGive;
+		}
+		else {
+			a.child1 = iGive;
+		}
+		nodes_[iGive].parent = iA;
+
+		a.aabb = Union(nodes_[iOther].aabb, nodes_[iGive].aabb);
+		a.height = 1 + std::max(nodes_[iOther].height, nodes_[iGive].height);
+		up.aabb = Union(a.aabb, nodes_[iKeep].aabb);
+		up.height = 1 + std::max(a.height, nodes_[iKeep].height);
+
+		return iUp;
+	}
+
+	return iA;
+
+}
+
+/// <summary>
+/// 2つのAABBを囲むAABBを求める関数
+/// </summary>
+AABB MyAABBTree::Union(const AABB& a, const AABB& b) {
+
+	return {
+		{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+		{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) }
+	};
+
+}
+
+/// <summary>
+/// AABBの表面積の半分を求める関数 (挿入先を選ぶコストに使う)
+/// </summary>
+float MyAABBTree::HalfArea(const AABB& aabb) {
+
+	Vector3 size = aabb.max - aabb.min;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+
+}
+
+/// <summary>
+/// a が b を含んでいるか判定する関数
+/// </summary>
+bool MyAABBTree::Contains(const AABB& a, const AABB& b) {
+
+	return a.min.x <= b.min.x && a.min.y <= b.min.y && a.min.z <= b.min.z &&
+		b.max.x <= a.max.x && b.max.y <= a.max.y && b.max.z <= a.max.z;
+
+}
@@ -0,0 +1,267 @@
+﻿#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "MyCollision.h"
+
+/// <summary>
+/// 動的AABB木クラス
+/// 葉には余白を持たせた太いAABBを登録し、小さな移動では木を組み替えない
+/// 挿入、削除時は回転で高さの差が1以内になるように保つ
+/// </summary>
+class MyAABBTree
+{
+public:
+
+	// 無効なノード番号
+	static const int32_t kNullNode = -1;
+
+	/// <summary>
+	/// コンストラクタ
+	/// </summary>
+	/// <param name="margin">葉のAABBに持たせる余白</param>
+	MyAABBTree(float margin = 0.1f);
+
+	/// <summary>
+	/// 要素を登録する関数
+	/// </summary>
+	/// <param name="aabb">要素のAABB</param>
+	/// <param name="userData">要素の識別番号 (配列の番号など)</param>
+	/// <returns>要素の番号</returns>
+	int32_t CreateProxy(const AABB& aabb, uint32_t userData);
+
+	/// <summary>
+	/// 要素を削除する関数
+	/// </summary>
+	/// <param name="proxyId">要素の番号</param>
+	void DestroyProxy(int32_t proxyId);
+
+	/// <summary>
+	/// 要素を移動する関数
+	/// 新しいAABBが太いAABBに収まっている場合は何もしない
+	/// </summary>
+	/// <param name="proxyId">要素の番号</param>
+	/// <param name="aabb">移動後のAABB</param>
+	/// <param name="displacement">移動量 (移動方向に太いAABBを伸ばす)</param>
+	/// <returns>木を組み替えたか</returns>
+	bool MoveProxy(int32_t proxyId, const AABB& aabb, const Vector3& displacement);
+
+	/// <summary>
+	/// 要素の識別番号を取得する関数
+	/// </summary>
+	/// <param name="proxyId">要素の番号</param>
+	/// <returns>識別番号</returns>
+	uint32_t GetUserData(int32_t proxyId) const { return nodes_[proxyId].userData; }
+
+	/// <summary>
+	/// 要素の太いAABBを取得する関数
+	/// </summary>
+	/// <param name="proxyId">要素の番号</param>
+	/// <returns>太いAABB</returns>
+	const AABB& GetFatAABB(int32_t proxyId) const { return nodes_[proxyId].aabb; }
+
+	/// <summary>
+	/// 木の高さを取得する関数
+	/// </summary>
+	/// <returns>高さ (空の場合は0)</returns>
+	int32_t GetHeight() const { return root_ == kNullNode ? 0 : nodes_[root_].height; }
+
+	/// <summary>
+	/// 全ての要素を囲むAABBを取得する関数
+	/// </summary>
+	/// <returns>根のAABB (空の場合は nullptr)</returns>
+	const AABB* GetBounds() const { return root_ == kNullNode ? nullptr : &nodes_[root_].aabb; }
+
+	/// <summary>
+	/// AABBと重なる要素を探す関数
+	/// </summary>
+	/// <param name="aabb">AABB</param>
+	/// <param name="callback">bool(int32_t proxyId) 見つかるたびに呼ばれ、falseを返すと探索を終える</param>
+	template<typename Callback>
+	void Query(const AABB& aabb, Callback&& callback) const;
+
+	/// <summary>
+	/// 線分と交差する要素を探す関数
+	/// </summary>
+	/// <param name="segment">線分</param>
+	/// <param name="callback">
+	/// float(int32_t proxyId, float maxFraction) 見つかるたびに呼ばれる
+	/// 0を返すと探索を終え、maxFraction より小さい値を返すと線分をその位置で切り詰める
+	/// </param>
+	template<typename Callback>
+	void RayCast(const Segment& segment, Callback&& callback) const;
+
+	/// <summary>
+	/// 太いAABB同士が重なっている要素の組を全て求める関数
+	/// 各組は MyCollision の詳細な判定に渡して確認すること
+	/// </summary>
+	/// <param name="pairs">識別番号の組の格納先 (末尾に追加される)</param>
+	void QueryPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const;
+
+private:
+
+	/// <summary>
+	/// 木のノード
+	/// </summary>
+	struct TreeNode {
+		AABB aabb; // 囲むAABB (葉の場合は太いAABB)
+		uint32_t userData; // 要素の識別番号
+		int32_t parent; // 親ノード (未使用の場合は次の未使用ノード)
+		int32_t child1; // 子ノード1 (葉の場合は kNullNode)
+		int32_t child2; // 子ノード2
+		int32_t height; // 葉からの高さ (未使用の場合は-1)
+	};
+
+	/// <summary>
+	/// ノードを確保する関数
+	/// </summary>
+	/// <returns>ノード番号</returns>
+	int32_t AllocateNode();
+
+	/// <summary>
+	/// ノードを解放する関数
+	/// </summary>
+	/// <param name="nodeId">ノード番号</param>
+	void FreeNode(int32_t nodeId);
+
+	/// <summary>
+	/// 葉を木に挿入する関数
+	/// </summary>
+	/// <param name="leaf">葉のノード番号</param>
+	void InsertLeaf(int32_t leaf);
+
+	/// <summary>
+	/// 葉を木から取り除く関数
+	/// </summary>
+	/// <param name="leaf">葉のノード番号</param>
+	void RemoveLeaf(int32_t leaf);
+
+	/// <summary>
+	/// 指定したノードから根までのAABBと高さを更新し、回転で釣り合いをとる関数
+	/// </summary>
+	/// <param name="nodeId">開始するノード番号</param>
+	void RefitAncestors(int32_t nodeId);
+
+	/// <summary>
+	/// ノードの子の高さの差が2以上なら回転する関数
+	/// </summary>
+	/// <param name="nodeId">ノード番号</param>
+	/// <returns>回転後にその位置にあるノード番号</returns>
+	int32_t Balance(int32_t nodeId);
+
+	/// <summary>
+	/// 2つのAABBを囲むAABBを求める関数
+	/// </summary>
+	static AABB Union(const AABB& a, const AABB& b);
+
+	/// <summary>
+	/// AABBの表面積の半分を求める関数 (挿入先を選ぶコストに使う)
+	/// </summary>
+	static float HalfArea(const AABB& aabb);
+
+	/// <summary>
+	/// a が b を含んでいるか判定する関数
+	/// </summary>
+	static bool Contains(const AABB& a, const AABB& b);
+
+	// 探索用スタックの大きさ
+	static const int32_t kStackSize = 256;
+	// 移動量に掛けて太いAABBを伸ばす倍率
+	static constexpr float kDisplacementMultiplier = 2.0f;
+
+	// ノード配列
+	std::vector<TreeNode> nodes_;
+	// 根ノード
+	int32_t root_ = kNullNode;
+	// 未使用ノードの先頭
+	int32_t freeList_ = kNullNode;
+	// 葉のAABBに持たせる余白
+	float margin_;
+
+};
+
+/// <summary>
+/// AABBと重なる要素を探す関数
+/// </summary>
+/// <param name="aabb">AABB</param>
+/// <param name="callback">bool(int32_t proxyId) 見つかるたびに呼ばれ、falseを返すと探索を終える</param>
+template<typename Callback>
+void MyAABBTree::Query(const AABB& aabb, Callback&& callback) const {
+
+	int32_t stack[kStackSize];
+	int32_t stackCount = 0;
+	if (root_ != kNullNode) {
+		stack[stackCount++] = root_;
+	}
+
+	while (stackCount > 0) {
+		int32_t nodeId = stack[--stackCount];
+		const TreeNode& node = nodes_[nodeId];
+
+		// 重なっていなければ子も調べない
+		if (!MyCollision::IsCollisionAABB(node.aabb, aabb)) {
+			continue;
+		}
+
+		if (node.child1 == kNullNode) {
+			// 葉なら呼び出し元に知らせる
+			if (!callback(nodeId)) {
+				return;
+			}
+		}
+		else {
+			assert(stackCount + 2 <= kStackSize);
+			stack[stackCount++] = node.child1;
+			stack[stackCount++] = node.child2;
+		}
+	}
+
+}
+
+/// <summary>
+/// 線分と交差する要素を探す関数
+/// </summary>
+/// <param name="segment">線分</param>
+/// <param name="callback">
+/// float(int32_t proxyId, float maxFraction) 見つかるたびに呼ばれる
+/// 0を返すと探索を終え、maxFraction より小さい値を返すと線分をその位置で切り詰める
+/// </param>
+template<typename Callback>
+void MyAABBTree::RayCast(const Segment& segment, Callback&& callback) const {
+
+	float maxFraction = 1.0f;
+
+	int32_t stack[kStackSize];
+	int32_t stackCount = 0;
+	if (root_ != kNullNode) {
+		stack[stackCount++] = root_;
+	}
+
+	while (stackCount > 0) {
+		int32_t nodeId = stack[--stackCount];
+		const TreeNode& node = nodes_[nodeId];
+
+		// 切り詰めた線分と交差していなければ子も調べない
+		float tEnter, tExit;
+		if (!MyCollision::IntersectAABB(segment, node.aabb, tEnter, tExit) || tEnter > maxFraction) {
+			continue;
+		}
+
+		if (node.child1 == kNullNode) {
+			// 葉なら呼び出し元で詳細な判定を行う
+			float fraction = callback(nodeId, maxFraction);
+			if (fraction == 0.0f) {
+				return;
+			}
+			if (fraction < maxFraction) {
+				maxFraction = fraction;
+			}
+		}
+		else {
+			assert(stackCount + 2 <= kStackSize);
+			stack[stackCount++] = node.child1;
+			stack[stackCount++] = node.child2;
+		}
+	}
+
+}
@@ -1,4 +1,207 @@
 ﻿#include "MyCollision.h"
+#include "MyPerfCounter.h"
+#include "MyExpression.h"
+#include "MyPredicate.h"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+
+namespace {
+
+	/// <summary>
+	/// 球と三角形上の最近接点から接触情報を求める関数
+	/// </summary>
+	/// <param name="a">三角形の頂点a</param>
+	/// <param name="b">三角形の頂点b</param>
+	/// <param name="c">三角形の頂点c</param>
+	/// <param name="sphere">球</param>
+	/// <param name="closest">三角形上の最近接点</param>
+	/// <returns>接触情報</returns>
+	Contact MakeSphereContact(const Vector3& a, const Vector3& b, const Vector3& c, const Sphere& sphere, const Vector3& closest) {
+
+		Contact result{};
+		result.point = closest;
+
+		Vector3 diff = sphere.center - closest;
+		float distance = MyMath::Length(diff);
+		if (distance > 0.0f) {
+			// 最近接点から球の中心へ押し出す
+			result.normal = MyMath::Multiply(1.0f / distance, diff);
+		}
+		else {
+			// 中心が面上にある場合は面の法線で押し出す
+			result.normal = MyMath::Normalize(MyMath::Cross(b - a, c - a));
+		}
+		result.depth = sphere.radius - distance;
+
+		return result;
+
+	}
+
+	/// <summary>
+	/// プリミティブの配列からAABBの配列を作成する関数
+	/// </summary>
+	/// <param name="shapes">プリミティブ配列</param>
+	/// <param name="count">プリミティブの数</param>
+	/// <param name="soa">作成先</param>
+	/// <param name="makeAABB">AABB(const Shape&) プリミティブを囲むAABBを求める関数</param>
+	template<typename Shape, typename MakeFunction>
+	void MakeAABBSoAFrom(const Shape* shapes, size_t count, AABBSoA& soa, MakeFunction makeAABB) {
+
+		// 4の倍数に切り上げ、余りの要素は最小が最大より大きいAABBにする
+		size_t paddedCount = (count + 3) & ~size_t(3);
+		soa.count = count;
+		soa.minX.assign(paddedCount, FLT_MAX);
+		soa.minY.assign(paddedCount, FLT_MAX);
+		soa.minZ.assign(paddedCount, FLT_MAX);
+		soa.maxX.assign(paddedCount, -FLT_MAX);
+		soa.maxY.assign(paddedCount, -FLT_MAX);
+		soa.maxZ.assign(paddedCount, -FLT_MAX);
+
+		for (size_t i = 0; i < count; i++) {
+			AABB aabb = makeAABB(shapes[i]);
+			soa.minX[i] = aabb.min.x;
+			soa.minY[i] = aabb.min.y;
+			soa.minZ[i] = aabb.min.z;
+			soa.maxX[i] = aabb.max.x;
+			soa.maxY[i] = aabb.max.y;
+			soa.maxZ[i] = aabb.max.z;
+		}
+
+	}
+
+	/// <summary>
+	/// 三角形と同じ平面上にある線分の当たり判定
+	/// 法線の最も大きい成分の軸を落とした平面に投影して判定する
+	/// </summary>
+	/// <param name="triangle">三角形</param>
+	/// <param name="p">線分の始点</param>
+	/// <param name="q">線分の終点</param>
+	/// <returns>衝突しているか</returns>
+	bool IsCollisionTriangleCoplanar(const Triangle& triangle, const Vector3& p, const Vector3& q) {
+
+		// 投影する軸を選ぶ (同じ平面上の点は軸を落としても位置関係が変わらない)
+		Vector3 normal = MyMath::Cross(triangle.vertex[1] - triangle.vertex[0], triangle.vertex[2] - triangle.vertex[0]);
+		Vector3 absNormal = { std::abs(normal.x), std::abs(normal.y), std::abs(normal.z) };
+		int axisU = 1, axisV = 2;
+		if (absNormal.y >= absNormal.x && absNormal.y >= absNormal.z) {
+			axisU = 2;
+			axisV = 0;
+		}
+		else if (absNormal.z >= absNormal.x && absNormal.z >= absNormal.y) {
+			axisU = 0;
+			axisV = 1;
+		}
+		auto u = [axisU](const Vector3& point) { return (&point.x)[axisU]; };
+		auto v = [axisV](const Vector3& point) { return (&point.x)[axisV]; };
+
+		const Vector3* vertex = triangle.vertex;
+		int orientation = MyPredicate::Orient2D(u(vertex[0]), v(vertex[0]), u(vertex[1]), v(vertex[1]), u(vertex[2]), v(vertex[2]));
+		if (orientation == 0) {
+			// 面積のない三角形
+			return false;
+		}
+
+		// 点が三角形の内側 (辺上を含む) にあるか
+		auto isInside = [&](const Vector3& point) {
+			for (uint32_t i = 0; i < 3; i++) {
+				const Vector3& e0 = vertex[i];
+				const Vector3& e1 = vertex[(i + 1) % 3];
+				if (MyPredicate::Orient2D(u(e0), v(e0), u(e1), v(e1), u(point), v(point)) * orientation < 0) {
+					return false;
+				}
+			}
+			return true;
+		};
+		if (isInside(p) || isInside(q)) {
+			return true;
+		}
+
+		// 両端が外側なら線分がいずれかの辺と交差しているか
+		for (uint32_t i = 0; i < 3; i++) {
+			const Vector3& e0 = vertex[i];
+			const Vector3& e1 = vertex[(i + 1) % 3];
+			int sideP = MyPredicate::Orient2D(u(e0), v(e0), u(e1), v(e1), u(p), v(p));
+			int sideQ = MyPredicate::Orient2D(u(e0), v(e0), u(e1), v(e1), u(q), v(q));
+			int side0 = MyPredicate::Orient2D(u(p), v(p), u(q), v(q), u(e0), v(e0));
+			int side1 = MyPredicate::Orient2D(u(p), v(p), u(q), v(q), u(e1), v(e1));
+			if (sideP * sideQ <= 0 && side0 * side1 <= 0) {
+				// 同じ直線上にある場合は範囲が重なっているか
+				if (sideP == 0 && sideQ == 0) {
+					float minU = std::min(u(p), u(q)), maxU = std::max(u(p), u(q));
+					float minV = std::min(v(p), v(q)), maxV = std::max(v(p), v(q));
+					auto isOnSegment = [&](const Vector3& point) {
+						return minU <= u(point) && u(point) <= maxU && minV <= v(point) && v(point) <= maxV;
+					};
+					if (isOnSegment(e0) || isOnSegment(e1)) {
+						return true;
+					}
+					continue;
+				}
+				return true;
+			}
+		}
+
+		return false;
+
+	}
+
+#ifdef MYMATH_SIMD_SSE
+	/// <summary>
+	/// 4つの要素の判定結果から当たった要素の番号を書き出す関数
+	/// </summary>
+	/// <param name="mask">判定結果 (下位4ビット)</param>
+	/// <param name="first">先頭の要素の番号</param>
+	/// <param name="count">要素の数 (これ以降の余りの要素は書き出さない)</param>
+	/// <param name="hitIndex">番号の格納先</param>
+	/// <param name="hitCount">格納済みの数</param>
+	/// <returns>格納後の数</returns>
+	size_t WriteHitIndex(uint32_t mask, size_t first, size_t count, uint32_t* hitIndex, size_t hitCount) {
+
+		if (first + 4 > count) {
+			mask &= (1u << (count - first)) - 1u;
+		}
+		while (mask != 0) {
+			hitIndex[hitCount++] = uint32_t(first + std::countr_zero(mask));
+			mask &= mask - 1u;
+		}
+		return hitCount;
+
+	}
+
+	/// <summary>
+	/// 4つの要素の中で最も手前の交点を選ぶ関数
+	/// </summary>
+	/// <param name="bestT">要素ごとの最も手前の媒介変数</param>
+	/// <param name="bestIndex">要素ごとの番号 (交点がない場合は UINT32_MAX)</param>
+	/// <param name="t">媒介変数の格納先</param>
+	/// <param name="hitIndex">番号の格納先</param>
+	/// <returns>交点があるか</returns>
+	bool SelectClosest(__m128 bestT, __m128i bestIndex, float& t, uint32_t& hitIndex) {
+
+		alignas(16) float laneT[4];
+		alignas(16) uint32_t laneIndex[4];
+		_mm_store_ps(laneT, bestT);
+		_mm_store_si128(reinterpret_cast<__m128i*>(laneIndex), bestIndex);
+
+		bool isHit = false;
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			if (laneIndex[lane] == UINT32_MAX) {
+				continue;
+			}
+			// 同じ距離なら番号の小さい方を選ぶ
+			if (!isHit || laneT[lane] < t || (laneT[lane] == t && laneIndex[lane] < hitIndex)) {
+				t = laneT[lane];
+				hitIndex = laneIndex[lane];
+				isHit = true;
+			}
+		}
+		return isHit;
+
+	}
+#endif
+
+}
 
 /// <summary>
 /// 球の当たり判定をとる関数
@@ -60,7 +263,44 @@ bool MyCollision::IsCollisionPlane(const Sphere& s, const Plane& p) {
 /// <returns>衝突しているか</returns>
 bool MyCollision::IsCollisionLine(const Line& l, const Plane& p) {
 
-	// 垂直な判定を散るために法線と線の内積をとる
+	return IntersectLine(l, p);
+
+}
+
+/// <summary>
+/// 半直線と平面の当たり判定をとる関数
+/// </summary>
+/// <param name="r">半直線</param>
+/// <param name="p">平面</param>
+/// <returns>衝突しているか</returns>
+bool MyCollision::IsCollisionLine(const Ray& r, const Plane& p) {
+
+	return IntersectLine(r, p);
+
+}
+
+/// <summary>
+/// 線分と平面の当たり判定をとる関数
+/// </summary>
+/// <param name="s">線分</param>
+/// <param name="p">平面</param>
+/// <returns>衝突しているか</returns>
+bool MyCollision::IsCollisionLine(const Segment& s, const Plane& p) {
+
+	return IntersectLine(s, p);
+
+}
+
+/// <summary>
+/// 直線と平面の交点を求める関数
+/// </summary>
+/// <param name="l">直線</param>
+/// <param name="p">平面</param>
+/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectLine(const Line& l, const Plane& p, HitInfo* hit) {
+
+	// 垂直な判定をとるために法線と線の内積をとる
 	float dot = MyMath::Dot(p.normal, l.diff);
 
 	// 垂直な場合は平行であるため衝突はしていない
@@ -71,66 +311,261 @@ bool MyCollision::IsCollisionLine(const Line& l, const Plane& p) {
 	// tを求める
 	float t = (p.distance - MyMath::Dot(l.origin, p.normal)) / dot;
 
-	// tの計算結果と線の種類によって衝突しているか検証する
+	// 直線はtの範囲に制限がない
+	if (hit != nullptr) {
+		hit->t = t;
+		hit->point = MyExpr::Eval(MyExpr::Ref(l.origin) + t * MyExpr::Ref(l.diff));
+		hit->normal = p.normal;
+	}
+
 	return true;
 
 }
 
 /// <summary>
-/// 半直線と平面の当たり判定をとる関数
+/// 半直線と平面の交点を求める関数
 /// </summary>
 /// <param name="r">半直線</param>
 /// <param name="p">平面</param>
-/// <returns>衝突しているか</returns>
-bool MyCollision::IsCollisionLine(const Ray& r, const Plane& p) {
+/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectLine(const Ray& r, const Plane& p, HitInfo* hit) {
 
-	// 垂直な判定を散るために法線と線の内積をとる
-	float dot = MyMath::Dot(p.normal, r.diff);
-
-	// 垂直な場合は平行であるため衝突はしていない
-	if (dot == 0.0f) {
+	// 半直線を直線として交点を求める
+	HitInfo lineHit{};
+	if (!IntersectLine(Line{ r.origin, r.diff }, p, &lineHit)) {
 		return false;
 	}
 
-	// tを求める
-	float t = (p.distance - MyMath::Dot(r.origin, p.normal)) / dot;
-
-	// tの計算結果と線の種類によって衝突しているか検証する
-	if (t < 1.0f) {
+	// 始点より後ろの交点は衝突していない
+	if (lineHit.t < 0.0f) {
 		return false;
 	}
-	else {
-		return true;
+
+	if (hit != nullptr) {
+		*hit = lineHit;
 	}
 
+	return true;
+
 }
 
 /// <summary>
-/// 線分と平面の当たり判定をとる関数
+/// 線分と平面の交点を求める関数
 /// </summary>
 /// <param name="s">線分</param>
 /// <param name="p">平面</param>
-/// <returns>衝突しているか</returns>
-bool MyCollision::IsCollisionLine(const Segment& s, const Plane& p) {
+/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectLine(const Segment& s, const Plane& p, HitInfo* hit) {
 
-	// 垂直な判定を散るために法線と線の内積をとる
-	float dot = MyMath::Dot(p.normal, s.diff);
+	// 線分を直線として交点を求める
+	HitInfo lineHit{};
+	if (!IntersectLine(Line{ s.origin, s.diff }, p, &lineHit)) {
+		return false;
+	}
 
-	// 垂直な場合は平行であるため衝突はしていない
-	if (dot == 0.0f) {
+	// 始点と終点の間になければ衝突していない
+	if (lineHit.t < 0.0f || 1.0f < lineHit.t) {
 		return false;
 	}
 
-	// tを求める
-	float t = (p.distance - MyMath::Dot(s.origin, p.normal)) / dot;
+	if (hit != nullptr) {
+		*hit = lineHit;
+	}
+
+	return true;
 
-	// tの計算結果と線の種類によって衝突しているか検証する
-	if (t < 0.0f || 1.0f < t) {
+}
+
+/// <summary>
+/// 半直線と球の交点を求める関数
+/// 始点が球の内側にある場合は球から出る点を返す
+/// </summary>
+/// <param name="r">半直線</param>
+/// <param name="sphere">球</param>
+/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectLine(const Ray& r, const Sphere& sphere, HitInfo* hit) {
+
+	// |origin + t * diff - center| = radius を t について解く
+	Vector3 offset = r.origin - sphere.center;
+	float a = MyMath::Dot(r.diff, r.diff);
+	float b = MyMath::Dot(offset, r.diff);
+	float c = MyMath::Dot(offset, offset) - sphere.radius * sphere.radius;
+
+	// 判別式が負なら交差していない
+	float discriminant = b * b - a * c;
+	if (a == 0.0f || discriminant < 0.0f) {
 		return false;
 	}
-	else {
-		return true;
+
+	// 手前の解が始点より後ろなら奥の解を使う
+	float root = std::sqrt(discriminant);
+	float t = (-b - root) / a;
+	if (t < 0.0f) {
+		t = (-b + root) / a;
+		if (t < 0.0f) {
+			return false;
+		}
+	}
+
+	if (hit != nullptr) {
+		hit->t = t;
+		hit->point = MyExpr::Eval(MyExpr::Ref(r.origin) + t * MyExpr::Ref(r.diff));
+		hit->normal = MyMath::Normalize(hit->point - sphere.center);
+	}
+
+	return true;
+
+}
+
+/// <summary>
+/// 半直線と三角形の交点を求める関数 (Moller-Trumbore)
+/// 法線は半直線と向かい合う向きで返す
+/// </summary>
+/// <param name="r">半直線</param>
+/// <param name="triangle">三角形</param>
+/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectLine(const Ray& r, const Triangle& triangle, HitInfo* hit) {
+
+	Vector3 edge1 = triangle.vertex[1] - triangle.vertex[0];
+	Vector3 edge2 = triangle.vertex[2] - triangle.vertex[0];
+
+	// 半直線が三角形と平行なら交差していない
+	Vector3 p = MyMath::Cross(r.diff, edge2);
+	float det = MyMath::Dot(edge1, p);
+	if (det == 0.0f) {
+		return false;
 	}
+	float inverseDet = 1.0f / det;
+
+	// 重心座標 u, v が三角形の内側にあるか
+	Vector3 s = r.origin - triangle.vertex[0];
+	float u = MyMath::Dot(s, p) * inverseDet;
+	if (u < 0.0f || 1.0f < u) {
+		return false;
+	}
+	Vector3 q = MyMath::Cross(s, edge1);
+	float v = MyMath::Dot(r.diff, q) * inverseDet;
+	if (v < 0.0f || 1.0f < u + v) {
+		return false;
+	}
+
+	// 始点より後ろなら交差していない
+	float t = MyMath::Dot(edge2, q) * inverseDet;
+	if (t < 0.0f) {
+		return false;
+	}
+
+	if (hit != nullptr) {
+		hit->t = t;
+		hit->point = MyExpr::Eval(MyExpr::Ref(r.origin) + t * MyExpr::Ref(r.diff));
+		hit->normal = MyMath::Normalize(MyMath::Cross(edge1, edge2));
+		if (MyMath::Dot(hit->normal, r.diff) > 0.0f) {
+			hit->normal = MyMath::Multiply(-1.0f, hit->normal);
+		}
+	}
+
+	return true;
+
+}
+
+/// <summary>
+/// 線分が複数の平面で囲まれた凸領域に入る区間を求める関数 (Cyrus-Beck)
+/// 各平面の法線の向きが外側で、Dot(normal, x) <= distance が内側になる
+/// 平面は4枚ずつSIMDでまとめて処理する
+/// </summary>
+/// <param name="s">線分</param>
+/// <param name="planes">平面配列</param>
+/// <param name="count">平面の数</param>
+/// <param name="tEnter">領域に入る媒介変数の格納先</param>
+/// <param name="tExit">領域から出る媒介変数の格納先</param>
+/// <returns>線分が領域と重なっているか</returns>
+bool MyCollision::IntersectConvex(const Segment& s, const Plane* planes, size_t count, float& tEnter, float& tExit) {
+
+	// 線分全体から始めて各平面で区間を狭めていく
+	tEnter = 0.0f;
+	tExit = 1.0f;
+
+	size_t i = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	static_assert(sizeof(Plane) == sizeof(float) * 4, "Plane は4つの float が並んでいること");
+
+	__m128 enter = _mm_set1_ps(0.0f);
+	__m128 exit = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	// 平行で外側にある平面があったか
+	__m128 outside = zero;
+
+	for (; i + 4 <= count; i += 4) {
+
+		// 4枚の平面を成分ごとに並べ替える
+		__m128 nx = _mm_loadu_ps(&planes[i].normal.x);
+		__m128 ny = _mm_loadu_ps(&planes[i + 1].normal.x);
+		__m128 nz = _mm_loadu_ps(&planes[i + 2].normal.x);
+		__m128 distance = _mm_loadu_ps(&planes[i + 3].normal.x);
+		_MM_TRANSPOSE4_PS(nx, ny, nz, distance);
+
+		// 始点から平面までの距離と、線分の方向と法線の内積
+		__m128 originDot = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(nx, _mm_set1_ps(s.origin.x)), _mm_mul_ps(ny, _mm_set1_ps(s.origin.y))), _mm_mul_ps(nz, _mm_set1_ps(s.origin.z)));
+		__m128 numer = _mm_sub_ps(distance, originDot);
+		__m128 denom = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(nx, _mm_set1_ps(s.diff.x)), _mm_mul_ps(ny, _mm_set1_ps(s.diff.y))), _mm_mul_ps(nz, _mm_set1_ps(s.diff.z)));
+		__m128 t = _mm_div_ps(numer, denom);
+
+		// 法線と逆向きに進むなら入る側、同じ向きなら出る側
+		__m128 isEnter = _mm_cmplt_ps(denom, zero);
+		__m128 isExit = _mm_cmpgt_ps(denom, zero);
+		enter = _mm_max_ps(enter, _mm_or_ps(_mm_and_ps(isEnter, t), _mm_andnot_ps(isEnter, zero)));
+		exit = _mm_min_ps(exit, _mm_or_ps(_mm_and_ps(isExit, t), _mm_andnot_ps(isExit, _mm_set1_ps(1.0f))));
+
+		// 平行な平面は始点が外側なら重ならない
+		__m128 isParallel = _mm_cmpeq_ps(denom, zero);
+		outside = _mm_or_ps(outside, _mm_and_ps(isParallel, _mm_cmplt_ps(numer, zero)));
+
+	}
+
+	if (_mm_movemask_ps(outside) != 0) {
+		return false;
+	}
+
+	// 4つの要素の最大値、最小値を求める
+	alignas(16) float enterValue[4], exitValue[4];
+	_mm_store_ps(enterValue, enter);
+	_mm_store_ps(exitValue, exit);
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		tEnter = std::max(tEnter, enterValue[lane]);
+		tExit = std::min(tExit, exitValue[lane]);
+	}
+#endif
+
+	// 残りの平面を1枚ずつ処理する
+	for (; i < count; i++) {
+		float numer = planes[i].distance - MyMath::Dot(planes[i].normal, s.origin);
+		float denom = MyMath::Dot(planes[i].normal, s.diff);
+
+		if (denom == 0.0f) {
+			// 平行な場合は始点が外側なら重ならない
+			if (numer < 0.0f) {
+				return false;
+			}
+			continue;
+		}
+
+		float t = numer / denom;
+		if (denom < 0.0f) {
+			tEnter = std::max(tEnter, t);
+		}
+		else {
+			tExit = std::min(tExit, t);
+		}
+	}
+
+	return tEnter <= tExit;
 
 }
 
@@ -142,61 +577,696 @@ bool MyCollision::IsCollisionLine(const Segment& s, const Plane& p) {
 /// <returns>衝突しているか</returns>
 bool MyCollision::IsCollisionTriangle(const Triangle& triangle, const Segment& s) {
 
-	// 3角形の平面の当たり判定をとる
-	Plane plane = {};
+	const Vector3& a = triangle.vertex[0];
+	const Vector3& b = triangle.vertex[1];
+	const Vector3& c = triangle.vertex[2];
+	Vector3 p = s.origin;
+	Vector3 q = s.origin + s.diff;
 
-	// 3角形を平面に落とし込む
-	plane.normal = MyMath::Normalize(
-		MyMath::Cross(
-			triangle.vertex[1] - triangle.vertex[0],
-			triangle.vertex[2] - triangle.vertex[1]
-		)
-	);
+	// 線分の両端が三角形の平面の同じ側にあれば衝突していない
+	int sideP = MyPredicate::Orient3D(a, b, c, p);
+	int sideQ = MyPredicate::Orient3D(a, b, c, q);
+	if (sideP * sideQ > 0) {
+		return false;
+	}
 
-	plane.distance = MyMath::Dot(triangle.vertex[0], plane.normal);
+	// 両端が平面上にある場合は平面上で判定する
+	if (sideP == 0 && sideQ == 0) {
+		return IsCollisionTriangleCoplanar(triangle, p, q);
+	}
 
-	// 垂直な判定をとるために法線と線の内積をとる
-	float dot = MyMath::Dot(plane.normal, s.diff);
+	// 線分を通る直線から見て、各辺が同じ向きに回っていれば三角形を貫いている (辺や頂点上も衝突とする)
+	int edge01 = MyPredicate::Orient3D(p, q, a, b);
+	int edge12 = MyPredicate::Orient3D(p, q, b, c);
+	int edge20 = MyPredicate::Orient3D(p, q, c, a);
 
-	// 垂直な場合は平行であるため衝突はしていない
-	if (dot == 0.0f) {
+	return (edge01 >= 0 && edge12 >= 0 && edge20 >= 0) || (edge01 <= 0 && edge12 <= 0 && edge20 <= 0);
+
+}
+
+/// <summary>
+/// 三角形と球の当たり判定
+/// </summary>
+/// <param name="triangle">三角形</param>
+/// <param name="sphere">球</param>
+/// <param name="contact">接触情報の格納先 (nullptrなら求めない)</param>
+/// <returns>衝突しているか</returns>
+bool MyCollision::IsCollisionTriangle(const Triangle& triangle, const Sphere& sphere, Contact* contact) {
+
+	// 三角形上の最近接点を求める
+	Vector3 closest = MyMath::ClosestPointTriangle(sphere.center, triangle);
+	Vector3 diff = sphere.center - closest;
+
+	// 最近接点が球の内側になければ衝突していない
+	if (MyMath::Dot(diff, diff) > sphere.radius * sphere.radius) {
 		return false;
 	}
 
-	// tを求める
-	float t = (plane.distance - MyMath::Dot(s.origin, plane.normal)) / dot;
+	if (contact != nullptr) {
+		*contact = MakeSphereContact(triangle.vertex[0], triangle.vertex[1], triangle.vertex[2], sphere, closest);
+	}
+
+	return true;
 
-	if (0.0f < t && 1.0f > t) {
-		// 衝突点pを求める
-		Vector3 p = s.origin + MyMath::Multiply(t, s.diff);
+}
 
-		// 各辺を結んだベクトルと頂点と衝突点pを結んだベクトルのクロス積をとる
-		Vector3 cross01 = MyMath::Cross(
-			triangle.vertex[1] - triangle.vertex[0],
-			p - triangle.vertex[1]
-		);
+/// <summary>
+/// AABB同士の当たり判定
+/// </summary>
+/// <param name="a">AABB1</param>
+/// <param name="b">AABB2</param>
+/// <returns>衝突しているか</returns>
+bool MyCollision::IsCollisionAABB(const AABB& a, const AABB& b) {
 
-		Vector3 cross12 = MyMath::Cross(
-			triangle.vertex[2] - triangle.vertex[1],
-			p - triangle.vertex[2]
-		);
+	// 全ての軸で範囲が重なっていれば衝突している
+	return (a.min.x <= b.max.x && a.max.x >= b.min.x) &&
+		(a.min.y <= b.max.y && a.max.y >= b.min.y) &&
+		(a.min.z <= b.max.z && a.max.z >= b.min.z);
 
-		Vector3 cross20 = MyMath::Cross(
-			triangle.vertex[0] - triangle.vertex[2],
-			p - triangle.vertex[0]
-		);
+}
 
-		// 全ての小三角形のクロス積と法線が同じ方向なら衝突している
-		if (MyMath::Dot(cross01, plane.normal) >= 0.0f,
-			MyMath::Dot(cross12, plane.normal) >= 0.0f,
-			MyMath::Dot(cross20, plane.normal) >= 0.0f) {
+/// <summary>
+/// 線分とAABBの交差区間を求める関数 (スラブ法)
+/// </summary>
+/// <param name="s">線分</param>
+/// <param name="aabb">AABB</param>
+/// <param name="tEnter">AABBに入る媒介変数の格納先</param>
+/// <param name="tExit">AABBから出る媒介変数の格納先</param>
+/// <returns>交差しているか</returns>
+bool MyCollision::IntersectAABB(const Segment& s, const AABB& aabb, float& tEnter, float& tExit) {
 
-			return true;
+	const float origin[3] = { s.origin.x, s.origin.y, s.origin.z };
+	const float diff[3] = { s.diff.x, s.diff.y, s.diff.z };
+	const float min[3] = { aabb.min.x, aabb.min.y, aabb.min.z };
+	const float max[3] = { aabb.max.x, aabb.max.y, aabb.max.z };
 
+	tEnter = 0.0f;
+	tExit = 1.0f;
+
+	// 軸ごとに2枚の平面で挟まれた区間を求めて重ねる
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		if (diff[axis] == 0.0f) {
+			// 軸に平行な場合は始点が範囲内になければ交差しない
+			if (origin[axis] < min[axis] || max[axis] < origin[axis]) {
+				return false;
+			}
+			continue;
+		}
+
+		float inverse = 1.0f / diff[axis];
+		float tNear = (min[axis] - origin[axis]) * inverse;
+		float tFar = (max[axis] - origin[axis]) * inverse;
+		if (tNear > tFar) {
+			std::swap(tNear, tFar);
 		}
 
+		tEnter = std::max(tEnter, tNear);
+		tExit = std::min(tExit, tFar);
+		if (tEnter > tExit) {
+			return false;
+		}
 	}
 
-	return false;
+	return true;
+
+}
+
+/// <summary>
+/// 球を囲むAABBを求める関数
+/// </summary>
+/// <param name="sphere">球</param>
+/// <returns>AABB</returns>
+AABB MyCollision::MakeAABB(const Sphere& sphere) {
+
+	Vector3 extent = { sphere.radius, sphere.radius, sphere.radius };
+	return { sphere.center - extent, sphere.center + extent };
+
+}
+
+/// <summary>
+/// 線分を囲むAABBを求める関数
+/// </summary>
+/// <param name="segment">線分</param>
+/// <returns>AABB</returns>
+AABB MyCollision::MakeAABB(const Segment& segment) {
+
+	Vector3 end = MyMath::Add(segment.origin, segment.diff);
+	return {
+		{ std::min(segment.origin.x, end.x), std::min(segment.origin.y, end.y), std::min(segment.origin.z, end.z) },
+		{ std::max(segment.origin.x, end.x), std::max(segment.origin.y, end.y), std::max(segment.origin.z, end.z) }
+	};
+
+}
+
+/// <summary>
+/// 三角形を囲むAABBを求める関数
+/// </summary>
+/// <param name="triangle">三角形</param>
+/// <returns>AABB</returns>
+AABB MyCollision::MakeAABB(const Triangle& triangle) {
+
+	const Vector3& a = triangle.vertex[0];
+	const Vector3& b = triangle.vertex[1];
+	const Vector3& c = triangle.vertex[2];
+	return {
+		{ std::min({ a.x, b.x, c.x }), std::min({ a.y, b.y, c.y }), std::min({ a.z, b.z, c.z }) },
+		{ std::max({ a.x, b.x, c.x }), std::max({ a.y, b.y, c.y }), std::max({ a.z, b.z, c.z }) }
+	};
+
+}
+
+/// <summary>
+/// 半直線を媒介変数 maxT までで切った部分を囲むAABBを求める関数
+/// </summary>
+/// <param name="ray">半直線</param>
+/// <param name="maxT">媒介変数の上限</param>
+/// <returns>AABB</returns>
+AABB MyCollision::MakeAABB(const Ray& ray, float maxT) {
+	return MakeAABB(Segment{ ray.origin, MyMath::Multiply(maxT, ray.diff) });
+}
+
+/// <summary>
+/// 三角形の配列からSIMD処理用の配列を作成する関数
+/// </summary>
+/// <param name="triangles">三角形配列</param>
+/// <param name="count">三角形の数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeTriangleSoA(const Triangle* triangles, size_t count, TriangleSoA& soa) {
+
+	// 4の倍数に切り上げる
+	size_t paddedCount = (count + 3) & ~size_t(3);
+	soa.count = count;
+
+	for (uint32_t v = 0; v < 3; v++) {
+		soa.x[v].assign(paddedCount, 0.0f);
+		soa.y[v].assign(paddedCount, 0.0f);
+		soa.z[v].assign(paddedCount, 0.0f);
+	}
+	// 余りの要素は最小が最大より大きいAABBにして必ず除外されるようにする
+	soa.minX.assign(paddedCount, FLT_MAX);
+	soa.minY.assign(paddedCount, FLT_MAX);
+	soa.minZ.assign(paddedCount, FLT_MAX);
+	soa.maxX.assign(paddedCount, -FLT_MAX);
+	soa.maxY.assign(paddedCount, -FLT_MAX);
+	soa.maxZ.assign(paddedCount, -FLT_MAX);
+
+	for (size_t i = 0; i < count; i++) {
+		for (uint32_t v = 0; v < 3; v++) {
+			const Vector3& vertex = triangles[i].vertex[v];
+			soa.x[v][i] = vertex.x;
+			soa.y[v][i] = vertex.y;
+			soa.z[v][i] = vertex.z;
+			soa.minX[i] = std::min(soa.minX[i], vertex.x);
+			soa.minY[i] = std::min(soa.minY[i], vertex.y);
+			soa.minZ[i] = std::min(soa.minZ[i], vertex.z);
+			soa.maxX[i] = std::max(soa.maxX[i], vertex.x);
+			soa.maxY[i] = std::max(soa.maxY[i], vertex.y);
+			soa.maxZ[i] = std::max(soa.maxZ[i], vertex.z);
+		}
+	}
+
+}
+
+/// <summary>
+/// 1つの球と複数の三角形の当たり判定をまとめてとる関数
+/// AABBで先に除外し、残ったものを4個ずつSIMDで判定する
+/// </summary>
+/// <param name="sphere">球</param>
+/// <param name="soa">三角形配列</param>
+/// <param name="hitIndex">衝突した三角形の番号の格納先 (soa.count 個分の領域が必要)</param>
+/// <param name="contact">接触情報の格納先 (nullptrなら求めない、soa.count 個分の領域が必要)</param>
+/// <returns>衝突した三角形の数</returns>
+size_t MyCollision::IsCollisionTriangleMany(const Sphere& sphere, const TriangleSoA& soa, uint32_t* hitIndex, Contact* contact) {
+
+	MYPERF_SCOPE("MyCollision::IsCollisionTriangleMany", soa.count);
+
+	// 衝突数
+	size_t hitCount = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	// 球の情報を4つ並べておく
+	const __m128 px = _mm_set1_ps(sphere.center.x);
+	const __m128 py = _mm_set1_ps(sphere.center.y);
+	const __m128 pz = _mm_set1_ps(sphere.center.z);
+	const __m128 radius = _mm_set1_ps(sphere.radius);
+	const __m128 radiusSq = _mm_mul_ps(radius, radius);
+
+	// 2つのベクトルの内積
+	auto dot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	};
+
+	size_t paddedCount = soa.minX.size();
+	for (size_t i = 0; i < paddedCount; i += 4) {
+
+		// 球のAABBと三角形のAABBが重ならないものを除外する
+		__m128 mask = _mm_cmple_ps(_mm_sub_ps(px, radius), _mm_loadu_ps(&soa.maxX[i]));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(px, radius), _mm_loadu_ps(&soa.minX[i])));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_sub_ps(py, radius), _mm_loadu_ps(&soa.maxY[i])));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(py, radius), _mm_loadu_ps(&soa.minY[i])));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_sub_ps(pz, radius), _mm_loadu_ps(&soa.maxZ[i])));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(pz, radius), _mm_loadu_ps(&soa.minZ[i])));
+		if (_mm_movemask_ps(mask) == 0) {
+			continue;
+		}
+
+		// 三角形上の最近接点
+		const __m128 point[3] = { px, py, pz };
+		const __m128 a[3] = { _mm_loadu_ps(&soa.x[0][i]), _mm_loadu_ps(&soa.y[0][i]), _mm_loadu_ps(&soa.z[0][i]) };
+		const __m128 b[3] = { _mm_loadu_ps(&soa.x[1][i]), _mm_loadu_ps(&soa.y[1][i]), _mm_loadu_ps(&soa.z[1][i]) };
+		const __m128 c[3] = { _mm_loadu_ps(&soa.x[2][i]), _mm_loadu_ps(&soa.y[2][i]), _mm_loadu_ps(&soa.z[2][i]) };
+		__m128 closest[3];
+		MyMath::ClosestPointTriangle4(point, a, b, c, closest);
+		__m128 qx = closest[0], qy = closest[1], qz = closest[2];
+
+		// 最近接点が球の内側にあるか
+		__m128 dx = _mm_sub_ps(px, qx), dy = _mm_sub_ps(py, qy), dz = _mm_sub_ps(pz, qz);
+		mask = _mm_and_ps(mask, _mm_cmple_ps(dot(dx, dy, dz, dx, dy, dz), radiusSq));
+		int hitMask = _mm_movemask_ps(mask);
+		if (hitMask == 0) {
+			continue;
+		}
+
+		// 衝突した要素を書き出す
+		alignas(16) float closestX[4], closestY[4], closestZ[4];
+		_mm_store_ps(closestX, qx);
+		_mm_store_ps(closestY, qy);
+		_mm_store_ps(closestZ, qz);
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			if ((hitMask & (1 << lane)) == 0) {
+				continue;
+			}
+			size_t index = i + lane;
+			if (contact != nullptr) {
+				contact[hitCount] = MakeSphereContact(
+					{ soa.x[0][index], soa.y[0][index], soa.z[0][index] },
+					{ soa.x[1][index], soa.y[1][index], soa.z[1][index] },
+					{ soa.x[2][index], soa.y[2][index], soa.z[2][index] },
+					sphere, { closestX[lane], closestY[lane], closestZ[lane] });
+			}
+			hitIndex[hitCount++] = uint32_t(index);
+		}
+
+	}
+#else
+	// SIMDが使えない場合は1つずつ判定する
+	for (size_t i = 0; i < soa.count; i++) {
+
+		// AABBで除外する
+		if (sphere.center.x - sphere.radius > soa.maxX[i] || sphere.center.x + sphere.radius < soa.minX[i] ||
+			sphere.center.y - sphere.radius > soa.maxY[i] || sphere.center.y + sphere.radius < soa.minY[i] ||
+			sphere.center.z - sphere.radius > soa.maxZ[i] || sphere.center.z + sphere.radius < soa.minZ[i]) {
+			continue;
+		}
+
+		Triangle triangle{};
+		for (uint32_t v = 0; v < 3; v++) {
+			triangle.vertex[v] = { soa.x[v][i], soa.y[v][i], soa.z[v][i] };
+		}
+		if (IsCollisionTriangle(triangle, sphere, contact != nullptr ? &contact[hitCount] : nullptr)) {
+			hitIndex[hitCount++] = uint32_t(i);
+		}
+
+	}
+#endif
+
+	return hitCount;
+
+}
+
+/// <summary>
+/// AABBの配列からSIMD処理用の配列を作成する関数
+/// </summary>
+/// <param name="aabbs">AABB配列</param>
+/// <param name="count">AABBの数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeAABBSoA(const AABB* aabbs, size_t count, AABBSoA& soa) {
+	MakeAABBSoAFrom(aabbs, count, soa, [](const AABB& aabb) { return aabb; });
+}
+
+/// <summary>
+/// 球の配列からAABBの配列を作成する関数
+/// </summary>
+/// <param name="spheres">球配列</param>
+/// <param name="count">球の数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeAABBSoA(const Sphere* spheres, size_t count, AABBSoA& soa) {
+	MakeAABBSoAFrom(spheres, count, soa, [](const Sphere& sphere) { return MakeAABB(sphere); });
+}
+
+/// <summary>
+/// 線分の配列からAABBの配列を作成する関数
+/// </summary>
+/// <param name="segments">線分配列</param>
+/// <param name="count">線分の数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeAABBSoA(const Segment* segments, size_t count, AABBSoA& soa) {
+	MakeAABBSoAFrom(segments, count, soa, [](const Segment& segment) { return MakeAABB(segment); });
+}
+
+/// <summary>
+/// 半直線の配列から媒介変数 maxT までで切ったAABBの配列を作成する関数
+/// </summary>
+/// <param name="rays">半直線配列</param>
+/// <param name="count">半直線の数</param>
+/// <param name="maxT">媒介変数の上限</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeAABBSoA(const Ray* rays, size_t count, float maxT, AABBSoA& soa) {
+	MakeAABBSoAFrom(rays, count, soa, [maxT](const Ray& ray) { return MakeAABB(ray, maxT); });
+}
+
+/// <summary>
+/// 三角形の配列からAABBの配列を作成する関数
+/// </summary>
+/// <param name="triangles">三角形配列</param>
+/// <param name="count">三角形の数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeAABBSoA(const Triangle* triangles, size_t count, AABBSoA& soa) {
+	MakeAABBSoAFrom(triangles, count, soa, [](const Triangle& triangle) { return MakeAABB(triangle); });
+}
+
+/// <summary>
+/// 1つのAABBと重なるAABBを配列からまとめて探す関数 (詳細な判定の前の除外用)
+/// 4個ずつSIMDで判定する
+/// </summary>
+/// <param name="aabb">AABB</param>
+/// <param name="soa">AABB配列</param>
+/// <param name="hitIndex">重なったAABBの番号の格納先 (soa.count 個分の領域が必要、番号の小さい順)</param>
+/// <returns>重なったAABBの数</returns>
+size_t MyCollision::IsCollisionAABBMany(const AABB& aabb, const AABBSoA& soa, uint32_t* hitIndex) {
+
+	MYPERF_SCOPE("MyCollision::IsCollisionAABBMany", soa.count);
+
+	size_t hitCount = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	const __m128 minX = _mm_set1_ps(aabb.min.x), minY = _mm_set1_ps(aabb.min.y), minZ = _mm_set1_ps(aabb.min.z);
+	const __m128 maxX = _mm_set1_ps(aabb.max.x), maxY = _mm_set1_ps(aabb.max.y), maxZ = _mm_set1_ps(aabb.max.z);
+
+	size_t paddedCount = soa.minX.size();
+	for (size_t i = 0; i < paddedCount; i += 4) {
+		// 全ての軸で範囲が重なっていれば衝突している
+		__m128 mask = _mm_and_ps(_mm_cmple_ps(minX, _mm_loadu_ps(&soa.maxX[i])), _mm_cmpge_ps(maxX, _mm_loadu_ps(&soa.minX[i])));
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmple_ps(minY, _mm_loadu_ps(&soa.maxY[i])), _mm_cmpge_ps(maxY, _mm_loadu_ps(&soa.minY[i]))));
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmple_ps(minZ, _mm_loadu_ps(&soa.maxZ[i])), _mm_cmpge_ps(maxZ, _mm_loadu_ps(&soa.minZ[i]))));
+
+		int hitMask = _mm_movemask_ps(mask);
+		if (hitMask != 0) {
+			hitCount = WriteHitIndex(uint32_t(hitMask), i, soa.count, hitIndex, hitCount);
+		}
+	}
+#else
+	// SIMDが使えない場合は1つずつ判定する
+	for (size_t i = 0; i < soa.count; i++) {
+		AABB other = { { soa.minX[i], soa.minY[i], soa.minZ[i] }, { soa.maxX[i], soa.maxY[i], soa.maxZ[i] } };
+		if (IsCollisionAABB(aabb, other)) {
+			hitIndex[hitCount++] = uint32_t(i);
+		}
+	}
+#endif
+
+	return hitCount;
+
+}
+
+/// <summary>
+/// 1つの線分と交差するAABBを配列からまとめて探す関数 (スラブ法、詳細な判定の前の除外用)
+/// 4個ずつSIMDで判定し、結果は IntersectAABB と一致する
+/// 半直線は媒介変数の上限を掛けた線分にして渡す
+/// </summary>
+/// <param name="segment">線分</param>
+/// <param name="soa">AABB配列</param>
+/// <param name="hitIndex">交差したAABBの番号の格納先 (soa.count 個分の領域が必要、番号の小さい順)</param>
+/// <returns>交差したAABBの数</returns>
+size_t MyCollision::IntersectAABBMany(const Segment& segment, const AABBSoA& soa, uint32_t* hitIndex) {
+
+	MYPERF_SCOPE("MyCollision::IntersectAABBMany", soa.count);
+
+	size_t hitCount = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	const float origin[3] = { segment.origin.x, segment.origin.y, segment.origin.z };
+	const float diff[3] = { segment.diff.x, segment.diff.y, segment.diff.z };
+	const float* min[3] = { soa.minX.data(), soa.minY.data(), soa.minZ.data() };
+	const float* max[3] = { soa.maxX.data(), soa.maxY.data(), soa.maxZ.data() };
+
+	// 軸ごとの値は全ての要素で共通なので先に求めておく
+	__m128 originLane[3], inverseLane[3];
+	bool isParallel[3];
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		isParallel[axis] = diff[axis] == 0.0f;
+		originLane[axis] = _mm_set1_ps(origin[axis]);
+		inverseLane[axis] = _mm_set1_ps(isParallel[axis] ? 0.0f : 1.0f / diff[axis]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 allTrue = _mm_cmpeq_ps(zero, zero);
+
+	size_t paddedCount = soa.minX.size();
+	for (size_t i = 0; i < paddedCount; i += 4) {
+		__m128 tEnter = zero;
+		__m128 tExit = one;
+		__m128 mask = allTrue;
+
+		// 軸ごとに2枚の平面で挟まれた区間を求めて重ねる
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			__m128 minLane = _mm_loadu_ps(min[axis] + i);
+			__m128 maxLane = _mm_loadu_ps(max[axis] + i);
+			if (isParallel[axis]) {
+				// 軸に平行な場合は始点が範囲内になければ交差しない
+				mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(originLane[axis], minLane), _mm_cmple_ps(originLane[axis], maxLane)));
+				continue;
+			}
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(minLane, originLane[axis]), inverseLane[axis]);
+			__m128 t2 = _mm_mul_ps(_mm_sub_ps(maxLane, originLane[axis]), inverseLane[axis]);
+			tEnter = _mm_max_ps(tEnter, _mm_min_ps(t1, t2));
+			tExit = _mm_min_ps(tExit, _mm_max_ps(t1, t2));
+		}
+		mask = _mm_and_ps(mask, _mm_cmple_ps(tEnter, tExit));
+
+		int hitMask = _mm_movemask_ps(mask);
+		if (hitMask != 0) {
+			hitCount = WriteHitIndex(uint32_t(hitMask), i, soa.count, hitIndex, hitCount);
+		}
+	}
+#else
+	// SIMDが使えない場合は1つずつ判定する
+	for (size_t i = 0; i < soa.count; i++) {
+		AABB aabb = { { soa.minX[i], soa.minY[i], soa.minZ[i] }, { soa.maxX[i], soa.maxY[i], soa.maxZ[i] } };
+		float tEnter, tExit;
+		if (IntersectAABB(segment, aabb, tEnter, tExit)) {
+			hitIndex[hitCount++] = uint32_t(i);
+		}
+	}
+#endif
+
+	return hitCount;
+
+}
+
+/// <summary>
+/// 球の配列からSIMD処理用の配列を作成する関数
+/// </summary>
+/// <param name="spheres">球配列</param>
+/// <param name="count">球の数</param>
+/// <param name="soa">作成先</param>
+void MyCollision::MakeSphereSoA(const Sphere* spheres, size_t count, SphereSoA& soa) {
+
+	// 4の倍数に切り上げる (余りの要素は番号で除外する)
+	size_t paddedCount = (count + 3) & ~size_t(3);
+	soa.count = count;
+	soa.x.assign(paddedCount, 0.0f);
+	soa.y.assign(paddedCount, 0.0f);
+	soa.z.assign(paddedCount, 0.0f);
+	soa.radius.assign(paddedCount, 0.0f);
+
+	for (size_t i = 0; i < count; i++) {
+		soa.x[i] = spheres[i].center.x;
+		soa.y[i] = spheres[i].center.y;
+		soa.z[i] = spheres[i].center.z;
+		soa.radius[i] = spheres[i].radius;
+	}
+
+}
+
+/// <summary>
+/// 1つの半直線が複数の球と最も手前で交わる点を求める関数
+/// 4個ずつSIMDで判定し、各球の交点は IntersectLine と一致する
+/// </summary>
+/// <param name="r">半直線</param>
+/// <param name="soa">球配列</param>
+/// <param name="maxT">判定する媒介変数の上限</param>
+/// <param name="t">交点の媒介変数の格納先</param>
+/// <param name="hitIndex">交わった球の番号の格納先 (同じ距離なら番号の小さい方)</param>
+/// <returns>交わったか</returns>
+bool MyCollision::IntersectLineMany(const Ray& r, const SphereSoA& soa, float maxT, float& t, uint32_t& hitIndex) {
+
+	float a = MyMath::Dot(r.diff, r.diff);
+	if (a == 0.0f) {
+		return false;
+	}
+
+#ifdef MYMATH_SIMD_SSE
+	const __m128 ox = _mm_set1_ps(r.origin.x), oy = _mm_set1_ps(r.origin.y), oz = _mm_set1_ps(r.origin.z);
+	const __m128 dx = _mm_set1_ps(r.diff.x), dy = _mm_set1_ps(r.diff.y), dz = _mm_set1_ps(r.diff.z);
+	const __m128 aLane = _mm_set1_ps(a);
+	const __m128 maxTLane = _mm_set1_ps(maxT);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128i laneOffset = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i countLane = _mm_set1_epi32(int32_t(soa.count));
+
+	// 要素ごとに最も手前の交点を残す
+	__m128 bestT = _mm_set1_ps(INFINITY);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+
+	size_t paddedCount = soa.x.size();
+	for (size_t i = 0; i < paddedCount; i += 4) {
+		__m128i index = _mm_add_epi32(_mm_set1_epi32(int32_t(i)), laneOffset);
+		__m128 radius = _mm_loadu_ps(&soa.radius[i]);
+
+		// |origin + t * diff - center| = radius を t について解く
+		__m128 offsetX = _mm_sub_ps(ox, _mm_loadu_ps(&soa.x[i]));
+		__m128 offsetY = _mm_sub_ps(oy, _mm_loadu_ps(&soa.y[i]));
+		__m128 offsetZ = _mm_sub_ps(oz, _mm_loadu_ps(&soa.z[i]));
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, dx), _mm_mul_ps(offsetY, dy)), _mm_mul_ps(offsetZ, dz));
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ)), _mm_mul_ps(radius, radius));
+		__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(aLane, c));
+
+		// 手前の解が始点より後ろなら奥の解を使う
+		__m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+		__m128 negativeB = _mm_xor_ps(b, signBit);
+		__m128 tNear = _mm_div_ps(_mm_sub_ps(negativeB, root), aLane);
+		__m128 tFar = _mm_div_ps(_mm_add_ps(negativeB, root), aLane);
+		__m128 isBehind = _mm_cmplt_ps(tNear, zero);
+		__m128 tHit = _mm_or_ps(_mm_and_ps(isBehind, tFar), _mm_andnot_ps(isBehind, tNear));
+
+		__m128 mask = _mm_castsi128_ps(_mm_cmplt_epi32(index, countLane));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(discriminant, zero));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(tHit, zero));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(tHit, maxTLane));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(tHit, bestT));
+		if (_mm_movemask_ps(mask) == 0) {
+			continue;
+		}
+
+		bestT = _mm_or_ps(_mm_and_ps(mask, tHit), _mm_andnot_ps(mask, bestT));
+		__m128i maskInt = _mm_castps_si128(mask);
+		bestIndex = _mm_or_si128(_mm_and_si128(maskInt, index), _mm_andnot_si128(maskInt, bestIndex));
+	}
+
+	return SelectClosest(bestT, bestIndex, t, hitIndex);
+#else
+	// SIMDが使えない場合は1つずつ判定する
+	bool isHit = false;
+	for (size_t i = 0; i < soa.count; i++) {
+		HitInfo info;
+		Sphere sphere = { { soa.x[i], soa.y[i], soa.z[i] }, soa.radius[i] };
+		if (IntersectLine(r, sphere, &info) && info.t <= maxT && (!isHit || info.t < t)) {
+			t = info.t;
+			hitIndex = uint32_t(i);
+			isHit = true;
+		}
+	}
+	return isHit;
+#endif
+
+}
+
+/// <summary>
+/// 1つの半直線が複数の三角形と最も手前で交わる点を求める関数 (Moller-Trumbore)
+/// 4個ずつSIMDで判定し、各三角形の交点は IntersectLine と一致する
+/// </summary>
+/// <param name="r">半直線</param>
+/// <param name="soa">三角形配列</param>
+/// <param name="maxT">判定する媒介変数の上限</param>
+/// <param name="t">交点の媒介変数の格納先</param>
+/// <param name="hitIndex">交わった三角形の番号の格納先 (同じ距離なら番号の小さい方)</param>
+/// <returns>交わったか</returns>
+bool MyCollision::IntersectLineMany(const Ray& r, const TriangleSoA& soa, float maxT, float& t, uint32_t& hitIndex) {
+
+#ifdef MYMATH_SIMD_SSE
+	const __m128 ox = _mm_set1_ps(r.origin.x), oy = _mm_set1_ps(r.origin.y), oz = _mm_set1_ps(r.origin.z);
+	const __m128 dx = _mm_set1_ps(r.diff.x), dy = _mm_set1_ps(r.diff.y), dz = _mm_set1_ps(r.diff.z);
+	const __m128 maxTLane = _mm_set1_ps(maxT);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i laneOffset = _mm_setr_epi32(0, 1, 2, 3);
+
+	// 2つのベクトルの内積と外積 (MyMath::Dot、MyMath::Cross と同じ順で計算する)
+	auto dot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	};
+	auto cross = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz, __m128 result[3]) {
+		result[0] = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+		result[1] = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+		result[2] = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+	};
+
+	// 要素ごとに最も手前の交点を残す
+	__m128 bestT = _mm_set1_ps(INFINITY);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+
+	// 余りの要素は全ての頂点が0の三角形なので det が0になり除外される
+	size_t paddedCount = soa.x[0].size();
+	for (size_t i = 0; i < paddedCount; i += 4) {
+		__m128 ax = _mm_loadu_ps(&soa.x[0][i]), ay = _mm_loadu_ps(&soa.y[0][i]), az = _mm_loadu_ps(&soa.z[0][i]);
+		__m128 edge1X = _mm_sub_ps(_mm_loadu_ps(&soa.x[1][i]), ax);
+		__m128 edge1Y = _mm_sub_ps(_mm_loadu_ps(&soa.y[1][i]), ay);
+		__m128 edge1Z = _mm_sub_ps(_mm_loadu_ps(&soa.z[1][i]), az);
+		__m128 edge2X = _mm_sub_ps(_mm_loadu_ps(&soa.x[2][i]), ax);
+		__m128 edge2Y = _mm_sub_ps(_mm_loadu_ps(&soa.y[2][i]), ay);
+		__m128 edge2Z = _mm_sub_ps(_mm_loadu_ps(&soa.z[2][i]), az);
+
+		// 半直線が三角形と平行なら交差していない
+		__m128 p[3];
+		cross(dx, dy, dz, edge2X, edge2Y, edge2Z, p);
+		__m128 det = dot(edge1X, edge1Y, edge1Z, p[0], p[1], p[2]);
+		__m128 mask = _mm_cmpneq_ps(det, zero);
+		if (_mm_movemask_ps(mask) == 0) {
+			continue;
+		}
+		__m128 inverseDet = _mm_div_ps(one, det);
+
+		// 重心座標 u, v が三角形の内側にあるか
+		__m128 sx = _mm_sub_ps(ox, ax), sy = _mm_sub_ps(oy, ay), sz = _mm_sub_ps(oz, az);
+		__m128 u = _mm_mul_ps(dot(sx, sy, sz, p[0], p[1], p[2]), inverseDet);
+		__m128 q[3];
+		cross(sx, sy, sz, edge1X, edge1Y, edge1Z, q);
+		__m128 v = _mm_mul_ps(dot(dx, dy, dz, q[0], q[1], q[2]), inverseDet);
+		__m128 tHit = _mm_mul_ps(dot(edge2X, edge2Y, edge2Z, q[0], q[1], q[2]), inverseDet);
+
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(tHit, zero), _mm_cmple_ps(tHit, maxTLane)));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(tHit, bestT));
+		if (_mm_movemask_ps(mask) == 0) {
+			continue;
+		}
+
+		__m128i index = _mm_add_epi32(_mm_set1_epi32(int32_t(i)), laneOffset);
+		bestT = _mm_or_ps(_mm_and_ps(mask, tHit), _mm_andnot_ps(mask, bestT));
+		__m128i maskInt = _mm_castps_si128(mask);
+		bestIndex = _mm_or_si128(_mm_and_si128(maskInt, index), _mm_andnot_si128(maskInt, bestIndex));
+	}
+
+	return SelectClosest(bestT, bestIndex, t, hitIndex);
+#else
+	// SIMDが使えない場合は1つずつ判定する
+	bool isHit = false;
+	for (size_t i = 0; i < soa.count; i++) {
+		Triangle triangle{};
+		for (uint32_t v = 0; v < 3; v++) {
+			triangle.vertex[v] = { soa.x[v][i], soa.y[v][i], soa.z[v][i] };
+		}
+		HitInfo info;
+		if (IntersectLine(r, triangle, &info) && info.t <= maxT && (!isHit || info.t < t)) {
+			t = info.t;
+			hitIndex = uint32_t(i);
+			isHit = true;
+		}
+	}
+	return isHit;
+#endif
 
 }
\ No newline at end of file
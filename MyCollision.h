@@ -1,8 +1,59 @@
 ﻿#pragma once
+#include <vector>
 #include "MyConst.h"
 #include "MyStruct.h"
 #include "MyMath.h"
 
+/// <summary>
+/// 接触情報構造体
+/// </summary>
+struct Contact {
+	Vector3 point; // 接触点
+	Vector3 normal; // 押し出す向きの法線
+	float depth; // めり込み量
+};
+
+/// <summary>
+/// 直線、半直線、線分の交差情報構造体
+/// </summary>
+struct HitInfo {
+	float t; // 交点の媒介変数 (origin + t * diff)
+	Vector3 point; // 交点
+	Vector3 normal; // 交差した面の法線
+};
+
+/// <summary>
+/// 三角形の配列を成分ごとに並べた構造体 (SIMD処理用)
+/// 要素数は4の倍数に切り上げられ、余りは必ず判定に失敗する三角形で埋められる
+/// </summary>
+struct TriangleSoA {
+	std::vector<float> x[3], y[3], z[3]; // 各頂点の座標
+	std::vector<float> minX, minY, minZ; // AABBの最小座標
+	std::vector<float> maxX, maxY, maxZ; // AABBの最大座標
+	size_t count; // 三角形の数 (切り上げ前)
+};
+
+/// <summary>
+/// AABBの配列を成分ごとに並べた構造体 (SIMD処理用)
+/// プリミティブのAABBを前もって求めておき、詳細な判定の前の除外に使う
+/// 要素数は4の倍数に切り上げられ、余りは最小が最大より大きいAABBで埋められる
+/// </summary>
+struct AABBSoA {
+	std::vector<float> minX, minY, minZ; // 最小座標
+	std::vector<float> maxX, maxY, maxZ; // 最大座標
+	size_t count; // AABBの数 (切り上げ前)
+};
+
+/// <summary>
+/// 球の配列を成分ごとに並べた構造体 (SIMD処理用)
+/// 要素数は4の倍数に切り上げられ、余りの要素は判定されない
+/// </summary>
+struct SphereSoA {
+	std::vector<float> x, y, z; // 中心座標
+	std::vector<float> radius; // 半径
+	size_t count; // 球の数 (切り上げ前)
+};
+
 /// <summary>
 /// 当たり判定を行う関数を保持するクラス
 /// </summary>
@@ -50,13 +101,243 @@ public:
 	/// <returns>衝突しているか</returns>
 	static bool IsCollisionLine(const Segment& s, const Plane& p);
 
+	/// <summary>
+	/// 直線と平面の交点を求める関数
+	/// </summary>
+	/// <param name="l">直線</param>
+	/// <param name="p">平面</param>
+	/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectLine(const Line& l, const Plane& p, HitInfo* hit = nullptr);
+
+	/// <summary>
+	/// 半直線と平面の交点を求める関数
+	/// </summary>
+	/// <param name="r">半直線</param>
+	/// <param name="p">平面</param>
+	/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectLine(const Ray& r, const Plane& p, HitInfo* hit = nullptr);
+
+	/// <summary>
+	/// 線分と平面の交点を求める関数
+	/// </summary>
+	/// <param name="s">線分</param>
+	/// <param name="p">平面</param>
+	/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectLine(const Segment& s, const Plane& p, HitInfo* hit = nullptr);
+
+	/// <summary>
+	/// 半直線と球の交点を求める関数
+	/// 始点が球の内側にある場合は球から出る点を返す
+	/// </summary>
+	/// <param name="r">半直線</param>
+	/// <param name="sphere">球</param>
+	/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectLine(const Ray& r, const Sphere& sphere, HitInfo* hit = nullptr);
+
+	/// <summary>
+	/// 半直線と三角形の交点を求める関数 (Moller-Trumbore)
+	/// 法線は半直線と向かい合う向きで返す
+	/// </summary>
+	/// <param name="r">半直線</param>
+	/// <param name="triangle">三角形</param>
+	/// <param name="hit">交差情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectLine(const Ray& r, const Triangle& triangle, HitInfo* hit = nullptr);
+
+	/// <summary>
+	/// 線分が複数の平面で囲まれた凸領域に入る区間を求める関数 (Cyrus-Beck)
+	/// 各平面の法線の向きが外側で、Dot(normal, x) <= distance が内側になる
+	/// 平面は4枚ずつSIMDでまとめて処理する
+	/// </summary>
+	/// <param name="s">線分</param>
+	/// <param name="planes">平面配列</param>
+	/// <param name="count">平面の数</param>
+	/// <param name="tEnter">領域に入る媒介変数の格納先</param>
+	/// <param name="tExit">領域から出る媒介変数の格納先</param>
+	/// <returns>線分が領域と重なっているか</returns>
+	static bool IntersectConvex(const Segment& s, const Plane* planes, size_t count, float& tEnter, float& tExit);
+
 	/// <summary>
 	/// 三角形と線分の当たり判定
+	/// 向きの判定に MyPredicate を使うので、辺や頂点をかすめる線分も正しく判定する (辺上も衝突とする)
 	/// </summary>
 	/// <param name="t">三角形</param>
 	/// <param name="s">線分</param>
 	/// <returns>衝突しているか</returns>
 	static bool IsCollisionTriangle(const Triangle& t, const Segment& s);
 
+	/// <summary>
+	/// 三角形と球の当たり判定
+	/// </summary>
+	/// <param name="triangle">三角形</param>
+	/// <param name="sphere">球</param>
+	/// <param name="contact">接触情報の格納先 (nullptrなら求めない)</param>
+	/// <returns>衝突しているか</returns>
+	static bool IsCollisionTriangle(const Triangle& triangle, const Sphere& sphere, Contact* contact = nullptr);
+
+	/// <summary>
+	/// AABB同士の当たり判定
+	/// </summary>
+	/// <param name="a">AABB1</param>
+	/// <param name="b">AABB2</param>
+	/// <returns>衝突しているか</returns>
+	static bool IsCollisionAABB(const AABB& a, const AABB& b);
+
+	/// <summary>
+	/// 線分とAABBの交差区間を求める関数 (スラブ法)
+	/// </summary>
+	/// <param name="s">線分</param>
+	/// <param name="aabb">AABB</param>
+	/// <param name="tEnter">AABBに入る媒介変数の格納先</param>
+	/// <param name="tExit">AABBから出る媒介変数の格納先</param>
+	/// <returns>交差しているか</returns>
+	static bool IntersectAABB(const Segment& s, const AABB& aabb, float& tEnter, float& tExit);
+
+	/// <summary>
+	/// 球を囲むAABBを求める関数
+	/// </summary>
+	/// <param name="sphere">球</param>
+	/// <returns>AABB</returns>
+	static AABB MakeAABB(const Sphere& sphere);
+
+	/// <summary>
+	/// 線分を囲むAABBを求める関数
+	/// </summary>
+	/// <param name="segment">線分</param>
+	/// <returns>AABB</returns>
+	static AABB MakeAABB(const Segment& segment);
+
+	/// <summary>
+	/// 三角形を囲むAABBを求める関数
+	/// </summary>
+	/// <param name="triangle">三角形</param>
+	/// <returns>AABB</returns>
+	static AABB MakeAABB(const Triangle& triangle);
+
+	/// <summary>
+	/// 半直線を媒介変数 maxT までで切った部分を囲むAABBを求める関数
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <param name="maxT">媒介変数の上限</param>
+	/// <returns>AABB</returns>
+	static AABB MakeAABB(const Ray& ray, float maxT);
+
+	/// <summary>
+	/// 三角形の配列からSIMD処理用の配列を作成する関数
+	/// </summary>
+	/// <param name="triangles">三角形配列</param>
+	/// <param name="count">三角形の数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeTriangleSoA(const Triangle* triangles, size_t count, TriangleSoA& soa);
+
+	/// <summary>
+	/// 1つの球と複数の三角形の当たり判定をまとめてとる関数
+	/// AABBで先に除外し、残ったものを4個ずつSIMDで判定する
+	/// </summary>
+	/// <param name="sphere">球</param>
+	/// <param name="soa">三角形配列</param>
+	/// <param name="hitIndex">衝突した三角形の番号の格納先 (soa.count 個分の領域が必要)</param>
+	/// <param name="contact">接触情報の格納先 (nullptrなら求めない、soa.count 個分の領域が必要)</param>
+	/// <returns>衝突した三角形の数</returns>
+	static size_t IsCollisionTriangleMany(const Sphere& sphere, const TriangleSoA& soa, uint32_t* hitIndex, Contact* contact = nullptr);
+
+	/// <summary>
+	/// AABBの配列からSIMD処理用の配列を作成する関数
+	/// </summary>
+	/// <param name="aabbs">AABB配列</param>
+	/// <param name="count">AABBの数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeAABBSoA(const AABB* aabbs, size_t count, AABBSoA& soa);
+
+	/// <summary>
+	/// 球の配列からAABBの配列を作成する関数
+	/// </summary>
+	/// <param name="spheres">球配列</param>
+	/// <param name="count">球の数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeAABBSoA(const Sphere* spheres, size_t count, AABBSoA& soa);
+
+	/// <summary>
+	/// 線分の配列からAABBの配列を作成する関数
+	/// </summary>
+	/// <param name="segments">線分配列</param>
+	/// <param name="count">線分の数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeAABBSoA(const Segment* segments, size_t count, AABBSoA& soa);
+
+	/// <summary>
+	/// 半直線の配列から媒介変数 maxT までで切ったAABBの配列を作成する関数
+	/// </summary>
+	/// <param name="rays">半直線配列</param>
+	/// <param name="count">半直線の数</param>
+	/// <param name="maxT">媒介変数の上限</param>
+	/// <param name="soa">作成先</param>
+	static void MakeAABBSoA(const Ray* rays, size_t count, float maxT, AABBSoA& soa);
+
+	/// <summary>
+	/// 三角形の配列からAABBの配列を作成する関数
+	/// </summary>
+	/// <param name="triangles">三角形配列</param>
+	/// <param name="count">三角形の数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeAABBSoA(const Triangle* triangles, size_t count, AABBSoA& soa);
+
+	/// <summary>
+	/// 1つのAABBと重なるAABBを配列からまとめて探す関数 (詳細な判定の前の除外用)
+	/// 4個ずつSIMDで判定する
+	/// </summary>
+	/// <param name="aabb">AABB</param>
+	/// <param name="soa">AABB配列</param>
+	/// <param name="hitIndex">重なったAABBの番号の格納先 (soa.count 個分の領域が必要、番号の小さい順)</param>
+	/// <returns>重なったAABBの数</returns>
+	static size_t IsCollisionAABBMany(const AABB& aabb, const AABBSoA& soa, uint32_t* hitIndex);
+
+	/// <summary>
+	/// 1つの線分と交差するAABBを配列からまとめて探す関数 (スラブ法、詳細な判定の前の除外用)
+	/// 4個ずつSIMDで判定し、結果は IntersectAABB と一致する
+	/// 半直線は媒介変数の上限を掛けた線分にして渡す
+	/// </summary>
+	/// <param name="segment">線分</param>
+	/// <param name="soa">AABB配列</param>
+	/// <param name="hitIndex">交差したAABBの番号の格納先 (soa.count 個分の領域が必要、番号の小さい順)</param>
+	/// <returns>交差したAABBの数</returns>
+	static size_t IntersectAABBMany(const Segment& segment, const AABBSoA& soa, uint32_t* hitIndex);
+
+	/// <summary>
+	/// 球の配列からSIMD処理用の配列を作成する関数
+	/// </summary>
+	/// <param name="spheres">球配列</param>
+	/// <param name="count">球の数</param>
+	/// <param name="soa">作成先</param>
+	static void MakeSphereSoA(const Sphere* spheres, size_t count, SphereSoA& soa);
+
+	/// <summary>
+	/// 1つの半直線が複数の球と最も手前で交わる点を求める関数
+	/// 4個ずつSIMDで判定し、各球の交点は IntersectLine と一致する
+	/// </summary>
+	/// <param name="r">半直線</param>
+	/// <param name="soa">球配列</param>
+	/// <param name="maxT">判定する媒介変数の上限</param>
+	/// <param name="t">交点の媒介変数の格納先</param>
+	/// <param name="hitIndex">交わった球の番号の格納先 (同じ距離なら番号の小さい方)</param>
+	/// <returns>交わったか</returns>
+	static bool IntersectLineMany(const Ray& r, const SphereSoA& soa, float maxT, float& t, uint32_t& hitIndex);
+
+	/// <summary>
+	/// 1つの半直線が複数の三角形と最も手前で交わる点を求める関数 (Moller-Trumbore)
+	/// 4個ずつSIMDで判定し、各三角形の交点は IntersectLine と一致する
+	/// </summary>
+	/// <param name="r">半直線</param>
+	/// <param name="soa">三角形配列</param>
+	/// <param name="maxT">判定する媒介変数の上限</param>
+	/// <param name="t">交点の媒介変数の格納先</param>
+	/// <param name="hitIndex">交わった三角形の番号の格納先 (同じ距離なら番号の小さい方)</param>
+	/// <returns>交わったか</returns>
+	static bool IntersectLineMany(const Ray& r, const TriangleSoA& soa, float maxT, float& t, uint32_t& hitIndex);
+
 };
 
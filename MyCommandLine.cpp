@@ -0,0 +1,260 @@
+﻿#include "MyCommandLine.h"
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MyCollision.h"
+#include "MyConst.h"
+#include "MyDebug.h"
+#include "MyMortonOrder.h"
+#include "MyPerfCounter.h"
+#include "MyQueryClient.h"
+#include "MyQueryServer.h"
+#include "MySelfTest.h"
+#include "MySegmentStream.h"
+#include "MySoftwareRasterizer.h"
+
+/// <summary>
+/// コマンドラインで指定された処理があれば実行する関数
+/// 形式:
+///   -segmentquery 三角形ファイル 線分ファイル 出力ファイル [スレッド数]
+///   -selftest
+///   -render 出力ファイル [幅 高さ]
+///   -querybench [線分の数 1回の要求の線分の数 スレッド数]
+///   -mortonbench [球の数 判定する球の数]
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+/// <returns>処理が指定されていたか (false ならウィンドウを開く)</returns>
+bool MyCommandLine::Run(const char* commandLine, int& exitCode) {
+
+	return MySegmentStream::RunCommandLine(commandLine, exitCode) ||
+		MySelfTest::RunCommandLine(commandLine, exitCode) ||
+		RunRender(commandLine, exitCode) ||
+		RunQueryBenchmark(commandLine, exitCode) ||
+		RunMortonBenchmark(commandLine, exitCode);
+
+}
+
+/// <summary>
+/// 確認用の場面を CPU で描画してPPM形式で書き出す関数
+/// 形式: -render 出力ファイル [幅 高さ]
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+/// <returns>描画が指定されていたか</returns>
+bool MyCommandLine::RunRender(const char* commandLine, int& exitCode) {
+
+	const uint32_t kBackgroundColor = 0x000000FF;
+	const uint32_t kWhite = 0xFFFFFFFF;
+	const uint32_t kRed = 0xFF0000FF;
+
+	if (commandLine == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(commandLine);
+	std::string command;
+	if (!(stream >> command) || command != "-render") {
+		return false;
+	}
+
+	std::string outputPath;
+	int width = kWindowWidth;
+	int height = kWindowHeight;
+	if (!(stream >> outputPath)) {
+		std::fprintf(stderr, "usage: -render <output.ppm> [width height]\n");
+		exitCode = 1;
+		return true;
+	}
+	if (stream >> width >> height) {
+		if (width <= 0 || height <= 0) {
+			std::fprintf(stderr, "invalid size: %d x %d\n", width, height);
+			exitCode = 1;
+			return true;
+		}
+	}
+	else {
+		width = kWindowWidth;
+		height = kWindowHeight;
+	}
+
+	// ウィンドウ表示の初期状態と同じ場面の行列を作る
+	Matrix4x4 cameraMatrix = MyMath::MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, kInitialCameraRotate, kInitialCameraTranslate);
+	Matrix4x4 viewMatrix = MyMath::Inverse(cameraMatrix);
+	Matrix4x4 projectionMatrix = MyMath::MakePerspectiveFovMatrix(0.45f, float(width) / float(height), 0.1f, 100.0f);
+	Matrix4x4 viewProjectionMatrix = MyMath::Multiply(viewMatrix, projectionMatrix);
+	Matrix4x4 viewPortMatrix = MyMath::MakeViewPortMatrix(0, 0, float(width), float(height), 0.0f, 1.0f);
+
+	// グリッド、三角形、線分 (衝突していれば赤) の描画命令を作る
+	DrawCommandList list;
+	uint32_t segmentColor = MyCollision::IsCollisionTriangle(kInitialTriangle, kInitialSegment) ? kRed : kWhite;
+	MyDebug::DrawGrid(viewProjectionMatrix, viewPortMatrix, list);
+	MyDebug::DrawTriangle(kInitialTriangle, viewProjectionMatrix, viewPortMatrix, kWhite, list);
+	MyDebug::DrawSegment(kInitialSegment, viewProjectionMatrix, viewPortMatrix, segmentColor, list);
+
+	// CPU で描画して書き出す
+	MySoftwareRasterizer rasterizer;
+	rasterizer.Initialize(width, height);
+	rasterizer.Clear(kBackgroundColor);
+	rasterizer.Submit(list);
+	if (!rasterizer.SavePPM(outputPath.c_str())) {
+		std::fprintf(stderr, "failed to write: %s\n", outputPath.c_str());
+		exitCode = 1;
+		return true;
+	}
+
+	std::fprintf(stderr, "rendered %zu commands to %s (%d x %d)\n", list.size(), outputPath.c_str(), width, height);
+	exitCode = 0;
+	return true;
+
+}
+
+/// <summary>
+/// 問い合わせサーバーを同じプロセスで起動し、ローカルのクライアントから処理速度を測定する関数
+/// 応答を待たずに送る要求の数を 1 から kMaxPendingQueryRequest まで変えて測る
+/// 形式: -querybench [線分の数 1回の要求の線分の数 スレッド数]
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+/// <returns>測定が指定されていたか</returns>
+bool MyCommandLine::RunQueryBenchmark(const char* commandLine, int& exitCode) {
+
+	const char* kSocketPath = "querybench.sock";
+	const uint32_t kTriangleCount = 1024;
+
+	if (commandLine == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(commandLine);
+	std::string command;
+	if (!(stream >> command) || command != "-querybench") {
+		return false;
+	}
+
+	size_t segmentCount = 50000;
+	uint32_t batchSize = 1024;
+	uint32_t workerCount = 0;
+	stream >> segmentCount >> batchSize >> workerCount;
+
+	// 一辺 20 の立方体の中に小さな三角形と線分を散らばらせる
+	std::mt19937 random(5489);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+	std::vector<Triangle> triangles(kTriangleCount);
+	for (Triangle& triangle : triangles) {
+		Vector3 center = { position(random), position(random), position(random) };
+		for (Vector3& vertex : triangle.vertex) {
+			vertex = center + Vector3{ offset(random), offset(random), offset(random) };
+		}
+	}
+	std::vector<Segment> segments(segmentCount);
+	for (Segment& segment : segments) {
+		segment.origin = { position(random), position(random), position(random) };
+		segment.diff = { offset(random) * 4.0f, offset(random) * 4.0f, offset(random) * 4.0f };
+	}
+
+	MyQueryServer server;
+	RaycastScene scene = { nullptr, 0, nullptr, 0, triangles.data(), triangles.size(), nullptr };
+	if (!server.Start(kSocketPath, scene, workerCount)) {
+		std::fprintf(stderr, "failed to start server: %s\n", kSocketPath);
+		exitCode = 1;
+		return true;
+	}
+
+	std::fprintf(stderr, "segments: %zu batch: %u triangles: %u\n", segmentCount, batchSize, kTriangleCount);
+	exitCode = 0;
+	for (uint32_t depth = 1; depth <= kMaxPendingQueryRequest; depth *= 2) {
+		QueryBenchmarkResult result;
+		if (!MyQueryClient::Benchmark(kSocketPath, segments.data(), segments.size(), batchSize, depth, result)) {
+			std::fprintf(stderr, "depth %2u: failed\n", depth);
+			exitCode = 1;
+			break;
+		}
+		std::fprintf(stderr, "depth %2u: %8.3f s %12.0f queries/s %10.0f requests/s\n",
+			depth, result.seconds, result.queriesPerSecond, result.requestsPerSecond);
+	}
+
+	server.Stop();
+	return true;
+
+}
+
+/// <summary>
+/// 球配列を渡された順序のままと Z順序に並べ替えた場合で、AABB木を使った判定の速度を比べる関数
+/// MyMortonOrder::Benchmark の結果と MyPerfCounter の集計を表示する
+/// 形式: -mortonbench [球の数 判定する球の数]
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+/// <returns>測定が指定されていたか</returns>
+bool MyCommandLine::RunMortonBenchmark(const char* commandLine, int& exitCode) {
+
+	if (commandLine == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(commandLine);
+	std::string command;
+	if (!(stream >> command) || command != "-mortonbench") {
+		return false;
+	}
+
+	size_t sphereCount = 100000;
+	size_t queryCount = 100000;
+	stream >> sphereCount >> queryCount;
+	if (sphereCount == 0) {
+		std::fprintf(stderr, "usage: -mortonbench [spheres queries]\n");
+		exitCode = 1;
+		return true;
+	}
+
+	// 生成した順序が空間的に近くならないように、一辺 600 の立方体の中に球を散らばらせる
+	std::mt19937 random(5489);
+	std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+	std::vector<Sphere> spheres(sphereCount);
+	for (Sphere& sphere : spheres) {
+		sphere = { { position(random), position(random), position(random) }, 2.0f };
+	}
+
+	MyPerfCounter::Reset();
+	MortonBenchmarkResult result;
+	MyMortonOrder::Benchmark(spheres.data(), spheres.size(), queryCount, result);
+
+	std::fprintf(stderr, "spheres: %zu queries: %zu hits: %llu\n", sphereCount, queryCount, static_cast<unsigned long long>(result.hitCount));
+	std::fprintf(stderr, "authoring: %8.3f s\n", result.authoringSeconds);
+	std::fprintf(stderr, "morton:    %8.3f s (%.2fx)\n", result.mortonSeconds, result.mortonSeconds > 0.0 ? result.authoringSeconds / result.mortonSeconds : 0.0);
+	std::fprintf(stderr, "%s", MyPerfCounter::MakeReport().c_str());
+
+	exitCode = 0;
+	return true;
+
+}
+
+#ifndef _WIN32
+
+// Windows 以外 (ウィンドウのないサーバーなど) でのエントリーポイント
+// コマンドラインで指定された処理だけを実行する
+int main(int argc, char* argv[]) {
+
+	// 引数を WinMain と同じ1つの文字列にまとめる
+	std::string commandLine;
+	for (int i = 1; i < argc; i++) {
+		if (i > 1) {
+			commandLine += ' ';
+		}
+		commandLine += argv[i];
+	}
+
+	int exitCode = 0;
+	if (!MyCommandLine::Run(commandLine.c_str(), exitCode)) {
+		std::fprintf(stderr, "usage: -segmentquery ... | -selftest | -render <output.ppm> [width height] | -querybench [segments batch workers] | -mortonbench [spheres queries]\n");
+		return 1;
+	}
+	return exitCode;
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+/// <summary>
+/// ウィンドウを開かずに実行する処理をコマンドラインから選ぶクラス
+/// WinMain と、Windows 以外の環境でのエントリーポイント (main) の両方から呼ばれる
+/// </summary>
+class MyCommandLine
+{
+public:
+
+	/// <summary>
+	/// コマンドラインで指定された処理があれば実行する関数
+	/// 形式:
+	///   -segmentquery 三角形ファイル 線分ファイル 出力ファイル [スレッド数]
+	///   -selftest
+	///   -render 出力ファイル [幅 高さ]
+	///   -querybench [線分の数 1回の要求の線分の数 スレッド数]
+	///   -mortonbench [球の数 判定する球の数]
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+	/// <returns>処理が指定されていたか (false ならウィンドウを開く)</returns>
+	static bool Run(const char* commandLine, int& exitCode);
+
+	/// <summary>
+	/// 確認用の場面を CPU で描画してPPM形式で書き出す関数
+	/// 形式: -render 出力ファイル [幅 高さ]
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+	/// <returns>描画が指定されていたか</returns>
+	static bool RunRender(const char* commandLine, int& exitCode);
+
+	/// <summary>
+	/// 問い合わせサーバーを同じプロセスで起動し、ローカルのクライアントから処理速度を測定する関数
+	/// 応答を待たずに送る要求の数を 1 から kMaxPendingQueryRequest まで変えて測る
+	/// 形式: -querybench [線分の数 1回の要求の線分の数 スレッド数]
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+	/// <returns>測定が指定されていたか</returns>
+	static bool RunQueryBenchmark(const char* commandLine, int& exitCode);
+
+	/// <summary>
+	/// 球配列を渡された順序のままと Z順序に並べ替えた場合で、AABB木を使った判定の速度を比べる関数
+	/// MyMortonOrder::Benchmark の結果と MyPerfCounter の集計を表示する
+	/// 形式: -mortonbench [球の数 判定する球の数]
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+	/// <returns>測定が指定されていたか</returns>
+	static bool RunMortonBenchmark(const char* commandLine, int& exitCode);
+
+};
@@ -0,0 +1,295 @@
+﻿#include "MyCompactMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <unordered_map>
+
+namespace {
+
+	// 量子化の最大値
+	const float kQuantizeMax = 65535.0f;
+	// 八面体写像の最大値
+	const float kOctahedralMax = 32767.0f;
+
+	/// <summary>
+	/// 座標を量子化する関数
+	/// </summary>
+	/// <param name="value">座標</param>
+	/// <param name="min">基準の最小値</param>
+	/// <param name="step">1段階あたりの長さ</param>
+	/// <returns>量子化した値</returns>
+	uint16_t Quantize(float value, float min, float step) {
+		if (step == 0.0f) {
+			return 0;
+		}
+		float q = std::round((value - min) / step);
+		return uint16_t(std::clamp(q, 0.0f, kQuantizeMax));
+	}
+
+	/// <summary>
+	/// 符号を求める関数 (0は正とする)
+	/// </summary>
+	float SignNotZero(float value) {
+		return value < 0.0f ? -1.0f : 1.0f;
+	}
+
+}
+
+/// <summary>
+/// 三角形配列から圧縮した形状を作る関数
+/// 量子化後に同じ座標になる頂点は共有する
+/// </summary>
+/// <param name="triangles">三角形配列 (近い三角形が並んでいるほど圧縮後の精度が上がる)</param>
+/// <param name="count">三角形の数</param>
+void MyCompactMesh::Build(const Triangle* triangles, size_t count) {
+
+	chunks_.clear();
+	positions_.clear();
+	indices_.clear();
+	indices_.reserve(count * 3);
+	triangleCount_ = count;
+
+	// 量子化した座標から頂点番号への対応 (まとまりごとに作り直す)
+	std::unordered_map<uint64_t, uint16_t> vertexMap;
+
+	for (size_t begin = 0; begin < count; begin += kChunkTriangleCount) {
+		size_t end = std::min(count, begin + kChunkTriangleCount);
+
+		// まとまりのAABBを求める
+		CompactChunk chunk{};
+		chunk.bounds = MyCollision::MakeAABB(triangles[begin]);
+		for (size_t i = begin + 1; i < end; i++) {
+			AABB aabb = MyCollision::MakeAABB(triangles[i]);
+			chunk.bounds.min = { std::min(chunk.bounds.min.x, aabb.min.x), std::min(chunk.bounds.min.y, aabb.min.y), std::min(chunk.bounds.min.z, aabb.min.z) };
+			chunk.bounds.max = { std::max(chunk.bounds.max.x, aabb.max.x), std::max(chunk.bounds.max.y, aabb.max.y), std::max(chunk.bounds.max.z, aabb.max.z) };
+		}
+		chunk.step = MyMath::Multiply(1.0f / kQuantizeMax, chunk.bounds.max - chunk.bounds.min);
+		chunk.vertexOffset = uint32_t(positions_.size() / 3);
+		chunk.triangleOffset = uint32_t(begin);
+		chunk.triangleCount = uint32_t(end - begin);
+
+		// 頂点を量子化し、同じ座標になる頂点は共有する
+		vertexMap.clear();
+		for (size_t i = begin; i < end; i++) {
+			for (uint32_t v = 0; v < 3; v++) {
+				const Vector3& vertex = triangles[i].vertex[v];
+				uint16_t qx = Quantize(vertex.x, chunk.bounds.min.x, chunk.step.x);
+				uint16_t qy = Quantize(vertex.y, chunk.bounds.min.y, chunk.step.y);
+				uint16_t qz = Quantize(vertex.z, chunk.bounds.min.z, chunk.step.z);
+				uint64_t key = (uint64_t(qx) << 32) | (uint64_t(qy) << 16) | qz;
+
+				auto [it, isNew] = vertexMap.try_emplace(key, uint16_t(positions_.size() / 3 - chunk.vertexOffset));
+				if (isNew) {
+					positions_.push_back(qx);
+					positions_.push_back(qy);
+					positions_.push_back(qz);
+				}
+				indices_.push_back(it->second);
+			}
+		}
+
+		chunks_.push_back(chunk);
+	}
+
+}
+
+/// <summary>
+/// 三角形を展開する関数
+/// </summary>
+/// <param name="index">三角形の番号</param>
+/// <returns>三角形 (誤差は各軸でまとまりのAABBの 1/131070 以内)</returns>
+Triangle MyCompactMesh::GetTriangle(size_t index) const {
+
+	const CompactChunk& chunk = chunks_[index / kChunkTriangleCount];
+
+	Triangle result{};
+	for (uint32_t v = 0; v < 3; v++) {
+		const uint16_t* q = &positions_[(chunk.vertexOffset + indices_[index * 3 + v]) * 3];
+		result.vertex[v] = {
+			chunk.bounds.min.x + float(q[0]) * chunk.step.x,
+			chunk.bounds.min.y + float(q[1]) * chunk.step.y,
+			chunk.bounds.min.z + float(q[2]) * chunk.step.z
+		};
+	}
+	return result;
+
+}
+
+/// <summary>
+/// 使用しているメモリ量を取得する関数
+/// </summary>
+/// <returns>バイト数</returns>
+size_t MyCompactMesh::GetByteSize() const {
+
+	return chunks_.size() * sizeof(CompactChunk) + positions_.size() * sizeof(uint16_t) + indices_.size() * sizeof(uint16_t);
+
+}
+
+/// <summary>
+/// 球と全ての三角形の当たり判定をとる関数
+/// まとまりのAABBで除外し、残ったまとまりの三角形を4個ずつ展開してSIMDで判定する
+/// SIMDの判定は半径を量子化の半段階分広げた候補選びで、候補は GetTriangle で展開した三角形で判定し直す
+/// (結果はSIMDを使わない場合と一致し、元の三角形との差は量子化の誤差の範囲になる)
+/// </summary>
+/// <param name="sphere">球</param>
+/// <param name="hitIndex">衝突した三角形の番号の格納先 (三角形の数分の領域が必要)</param>
+/// <param name="contact">接触情報の格納先 (nullptrなら求めない、三角形の数分の領域が必要)</param>
+/// <returns>衝突した三角形の数</returns>
+size_t MyCompactMesh::IsCollision(const Sphere& sphere, uint32_t* hitIndex, Contact* contact) const {
+
+	// 衝突数
+	size_t hitCount = 0;
+	AABB sphereAABB = MyCollision::MakeAABB(sphere);
+
+	// 展開した三角形で判定し、衝突していれば書き出す
+	auto addHit = [&](uint32_t index) {
+		if (MyCollision::IsCollisionTriangle(GetTriangle(index), sphere, contact != nullptr ? &contact[hitCount] : nullptr)) {
+			hitIndex[hitCount++] = index;
+		}
+	};
+
+	for (const CompactChunk& chunk : chunks_) {
+
+		// まとまりごと除外する
+		if (!MyCollision::IsCollisionAABB(sphereAABB, chunk.bounds)) {
+			continue;
+		}
+
+		const uint16_t* indices = &indices_[size_t(chunk.triangleOffset) * 3];
+		const uint16_t* positions = &positions_[size_t(chunk.vertexOffset) * 3];
+
+#ifdef MYMATH_SIMD_SSE
+		// 球の情報と展開用の値を4つ並べておく
+		// SIMDでの展開と最近接点の計算は GetTriangle と丸め方が異なるため、半径を量子化の半段階の対角線分広げて候補を選ぶ
+		const __m128 point[3] = { _mm_set1_ps(sphere.center.x), _mm_set1_ps(sphere.center.y), _mm_set1_ps(sphere.center.z) };
+		float candidateRadius = sphere.radius + 0.5f * MyMath::Length(chunk.step) + FLT_EPSILON * (sphere.radius + MyMath::Length(chunk.bounds.max - chunk.bounds.min));
+		const __m128 radiusSq = _mm_set1_ps(candidateRadius * candidateRadius);
+		const __m128 min[3] = { _mm_set1_ps(chunk.bounds.min.x), _mm_set1_ps(chunk.bounds.min.y), _mm_set1_ps(chunk.bounds.min.z) };
+		const __m128 step[3] = { _mm_set1_ps(chunk.step.x), _mm_set1_ps(chunk.step.y), _mm_set1_ps(chunk.step.z) };
+
+		for (uint32_t i = 0; i < chunk.triangleCount; i += 4) {
+
+			// 4個に満たない分は最後の三角形で埋めて結果から除く
+			uint32_t laneCount = std::min(4u, chunk.triangleCount - i);
+			uint32_t triangle[4];
+			for (uint32_t lane = 0; lane < 4; lane++) {
+				triangle[lane] = i + std::min(lane, laneCount - 1);
+			}
+
+			// 頂点番号から量子化した座標を集めて展開する
+			__m128 vertex[3][3];
+			for (uint32_t v = 0; v < 3; v++) {
+				const uint16_t* q0 = &positions[indices[triangle[0] * 3 + v] * 3];
+				const uint16_t* q1 = &positions[indices[triangle[1] * 3 + v] * 3];
+				const uint16_t* q2 = &positions[indices[triangle[2] * 3 + v] * 3];
+				const uint16_t* q3 = &positions[indices[triangle[3] * 3 + v] * 3];
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					__m128i q = _mm_setr_epi32(q0[axis], q1[axis], q2[axis], q3[axis]);
+					vertex[v][axis] = _mm_add_ps(min[axis], _mm_mul_ps(_mm_cvtepi32_ps(q), step[axis]));
+				}
+			}
+
+			// 三角形上の最近接点が広げた球の内側にあるか
+			__m128 closest[3];
+			MyMath::ClosestPointTriangle4(point, vertex[0], vertex[1], vertex[2], closest);
+			__m128 dx = _mm_sub_ps(point[0], closest[0]);
+			__m128 dy = _mm_sub_ps(point[1], closest[1]);
+			__m128 dz = _mm_sub_ps(point[2], closest[2]);
+			__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int hitMask = _mm_movemask_ps(_mm_cmple_ps(distanceSq, radiusSq)) & ((1 << laneCount) - 1);
+
+			// 候補を展開した三角形で判定し直す
+			for (uint32_t lane = 0; lane < laneCount; lane++) {
+				if (hitMask & (1 << lane)) {
+					addHit(chunk.triangleOffset + i + lane);
+				}
+			}
+		}
+#else
+		// SIMDが使えない場合は1つずつ展開して判定する
+		(void)indices;
+		(void)positions;
+		for (uint32_t i = 0; i < chunk.triangleCount; i++) {
+			addHit(chunk.triangleOffset + i);
+		}
+#endif
+	}
+
+	return hitCount;
+
+}
+
+/// <summary>
+/// 単位ベクトルを八面体写像で圧縮する関数
+/// </summary>
+/// <param name="normal">単位ベクトル</param>
+/// <param name="x">圧縮したxの格納先</param>
+/// <param name="y">圧縮したyの格納先</param>
+void MyCompactMesh::EncodeOctahedral(const Vector3& normal, int16_t& x, int16_t& y) {
+
+	// 八面体に投影する
+	float inverseSum = 1.0f / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+	float u = normal.x * inverseSum;
+	float v = normal.y * inverseSum;
+
+	// 下半分は折り返して正方形に収める
+	if (normal.z < 0.0f) {
+		float foldU = (1.0f - std::abs(v)) * SignNotZero(u);
+		float foldV = (1.0f - std::abs(u)) * SignNotZero(v);
+		u = foldU;
+		v = foldV;
+	}
+
+	x = int16_t(std::round(std::clamp(u, -1.0f, 1.0f) * kOctahedralMax));
+	y = int16_t(std::round(std::clamp(v, -1.0f, 1.0f) * kOctahedralMax));
+
+}
+
+/// <summary>
+/// 八面体写像で圧縮した単位ベクトルを展開する関数
+/// </summary>
+/// <param name="x">圧縮したx</param>
+/// <param name="y">圧縮したy</param>
+/// <returns>単位ベクトル</returns>
+Vector3 MyCompactMesh::DecodeOctahedral(int16_t x, int16_t y) {
+
+	Vector3 result{};
+	result.x = float(x) / kOctahedralMax;
+	result.y = float(y) / kOctahedralMax;
+	result.z = 1.0f - std::abs(result.x) - std::abs(result.y);
+
+	// 下半分は折り返しを戻す
+	if (result.z < 0.0f) {
+		float u = (1.0f - std::abs(result.y)) * SignNotZero(result.x);
+		float v = (1.0f - std::abs(result.x)) * SignNotZero(result.y);
+		result.x = u;
+		result.y = v;
+	}
+
+	return MyMath::Normalize(result);
+
+}
+
+/// <summary>
+/// 平面を圧縮する関数
+/// </summary>
+/// <param name="plane">平面</param>
+/// <returns>圧縮した平面</returns>
+CompactPlane MyCompactMesh::EncodePlane(const Plane& plane) {
+
+	CompactPlane result{};
+	EncodeOctahedral(plane.normal, result.normalX, result.normalY);
+	result.distance = plane.distance;
+	return result;
+
+}
+
+/// <summary>
+/// 圧縮した平面を展開する関数
+/// </summary>
+/// <param name="plane">圧縮した平面</param>
+/// <returns>平面</returns>
+Plane MyCompactMesh::DecodePlane(const CompactPlane& plane) {
+
+	return { DecodeOctahedral(plane.normalX, plane.normalY), plane.distance };
+
+}
@@ -0,0 +1,119 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "MyCollision.h"
+
+/// <summary>
+/// 八面体写像で圧縮した平面構造体 (16バイトを8バイトにする)
+/// </summary>
+struct CompactPlane {
+	int16_t normalX; // 八面体写像した法線のx (-32767 ～ 32767)
+	int16_t normalY; // 八面体写像した法線のy
+	float distance; // 原点からの距離
+};
+
+/// <summary>
+/// 圧縮した三角形のまとまり
+/// 頂点座標はまとまりのAABBを基準に16bitで量子化する
+/// </summary>
+struct CompactChunk {
+	AABB bounds; // 三角形を囲むAABB (量子化の基準)
+	Vector3 step; // 量子化の1段階あたりの長さ
+	uint32_t vertexOffset; // 先頭の頂点の番号
+	uint32_t triangleOffset; // 先頭の三角形の番号
+	uint32_t triangleCount; // 三角形の数
+};
+
+/// <summary>
+/// 大量の三角形を量子化して少ないメモリで保持するクラス
+/// 頂点は共有して番号で参照し、座標は16bitに量子化する (格子状のメッシュで1三角形あたり約12バイト)
+/// 判定時はSIMDで展開しながら調べる
+/// </summary>
+class MyCompactMesh
+{
+public:
+
+	// 1つのまとまりに入れる三角形の数
+	static const uint32_t kChunkTriangleCount = 256;
+
+	/// <summary>
+	/// 三角形配列から圧縮した形状を作る関数
+	/// 量子化後に同じ座標になる頂点は共有する
+	/// </summary>
+	/// <param name="triangles">三角形配列 (近い三角形が並んでいるほど圧縮後の精度が上がる)</param>
+	/// <param name="count">三角形の数</param>
+	void Build(const Triangle* triangles, size_t count);
+
+	/// <summary>
+	/// 三角形を展開する関数
+	/// </summary>
+	/// <param name="index">三角形の番号</param>
+	/// <returns>三角形 (誤差は各軸でまとまりのAABBの 1/131070 以内)</returns>
+	Triangle GetTriangle(size_t index) const;
+
+	/// <summary>
+	/// 三角形の数を取得する関数
+	/// </summary>
+	/// <returns>三角形の数</returns>
+	size_t GetTriangleCount() const { return triangleCount_; }
+
+	/// <summary>
+	/// 使用しているメモリ量を取得する関数
+	/// </summary>
+	/// <returns>バイト数</returns>
+	size_t GetByteSize() const;
+
+	/// <summary>
+	/// 球と全ての三角形の当たり判定をとる関数
+	/// まとまりのAABBで除外し、残ったまとまりの三角形を4個ずつ展開してSIMDで判定する
+	/// SIMDの判定は半径を量子化の半段階分広げた候補選びで、候補は GetTriangle で展開した三角形で判定し直す
+	/// (結果はSIMDを使わない場合と一致し、元の三角形との差は量子化の誤差の範囲になる)
+	/// </summary>
+	/// <param name="sphere">球</param>
+	/// <param name="hitIndex">衝突した三角形の番号の格納先 (三角形の数分の領域が必要)</param>
+	/// <param name="contact">接触情報の格納先 (nullptrなら求めない、三角形の数分の領域が必要)</param>
+	/// <returns>衝突した三角形の数</returns>
+	size_t IsCollision(const Sphere& sphere, uint32_t* hitIndex, Contact* contact = nullptr) const;
+
+	/// <summary>
+	/// 単位ベクトルを八面体写像で圧縮する関数
+	/// </summary>
+	/// <param name="normal">単位ベクトル</param>
+	/// <param name="x">圧縮したxの格納先</param>
+	/// <param name="y">圧縮したyの格納先</param>
+	static void EncodeOctahedral(const Vector3& normal, int16_t& x, int16_t& y);
+
+	/// <summary>
+	/// 八面体写像で圧縮した単位ベクトルを展開する関数
+	/// </summary>
+	/// <param name="x">圧縮したx</param>
+	/// <param name="y">圧縮したy</param>
+	/// <returns>単位ベクトル</returns>
+	static Vector3 DecodeOctahedral(int16_t x, int16_t y);
+
+	/// <summary>
+	/// 平面を圧縮する関数
+	/// </summary>
+	/// <param name="plane">平面</param>
+	/// <returns>圧縮した平面</returns>
+	static CompactPlane EncodePlane(const Plane& plane);
+
+	/// <summary>
+	/// 圧縮した平面を展開する関数
+	/// </summary>
+	/// <param name="plane">圧縮した平面</param>
+	/// <returns>平面</returns>
+	static Plane DecodePlane(const CompactPlane& plane);
+
+private:
+
+	// まとまりの配列
+	std::vector<CompactChunk> chunks_;
+	// 量子化した頂点座標 (x, y, z の順に並べる)
+	std::vector<uint16_t> positions_;
+	// 三角形の頂点番号 (まとまりの先頭の頂点からの番号)
+	std::vector<uint16_t> indices_;
+	// 三角形の数
+	size_t triangleCount_ = 0;
+
+};
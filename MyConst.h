@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "MyStruct.h"
 
 static const char kWindowTitle[] = "LE2A_11_トヨダユウキ";
 
@@ -6,3 +7,9 @@ static const int kWindowWidth = 1280;
 static const int kWindowHeight = 720;
 
 static const int kColumWidth = 60;
+
+// 確認用の場面の初期状態 (ウィンドウ表示と -render で共通)
+static const Triangle kInitialTriangle = { { { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f } } };
+static const Segment kInitialSegment = { { -0.45f, 0.35f, 0.0f }, { 0.0f, 0.5f, 0.0f } };
+static const Vector3 kInitialCameraTranslate = { 0.0f, 1.9f, -6.49f };
+static const Vector3 kInitialCameraRotate = { 0.26f, 0.0f, 0.0f };
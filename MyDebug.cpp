@@ -1,4 +1,81 @@
 ﻿#include "MyDebug.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+
+namespace {
+
+	/// <summary>
+	/// 線の描画命令を追加する関数
+	/// </summary>
+	void AddLine(DrawCommandList& list, int x1, int y1, int x2, int y2, uint32_t color) {
+		list.push_back({ DrawCommandType::kLine, { x1, x2, 0 }, { y1, y2, 0 }, color });
+	}
+
+	/// <summary>
+	/// ワイヤーフレームの三角形の描画命令を追加する関数
+	/// </summary>
+	void AddTriangle(DrawCommandList& list, int x1, int y1, int x2, int y2, int x3, int y3, uint32_t color) {
+		list.push_back({ DrawCommandType::kTriangle, { x1, x2, x3 }, { y1, y2, y3 }, color });
+	}
+
+	/// <summary>
+	/// 即時描画用に使い回す描画命令の配列を取得する関数
+	/// </summary>
+	DrawCommandList& GetScratchList() {
+		static thread_local DrawCommandList list;
+		list.clear();
+		return list;
+	}
+
+	/// <summary>
+	/// ワールド座標の点の付近で1単位の長さが画面上で何ピクセルになるかを求める関数
+	/// ビュー射影行列のy列の長さ (視野角による拡大率) を w で割って求める
+	/// </summary>
+	/// <param name="point">ワールド座標</param>
+	/// <param name="viewProjectionMatrix">ビュー射影行列</param>
+	/// <param name="viewportMatrix">ビューポート行列</param>
+	/// <returns>1単位あたりのピクセル数 (カメラの後ろにある場合は0)</returns>
+	float GetPixelsPerUnit(const Vector3& point, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix) {
+
+		const Matrix4x4& m = viewProjectionMatrix;
+		float w = point.x * m.m[0][3] + point.y * m.m[1][3] + point.z * m.m[2][3] + m.m[3][3];
+		if (w <= 0.0f) {
+			return 0.0f;
+		}
+
+		float scaleY = MyMath::Length({ m.m[0][1], m.m[1][1], m.m[2][1] });
+		return scaleY / w * std::abs(viewportMatrix.m[1][1]);
+
+	}
+
+	/// <summary>
+	/// ビュー射影行列からカメラの位置を求める関数
+	/// カメラの位置はクリップ座標の x, y, w が全て0になる点なので、逆行列の z行 (同次座標) から求める
+	/// </summary>
+	/// <param name="viewProjectionMatrix">ビュー射影行列</param>
+	/// <param name="position">カメラの位置の格納先</param>
+	/// <returns>求められたか (平行投影ではカメラが無限遠にあるので求まらない)</returns>
+	bool GetCameraPosition(const Matrix4x4& viewProjectionMatrix, Vector3& position) {
+
+		Matrix4x4 inverse = MyMath::Inverse(viewProjectionMatrix);
+		float w = inverse.m[2][3];
+		if (!std::isfinite(w) || std::abs(w) <= 1.0e-12f) {
+			return false;
+		}
+		position = { inverse.m[2][0] / w, inverse.m[2][1] / w, inverse.m[2][2] / w };
+		return std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z);
+
+	}
+
+}
+
+// 描画命令の実行先
+MyDrawBackend* MyDebug::backend_ = nullptr;
+
+#ifdef MYDEBUG_NOVICE
 
 /// <summary>
 /// ベクトルの情報を書き出す関数
@@ -15,6 +92,8 @@ void MyDebug::VectorScreenPrintf(int x, int y, const Vector3& vector, const char
 
 }
 
+#endif
+
 /// <summary>
 /// グリッドを描画する関数
 /// </summary>
@@ -22,9 +101,60 @@ void MyDebug::VectorScreenPrintf(int x, int y, const Vector3& vector, const char
 /// <param name="viewportMatrix">ビューポート行列</param>
 void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix) {
 
-	const float kGridHalfWidth = 2.0f; // グリッドの半分の幅
+	// 描画命令を作成してすぐに実行する
+	DrawCommandList& list = GetScratchList();
+	DrawGrid(viewProjectionMatrix, viewportMatrix, list);
+	Submit(list);
+
+}
+
+/// <summary>
+/// グリッドの描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+/// </summary>
+/// <param name="viewProjectionMatrix">射影行列</param>
+/// <param name="viewportMatrix">ビューポート行列</param>
+/// <param name="list">追加先</param>
+void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawCommandList& list) {
+
+	const float kGridHalfWidth = 2.0f; // 最も細かい段階でのグリッドの半分の幅
 	const uint32_t kSubdivision = 10; // 分割数
-	const float kGridEvery = (kGridHalfWidth * 2.0f) / float(kSubdivision); // 1つ分の長さ
+	const float kMinCellPixels = 8.0f; // 1マスの画面上の最小の大きさ
+	const uint32_t kMaxLevel = 16; // 最も粗い段階
+
+	// カメラの位置をグリッドの平面 (y = 0) に下ろした点を基準にする
+	// 平行投影などでカメラの位置が求まらない場合は原点を基準にする
+	Vector3 focus = { 0.0f, 0.0f, 0.0f };
+	Vector3 cameraPosition;
+	if (GetCameraPosition(viewProjectionMatrix, cameraPosition)) {
+		focus = { cameraPosition.x, 0.0f, cameraPosition.z };
+	}
+
+	// 基準の点の付近で1マスが画面上で kMinCellPixels 以上になるまで、マスと範囲を2倍ずつ広げる
+	// (分割数は変わらないので、引いて見るほど広い範囲を同じ本数で描く)
+	// 基準の点がカメラの後ろや真横にある (水平に見ている) 場合は原点で大きさを求め、それも求まらなければ最も細かい段階のまま描く
+	float gridHalfWidth = kGridHalfWidth;
+	float pixelsPerUnit = GetPixelsPerUnit(focus, viewProjectionMatrix, viewportMatrix);
+	if (pixelsPerUnit <= 0.0f) {
+		pixelsPerUnit = GetPixelsPerUnit({ 0.0f, 0.0f, 0.0f }, viewProjectionMatrix, viewportMatrix);
+	}
+	for (uint32_t level = 0; level < kMaxLevel && pixelsPerUnit > 0.0f; level++) {
+		float cellPixels = pixelsPerUnit * (gridHalfWidth * 2.0f) / float(kSubdivision);
+		if (cellPixels >= kMinCellPixels) {
+			break;
+		}
+		gridHalfWidth *= 2.0f;
+	}
+	const float kGridEvery = (gridHalfWidth * 2.0f) / float(kSubdivision); // 1つ分の長さ
+
+	// 基準の点から遠い線ほど薄くする (グリッドの最も遠い角で最も薄くなる)
+	// 線 (線分) と基準の点の平面上の距離を、線と垂直な方向の差 across と線に沿った方向のはみ出し along から求める
+	float maxDistance = std::sqrt((std::abs(focus.x) + gridHalfWidth) * (std::abs(focus.x) + gridHalfWidth) + (std::abs(focus.z) + gridHalfWidth) * (std::abs(focus.z) + gridHalfWidth));
+	auto fadeColor = [&](float across, float along) {
+		float outside = std::max(std::abs(along) - gridHalfWidth, 0.0f);
+		float distance = std::min(std::sqrt(across * across + outside * outside) / maxDistance, 1.0f);
+		uint32_t alpha = uint32_t(0xFF * (1.0f - 0.75f * distance * distance));
+		return 0xAAAAAA00 | alpha;
+	};
 
 	// <para>返還前のワールド座標<para>
 	// 0 ... 始点　1 ... 終点
@@ -37,8 +167,8 @@ void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& v
 	for (uint32_t xIndex = 0; xIndex <= kSubdivision; xIndex++) {
 
 		// 上記の除法を使ってワールド座標系の始点、終点を求める
-		worldVertex[0] = { (float)xIndex * kGridEvery - kGridHalfWidth, 0.0f, -kGridHalfWidth };
-		worldVertex[1] = { (float)xIndex * kGridEvery - kGridHalfWidth, 0.0f, kGridHalfWidth };
+		worldVertex[0] = { (float)xIndex * kGridEvery - gridHalfWidth, 0.0f, -gridHalfWidth };
+		worldVertex[1] = { (float)xIndex * kGridEvery - gridHalfWidth, 0.0f, gridHalfWidth };
 		// スクリーン座標系に変換
 		// 始点
 		screenVertex[0] = MyMath::Transform(worldVertex[0], viewProjectionMatrix);
@@ -48,7 +178,7 @@ void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& v
 		screenVertex[1] = MyMath::Transform(screenVertex[1], viewportMatrix);
 
 		// 変換した座標を使用して描画する
-		Novice::DrawLine((int)screenVertex[0].x, (int)screenVertex[0].y, (int)screenVertex[1].x, (int)screenVertex[1].y, 0xAAAAAAFF);
+		AddLine(list, (int)screenVertex[0].x, (int)screenVertex[0].y, (int)screenVertex[1].x, (int)screenVertex[1].y, fadeColor(worldVertex[0].x - focus.x, focus.z));
 
 	}
 
@@ -56,8 +186,8 @@ void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& v
 	for (uint32_t zIndex = 0; zIndex <= kSubdivision; zIndex++) {
 
 		// 上記の除法を使ってワールド座標系の始点、終点を求める
-		worldVertex[0] = { -kGridHalfWidth, 0.0f,  (float)zIndex * kGridEvery - kGridHalfWidth };
-		worldVertex[1] = { kGridHalfWidth, 0.0f, (float)zIndex * kGridEvery - kGridHalfWidth };
+		worldVertex[0] = { -gridHalfWidth, 0.0f,  (float)zIndex * kGridEvery - gridHalfWidth };
+		worldVertex[1] = { gridHalfWidth, 0.0f, (float)zIndex * kGridEvery - gridHalfWidth };
 		// スクリーン座標系に変換
 		// 始点
 		screenVertex[0] = MyMath::Transform(worldVertex[0], viewProjectionMatrix);
@@ -67,7 +197,7 @@ void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& v
 		screenVertex[1] = MyMath::Transform(screenVertex[1], viewportMatrix);
 
 		// 変換した座標を使用して描画する
-		Novice::DrawLine((int)screenVertex[0].x, (int)screenVertex[0].y, (int)screenVertex[1].x, (int)screenVertex[1].y, 0xAAAAAAFF);
+		AddLine(list, (int)screenVertex[0].x, (int)screenVertex[0].y, (int)screenVertex[1].x, (int)screenVertex[1].y, fadeColor(worldVertex[0].z - focus.z, focus.x));
 
 	}
 
@@ -82,24 +212,72 @@ void MyDebug::DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& v
 /// <param name="color">球の色</param>
 void MyDebug::DrawSphere(const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color) {
 
-	const uint32_t kSubdivison = 30;
-	const float kLonEvery = 2.0f * float(std::numbers::pi) / float(kSubdivison);
-	const float kLatEvery = float(std::numbers::pi) / float(kSubdivison);
+	// 描画命令を作成してすぐに実行する
+	DrawCommandList& list = GetScratchList();
+	DrawSphere(sphere, viewProjectionMatrix, viewPortMatrix, color, list);
+	Submit(list);
+
+}
+
+/// <summary>
+/// 球の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+/// </summary>
+/// <param name="sphere">球構造体</param>
+/// <param name="viewProjectionMatrix">射影行列</param>
+/// <param name="viewPortMatrix">ビューポート行列</param>
+/// <param name="color">球の色</param>
+/// <param name="list">追加先</param>
+void MyDebug::DrawSphere(const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list) {
+
+	const uint32_t kMaxSubdivision = 30; // 最大の分割数
+	const uint32_t kMinSubdivision = 4; // 最小の分割数
+	const float kMaxErrorPixels = 0.5f; // 許容する画面上の誤差
+
+	// 画面上の半径から、弦と円弧のずれが許容誤差以下になる分割数を求める
+	// ずれ = r(1 - cos(π/n)) ≒ rπ²/(2n²) より n = π√(r / 2ε)
+	uint32_t subdivision = kMaxSubdivision;
+	float pixelsPerUnit = GetPixelsPerUnit(sphere.center, viewProjectionMatrix, viewPortMatrix);
+	if (pixelsPerUnit > 0.0f) {
+		float radiusPixels = sphere.radius * pixelsPerUnit;
+		float idealSubdivision = std::ceil(float(std::numbers::pi) * std::sqrt(radiusPixels / (2.0f * kMaxErrorPixels)));
+		subdivision = uint32_t(std::clamp(idealSubdivision, float(kMinSubdivision), float(kMaxSubdivision)));
+	}
+	const float kLonEvery = 2.0f * float(std::numbers::pi) / float(subdivision);
+	const float kLatEvery = float(std::numbers::pi) / float(subdivision);
+
+	// 緯度、経度ごとのサインとコサインを先にまとめて求めておく
+	float latAngle[kMaxSubdivision + 1], latSin[kMaxSubdivision + 1], latCos[kMaxSubdivision + 1];
+	float lonAngle[kMaxSubdivision + 1], lonSin[kMaxSubdivision + 1], lonCos[kMaxSubdivision + 1];
+	for (uint32_t i = 0; i <= subdivision; i++) {
+		latAngle[i] = float(-std::numbers::pi) / 2.0f + kLatEvery * i;
+		lonAngle[i] = i * kLonEvery;
+	}
+#ifdef MYMATH_FAST_APPROX
+	// 近似版でまとめて計算
+	MyMath::FastSinCosMany(latAngle, latSin, latCos, subdivision + 1);
+	MyMath::FastSinCosMany(lonAngle, lonSin, lonCos, subdivision + 1);
+#else
+	// 計算処理
+	for (uint32_t i = 0; i <= subdivision; i++) {
+		latSin[i] = std::sin(latAngle[i]);
+		latCos[i] = std::cos(latAngle[i]);
+		lonSin[i] = std::sin(lonAngle[i]);
+		lonCos[i] = std::cos(lonAngle[i]);
+	}
+#endif
 
 	// 緯度の方向に分割
-	for (uint32_t latIndex = 0; latIndex < kSubdivison; latIndex++) {
-		float lat = float(-std::numbers::pi) / 2.0f + kLatEvery * latIndex;
+	for (uint32_t latIndex = 0; latIndex < subdivision; latIndex++) {
 		// 軽度の方向に分割
-		for (uint32_t lonIndex = 0; lonIndex < kSubdivison; lonIndex++) {
-			float lon = lonIndex * kLonEvery;
+		for (uint32_t lonIndex = 0; lonIndex < subdivision; lonIndex++) {
 
 			// ワールド座標系でのa, b, cを求める
 			Vector3 a, b, c;
-			a = { sphere.radius * std::cosf(lat) * std::cosf(lon),sphere.radius * std::sinf(lat), sphere.radius * std::cosf(lat) * std::sinf(lon) };
+			a = { sphere.radius * latCos[latIndex] * lonCos[lonIndex], sphere.radius * latSin[latIndex], sphere.radius * latCos[latIndex] * lonSin[lonIndex] };
 			a = MyMath::Add(a, sphere.center);
-			b = { sphere.radius * std::cosf(lat + kLatEvery) * std::cosf(lon), sphere.radius * std::sinf(lat + kLatEvery), sphere.radius * std::cosf(lat + kLatEvery) * std::sinf(lon) };
+			b = { sphere.radius * latCos[latIndex + 1] * lonCos[lonIndex], sphere.radius * latSin[latIndex + 1], sphere.radius * latCos[latIndex + 1] * lonSin[lonIndex] };
 			b = MyMath::Add(b, sphere.center);
-			c = { sphere.radius * std::cosf(lat) * cosf(lon + kLonEvery), sphere.radius * std::sinf(lat), sphere.radius * std::cosf(lat) * std::sinf(lon + kLonEvery) };
+			c = { sphere.radius * latCos[latIndex] * lonCos[lonIndex + 1], sphere.radius * latSin[latIndex], sphere.radius * latCos[latIndex] * lonSin[lonIndex + 1] };
 			c = MyMath::Add(c, sphere.center);
 
 			// a, b, c をスクリーン座標系に変換
@@ -111,8 +289,8 @@ void MyDebug::DrawSphere(const Sphere& sphere, const Matrix4x4& viewProjectionMa
 			c = MyMath::Transform(c, viewPortMatrix);
 
 			// 線を引く
-			Novice::DrawLine(int(a.x), int(a.y), int(b.x), int(b.y), color);
-			Novice::DrawLine(int(a.x), int(a.y), int(c.x), int(c.y), color);
+			AddLine(list, int(a.x), int(a.y), int(b.x), int(b.y), color);
+			AddLine(list, int(a.x), int(a.y), int(c.x), int(c.y), color);
 
 		}
 	}
@@ -128,6 +306,23 @@ void MyDebug::DrawSphere(const Sphere& sphere, const Matrix4x4& viewProjectionMa
 /// <param name="color">三角の色</param>
 void MyDebug::DrawTriangle(const Triangle& triangle, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color) {
 
+	// 描画命令を作成してすぐに実行する
+	DrawCommandList& list = GetScratchList();
+	DrawTriangle(triangle, viewProjectionMatrix, viewPortMatrix, color, list);
+	Submit(list);
+
+}
+
+/// <summary>
+/// 三角形の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+/// </summary>
+/// <param name="triangle">三角形構造体</param>
+/// <param name="viewProjectionMatrix">射影行列</param>
+/// <param name="viewPortMatrix">ビューポート行列</param>
+/// <param name="color">三角の色</param>
+/// <param name="list">追加先</param>
+void MyDebug::DrawTriangle(const Triangle& triangle, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list) {
+
 	// 三角形の頂点座標
 	Vector3 screenVertices[3];
 	for (uint32_t i = 0; i < 3; ++i) {
@@ -136,11 +331,89 @@ void MyDebug::DrawTriangle(const Triangle& triangle, const Matrix4x4& viewProjec
 	}
 
 	// 三角形の描画
-	Novice::DrawTriangle(
+	AddTriangle(list,
 		int(screenVertices[0].x), int(screenVertices[0].y),
 		int(screenVertices[1].x), int(screenVertices[1].y),
 		int(screenVertices[2].x), int(screenVertices[2].y),
-		color, kFillModeWireFrame
+		color
 	);
 
+}
+
+/// <summary>
+/// 線分を描画する関数
+/// </summary>
+/// <param name="segment">線分構造体</param>
+/// <param name="viewProjectionMatrix">射影行列</param>
+/// <param name="viewPortMatrix">ビューポート行列</param>
+/// <param name="color">線の色</param>
+void MyDebug::DrawSegment(const Segment& segment, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color) {
+
+	// 描画命令を作成してすぐに実行する
+	DrawCommandList& list = GetScratchList();
+	DrawSegment(segment, viewProjectionMatrix, viewPortMatrix, color, list);
+	Submit(list);
+
+}
+
+/// <summary>
+/// 線分の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+/// </summary>
+/// <param name="segment">線分構造体</param>
+/// <param name="viewProjectionMatrix">射影行列</param>
+/// <param name="viewPortMatrix">ビューポート行列</param>
+/// <param name="color">線の色</param>
+/// <param name="list">追加先</param>
+void MyDebug::DrawSegment(const Segment& segment, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list) {
+
+	// 始点と終点をスクリーン座標系に変換
+	Vector3 start = MyMath::Transform(MyMath::Transform(segment.origin, viewProjectionMatrix), viewPortMatrix);
+	Vector3 end = MyMath::Transform(MyMath::Transform(MyMath::Add(segment.origin, segment.diff), viewProjectionMatrix), viewPortMatrix);
+
+	// 線を引く
+	AddLine(list, int(start.x), int(start.y), int(end.x), int(end.y), color);
+
+}
+
+/// <summary>
+/// 描画命令を実行する関数
+/// 描画先が設定されていなければ Novice で描画する (メインスレッドから呼ぶこと)
+/// Novice が使用できない環境では描画先の設定が必要 (設定されていなければ描画せずに失敗を返す)
+/// </summary>
+/// <param name="list">描画命令の配列</param>
+/// <returns>描画できたか</returns>
+bool MyDebug::Submit(const DrawCommandList& list) {
+
+	// 描画先が設定されていればそちらで描画する
+	if (backend_ != nullptr) {
+		backend_->Submit(list);
+		return true;
+	}
+
+#ifdef MYDEBUG_NOVICE
+	for (const DrawCommand& command : list) {
+		switch (command.type) {
+		case DrawCommandType::kLine:
+			Novice::DrawLine(command.x[0], command.y[0], command.x[1], command.y[1], command.color);
+			break;
+		case DrawCommandType::kTriangle:
+			Novice::DrawTriangle(
+				command.x[0], command.y[0],
+				command.x[1], command.y[1],
+				command.x[2], command.y[2],
+				command.color, kFillModeWireFrame
+			);
+			break;
+		}
+	}
+	return true;
+#else
+	// 描画先がなければ描画できない (リリースビルドでも気付けるように最初の1回だけ知らせる)
+	static std::atomic<bool> isReported = false;
+	if (!isReported.exchange(true)) {
+		std::fprintf(stderr, "MyDebug::Submit: no backend is set (call MyDebug::SetBackend without Novice), %zu commands dropped\n", list.size());
+	}
+	return false;
+#endif
+
 }
\ No newline at end of file
@@ -1,7 +1,15 @@
 ﻿#pragma once
-#include <Novice.h>
+#include <vector>
 #include "MyMath.h"
 #include "MyConst.h"
+#include "MyDrawBackend.h"
+
+// Novice が使用できる環境では Novice での描画を有効にする
+// (使用できない環境では描画命令の作成のみ行え、描画には SetBackend で描画先を設定する)
+#if __has_include(<Novice.h>)
+#include <Novice.h>
+#define MYDEBUG_NOVICE
+#endif
 
 /// <summary>
 /// デバック系関数のクラス
@@ -11,6 +19,8 @@ class MyDebug
 
 public:
 
+#ifdef MYDEBUG_NOVICE
+
 	/// <summary>
 	/// ベクトルの情報を書き出す関数
 	/// </summary>
@@ -20,6 +30,8 @@ public:
 	/// <param name="label">名前</param>
 	static void VectorScreenPrintf(int x, int y, const Vector3& vector, const char* label);
 
+#endif
+
 	/// <summary>
 	/// グリッドを描画する関数
 	/// </summary>
@@ -45,5 +57,72 @@ public:
 	/// <param name="color">三角の色</param>
 	static void DrawTriangle(const Triangle& triangle, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color);
 
+	/// <summary>
+	/// 線分を描画する関数
+	/// </summary>
+	/// <param name="segment">線分構造体</param>
+	/// <param name="viewProjectionMatrix">射影行列</param>
+	/// <param name="viewPortMatrix">ビューポート行列</param>
+	/// <param name="color">線の色</param>
+	static void DrawSegment(const Segment& segment, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color);
+
+	/// <summary>
+	/// グリッドの描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+	/// </summary>
+	/// <param name="viewProjectionMatrix">射影行列</param>
+	/// <param name="viewportMatrix">ビューポート行列</param>
+	/// <param name="list">追加先</param>
+	static void DrawGrid(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawCommandList& list);
+
+	/// <summary>
+	/// 球の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+	/// </summary>
+	/// <param name="sphere">球構造体</param>
+	/// <param name="viewProjectionMatrix">射影行列</param>
+	/// <param name="viewPortMatrix">ビューポート行列</param>
+	/// <param name="color">球の色</param>
+	/// <param name="list">追加先</param>
+	static void DrawSphere(const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list);
+
+	/// <summary>
+	/// 三角形の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+	/// </summary>
+	/// <param name="triangle">三角形構造体</param>
+	/// <param name="viewProjectionMatrix">射影行列</param>
+	/// <param name="viewPortMatrix">ビューポート行列</param>
+	/// <param name="color">三角の色</param>
+	/// <param name="list">追加先</param>
+	static void DrawTriangle(const Triangle& triangle, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list);
+
+	/// <summary>
+	/// 線分の描画命令を追加する関数 (Novice を呼ばないため別スレッドから呼べる)
+	/// </summary>
+	/// <param name="segment">線分構造体</param>
+	/// <param name="viewProjectionMatrix">射影行列</param>
+	/// <param name="viewPortMatrix">ビューポート行列</param>
+	/// <param name="color">線の色</param>
+	/// <param name="list">追加先</param>
+	static void DrawSegment(const Segment& segment, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewPortMatrix, uint32_t color, DrawCommandList& list);
+
+	/// <summary>
+	/// 描画命令を実行する関数
+	/// 描画先が設定されていなければ Novice で描画する (メインスレッドから呼ぶこと)
+	/// Novice が使用できない環境では描画先の設定が必要 (設定されていなければ描画せずに失敗を返す)
+	/// </summary>
+	/// <param name="list">描画命令の配列</param>
+	/// <returns>描画できたか</returns>
+	static bool Submit(const DrawCommandList& list);
+
+	/// <summary>
+	/// 描画命令の実行先を設定する関数
+	/// </summary>
+	/// <param name="backend">実行先 (nullptrなら Novice で描画する)</param>
+	static void SetBackend(MyDrawBackend* backend) { backend_ = backend; }
+
+private:
+
+	// 描画命令の実行先 (nullptrなら Novice で描画する)
+	static MyDrawBackend* backend_;
+
 };
 
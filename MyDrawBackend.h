@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 描画命令の種類
+/// </summary>
+enum class DrawCommandType {
+	kLine, // 線
+	kTriangle, // ワイヤーフレームの三角形
+};
+
+/// <summary>
+/// スクリーン座標系の描画命令構造体
+/// </summary>
+struct DrawCommand {
+	DrawCommandType type; // 種類
+	int x[3]; // x座標 (線は2点分のみ使用)
+	int y[3]; // y座標 (線は2点分のみ使用)
+	uint32_t color; // 色 (0xRRGGBBAA)
+};
+
+/// <summary>
+/// 描画命令の配列
+/// </summary>
+using DrawCommandList = std::vector<DrawCommand>;
+
+/// <summary>
+/// 描画命令の実行先の基底クラス
+/// MyDebug::SetBackend で設定すると MyDebug::Submit の描画先を差し替えられる
+/// </summary>
+class MyDrawBackend
+{
+public:
+
+	/// <summary>
+	/// 仮想デストラクタ
+	/// </summary>
+	virtual ~MyDrawBackend() = default;
+
+	/// <summary>
+	/// 描画命令を実行する関数
+	/// </summary>
+	/// <param name="list">描画命令の配列</param>
+	virtual void Submit(const DrawCommandList& list) = 0;
+
+};
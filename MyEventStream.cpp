@@ -0,0 +1,136 @@
+﻿#include "MyEventStream.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+/// <summary>
+/// コンストラクタ
+/// </summary>
+/// <param name="capacity">読み手ごとに保持できるイベントの数 (2の累乗に切り上げられる)</param>
+MyEventStream::MyEventStream(size_t capacity) {
+
+	capacity_ = std::bit_ceil(std::max<size_t>(capacity, 2));
+	mask_ = capacity_ - 1;
+
+}
+
+/// <summary>
+/// 読み手を登録する関数
+/// 書き込み中でも登録できるが、登録は1つのスレッドから行うこと
+/// 登録前に書き込まれたイベントは受け取れない
+/// </summary>
+/// <returns>読み手の番号</returns>
+uint32_t MyEventStream::AddConsumer() {
+
+	uint32_t consumer = consumerCount_.load(std::memory_order_relaxed);
+	assert(consumer < kMaxConsumer);
+
+	std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+	ring->buffer = std::make_unique<CollisionEvent[]>(capacity_);
+	ring->head.store(0, std::memory_order_relaxed);
+	ring->cachedTail = 0;
+	ring->dropped.store(0, std::memory_order_relaxed);
+	ring->tail.store(0, std::memory_order_relaxed);
+	ring->cachedHead = 0;
+	rings_[consumer] = std::move(ring);
+
+	// リングを作り終えてから書き手に見えるようにする
+	consumerCount_.store(consumer + 1, std::memory_order_release);
+
+	return consumer;
+
+}
+
+/// <summary>
+/// イベントをまとめて書き込む関数 (書き手のスレッドからのみ呼ぶ)
+/// 読み手を待つことはなく、入りきらなかった分はその読み手の捨てた数に加える
+/// </summary>
+/// <param name="events">イベント配列</param>
+/// <param name="count">イベントの数</param>
+void MyEventStream::Publish(const CollisionEvent* events, size_t count) {
+
+	if (count == 0) {
+		return;
+	}
+
+	uint32_t consumerCount = consumerCount_.load(std::memory_order_acquire);
+	for (uint32_t consumer = 0; consumer < consumerCount; consumer++) {
+		Ring& ring = *rings_[consumer];
+		size_t head = ring.head.load(std::memory_order_relaxed);
+
+		// 空きが足りない場合だけ読み手の位置を読み直す
+		size_t freeCount = capacity_ - (head - ring.cachedTail);
+		if (freeCount < count) {
+			ring.cachedTail = ring.tail.load(std::memory_order_acquire);
+			freeCount = capacity_ - (head - ring.cachedTail);
+		}
+
+		size_t writeCount = std::min(count, freeCount);
+		if (writeCount < count) {
+			ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + (count - writeCount), std::memory_order_relaxed);
+		}
+		if (writeCount == 0) {
+			continue;
+		}
+
+		// 配列の終端で折り返して書き込む
+		size_t begin = head & mask_;
+		size_t firstCount = std::min(writeCount, capacity_ - begin);
+		std::copy(events, events + firstCount, &ring.buffer[begin]);
+		std::copy(events + firstCount, events + writeCount, &ring.buffer[0]);
+
+		// 書き込んだ内容が読み手に見えてから位置を進める
+		ring.head.store(head + writeCount, std::memory_order_release);
+	}
+
+}
+
+/// <summary>
+/// 届いているイベントをまとめて取り出す関数 (読み手ごとに1つのスレッドからのみ呼ぶ)
+/// </summary>
+/// <param name="consumer">読み手の番号</param>
+/// <param name="events">イベントの格納先</param>
+/// <param name="maxCount">取り出す最大数</param>
+/// <returns>取り出した数</returns>
+size_t MyEventStream::Drain(uint32_t consumer, CollisionEvent* events, size_t maxCount) {
+
+	assert(consumer < GetConsumerCount());
+	Ring& ring = *rings_[consumer];
+	size_t tail = ring.tail.load(std::memory_order_relaxed);
+
+	// 手元の書き込み位置で足りない場合だけ読み直す
+	size_t available = ring.cachedHead - tail;
+	if (available < maxCount) {
+		ring.cachedHead = ring.head.load(std::memory_order_acquire);
+		available = ring.cachedHead - tail;
+	}
+
+	size_t readCount = std::min(maxCount, available);
+	if (readCount == 0) {
+		return 0;
+	}
+
+	// 配列の終端で折り返して読み込む
+	size_t begin = tail & mask_;
+	size_t firstCount = std::min(readCount, capacity_ - begin);
+	std::copy(&ring.buffer[begin], &ring.buffer[begin] + firstCount, events);
+	std::copy(&ring.buffer[0], &ring.buffer[0] + (readCount - firstCount), events + firstCount);
+
+	// 読み終えてから書き手に空きを知らせる
+	ring.tail.store(tail + readCount, std::memory_order_release);
+
+	return readCount;
+
+}
+
+/// <summary>
+/// リングが一杯で捨てたイベントの数を取得する関数
+/// </summary>
+/// <param name="consumer">読み手の番号</param>
+/// <returns>捨てたイベントの数</returns>
+uint64_t MyEventStream::GetDroppedCount(uint32_t consumer) const {
+
+	assert(consumer < GetConsumerCount());
+	return rings_[consumer]->dropped.load(std::memory_order_relaxed);
+
+}
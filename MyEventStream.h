@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "MyPairCache.h"
+
+/// <summary>
+/// 衝突イベント
+/// </summary>
+struct CollisionEvent {
+	uint32_t frame; // 発生したフレーム
+	PairEventRecord pair; // 組と状態の変化
+};
+
+/// <summary>
+/// 衝突イベントを他のスレッドに受け渡すクラス
+/// 読み手ごとに書き手1つ、読み手1つのリングバッファを持ち、書き手は全ての読み手に同じイベントを書き込む
+/// ロックを使わず、リングが一杯の読み手の分は待たずに捨てて数を記録する
+/// </summary>
+class MyEventStream
+{
+public:
+
+	// 登録できる読み手の最大数
+	static const uint32_t kMaxConsumer = 8;
+
+	/// <summary>
+	/// コンストラクタ
+	/// </summary>
+	/// <param name="capacity">読み手ごとに保持できるイベントの数 (2の累乗に切り上げられる)</param>
+	explicit MyEventStream(size_t capacity = 4096);
+
+	/// <summary>
+	/// 読み手を登録する関数
+	/// 書き込み中でも登録できるが、登録は1つのスレッドから行うこと
+	/// 登録前に書き込まれたイベントは受け取れない
+	/// </summary>
+	/// <returns>読み手の番号</returns>
+	uint32_t AddConsumer();
+
+	/// <summary>
+	/// イベントをまとめて書き込む関数 (書き手のスレッドからのみ呼ぶ)
+	/// 読み手を待つことはなく、入りきらなかった分はその読み手の捨てた数に加える
+	/// </summary>
+	/// <param name="events">イベント配列</param>
+	/// <param name="count">イベントの数</param>
+	void Publish(const CollisionEvent* events, size_t count);
+
+	/// <summary>
+	/// 届いているイベントをまとめて取り出す関数 (読み手ごとに1つのスレッドからのみ呼ぶ)
+	/// </summary>
+	/// <param name="consumer">読み手の番号</param>
+	/// <param name="events">イベントの格納先</param>
+	/// <param name="maxCount">取り出す最大数</param>
+	/// <returns>取り出した数</returns>
+	size_t Drain(uint32_t consumer, CollisionEvent* events, size_t maxCount);
+
+	/// <summary>
+	/// リングが一杯で捨てたイベントの数を取得する関数
+	/// </summary>
+	/// <param name="consumer">読み手の番号</param>
+	/// <returns>捨てたイベントの数</returns>
+	uint64_t GetDroppedCount(uint32_t consumer) const;
+
+	/// <summary>
+	/// 登録されている読み手の数を取得する関数
+	/// </summary>
+	/// <returns>読み手の数</returns>
+	uint32_t GetConsumerCount() const { return consumerCount_.load(std::memory_order_acquire); }
+
+private:
+
+	// キャッシュラインの大きさ
+	static const size_t kCacheLineSize = 64;
+
+	/// <summary>
+	/// 読み手ごとのリングバッファ
+	/// 書き手と読み手が更新する値を別のキャッシュラインに置き、互いの位置は減ったときだけ読み直す
+	/// alignas で揃えると詰め物の警告 (C4324) が出るため、値の組の間にキャッシュライン1つ分の詰め物を明示的に置く
+	/// (確保した位置が揃っていなくても、組の間が1ライン以上離れるので同じラインに載らない)
+	/// </summary>
+	struct Ring {
+		std::unique_ptr<CollisionEvent[]> buffer; // イベント配列
+		char padding0[kCacheLineSize]; // 書き手の値との間の詰め物
+
+		std::atomic<size_t> head; // 書き込み位置 (書き手のみ更新する)
+		size_t cachedTail; // 書き手が最後に読んだ読み込み位置
+		std::atomic<uint64_t> dropped; // 捨てたイベントの数 (書き手のみ更新する)
+		char padding1[kCacheLineSize]; // 書き手の値と読み手の値の間の詰め物
+
+		std::atomic<size_t> tail; // 読み込み位置 (読み手のみ更新する)
+		size_t cachedHead; // 読み手が最後に読んだ書き込み位置
+		char padding2[kCacheLineSize]; // 後ろに確保された値との間の詰め物
+	};
+
+	// 読み手ごとに保持できるイベントの数
+	size_t capacity_;
+	// 位置から配列の番号を求めるマスク
+	size_t mask_;
+	// 読み手ごとのリングバッファ
+	std::unique_ptr<Ring> rings_[kMaxConsumer];
+	// 登録されている読み手の数
+	std::atomic<uint32_t> consumerCount_ = 0;
+
+};
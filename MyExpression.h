@@ -0,0 +1,213 @@
+﻿#pragma once
+#include <cassert>
+#include <cstddef>
+#include "Vector3.h"
+#include "Matrix4x4.h"
+
+static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 must be three packed floats");
+static_assert(sizeof(Matrix4x4) == sizeof(float) * 16, "Matrix4x4 must be sixteen packed floats");
+
+/// <summary>
+/// ベクトル、行列、ベクトル配列の要素ごとの演算を式のまま保持し、代入時にまとめて計算する仕組み
+/// a + t * b のような式で途中の Vector3 を作らず、1回のループで全ての要素を求める
+/// 値は float の並びとして扱うので、Vector3 配列は 3 * 個数 の float 配列として1つのループになる
+/// 各要素は同じ番号の要素だけから求まるので、代入先を式の中で使ってもよい
+/// 例: Vector3 point = MyExpr::Eval(MyExpr::Ref(r.origin) + t * MyExpr::Ref(r.diff));
+/// 例: MyExpr::Store(out, count, MyExpr::Ref(a, count) + t * MyExpr::Ref(b, count));
+/// </summary>
+namespace MyExpr {
+
+	/// <summary>
+	/// 式の基底 (CRTP)
+	/// </summary>
+	/// <typeparam name="E">派生した式の型</typeparam>
+	template<typename E>
+	struct Expr {
+
+		/// <summary>
+		/// 派生した式を取得する関数
+		/// </summary>
+		const E& Self() const { return static_cast<const E&>(*this); }
+
+	};
+
+	/// <summary>
+	/// 既存の値を参照する式 (float の並び)
+	/// </summary>
+	struct Terminal : Expr<Terminal> {
+		const float* data; // 先頭
+		size_t size; // 要素数
+
+		Terminal(const float* data, size_t size) : data(data), size(size) {}
+		float operator[](size_t i) const { return data[i]; }
+		size_t Size() const { return size; }
+	};
+
+	/// <summary>
+	/// スカラーの式 (全ての要素に同じ値を使う)
+	/// </summary>
+	struct Scalar : Expr<Scalar> {
+		float value; // 値
+
+		explicit Scalar(float value) : value(value) {}
+		float operator[](size_t) const { return value; }
+		size_t Size() const { return 0; }
+	};
+
+	/// <summary>
+	/// 要素ごとの二項演算の式
+	/// </summary>
+	/// <typeparam name="L">左辺の式の型</typeparam>
+	/// <typeparam name="R">右辺の式の型</typeparam>
+	/// <typeparam name="Op">演算 (static float Apply(float, float))</typeparam>
+	template<typename L, typename R, typename Op>
+	struct Binary : Expr<Binary<L, R, Op>> {
+		L left; // 左辺
+		R right; // 右辺
+
+		Binary(const L& left, const R& right) : left(left), right(right) {
+			// スカラー以外の要素数は揃っていること
+			assert(left.Size() == 0 || right.Size() == 0 || left.Size() == right.Size());
+		}
+		float operator[](size_t i) const { return Op::Apply(left[i], right[i]); }
+		size_t Size() const { return left.Size() != 0 ? left.Size() : right.Size(); }
+	};
+
+	/// <summary>
+	/// 符号を反転する式
+	/// </summary>
+	/// <typeparam name="E">元の式の型</typeparam>
+	template<typename E>
+	struct Negate : Expr<Negate<E>> {
+		E expr; // 元の式
+
+		explicit Negate(const E& expr) : expr(expr) {}
+		float operator[](size_t i) const { return -expr[i]; }
+		size_t Size() const { return expr.Size(); }
+	};
+
+	/// <summary>
+	/// 要素ごとの演算
+	/// </summary>
+	struct AddOp { static float Apply(float a, float b) { return a + b; } };
+	struct SubtractOp { static float Apply(float a, float b) { return a - b; } };
+	struct MultiplyOp { static float Apply(float a, float b) { return a * b; } };
+	struct DivideOp { static float Apply(float a, float b) { return a / b; } };
+
+#pragma region 式の作成
+
+	/// <summary>
+	/// ベクトルを参照する式を作成する関数
+	/// </summary>
+	/// <param name="v">ベクトル (式を計算するまで有効であること)</param>
+	/// <returns>式</returns>
+	inline Terminal Ref(const Vector3& v) { return Terminal(&v.x, 3); }
+
+	/// <summary>
+	/// 行列を参照する式を作成する関数
+	/// </summary>
+	/// <param name="m">行列 (式を計算するまで有効であること)</param>
+	/// <returns>式</returns>
+	inline Terminal Ref(const Matrix4x4& m) { return Terminal(&m.m[0][0], 16); }
+
+	/// <summary>
+	/// ベクトル配列を参照する式を作成する関数
+	/// </summary>
+	/// <param name="v">ベクトル配列 (式を計算するまで有効であること)</param>
+	/// <param name="count">ベクトルの数</param>
+	/// <returns>式</returns>
+	inline Terminal Ref(const Vector3* v, size_t count) { return Terminal(&v->x, count * 3); }
+
+	template<typename L, typename R>
+	Binary<L, R, AddOp> operator+(const Expr<L>& left, const Expr<R>& right) { return { left.Self(), right.Self() }; }
+
+	template<typename L, typename R>
+	Binary<L, R, SubtractOp> operator-(const Expr<L>& left, const Expr<R>& right) { return { left.Self(), right.Self() }; }
+
+	template<typename E>
+	Negate<E> operator-(const Expr<E>& expr) { return Negate<E>(expr.Self()); }
+
+	template<typename E>
+	Binary<Scalar, E, MultiplyOp> operator*(float scalar, const Expr<E>& expr) { return { Scalar(scalar), expr.Self() }; }
+
+	template<typename E>
+	Binary<E, Scalar, MultiplyOp> operator*(const Expr<E>& expr, float scalar) { return { expr.Self(), Scalar(scalar) }; }
+
+	template<typename E>
+	Binary<E, Scalar, DivideOp> operator/(const Expr<E>& expr, float scalar) { return { expr.Self(), Scalar(scalar) }; }
+
+#pragma endregion
+
+#pragma region 式の計算
+
+	/// <summary>
+	/// 3要素の式の内積を求める関数 (MyMath::Dot と同じ順で計算する)
+	/// </summary>
+	/// <param name="left">式1</param>
+	/// <param name="right">式2</param>
+	/// <returns>内積</returns>
+	template<typename L, typename R>
+	float Dot(const Expr<L>& left, const Expr<R>& right) {
+		const L& l = left.Self();
+		const R& r = right.Self();
+		assert(l.Size() == 3 && r.Size() == 3);
+		return (l[0] * r[0]) + (l[1] * r[1]) + (l[2] * r[2]);
+	}
+
+	/// <summary>
+	/// 3要素の式をベクトルとして計算する関数
+	/// </summary>
+	/// <param name="expr">式</param>
+	/// <returns>ベクトル</returns>
+	template<typename E>
+	Vector3 Eval(const Expr<E>& expr) {
+		const E& e = expr.Self();
+		assert(e.Size() == 3);
+		return { e[0], e[1], e[2] };
+	}
+
+	/// <summary>
+	/// 式を計算してベクトルに代入する関数
+	/// </summary>
+	/// <param name="out">代入先</param>
+	/// <param name="expr">3要素の式</param>
+	template<typename E>
+	void Store(Vector3& out, const Expr<E>& expr) {
+		out = Eval(expr);
+	}
+
+	/// <summary>
+	/// 式を計算して行列に代入する関数
+	/// </summary>
+	/// <param name="out">代入先</param>
+	/// <param name="expr">16要素の式</param>
+	template<typename E>
+	void Store(Matrix4x4& out, const Expr<E>& expr) {
+		const E& e = expr.Self();
+		assert(e.Size() == 16);
+		float* data = &out.m[0][0];
+		for (size_t i = 0; i < 16; i++) {
+			data[i] = e[i];
+		}
+	}
+
+	/// <summary>
+	/// 式を計算してベクトル配列に代入する関数 (3 * 個数 の float を1つのループで求める)
+	/// </summary>
+	/// <param name="out">代入先</param>
+	/// <param name="count">ベクトルの数</param>
+	/// <param name="expr">式</param>
+	template<typename E>
+	void Store(Vector3* out, size_t count, const Expr<E>& expr) {
+		const E& e = expr.Self();
+		assert(e.Size() == count * 3);
+		float* data = &out->x;
+		size_t size = count * 3;
+		for (size_t i = 0; i < size; i++) {
+			data[i] = e[i];
+		}
+	}
+
+#pragma endregion
+
+}
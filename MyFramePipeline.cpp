@@ -0,0 +1,122 @@
+﻿#include "MyFramePipeline.h"
+
+/// <summary>
+/// デストラクタ
+/// </summary>
+MyFramePipeline::~MyFramePipeline() {
+	Finalize();
+}
+
+/// <summary>
+/// 初期化 (ワーカースレッドを起動する)
+/// </summary>
+void MyFramePipeline::Initialize() {
+
+	// 起動済みなら何もしない
+	if (worker_.joinable()) {
+		return;
+	}
+
+	isExit_ = false;
+	hasJob_ = false;
+	worker_ = std::thread(&MyFramePipeline::WorkerMain, this);
+
+}
+
+/// <summary>
+/// 終了処理 (実行中の更新処理を待ってワーカースレッドを終了する)
+/// </summary>
+void MyFramePipeline::Finalize() {
+
+	if (!worker_.joinable()) {
+		return;
+	}
+
+	// 終了を通知する
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		isExit_ = true;
+	}
+	condition_.notify_all();
+	worker_.join();
+
+}
+
+/// <summary>
+/// 更新処理をワーカースレッドに渡す関数
+/// 前の更新処理が終わっていない場合は終わるまで待つ
+/// </summary>
+/// <param name="job">更新処理 (必要な値は値渡しでキャプチャすること)</param>
+void MyFramePipeline::Kick(UpdateJob job) {
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return !hasJob_; });
+	job_ = std::move(job);
+	hasJob_ = true;
+	lock.unlock();
+	condition_.notify_all();
+
+}
+
+/// <summary>
+/// 完了している中で最新の描画命令の配列を取得する関数
+/// 次に Acquire を呼ぶまで内容は変更されない
+/// </summary>
+/// <returns>描画命令の配列</returns>
+const DrawCommandList& MyFramePipeline::Acquire() {
+
+	// 未読の配列があれば読み込み中の配列と交換する
+	if (middleIndex_.load(std::memory_order_acquire) & kDirtyFlag) {
+		readIndex_ = middleIndex_.exchange(readIndex_, std::memory_order_acq_rel) & ~kDirtyFlag;
+	}
+
+	return buffers_[readIndex_];
+
+}
+
+/// <summary>
+/// 実行中の更新処理が終わるまで待つ関数
+/// </summary>
+void MyFramePipeline::Wait() {
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return !hasJob_; });
+
+}
+
+/// <summary>
+/// ワーカースレッドの処理
+/// </summary>
+void MyFramePipeline::WorkerMain() {
+
+	while (true) {
+
+		// 更新処理が渡されるまで待つ
+		UpdateJob job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this] { return hasJob_ || isExit_; });
+			if (!hasJob_ && isExit_) {
+				break;
+			}
+			job = std::move(job_);
+		}
+
+		// 書き込み中の配列に描画命令を作成する
+		DrawCommandList& list = buffers_[writeIndex_];
+		list.clear();
+		job(list);
+
+		// 受け渡し待ちの配列と交換して未読にする
+		writeIndex_ = middleIndex_.exchange(writeIndex_ | kDirtyFlag, std::memory_order_acq_rel) & ~kDirtyFlag;
+
+		// 完了を通知する
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			hasJob_ = false;
+		}
+		condition_.notify_all();
+
+	}
+
+}
@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "MyDebug.h"
+
+/// <summary>
+/// 更新処理と描画処理を1フレームずらして並列に行うクラス
+/// ワーカースレッドがフレームNの更新と描画命令の作成を行う間に、
+/// メインスレッドはフレームN-1の描画命令を実行する
+/// </summary>
+class MyFramePipeline
+{
+public:
+
+	/// <summary>
+	/// ワーカースレッドで実行する更新処理
+	/// 引数の描画命令の配列に描画内容を追加する
+	/// </summary>
+	using UpdateJob = std::function<void(DrawCommandList& list)>;
+
+	/// <summary>
+	/// デストラクタ
+	/// </summary>
+	~MyFramePipeline();
+
+	/// <summary>
+	/// 初期化 (ワーカースレッドを起動する)
+	/// </summary>
+	void Initialize();
+
+	/// <summary>
+	/// 終了処理 (実行中の更新処理を待ってワーカースレッドを終了する)
+	/// </summary>
+	void Finalize();
+
+	/// <summary>
+	/// 更新処理をワーカースレッドに渡す関数
+	/// 前の更新処理が終わっていない場合は終わるまで待つ
+	/// </summary>
+	/// <param name="job">更新処理 (必要な値は値渡しでキャプチャすること)</param>
+	void Kick(UpdateJob job);
+
+	/// <summary>
+	/// 完了している中で最新の描画命令の配列を取得する関数
+	/// 次に Acquire を呼ぶまで内容は変更されない
+	/// </summary>
+	/// <returns>描画命令の配列</returns>
+	const DrawCommandList& Acquire();
+
+	/// <summary>
+	/// 実行中の更新処理が終わるまで待つ関数
+	/// </summary>
+	void Wait();
+
+private:
+
+	/// <summary>
+	/// ワーカースレッドの処理
+	/// </summary>
+	void WorkerMain();
+
+	// 未読の描画命令があることを示すフラグ
+	static const uint32_t kDirtyFlag = 4;
+
+	// 3つの描画命令の配列 (書き込み中、受け渡し待ち、読み込み中)
+	DrawCommandList buffers_[3];
+	// ワーカースレッドが書き込む配列の番号
+	uint32_t writeIndex_ = 0;
+	// 受け渡し待ちの配列の番号 (未読なら kDirtyFlag が立つ)
+	std::atomic<uint32_t> middleIndex_ = 1;
+	// メインスレッドが読み込む配列の番号
+	uint32_t readIndex_ = 2;
+
+	// ワーカースレッド
+	std::thread worker_;
+	// 更新処理の受け渡し用
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	UpdateJob job_;
+	bool hasJob_ = false;
+	bool isExit_ = false;
+
+};
@@ -0,0 +1,58 @@
+﻿#include "MyFrameScheduler.h"
+
+/// <summary>
+/// コンストラクタ
+/// </summary>
+/// <param name="fixedStep">更新1回あたりの時間 (秒)</param>
+/// <param name="maxStepCount">1フレームで行う更新の最大回数 (追いつけない分は捨てる)</param>
+MyFrameScheduler::MyFrameScheduler(float fixedStep, uint32_t maxStepCount) : fixedStep_(fixedStep), maxStepCount_(maxStepCount) {
+}
+
+/// <summary>
+/// フレームの開始 (前回の呼び出しからの経過時間を測って Advance する)
+/// 初回の呼び出しでは時間を進めない
+/// </summary>
+/// <returns>このフレームで行う更新の回数</returns>
+uint32_t MyFrameScheduler::BeginFrame() {
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	float deltaTime = 0.0f;
+	if (isStarted_) {
+		deltaTime = std::chrono::duration<float>(now - lastTime_).count();
+	}
+	lastTime_ = now;
+	isStarted_ = true;
+
+	return Advance(deltaTime);
+
+}
+
+/// <summary>
+/// 経過時間を貯めて、このフレームで行う更新の回数を求める関数
+/// </summary>
+/// <param name="deltaTime">経過時間 (秒)</param>
+/// <returns>このフレームで行う更新の回数</returns>
+uint32_t MyFrameScheduler::Advance(float deltaTime) {
+
+	accumulator_ += deltaTime;
+
+	uint32_t stepCount = 0;
+	while (accumulator_ >= fixedStep_) {
+		// 追いつけない分は捨てる (止まっていた後にまとめて更新しないようにする)
+		if (stepCount == maxStepCount_) {
+			uint64_t droppedCount = uint64_t(accumulator_ / fixedStep_);
+			droppedStepCount_ += droppedCount;
+			accumulator_ -= float(droppedCount) * fixedStep_;
+			if (accumulator_ >= fixedStep_ || accumulator_ < 0.0f) {
+				accumulator_ = 0.0f;
+			}
+			break;
+		}
+		accumulator_ -= fixedStep_;
+		stepCount++;
+	}
+	stepCount_ += stepCount;
+
+	return stepCount;
+
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+
+/// <summary>
+/// 描画とは別の一定の間隔で更新処理を行うための時間管理クラス
+/// 描画のたびに経過時間を貯め、時間刻み分たまるごとに1回の更新を行わせる
+/// 描画は残りの経過時間の割合 (GetAlpha) で直前の2回の更新結果を補間する
+/// </summary>
+class MyFrameScheduler
+{
+public:
+
+	/// <summary>
+	/// コンストラクタ
+	/// </summary>
+	/// <param name="fixedStep">更新1回あたりの時間 (秒)</param>
+	/// <param name="maxStepCount">1フレームで行う更新の最大回数 (追いつけない分は捨てる)</param>
+	explicit MyFrameScheduler(float fixedStep = 1.0f / 60.0f, uint32_t maxStepCount = 5);
+
+	/// <summary>
+	/// フレームの開始 (前回の呼び出しからの経過時間を測って Advance する)
+	/// 初回の呼び出しでは時間を進めない
+	/// </summary>
+	/// <returns>このフレームで行う更新の回数</returns>
+	uint32_t BeginFrame();
+
+	/// <summary>
+	/// 経過時間を貯めて、このフレームで行う更新の回数を求める関数
+	/// </summary>
+	/// <param name="deltaTime">経過時間 (秒)</param>
+	/// <returns>このフレームで行う更新の回数</returns>
+	uint32_t Advance(float deltaTime);
+
+	/// <summary>
+	/// 貯まっている経過時間の時間刻みに対する割合を取得する関数 (描画時の補間用)
+	/// </summary>
+	/// <returns>0以上1未満の割合</returns>
+	float GetAlpha() const { return accumulator_ / fixedStep_; }
+
+	/// <summary>
+	/// 更新1回あたりの時間を取得する関数
+	/// </summary>
+	/// <returns>時間 (秒)</returns>
+	float GetFixedStep() const { return fixedStep_; }
+
+	/// <summary>
+	/// これまでに行わせた更新の回数を取得する関数
+	/// </summary>
+	/// <returns>更新の回数</returns>
+	uint64_t GetStepCount() const { return stepCount_; }
+
+	/// <summary>
+	/// 追いつけずに捨てた更新の回数を取得する関数
+	/// </summary>
+	/// <returns>捨てた更新の回数</returns>
+	uint64_t GetDroppedStepCount() const { return droppedStepCount_; }
+
+private:
+
+	// 更新1回あたりの時間
+	float fixedStep_;
+	// 1フレームで行う更新の最大回数
+	uint32_t maxStepCount_;
+	// 貯まっている経過時間
+	float accumulator_ = 0.0f;
+	// これまでに行わせた更新の回数
+	uint64_t stepCount_ = 0;
+	// 追いつけずに捨てた更新の回数
+	uint64_t droppedStepCount_ = 0;
+	// 前回の BeginFrame の時刻
+	std::chrono::steady_clock::time_point lastTime_;
+	// BeginFrame を呼んだことがあるか
+	bool isStarted_ = false;
+
+};
@@ -0,0 +1,793 @@
+﻿#include "MyGJK.h"
+#include <cfloat>
+#include <vector>
+
+namespace {
+
+	// GJKの最大反復回数
+	const uint32_t kGJKMaxIteration = 64;
+	// GJKの収束判定の相対許容誤差
+	const float kGJKTolerance = 1.0e-6f;
+	// 原点に重なっているとみなす距離の2乗
+	const float kGJKEpsilon = 1.0e-12f;
+	// つぶれた四面体とみなす体積と辺の長さの積の比
+	const float kGJKFlatRatio = 1.0e-4f;
+	// EPAの最大反復回数
+	const uint32_t kEPAMaxIteration = 64;
+	// EPAの収束判定の許容誤差
+	const float kEPATolerance = 1.0e-4f;
+
+	/// <summary>
+	/// 単体から指定した頂点だけを残す関数
+	/// </summary>
+	/// <param name="simplex">単体</param>
+	/// <param name="index">残す頂点の番号</param>
+	/// <param name="count">残す頂点数</param>
+	void KeepVertex(GJKSimplex& simplex, const uint32_t* index, uint32_t count) {
+		GJKSimplex temp = simplex;
+		for (uint32_t i = 0; i < count; i++) {
+			simplex.direction[i] = temp.direction[index[i]];
+			simplex.pointA[i] = temp.pointA[index[i]];
+			simplex.pointB[i] = temp.pointB[index[i]];
+			simplex.point[i] = temp.point[index[i]];
+		}
+		simplex.count = count;
+	}
+
+	/// <summary>
+	/// 点 p と三角形 abc の重心座標を求める関数
+	/// </summary>
+	/// <param name="p">点 (三角形の平面上にあること)</param>
+	/// <param name="a">頂点a</param>
+	/// <param name="b">頂点b</param>
+	/// <param name="c">頂点c</param>
+	/// <param name="weight">重心座標の格納先</param>
+	void Barycentric(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c, float weight[3]) {
+		Vector3 v0 = b - a;
+		Vector3 v1 = c - a;
+		Vector3 v2 = p - a;
+		float d00 = MyMath::Dot(v0, v0);
+		float d01 = MyMath::Dot(v0, v1);
+		float d11 = MyMath::Dot(v1, v1);
+		float d20 = MyMath::Dot(v2, v0);
+		float d21 = MyMath::Dot(v2, v1);
+		float denom = d00 * d11 - d01 * d01;
+
+		// 三角形がつぶれている場合は頂点aを返す
+		if (denom == 0.0f) {
+			weight[0] = 1.0f;
+			weight[1] = 0.0f;
+			weight[2] = 0.0f;
+			return;
+		}
+
+		weight[1] = (d11 * d20 - d01 * d21) / denom;
+		weight[2] = (d00 * d21 - d01 * d20) / denom;
+		weight[0] = 1.0f - weight[1] - weight[2];
+	}
+
+}
+
+/// <summary>
+/// 形状のサポート点を求める関数 (球、カプセルは半径を除いた芯の形状で求める)
+/// </summary>
+/// <param name="shape">凸形状</param>
+/// <param name="direction">探索方向</param>
+/// <returns>探索方向に最も遠い点</returns>
+Vector3 MyGJK::Support(const ConvexShape& shape, const Vector3& direction) {
+
+	// 点群の場合は全ての頂点から探す
+	if (const PointCloud* cloud = std::get_if<PointCloud>(&shape)) {
+		assert(cloud->count > 0);
+		Vector3 result = cloud->points[0];
+		float maxDot = MyMath::Dot(result, direction);
+		for (uint32_t i = 1; i < cloud->count; i++) {
+			float dot = MyMath::Dot(cloud->points[i], direction);
+			if (maxDot < dot) {
+				maxDot = dot;
+				result = cloud->points[i];
+			}
+		}
+		return result;
+	}
+
+	// 球の芯は中心点
+	if (const Sphere* sphere = std::get_if<Sphere>(&shape)) {
+		return sphere->center;
+	}
+
+	// OBBは各軸の向きに応じて頂点を選ぶ
+	if (const OBB* obb = std::get_if<OBB>(&shape)) {
+		const float size[3] = { obb->size.x, obb->size.y, obb->size.z };
+		Vector3 result = obb->center;
+		for (uint32_t i = 0; i < 3; i++) {
+			float sign = MyMath::Dot(direction, obb->orientations[i]) >= 0.0f ? 1.0f : -1.0f;
+			result = MyMath::Add(result, MyMath::Multiply(sign * size[i], obb->orientations[i]));
+		}
+		return result;
+	}
+
+	// カプセルの芯は中心線
+	if (const Capsule* capsule = std::get_if<Capsule>(&shape)) {
+		if (MyMath::Dot(direction, capsule->segment.diff) >= 0.0f) {
+			return MyMath::Add(capsule->segment.origin, capsule->segment.diff);
+		}
+		return capsule->segment.origin;
+	}
+
+	// 三角形は3頂点から探す
+	const Triangle& triangle = std::get<Triangle>(shape);
+	uint32_t index = 0;
+	float maxDot = MyMath::Dot(triangle.vertex[0], direction);
+	for (uint32_t i = 1; i < 3; i++) {
+		float dot = MyMath::Dot(triangle.vertex[i], direction);
+		if (maxDot < dot) {
+			maxDot = dot;
+			index = i;
+		}
+	}
+	return triangle.vertex[index];
+
+}
+
+/// <summary>
+/// 形状の半径を求める関数 (球、カプセル以外は0)
+/// </summary>
+/// <param name="shape">凸形状</param>
+/// <returns>半径</returns>
+float MyGJK::GetRadius(const ConvexShape& shape) {
+
+	if (const Sphere* sphere = std::get_if<Sphere>(&shape)) {
+		return sphere->radius;
+	}
+	if (const Capsule* capsule = std::get_if<Capsule>(&shape)) {
+		return capsule->radius;
+	}
+	return 0.0f;
+
+}
+
+/// <summary>
+/// 2つの凸形状間の最短距離を求める関数
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+/// <returns>距離計算結果</returns>
+GJKResult MyGJK::Distance(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache) {
+
+	// 芯の形状同士の距離を求める
+	GJKSimplex simplex{};
+	if (cache != nullptr) {
+		simplex = *cache;
+	}
+	GJKResult result = SolveCore(a, b, simplex);
+	if (cache != nullptr) {
+		*cache = simplex;
+	}
+
+	// 芯が重なっていればそのまま返す
+	if (result.isIntersect) {
+		return result;
+	}
+
+	// 半径の分だけ距離を縮める
+	float radiusA = GetRadius(a);
+	float radiusB = GetRadius(b);
+	if (radiusA == 0.0f && radiusB == 0.0f) {
+		return result;
+	}
+
+	Vector3 normal = MyMath::Multiply(1.0f / result.distance, result.closestB - result.closestA);
+	result.closestA = MyMath::Add(result.closestA, MyMath::Multiply(radiusA, normal));
+	result.closestB = MyMath::Subtract(result.closestB, MyMath::Multiply(radiusB, normal));
+	result.distance -= radiusA + radiusB;
+	if (result.distance <= 0.0f) {
+		result.isIntersect = true;
+		result.distance = 0.0f;
+	}
+
+	return result;
+
+}
+
+/// <summary>
+/// 2つの凸形状の当たり判定をとる関数
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+/// <returns>衝突しているか</returns>
+bool MyGJK::IsCollision(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache) {
+
+	return Distance(a, b, cache).isIntersect;
+
+}
+
+/// <summary>
+/// 2つの凸形状のめり込み量と衝突法線を求める関数
+/// 芯の形状が重なっている場合はEPAで求める
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+/// <returns>めり込み計算結果</returns>
+PenetrationResult MyGJK::Penetration(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache) {
+
+	// 結果格納用
+	PenetrationResult result{};
+
+	// 芯の形状同士の距離を求める
+	GJKSimplex simplex{};
+	if (cache != nullptr) {
+		simplex = *cache;
+	}
+	GJKResult core = SolveCore(a, b, simplex);
+	if (cache != nullptr) {
+		*cache = simplex;
+	}
+
+	float radiusA = GetRadius(a);
+	float radiusB = GetRadius(b);
+
+	if (!core.isIntersect) {
+		// 芯が離れている場合は半径の分だけめり込んでいるか調べる
+		result.depth = radiusA + radiusB - core.distance;
+		if (result.depth < 0.0f) {
+			return result;
+		}
+		result.normal = MyMath::Multiply(1.0f / core.distance, core.closestB - core.closestA);
+	}
+	else if (!SolveEPA(a, b, simplex, result)) {
+		// 芯が接しているだけで方向が決まらない場合
+		result.normal = { 0.0f, 1.0f, 0.0f };
+		result.depth = radiusA + radiusB;
+	}
+	else {
+		// EPAで求めためり込みに半径の分を加える
+		result.depth += radiusA + radiusB;
+		core.closestA = result.contactA;
+		core.closestB = result.contactB;
+	}
+
+	// 接触点を半径の分だけ表面に移動する
+	result.isIntersect = true;
+	result.contactA = MyMath::Add(core.closestA, MyMath::Multiply(radiusA, result.normal));
+	result.contactB = MyMath::Subtract(core.closestB, MyMath::Multiply(radiusB, result.normal));
+
+	return result;
+
+}
+
+/// <summary>
+/// 芯の形状同士でGJKを行う関数
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="simplex">初期単体 (終了時の単体で上書きされる)</param>
+/// <returns>距離計算結果</returns>
+GJKResult MyGJK::SolveCore(const ConvexShape& a, const ConvexShape& b, GJKSimplex& simplex) {
+
+	// 結果格納用
+	GJKResult result{};
+
+	// 前回の探索方向で現在の形状のサポート点を求め直す (同じ点になったものは除く)
+	GJKSimplex warmStart = simplex;
+	simplex.count = 0;
+	for (uint32_t i = 0; i < warmStart.count && i < 4; i++) {
+		PushSupport(a, b, warmStart.direction[i], simplex);
+		for (uint32_t j = 0; j + 1 < simplex.count; j++) {
+			Vector3 diff = simplex.point[j] - simplex.point[simplex.count - 1];
+			if (MyMath::Dot(diff, diff) <= kGJKEpsilon) {
+				simplex.count--;
+				break;
+			}
+		}
+	}
+
+	// 単体が空の場合は任意の方向から始める
+	if (simplex.count == 0) {
+		PushSupport(a, b, { 1.0f, 0.0f, 0.0f }, simplex);
+	}
+
+	float weight[4] = {};
+	Vector3 closest{};
+
+	for (result.iteration = 0; result.iteration < kGJKMaxIteration; result.iteration++) {
+
+		// 単体上の原点への最近点を求める
+		closest = ReduceSimplex(simplex, weight);
+		float closestSq = MyMath::Dot(closest, closest);
+
+		// 原点を含んでいれば衝突している
+		if (simplex.count == 4 || closestSq <= kGJKEpsilon) {
+			result.isIntersect = true;
+			break;
+		}
+
+		// 原点の方向に新しいサポート点を求める
+		PushSupport(a, b, MyMath::Multiply(-1.0f, closest), simplex);
+		const Vector3& newPoint = simplex.point[simplex.count - 1];
+
+		// これ以上原点に近づかなければ収束している
+		if (closestSq - MyMath::Dot(closest, newPoint) <= kGJKTolerance * closestSq) {
+			simplex.count--;
+			break;
+		}
+
+		// 既にある頂点と同じ点なら収束している
+		bool isDuplicate = false;
+		for (uint32_t i = 0; i + 1 < simplex.count; i++) {
+			Vector3 diff = simplex.point[i] - newPoint;
+			if (MyMath::Dot(diff, diff) <= kGJKEpsilon) {
+				isDuplicate = true;
+				break;
+			}
+		}
+		if (isDuplicate) {
+			simplex.count--;
+			break;
+		}
+
+	}
+
+	// 反復回数の上限に達した場合は追加した頂点を含めて最近点を求め直す
+	if (result.iteration == kGJKMaxIteration) {
+		closest = ReduceSimplex(simplex, weight);
+		result.isIntersect = simplex.count == 4 || MyMath::Dot(closest, closest) <= kGJKEpsilon;
+	}
+
+	if (result.isIntersect) {
+		result.distance = 0.0f;
+		result.closestA = simplex.pointA[0];
+		result.closestB = simplex.pointB[0];
+		return result;
+	}
+
+	// 重心座標から各形状上の最近点を求める
+	result.closestA = { 0.0f, 0.0f, 0.0f };
+	result.closestB = { 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i < simplex.count; i++) {
+		result.closestA = MyMath::Add(result.closestA, MyMath::Multiply(weight[i], simplex.pointA[i]));
+		result.closestB = MyMath::Add(result.closestB, MyMath::Multiply(weight[i], simplex.pointB[i]));
+	}
+	result.distance = MyMath::Length(closest);
+
+	return result;
+
+}
+
+/// <summary>
+/// ミンコフスキー差のサポート点を単体の末尾に追加する関数
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="direction">探索方向</param>
+/// <param name="simplex">追加先の単体</param>
+void MyGJK::PushSupport(const ConvexShape& a, const ConvexShape& b, const Vector3& direction, GJKSimplex& simplex) {
+
+	assert(simplex.count < 4);
+
+	uint32_t index = simplex.count;
+	simplex.direction[index] = direction;
+	simplex.pointA[index] = Support(a, direction);
+	simplex.pointB[index] = Support(b, MyMath::Multiply(-1.0f, direction));
+	simplex.point[index] = simplex.pointA[index] - simplex.pointB[index];
+	simplex.count++;
+
+}
+
+/// <summary>
+/// 単体上の原点への最近点を求め、不要な頂点を取り除く関数
+/// </summary>
+/// <param name="simplex">単体</param>
+/// <param name="weight">残った頂点の重心座標</param>
+/// <returns>最近点 (原点が四面体の内部にある場合は0ベクトル)</returns>
+Vector3 MyGJK::ReduceSimplex(GJKSimplex& simplex, float weight[4]) {
+
+	// 点
+	if (simplex.count == 1) {
+		weight[0] = 1.0f;
+		return simplex.point[0];
+	}
+
+	// 線分
+	if (simplex.count == 2) {
+		const Vector3& a = simplex.point[0];
+		Vector3 ab = simplex.point[1] - a;
+		float lengthSq = MyMath::Dot(ab, ab);
+		float t = lengthSq == 0.0f ? 0.0f : -MyMath::Dot(a, ab) / lengthSq;
+
+		// 端点の外側ならその頂点だけを残す
+		if (t <= 0.0f) {
+			const uint32_t index[] = { 0 };
+			KeepVertex(simplex, index, 1);
+			weight[0] = 1.0f;
+			return simplex.point[0];
+		}
+		if (t >= 1.0f) {
+			const uint32_t index[] = { 1 };
+			KeepVertex(simplex, index, 1);
+			weight[0] = 1.0f;
+			return simplex.point[0];
+		}
+
+		weight[0] = 1.0f - t;
+		weight[1] = t;
+		return MyMath::Add(a, MyMath::Multiply(t, ab));
+	}
+
+	// 三角形 (ボロノイ領域で判定する)
+	if (simplex.count == 3) {
+		const Vector3& a = simplex.point[0];
+		const Vector3& b = simplex.point[1];
+		const Vector3& c = simplex.point[2];
+		Vector3 ab = b - a;
+		Vector3 ac = c - a;
+
+		// 頂点aの領域
+		float d1 = -MyMath::Dot(ab, a);
+		float d2 = -MyMath::Dot(ac, a);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			const uint32_t index[] = { 0 };
+			KeepVertex(simplex, index, 1);
+			weight[0] = 1.0f;
+			return simplex.point[0];
+		}
+
+		// 頂点bの領域
+		float d3 = -MyMath::Dot(ab, b);
+		float d4 = -MyMath::Dot(ac, b);
+		if (d3 >= 0.0f && d4 <= d3) {
+			const uint32_t index[] = { 1 };
+			KeepVertex(simplex, index, 1);
+			weight[0] = 1.0f;
+			return simplex.point[0];
+		}
+
+		// 辺abの領域
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			float t = d1 / (d1 - d3);
+			const uint32_t index[] = { 0, 1 };
+			KeepVertex(simplex, index, 2);
+			weight[0] = 1.0f - t;
+			weight[1] = t;
+			return MyMath::Add(simplex.point[0], MyMath::Multiply(t, ab));
+		}
+
+		// 頂点cの領域
+		float d5 = -MyMath::Dot(ab, c);
+		float d6 = -MyMath::Dot(ac, c);
+		if (d6 >= 0.0f && d5 <= d6) {
+			const uint32_t index[] = { 2 };
+			KeepVertex(simplex, index, 1);
+			weight[0] = 1.0f;
+			return simplex.point[0];
+		}
+
+		// 辺acの領域
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			float t = d2 / (d2 - d6);
+			const uint32_t index[] = { 0, 2 };
+			KeepVertex(simplex, index, 2);
+			weight[0] = 1.0f - t;
+			weight[1] = t;
+			return MyMath::Add(simplex.point[0], MyMath::Multiply(t, ac));
+		}
+
+		// 辺bcの領域
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+			float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			const uint32_t index[] = { 1, 2 };
+			KeepVertex(simplex, index, 2);
+			weight[0] = 1.0f - t;
+			weight[1] = t;
+			return MyMath::Add(simplex.point[0], MyMath::Multiply(t, simplex.point[1] - simplex.point[0]));
+		}
+
+		// 三角形がつぶれている場合は最も長い辺の線分として扱う
+		float denom = va + vb + vc;
+		if (denom <= kGJKEpsilon) {
+			Vector3 bc = c - b;
+			float abSq = MyMath::Dot(ab, ab);
+			float acSq = MyMath::Dot(ac, ac);
+			float bcSq = MyMath::Dot(bc, bc);
+			uint32_t index[2] = { 0, 1 };
+			if (acSq >= abSq && acSq >= bcSq) {
+				index[1] = 2;
+			}
+			else if (bcSq >= abSq) {
+				index[0] = 1;
+				index[1] = 2;
+			}
+			KeepVertex(simplex, index, 2);
+			return ReduceSimplex(simplex, weight);
+		}
+
+		// 面の内側
+		float v = vb / denom;
+		float w = vc / denom;
+		weight[0] = 1.0f - v - w;
+		weight[1] = v;
+		weight[2] = w;
+		return MyMath::Add(a, MyMath::Add(MyMath::Multiply(v, ab), MyMath::Multiply(w, ac)));
+	}
+
+	// 四面体 (原点が外側にある面の中から最も近いものを選ぶ)
+	const uint32_t kFace[4][4] = {
+		{ 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 }
+	};
+
+	// つぶれていれば全ての面を候補にする
+	// (面の向きが丸めで逆転し、原点が外にあっても全ての面が候補から外れることがあるため、
+	//  体積を辺の長さの積との比で判定する)
+	Vector3 ab = simplex.point[1] - simplex.point[0];
+	Vector3 ac = simplex.point[2] - simplex.point[0];
+	Vector3 ad = simplex.point[3] - simplex.point[0];
+	float volume = MyMath::Dot(ad, MyMath::Cross(ab, ac));
+	float edgeProduct = std::sqrt(MyMath::Dot(ab, ab) * MyMath::Dot(ac, ac) * MyMath::Dot(ad, ad));
+	bool isFlat = std::abs(volume) <= kGJKFlatRatio * edgeProduct || std::abs(volume) <= kGJKEpsilon;
+
+	GJKSimplex best{};
+	float bestWeight[4] = {};
+	Vector3 bestClosest{};
+	float bestDistanceSq = FLT_MAX;
+
+	for (uint32_t i = 0; i < 4; i++) {
+		const Vector3& a = simplex.point[kFace[i][0]];
+		Vector3 normal = MyMath::Cross(simplex.point[kFace[i][1]] - a, simplex.point[kFace[i][2]] - a);
+		float originSide = -MyMath::Dot(normal, a);
+		float oppositeSide = MyMath::Dot(normal, simplex.point[kFace[i][3]] - a);
+
+		// 原点と反対側の頂点が同じ側にある面は候補にしない
+		if (!isFlat && originSide * oppositeSide >= 0.0f) {
+			continue;
+		}
+
+		// 面上の最近点を求める
+		GJKSimplex face = simplex;
+		KeepVertex(face, kFace[i], 3);
+		float faceWeight[4] = {};
+		Vector3 faceClosest = ReduceSimplex(face, faceWeight);
+		float distanceSq = MyMath::Dot(faceClosest, faceClosest);
+		if (distanceSq < bestDistanceSq) {
+			bestDistanceSq = distanceSq;
+			best = face;
+			bestClosest = faceClosest;
+			for (uint32_t j = 0; j < 4; j++) {
+				bestWeight[j] = faceWeight[j];
+			}
+		}
+	}
+
+	// 全ての面の内側なら原点を含んでいる
+	if (bestDistanceSq == FLT_MAX) {
+		return { 0.0f, 0.0f, 0.0f };
+	}
+
+	simplex = best;
+	for (uint32_t j = 0; j < 4; j++) {
+		weight[j] = bestWeight[j];
+	}
+	return bestClosest;
+
+}
+
+/// <summary>
+/// EPAで芯の形状同士のめり込みを求める関数
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="simplex">原点を含むGJKの単体</param>
+/// <param name="result">結果格納先</param>
+/// <returns>求められたか</returns>
+bool MyGJK::SolveEPA(const ConvexShape& a, const ConvexShape& b, const GJKSimplex& simplex, PenetrationResult& result) {
+
+	// 原点が単体の境界上にある場合は四面体になるまで頂点を追加する
+	GJKSimplex tetra = simplex;
+	const Vector3 kAxis[6] = {
+		{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+	};
+	while (tetra.count < 4) {
+
+		// 追加を試す探索方向を求める
+		Vector3 candidate[6];
+		uint32_t candidateCount = 0;
+		if (tetra.count == 1) {
+			for (uint32_t i = 0; i < 6; i++) {
+				candidate[candidateCount++] = kAxis[i];
+			}
+		}
+		else if (tetra.count == 2) {
+			Vector3 ab = tetra.point[1] - tetra.point[0];
+			for (uint32_t i = 0; i < 6; i += 2) {
+				Vector3 perpendicular = MyMath::Cross(ab, kAxis[i]);
+				candidate[candidateCount++] = perpendicular;
+				candidate[candidateCount++] = MyMath::Multiply(-1.0f, perpendicular);
+			}
+		}
+		else {
+			Vector3 normal = MyMath::Cross(tetra.point[1] - tetra.point[0], tetra.point[2] - tetra.point[0]);
+			candidate[candidateCount++] = normal;
+			candidate[candidateCount++] = MyMath::Multiply(-1.0f, normal);
+		}
+
+		// 単体が退化しない点が見つかれば追加する
+		uint32_t prevCount = tetra.count;
+		for (uint32_t i = 0; i < candidateCount && tetra.count == prevCount; i++) {
+			if (MyMath::Dot(candidate[i], candidate[i]) <= kGJKEpsilon) {
+				continue;
+			}
+			PushSupport(a, b, candidate[i], tetra);
+			Vector3 offset = tetra.point[prevCount] - tetra.point[0];
+			float degenerate = 0.0f;
+			if (prevCount == 1) {
+				degenerate = MyMath::Dot(offset, offset);
+			}
+			else if (prevCount == 2) {
+				Vector3 cross = MyMath::Cross(tetra.point[1] - tetra.point[0], offset);
+				degenerate = MyMath::Dot(cross, cross);
+			}
+			else {
+				Vector3 normal = MyMath::Cross(tetra.point[1] - tetra.point[0], tetra.point[2] - tetra.point[0]);
+				degenerate = std::abs(MyMath::Dot(normal, offset));
+			}
+			if (degenerate <= kGJKEpsilon) {
+				tetra.count--;
+			}
+		}
+
+		// どの方向にも広がらなければ形状が平たいため求められない
+		if (tetra.count == prevCount) {
+			return false;
+		}
+
+	}
+
+	// 多面体の頂点
+	struct Vertex {
+		Vector3 point; // ミンコフスキー差上の点
+		Vector3 pointA; // 形状Aのサポート点
+		Vector3 pointB; // 形状Bのサポート点
+	};
+	// 多面体の面
+	struct Face {
+		uint32_t index[3]; // 頂点番号 (外側から見て反時計回り)
+		Vector3 normal; // 外向きの法線
+		float distance; // 原点からの距離
+	};
+	// 辺
+	struct Edge {
+		uint32_t index[2]; // 頂点番号
+	};
+
+	std::vector<Vertex> vertices;
+	std::vector<Face> faces;
+	std::vector<Edge> edges;
+	vertices.reserve(kEPAMaxIteration + 4);
+	faces.reserve(kEPAMaxIteration * 2 + 4);
+
+	for (uint32_t i = 0; i < 4; i++) {
+		vertices.push_back({ tetra.point[i], tetra.pointA[i], tetra.pointB[i] });
+	}
+
+	// 面を追加する関数
+	auto addFace = [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+		Face face{ { i0, i1, i2 }, {}, FLT_MAX };
+		Vector3 normal = MyMath::Cross(vertices[i1].point - vertices[i0].point, vertices[i2].point - vertices[i0].point);
+		float length = MyMath::Length(normal);
+		if (length > 0.0f) {
+			face.normal = MyMath::Multiply(1.0f / length, normal);
+			face.distance = MyMath::Dot(face.normal, vertices[i0].point);
+		}
+		faces.push_back(face);
+	};
+
+	// 四面体の面を外向きになるように追加する
+	const uint32_t kFace[4][4] = {
+		{ 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 }
+	};
+	for (uint32_t i = 0; i < 4; i++) {
+		Vector3 normal = MyMath::Cross(
+			vertices[kFace[i][1]].point - vertices[kFace[i][0]].point,
+			vertices[kFace[i][2]].point - vertices[kFace[i][0]].point);
+		if (MyMath::Dot(normal, vertices[kFace[i][3]].point - vertices[kFace[i][0]].point) > 0.0f) {
+			addFace(kFace[i][0], kFace[i][2], kFace[i][1]);
+		}
+		else {
+			addFace(kFace[i][0], kFace[i][1], kFace[i][2]);
+		}
+	}
+
+	// 原点に最も近い面を探す関数
+	auto findClosestFace = [&]() {
+		size_t closestIndex = 0;
+		for (size_t i = 1; i < faces.size(); i++) {
+			if (faces[i].distance < faces[closestIndex].distance) {
+				closestIndex = i;
+			}
+		}
+		return closestIndex;
+	};
+
+	// 原点に最も近い面を外側に広げていく
+	for (uint32_t iteration = 0; iteration < kEPAMaxIteration; iteration++) {
+
+		Face closest = faces[findClosestFace()];
+
+		// 面の法線方向のサポート点を求める
+		Vertex support{};
+		support.pointA = Support(a, closest.normal);
+		support.pointB = Support(b, MyMath::Multiply(-1.0f, closest.normal));
+		support.point = support.pointA - support.pointB;
+
+		// これ以上広がらなければ収束している
+		if (MyMath::Dot(support.point, closest.normal) - closest.distance <= kEPATolerance) {
+			break;
+		}
+
+		uint32_t newIndex = uint32_t(vertices.size());
+		vertices.push_back(support);
+
+		// 新しい点から見える面を取り除き、境界の辺を求める
+		edges.clear();
+		for (size_t i = 0; i < faces.size();) {
+			const Face& face = faces[i];
+			if (MyMath::Dot(face.normal, support.point - vertices[face.index[0]].point) <= 0.0f) {
+				i++;
+				continue;
+			}
+			for (uint32_t j = 0; j < 3; j++) {
+				Edge edge{ { face.index[j], face.index[(j + 1) % 3] } };
+				// 逆向きの辺が既にあれば共有辺なので取り除く
+				bool isShared = false;
+				for (size_t k = 0; k < edges.size(); k++) {
+					if (edges[k].index[0] == edge.index[1] && edges[k].index[1] == edge.index[0]) {
+						edges[k] = edges.back();
+						edges.pop_back();
+						isShared = true;
+						break;
+					}
+				}
+				if (!isShared) {
+					edges.push_back(edge);
+				}
+			}
+			faces[i] = faces.back();
+			faces.pop_back();
+		}
+
+		// 境界の辺と新しい点で面を作る
+		for (const Edge& edge : edges) {
+			addFace(edge.index[0], edge.index[1], newIndex);
+		}
+
+		if (faces.empty()) {
+			return false;
+		}
+
+	}
+
+	// 最も近い面上の点の重心座標から接触点を求める
+	const Face& face = faces[findClosestFace()];
+	float weight[3];
+	Barycentric(MyMath::Multiply(face.distance, face.normal),
+		vertices[face.index[0]].point, vertices[face.index[1]].point, vertices[face.index[2]].point, weight);
+
+	result.normal = face.normal;
+	result.depth = face.distance;
+	result.contactA = { 0.0f, 0.0f, 0.0f };
+	result.contactB = { 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i < 3; i++) {
+		result.contactA = MyMath::Add(result.contactA, MyMath::Multiply(weight[i], vertices[face.index[i]].pointA));
+		result.contactB = MyMath::Add(result.contactB, MyMath::Multiply(weight[i], vertices[face.index[i]].pointB));
+	}
+
+	return true;
+
+}
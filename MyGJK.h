@@ -0,0 +1,141 @@
+﻿#pragma once
+#include <cstdint>
+#include <variant>
+#include "MyStruct.h"
+#include "MyMath.h"
+
+/// <summary>
+/// 点群構造体 (凸包として扱う)
+/// </summary>
+struct PointCloud {
+	const Vector3* points; // 頂点配列
+	uint32_t count; // 頂点数
+};
+
+/// <summary>
+/// サポート関数で表される凸形状
+/// </summary>
+using ConvexShape = std::variant<PointCloud, Sphere, OBB, Capsule, Triangle>;
+
+/// <summary>
+/// GJKの単体 (フレーム間で保持すると次回の計算の初期値になる)
+/// </summary>
+struct GJKSimplex {
+	Vector3 direction[4]; // 各頂点を求めた探索方向
+	Vector3 pointA[4]; // 形状Aのサポート点
+	Vector3 pointB[4]; // 形状Bのサポート点
+	Vector3 point[4]; // ミンコフスキー差上の点 (pointA - pointB)
+	uint32_t count; // 頂点数
+};
+
+/// <summary>
+/// GJKの距離計算結果構造体
+/// </summary>
+struct GJKResult {
+	bool isIntersect; // 衝突しているか
+	float distance; // 形状間の最短距離 (衝突時は0)
+	Vector3 closestA; // 形状A上の最近点
+	Vector3 closestB; // 形状B上の最近点
+	uint32_t iteration; // 反復回数
+};
+
+/// <summary>
+/// EPAのめり込み計算結果構造体
+/// </summary>
+struct PenetrationResult {
+	bool isIntersect; // 衝突しているか
+	Vector3 normal; // 衝突法線 (AからBへ向かう向き)
+	float depth; // めり込み量
+	Vector3 contactA; // 形状A上の接触点
+	Vector3 contactB; // 形状B上の接触点
+};
+
+/// <summary>
+/// GJK/EPAによる凸形状の当たり判定を行うクラス
+/// </summary>
+class MyGJK
+{
+public:
+
+	/// <summary>
+	/// 形状のサポート点を求める関数 (球、カプセルは半径を除いた芯の形状で求める)
+	/// </summary>
+	/// <param name="shape">凸形状</param>
+	/// <param name="direction">探索方向</param>
+	/// <returns>探索方向に最も遠い点</returns>
+	static Vector3 Support(const ConvexShape& shape, const Vector3& direction);
+
+	/// <summary>
+	/// 形状の半径を求める関数 (球、カプセル以外は0)
+	/// </summary>
+	/// <param name="shape">凸形状</param>
+	/// <returns>半径</returns>
+	static float GetRadius(const ConvexShape& shape);
+
+	/// <summary>
+	/// 2つの凸形状間の最短距離を求める関数
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+	/// <returns>距離計算結果</returns>
+	static GJKResult Distance(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache = nullptr);
+
+	/// <summary>
+	/// 2つの凸形状の当たり判定をとる関数
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+	/// <returns>衝突しているか</returns>
+	static bool IsCollision(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache = nullptr);
+
+	/// <summary>
+	/// 2つの凸形状のめり込み量と衝突法線を求める関数
+	/// 芯の形状が重なっている場合はEPAで求める
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="cache">前フレームの単体 (nullptrなら使用しない、結果で上書きされる)</param>
+	/// <returns>めり込み計算結果</returns>
+	static PenetrationResult Penetration(const ConvexShape& a, const ConvexShape& b, GJKSimplex* cache = nullptr);
+
+private:
+
+	/// <summary>
+	/// 芯の形状同士でGJKを行う関数
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="simplex">初期単体 (終了時の単体で上書きされる)</param>
+	/// <returns>距離計算結果</returns>
+	static GJKResult SolveCore(const ConvexShape& a, const ConvexShape& b, GJKSimplex& simplex);
+
+	/// <summary>
+	/// ミンコフスキー差のサポート点を単体の末尾に追加する関数
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="direction">探索方向</param>
+	/// <param name="simplex">追加先の単体</param>
+	static void PushSupport(const ConvexShape& a, const ConvexShape& b, const Vector3& direction, GJKSimplex& simplex);
+
+	/// <summary>
+	/// 単体上の原点への最近点を求め、不要な頂点を取り除く関数
+	/// </summary>
+	/// <param name="simplex">単体</param>
+	/// <param name="weight">残った頂点の重心座標</param>
+	/// <returns>最近点 (原点が四面体の内部にある場合は0ベクトル)</returns>
+	static Vector3 ReduceSimplex(GJKSimplex& simplex, float weight[4]);
+
+	/// <summary>
+	/// EPAで芯の形状同士のめり込みを求める関数
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <param name="simplex">原点を含むGJKの単体</param>
+	/// <param name="result">結果格納先</param>
+	/// <returns>求められたか</returns>
+	static bool SolveEPA(const ConvexShape& a, const ConvexShape& b, const GJKSimplex& simplex, PenetrationResult& result);
+
+};
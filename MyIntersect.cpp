@@ -0,0 +1,217 @@
+﻿#include "MyIntersect.h"
+#include <algorithm>
+
+/// <summary>
+/// AABBをGJKで扱う形状に変換する関数 (OBBとして扱う)
+/// </summary>
+/// <param name="shape">AABB</param>
+/// <returns>GJKで扱う形状</returns>
+ConvexShape MyIntersect::ToConvexShape(const AABB& shape) {
+
+	OBB obb{};
+	obb.center = MyMath::Multiply(0.5f, MyMath::Add(shape.min, shape.max));
+	obb.orientations[0] = { 1.0f, 0.0f, 0.0f };
+	obb.orientations[1] = { 0.0f, 1.0f, 0.0f };
+	obb.orientations[2] = { 0.0f, 0.0f, 1.0f };
+	obb.size = MyMath::Multiply(0.5f, shape.max - shape.min);
+	return obb;
+
+}
+
+/// <summary>
+/// 平面と凸形状の当たり判定をとる関数
+/// </summary>
+/// <param name="plane">平面</param>
+/// <param name="shape">凸形状</param>
+/// <returns>衝突しているか</returns>
+bool MyIntersect::IsCollisionPlane(const Plane& plane, const ConvexShape& shape) {
+
+	// 法線方向と逆方向のサポート点が平面を挟んでいれば衝突している
+	float radius = MyGJK::GetRadius(shape);
+	float maxDistance = MyMath::Dot(MyGJK::Support(shape, plane.normal), plane.normal) + radius;
+	float minDistance = MyMath::Dot(MyGJK::Support(shape, MyMath::Multiply(-1.0f, plane.normal)), plane.normal) - radius;
+
+	return minDistance <= plane.distance && plane.distance <= maxDistance;
+
+}
+
+/// <summary>
+/// 2つの線 (origin + t * diff, t は [min, max] の範囲) の当たり判定をとる関数
+/// 直線は [-∞, ∞]、半直線は [0, ∞]、線分は [0, 1] を指定する
+/// </summary>
+/// <param name="a">線A</param>
+/// <param name="minA">線Aの媒介変数の下限</param>
+/// <param name="maxA">線Aの媒介変数の上限</param>
+/// <param name="b">線B</param>
+/// <param name="minB">線Bの媒介変数の下限</param>
+/// <param name="maxB">線Bの媒介変数の上限</param>
+/// <returns>最短距離が誤差の範囲で0か</returns>
+bool MyIntersect::IsCollisionLinear(const Line& a, float minA, float maxA, const Line& b, float minB, float maxB) {
+
+	// 長さ0とみなす差分ベクトルの長さの2乗
+	const float kDegenerateLengthSq = 1.0e-12f;
+	// 交わっているとみなす最短距離 (座標の大きさに対する比)
+	const float kRelativeTolerance = 1.0e-6f;
+
+	// 媒介変数 s, t で表した最近点 a.origin + s * a.diff, b.origin + t * b.diff を求める
+	Vector3 r = a.origin - b.origin;
+	float lengthSqA = MyMath::Dot(a.diff, a.diff);
+	float lengthSqB = MyMath::Dot(b.diff, b.diff);
+	float f = MyMath::Dot(b.diff, r);
+	float s = std::clamp(0.0f, minA, maxA);
+	float t = std::clamp(0.0f, minB, maxB);
+
+	if (lengthSqA <= kDegenerateLengthSq && lengthSqB <= kDegenerateLengthSq) {
+		// どちらも点
+	}
+	else if (lengthSqA <= kDegenerateLengthSq) {
+		// A が点
+		t = std::clamp(f / lengthSqB, minB, maxB);
+	}
+	else {
+		float c = MyMath::Dot(a.diff, r);
+		if (lengthSqB <= kDegenerateLengthSq) {
+			// B が点
+			s = std::clamp(-c / lengthSqA, minA, maxA);
+		}
+		else {
+			// 平行でなければ直線同士の最近点から始め、B の範囲に収めてから A を求め直す
+			float d = MyMath::Dot(a.diff, b.diff);
+			float denominator = lengthSqA * lengthSqB - d * d;
+			if (denominator > 0.0f) {
+				s = std::clamp((d * f - c * lengthSqB) / denominator, minA, maxA);
+			}
+			t = (d * s + f) / lengthSqB;
+			if (t < minB || maxB < t) {
+				t = std::clamp(t, minB, maxB);
+				s = std::clamp((t * d - c) / lengthSqA, minA, maxA);
+			}
+		}
+	}
+
+	Vector3 closestA = a.origin + MyMath::Multiply(s, a.diff);
+	Vector3 closestB = b.origin + MyMath::Multiply(t, b.diff);
+	Vector3 offset = closestA - closestB;
+	float scale = 1.0f + std::max({ std::abs(closestA.x), std::abs(closestA.y), std::abs(closestA.z) });
+	float tolerance = kRelativeTolerance * scale;
+
+	return MyMath::Dot(offset, offset) <= tolerance * tolerance;
+
+}
+
+/// <summary>
+/// 線 (origin + t * diff, t >= minT) のうち凸形状の境界球の内側にある部分を線分として求める関数
+/// 凸形状は境界球の内側にあるので、求めた線分と凸形状の判定は元の線との判定と一致する
+/// </summary>
+/// <param name="line">線</param>
+/// <param name="minT">媒介変数の下限 (直線は -∞、半直線は 0)</param>
+/// <param name="shape">凸形状</param>
+/// <param name="segment">線分の格納先</param>
+/// <returns>境界球と交わるか (false なら凸形状とも交わらない)</returns>
+bool MyIntersect::ClipToBounds(const Line& line, float minT, const ConvexShape& shape, Segment& segment) {
+
+	// 丸めで取りこぼさないように境界球を少し大きくする
+	const float kBoundsMargin = 1.0e-4f;
+
+	// 各軸方向のサポート点から境界箱を求め、それを囲む球を境界球とする
+	float radius = MyGJK::GetRadius(shape);
+	Vector3 min, max;
+	min.x = MyGJK::Support(shape, { -1.0f, 0.0f, 0.0f }).x - radius;
+	min.y = MyGJK::Support(shape, { 0.0f, -1.0f, 0.0f }).y - radius;
+	min.z = MyGJK::Support(shape, { 0.0f, 0.0f, -1.0f }).z - radius;
+	max.x = MyGJK::Support(shape, { 1.0f, 0.0f, 0.0f }).x + radius;
+	max.y = MyGJK::Support(shape, { 0.0f, 1.0f, 0.0f }).y + radius;
+	max.z = MyGJK::Support(shape, { 0.0f, 0.0f, 1.0f }).z + radius;
+	Vector3 center = MyMath::Multiply(0.5f, min + max);
+	Vector3 halfSize = MyMath::Multiply(0.5f, max - min);
+	float boundsRadius = MyMath::Length(halfSize) * (1.0f + kBoundsMargin) + kBoundsMargin;
+
+	// 長さ0の線は点として扱う
+	float lengthSq = MyMath::Dot(line.diff, line.diff);
+	if (lengthSq == 0.0f) {
+		segment = { line.origin, { 0.0f, 0.0f, 0.0f } };
+		return true;
+	}
+
+	// 境界球の中心に最も近い点から、球の内側にある範囲 [t0, t1] を求める
+	float tCenter = MyMath::Dot(center - line.origin, line.diff) / lengthSq;
+	Vector3 offset = center - (line.origin + MyMath::Multiply(tCenter, line.diff));
+	float remainSq = boundsRadius * boundsRadius - MyMath::Dot(offset, offset);
+	if (remainSq < 0.0f) {
+		return false;
+	}
+	float halfRange = std::sqrt(remainSq / lengthSq);
+	float t0 = std::max(tCenter - halfRange, minT);
+	float t1 = tCenter + halfRange;
+	if (t1 < t0) {
+		return false;
+	}
+
+	segment.origin = line.origin + MyMath::Multiply(t0, line.diff);
+	segment.diff = MyMath::Multiply(t1 - t0, line.diff);
+	return true;
+
+}
+
+/// <summary>
+/// 種類の混ざった形状の組をまとめて判定する関数
+/// 組を種類の組み合わせごとに並べ替え、組み合わせごとの型の決まったループで判定する
+/// 全ての種類の組み合わせに判定が用意されていることをコンパイル時に確認する
+/// </summary>
+/// <param name="primitives">形状配列</param>
+/// <param name="pairs">判定する組 (形状配列の番号)</param>
+/// <param name="pairCount">組の数</param>
+/// <param name="results">判定結果の格納先 (pairCount 個)</param>
+void MyIntersect::IntersectMany(const Primitive* primitives, const std::pair<uint32_t, uint32_t>* pairs, size_t pairCount, bool* results) {
+
+	// 種類の組み合わせごとの判定関数の表
+	static constexpr auto kBucketTable = MakeBucketTable(std::make_index_sequence<kTypeCount * kTypeCount>());
+
+	// 作業用の配列を使い回す
+	static thread_local PrimitiveArrays arrays;
+	static thread_local std::vector<uint32_t> localIndex;
+	static thread_local std::vector<BatchPair> sorted;
+	std::apply([](auto&... array) { (array.clear(), ...); }, arrays);
+
+	// 組で参照される形状を種類ごとの配列に分ける
+	uint32_t primitiveCount = 0;
+	for (size_t i = 0; i < pairCount; i++) {
+		primitiveCount = std::max({ primitiveCount, pairs[i].first + 1, pairs[i].second + 1 });
+	}
+	localIndex.resize(primitiveCount);
+	for (uint32_t i = 0; i < primitiveCount; i++) {
+		std::visit([&](const auto& shape) {
+			auto& array = std::get<std::vector<std::decay_t<decltype(shape)>>>(arrays);
+			localIndex[i] = uint32_t(array.size());
+			array.push_back(shape);
+		}, primitives[i]);
+	}
+
+	// 種類の組み合わせごとの組の数を数える
+	std::array<uint32_t, kTypeCount * kTypeCount + 1> offset{};
+	for (size_t i = 0; i < pairCount; i++) {
+		size_t key = primitives[pairs[i].first].index() * kTypeCount + primitives[pairs[i].second].index();
+		offset[key + 1]++;
+	}
+	for (size_t key = 0; key < kTypeCount * kTypeCount; key++) {
+		offset[key + 1] += offset[key];
+	}
+
+	// 種類の組み合わせごとに並べる
+	sorted.resize(pairCount);
+	std::array<uint32_t, kTypeCount * kTypeCount> cursor{};
+	std::copy(offset.begin(), offset.end() - 1, cursor.begin());
+	for (size_t i = 0; i < pairCount; i++) {
+		size_t key = primitives[pairs[i].first].index() * kTypeCount + primitives[pairs[i].second].index();
+		sorted[cursor[key]++] = { localIndex[pairs[i].first], localIndex[pairs[i].second], uint32_t(i) };
+	}
+
+	// 組み合わせごとにまとめて判定する
+	for (size_t key = 0; key < kTypeCount * kTypeCount; key++) {
+		uint32_t count = offset[key + 1] - offset[key];
+		if (count > 0) {
+			kBucketTable[key](arrays, sorted.data() + offset[key], count, results);
+		}
+	}
+
+}
@@ -0,0 +1,323 @@
+﻿#pragma once
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "MyCollision.h"
+#include "MyGJK.h"
+
+/// <summary>
+/// 判定の組み合わせごとの実装 (カスタマイズポイント)
+/// static bool Test(const A&, const B&) を持つ特殊化を追加すると Intersect で使えるようになる
+/// 片方の順序だけ特殊化すれば逆順でも呼び出せる
+/// </summary>
+template<typename A, typename B>
+struct IntersectImpl;
+
+/// <summary>
+/// IntersectImpl が特殊化されているか
+/// </summary>
+template<typename A, typename B>
+concept HasIntersectImpl = requires(const A& a, const B& b) {
+	{ IntersectImpl<A, B>::Test(a, b) } -> std::convertible_to<bool>;
+};
+
+/// <summary>
+/// GJKで判定できる凸形状か
+/// </summary>
+template<typename T>
+concept ConvexPrimitive =
+	std::is_same_v<T, Sphere> || std::is_same_v<T, Segment> || std::is_same_v<T, Triangle> ||
+	std::is_same_v<T, OBB> || std::is_same_v<T, Capsule> || std::is_same_v<T, AABB>;
+
+/// <summary>
+/// 片側または両側に無限に伸びる線か (直線、半直線)
+/// </summary>
+template<typename T>
+concept UnboundedPrimitive = std::is_same_v<T, Line> || std::is_same_v<T, Ray>;
+
+/// <summary>
+/// A と B の判定が用意されているか
+/// </summary>
+template<typename A, typename B>
+concept Intersectable =
+	HasIntersectImpl<A, B> || HasIntersectImpl<B, A> ||
+	(ConvexPrimitive<A> && ConvexPrimitive<B>) ||
+	(std::is_same_v<A, Plane> && ConvexPrimitive<B>) || (ConvexPrimitive<A> && std::is_same_v<B, Plane>);
+
+/// <summary>
+/// 当たり判定の組み合わせを型から選ぶクラス
+/// </summary>
+class MyIntersect
+{
+public:
+
+	/// <summary>
+	/// 判定対象となる全ての形状
+	/// </summary>
+	using Primitive = std::variant<Sphere, Plane, Line, Ray, Segment, Triangle, OBB, Capsule, AABB>;
+
+	// 形状の種類の数
+	static constexpr size_t kTypeCount = std::variant_size_v<Primitive>;
+
+	/// <summary>
+	/// 凸形状をGJKで扱う形状に変換する関数
+	/// </summary>
+	/// <param name="shape">形状 (線分は半径0のカプセル、AABBはOBBとして扱う)</param>
+	/// <returns>GJKで扱う形状</returns>
+	static ConvexShape ToConvexShape(const Sphere& shape) { return shape; }
+	static ConvexShape ToConvexShape(const Segment& shape) { return Capsule{ shape, 0.0f }; }
+	static ConvexShape ToConvexShape(const Triangle& shape) { return shape; }
+	static ConvexShape ToConvexShape(const OBB& shape) { return shape; }
+	static ConvexShape ToConvexShape(const Capsule& shape) { return shape; }
+	static ConvexShape ToConvexShape(const AABB& shape);
+
+	/// <summary>
+	/// 平面と凸形状の当たり判定をとる関数
+	/// </summary>
+	/// <param name="plane">平面</param>
+	/// <param name="shape">凸形状</param>
+	/// <returns>衝突しているか</returns>
+	static bool IsCollisionPlane(const Plane& plane, const ConvexShape& shape);
+
+	/// <summary>
+	/// 2つの線 (origin + t * diff, t は [min, max] の範囲) の当たり判定をとる関数
+	/// 直線は [-∞, ∞]、半直線は [0, ∞]、線分は [0, 1] を指定する
+	/// </summary>
+	/// <param name="a">線A</param>
+	/// <param name="minA">線Aの媒介変数の下限</param>
+	/// <param name="maxA">線Aの媒介変数の上限</param>
+	/// <param name="b">線B</param>
+	/// <param name="minB">線Bの媒介変数の下限</param>
+	/// <param name="maxB">線Bの媒介変数の上限</param>
+	/// <returns>最短距離が誤差の範囲で0か</returns>
+	static bool IsCollisionLinear(const Line& a, float minA, float maxA, const Line& b, float minB, float maxB);
+
+	/// <summary>
+	/// 線 (origin + t * diff, t >= minT) のうち凸形状の境界球の内側にある部分を線分として求める関数
+	/// 凸形状は境界球の内側にあるので、求めた線分と凸形状の判定は元の線との判定と一致する
+	/// </summary>
+	/// <param name="line">線</param>
+	/// <param name="minT">媒介変数の下限 (直線は -∞、半直線は 0)</param>
+	/// <param name="shape">凸形状</param>
+	/// <param name="segment">線分の格納先</param>
+	/// <returns>境界球と交わるか (false なら凸形状とも交わらない)</returns>
+	static bool ClipToBounds(const Line& line, float minT, const ConvexShape& shape, Segment& segment);
+
+	/// <summary>
+	/// 2つの形状の当たり判定をとる関数 (引数の順序は問わない)
+	/// 専用の判定があればそれを使い、なければ凸形状同士はGJK、平面と凸形状はサポート点で判定する
+	/// </summary>
+	/// <param name="a">形状A</param>
+	/// <param name="b">形状B</param>
+	/// <returns>衝突しているか</returns>
+	template<typename A, typename B>
+		requires Intersectable<A, B>
+	static bool Intersect(const A& a, const B& b);
+
+	/// <summary>
+	/// 種類の混ざった形状の組をまとめて判定する関数
+	/// 組を種類の組み合わせごとに並べ替え、組み合わせごとの型の決まったループで判定する
+	/// 全ての種類の組み合わせに判定が用意されていることをコンパイル時に確認する
+	/// </summary>
+	/// <param name="primitives">形状配列</param>
+	/// <param name="pairs">判定する組 (形状配列の番号)</param>
+	/// <param name="pairCount">組の数</param>
+	/// <param name="results">判定結果の格納先 (pairCount 個)</param>
+	static void IntersectMany(const Primitive* primitives, const std::pair<uint32_t, uint32_t>* pairs, size_t pairCount, bool* results);
+
+private:
+
+	/// <summary>
+	/// 種類ごとに分けた形状配列
+	/// </summary>
+	template<typename Variant>
+	struct SplitArrays;
+	template<typename... Types>
+	struct SplitArrays<std::variant<Types...>> {
+		using Type = std::tuple<std::vector<Types>...>;
+	};
+	using PrimitiveArrays = SplitArrays<Primitive>::Type;
+
+	/// <summary>
+	/// 種類ごとの配列の番号に置き換えた組
+	/// </summary>
+	struct BatchPair {
+		uint32_t a; // 形状Aの種類ごとの配列の番号
+		uint32_t b; // 形状Bの種類ごとの配列の番号
+		uint32_t index; // 元の組の番号
+	};
+
+	/// <summary>
+	/// 1つの種類の組み合わせの組をまとめて判定する関数
+	/// </summary>
+	/// <param name="arrays">種類ごとに分けた形状配列</param>
+	/// <param name="pairs">組の配列</param>
+	/// <param name="count">組の数</param>
+	/// <param name="results">判定結果の格納先</param>
+	template<size_t I, size_t J>
+	static void IntersectBucket(const PrimitiveArrays& arrays, const BatchPair* pairs, size_t count, bool* results);
+
+	/// <summary>
+	/// 種類の組み合わせごとの判定関数の表を作る関数
+	/// </summary>
+	template<size_t... K>
+	static constexpr auto MakeBucketTable(std::index_sequence<K...>);
+
+};
+
+/// 専用の判定の特殊化
+
+template<> struct IntersectImpl<Sphere, Sphere> {
+	static bool Test(const Sphere& a, const Sphere& b) { return MyCollision::IsCollisionSphere(a, b); }
+};
+template<> struct IntersectImpl<Sphere, Plane> {
+	static bool Test(const Sphere& a, const Plane& b) { return MyCollision::IsCollisionPlane(a, b); }
+};
+template<> struct IntersectImpl<Line, Plane> {
+	static bool Test(const Line& a, const Plane& b) { return MyCollision::IsCollisionLine(a, b); }
+};
+template<> struct IntersectImpl<Ray, Plane> {
+	static bool Test(const Ray& a, const Plane& b) { return MyCollision::IsCollisionLine(a, b); }
+};
+template<> struct IntersectImpl<Segment, Plane> {
+	static bool Test(const Segment& a, const Plane& b) { return MyCollision::IsCollisionLine(a, b); }
+};
+template<> struct IntersectImpl<Ray, Sphere> {
+	static bool Test(const Ray& a, const Sphere& b) { return MyCollision::IntersectLine(a, b); }
+};
+template<> struct IntersectImpl<Ray, Triangle> {
+	static bool Test(const Ray& a, const Triangle& b) { return MyCollision::IntersectLine(a, b); }
+};
+template<> struct IntersectImpl<Line, Sphere> {
+	static bool Test(const Line& a, const Sphere& b) {
+		// 直線上の最近点までの距離で判定する
+		float lengthSq = MyMath::Dot(a.diff, a.diff);
+		float t = lengthSq > 0.0f ? MyMath::Dot(b.center - a.origin, a.diff) / lengthSq : 0.0f;
+		Vector3 offset = b.center - (a.origin + MyMath::Multiply(t, a.diff));
+		return MyMath::Dot(offset, offset) <= b.radius * b.radius;
+	}
+};
+template<> struct IntersectImpl<Triangle, Segment> {
+	static bool Test(const Triangle& a, const Segment& b) { return MyCollision::IsCollisionTriangle(a, b); }
+};
+template<> struct IntersectImpl<Triangle, Sphere> {
+	static bool Test(const Triangle& a, const Sphere& b) { return MyCollision::IsCollisionTriangle(a, b); }
+};
+template<> struct IntersectImpl<AABB, AABB> {
+	static bool Test(const AABB& a, const AABB& b) { return MyCollision::IsCollisionAABB(a, b); }
+};
+template<> struct IntersectImpl<Segment, AABB> {
+	static bool Test(const Segment& a, const AABB& b) {
+		float tEnter, tExit;
+		return MyCollision::IntersectAABB(a, b, tEnter, tExit);
+	}
+};
+
+/// 直線、半直線と線の判定 (最短距離で判定する)
+template<UnboundedPrimitive A, typename B>
+	requires (UnboundedPrimitive<B> || std::is_same_v<B, Segment>)
+struct IntersectImpl<A, B> {
+	static bool Test(const A& a, const B& b) {
+		constexpr float kMinA = std::is_same_v<A, Line> ? -std::numeric_limits<float>::infinity() : 0.0f;
+		constexpr float kMinB = std::is_same_v<B, Line> ? -std::numeric_limits<float>::infinity() : 0.0f;
+		constexpr float kMaxB = std::is_same_v<B, Segment> ? 1.0f : std::numeric_limits<float>::infinity();
+		return MyIntersect::IsCollisionLinear({ a.origin, a.diff }, kMinA, std::numeric_limits<float>::infinity(), { b.origin, b.diff }, kMinB, kMaxB);
+	}
+};
+
+/// 直線、半直線と有限の凸形状の判定 (境界球で線分に切り取って線分の判定を使う)
+template<UnboundedPrimitive A, typename B>
+	requires (ConvexPrimitive<B> && !std::is_same_v<B, Segment>)
+struct IntersectImpl<A, B> {
+	static bool Test(const A& a, const B& b) {
+		constexpr float kMinA = std::is_same_v<A, Line> ? -std::numeric_limits<float>::infinity() : 0.0f;
+		Segment segment;
+		if (!MyIntersect::ClipToBounds({ a.origin, a.diff }, kMinA, MyIntersect::ToConvexShape(b), segment)) {
+			return false;
+		}
+		return MyIntersect::Intersect(segment, b);
+	}
+};
+
+template<> struct IntersectImpl<Plane, Plane> {
+	static bool Test(const Plane& a, const Plane& b) {
+		// 平行でなければ必ず交わり、平行なら同じ平面の場合のみ交わる
+		Vector3 cross = MyMath::Cross(a.normal, b.normal);
+		if (MyMath::Dot(cross, cross) > 0.0f) {
+			return true;
+		}
+		float sign = MyMath::Dot(a.normal, b.normal) < 0.0f ? -1.0f : 1.0f;
+		return a.distance == sign * b.distance;
+	}
+};
+
+/// <summary>
+/// 2つの形状の当たり判定をとる関数 (引数の順序は問わない)
+/// 専用の判定があればそれを使い、なければ凸形状同士はGJK、平面と凸形状はサポート点で判定する
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <returns>衝突しているか</returns>
+template<typename A, typename B>
+	requires Intersectable<A, B>
+bool MyIntersect::Intersect(const A& a, const B& b) {
+
+	if constexpr (HasIntersectImpl<A, B>) {
+		return IntersectImpl<A, B>::Test(a, b);
+	}
+	else if constexpr (HasIntersectImpl<B, A>) {
+		return IntersectImpl<B, A>::Test(b, a);
+	}
+	else if constexpr (std::is_same_v<A, Plane>) {
+		return IsCollisionPlane(a, ToConvexShape(b));
+	}
+	else if constexpr (std::is_same_v<B, Plane>) {
+		return IsCollisionPlane(b, ToConvexShape(a));
+	}
+	else {
+		return MyGJK::IsCollision(ToConvexShape(a), ToConvexShape(b));
+	}
+
+}
+
+/// <summary>
+/// 1つの種類の組み合わせの組をまとめて判定する関数
+/// </summary>
+/// <param name="arrays">種類ごとに分けた形状配列</param>
+/// <param name="pairs">組の配列</param>
+/// <param name="count">組の数</param>
+/// <param name="results">判定結果の格納先</param>
+template<size_t I, size_t J>
+void MyIntersect::IntersectBucket(const PrimitiveArrays& arrays, const BatchPair* pairs, size_t count, bool* results) {
+
+	using A = std::variant_alternative_t<I, Primitive>;
+	using B = std::variant_alternative_t<J, Primitive>;
+
+	// 判定が用意されていない組み合わせを外れと区別できなくならないように、コンパイル時に弾く
+	static_assert(Intersectable<A, B>, "IntersectImpl is missing for a Primitive combination");
+
+	// 型が決まっているので組ごとの分岐はない
+	const A* arrayA = std::get<I>(arrays).data();
+	const B* arrayB = std::get<J>(arrays).data();
+	for (size_t i = 0; i < count; i++) {
+		results[pairs[i].index] = Intersect(arrayA[pairs[i].a], arrayB[pairs[i].b]);
+	}
+
+}
+
+/// <summary>
+/// 種類の組み合わせごとの判定関数の表を作る関数
+/// </summary>
+template<size_t... K>
+constexpr auto MyIntersect::MakeBucketTable(std::index_sequence<K...>) {
+
+	using BucketFunction = void (*)(const PrimitiveArrays&, const BatchPair*, size_t, bool*);
+	return std::array<BucketFunction, sizeof...(K)>{ &IntersectBucket<K / kTypeCount, K % kTypeCount>... };
+
+}
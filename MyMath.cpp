@@ -1,4 +1,5 @@
 ﻿#include "MyMath.h"
+#include "MyPerfCounter.h"
 
 #pragma region float系演算関数
 
@@ -27,8 +28,13 @@ float MyMath::Dot(const Vector3& v1, const Vector3& v2) {
 /// <returns>長さ</returns>
 float MyMath::Length(const Vector3& v) {
 
+#ifdef MYMATH_FAST_APPROX
+	// 近似版で計算
+	return FastLength(v);
+#else
 	// 計算処理
 	return sqrtf(Dot(v, v));
+#endif
 
 }
 
@@ -49,6 +55,264 @@ float MyMath::Clamp(float a, float min, float max) {
 	return a;
 }
 
+/// <summary>
+/// サインとコサインを同時に求める関数
+/// MYMATH_FAST_APPROX 定義時は FastSinCos を使用する
+/// </summary>
+/// <param name="radian">角度(ラジアン)</param>
+/// <param name="outSin">サインの格納先</param>
+/// <param name="outCos">コサインの格納先</param>
+void MyMath::SinCos(float radian, float& outSin, float& outCos) {
+
+#ifdef MYMATH_FAST_APPROX
+	// 近似版で計算
+	FastSinCos(radian, outSin, outCos);
+#else
+	// 計算処理
+	outSin = std::sinf(radian);
+	outCos = std::cosf(radian);
+#endif
+
+}
+
+#pragma endregion
+
+#pragma region 高速近似演算関数
+
+namespace {
+
+	// 2 / π
+	const float kTwoOverPi = 0.636619772f;
+	// π / 2 を3つに分割した値 (範囲縮小の誤差を抑えるため)
+	const float kHalfPiPart1 = 1.5703125f;
+	const float kHalfPiPart2 = 4.837512969970703125e-4f;
+	const float kHalfPiPart3 = 7.54978995489188216e-8f;
+
+	// [-π/4, π/4] でのサインの近似多項式の係数
+	const float kSinCoef1 = -1.6666654611e-1f;
+	const float kSinCoef2 = 8.3321608736e-3f;
+	const float kSinCoef3 = -1.9515295891e-4f;
+	// [-π/4, π/4] でのコサインの近似多項式の係数
+	const float kCosCoef1 = 4.166664568298827e-2f;
+	const float kCosCoef2 = -1.388731625493765e-3f;
+	const float kCosCoef3 = 2.443315711809948e-5f;
+
+}
+
+/// <summary>
+/// 平方根の逆数を近似で求める関数
+/// rsqrt の近似値にニュートン法を1回適用する (SSE を使わない場合はビット演算の初期値に2回適用する、最大相対誤差 5e-6 以下)
+/// </summary>
+/// <param name="x">値 (0より大きいこと)</param>
+/// <returns>1 / sqrt(x) の近似値</returns>
+float MyMath::FastInverseSqrt(float x) {
+
+#ifdef MYMATH_SIMD_SSE
+	// rsqrtss で初期値を求める (相対誤差 3.7e-4 以下)
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	// ニュートン法を1回適用
+	y = y * (1.5f - 0.5f * x * y * y);
+#else
+	// ビット演算で初期値を求める (相対誤差 3.5e-3 以下)
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	bits = 0x5f3759df - (bits >> 1);
+	float y;
+	std::memcpy(&y, &bits, sizeof(y));
+	// 初期値の精度が低いためニュートン法を2回適用
+	y = y * (1.5f - 0.5f * x * y * y);
+	y = y * (1.5f - 0.5f * x * y * y);
+#endif
+
+	return y;
+
+}
+
+/// <summary>
+/// ベクトルの長さを近似で求める関数 (最大相対誤差 5e-6 以下)
+/// </summary>
+/// <param name="v">ベクトル</param>
+/// <returns>長さの近似値</returns>
+float MyMath::FastLength(const Vector3& v) {
+
+	// 長さの2乗を求める
+	float lengthSq = Dot(v, v);
+
+	// 長さが0の場合は0を返す
+	if (lengthSq == 0.0f) {
+		return 0.0f;
+	}
+
+	// sqrt(x) = x * (1 / sqrt(x))
+	return lengthSq * FastInverseSqrt(lengthSq);
+
+}
+
+/// <summary>
+/// ベクトルの正規化を近似で行う関数 (長さの最大相対誤差 5e-6 以下)
+/// </summary>
+/// <param name="v">ベクトル</param>
+/// <returns>正規化されたベクトル (長さ0の場合は0ベクトル)</returns>
+Vector3 MyMath::FastNormalize(const Vector3& v) {
+
+	// 長さの2乗を求める
+	float lengthSq = Dot(v, v);
+
+	// 長さが0の場合は0ベクトルを返す
+	if (lengthSq == 0.0f) {
+		return { 0.0f, 0.0f, 0.0f };
+	}
+
+	// 計算処理
+	return Multiply(FastInverseSqrt(lengthSq), v);
+
+}
+
+/// <summary>
+/// サインとコサインを多項式近似で同時に求める関数
+/// |radian| <= 8192 の範囲で最大絶対誤差 2e-6 以下
+/// </summary>
+/// <param name="radian">角度(ラジアン)</param>
+/// <param name="outSin">サインの格納先</param>
+/// <param name="outCos">コサインの格納先</param>
+void MyMath::FastSinCos(float radian, float& outSin, float& outCos) {
+
+	// π/2 単位で何周目かを求める
+	int32_t quadrant = int32_t(std::floor(radian * kTwoOverPi + 0.5f));
+	float k = float(quadrant);
+
+	// [-π/4, π/4] の範囲に縮小する
+	float r = ((radian - k * kHalfPiPart1) - k * kHalfPiPart2) - k * kHalfPiPart3;
+	float z = r * r;
+
+	// 多項式で近似する
+	float s = r + r * z * (kSinCoef1 + z * (kSinCoef2 + z * kSinCoef3));
+	float c = 1.0f - 0.5f * z + z * z * (kCosCoef1 + z * (kCosCoef2 + z * kCosCoef3));
+
+	// 象限に応じて入れ替えと符号反転を行う
+	if (quadrant & 1) {
+		outSin = c;
+		outCos = s;
+	}
+	else {
+		outSin = s;
+		outCos = c;
+	}
+	if (quadrant & 2) {
+		outSin = -outSin;
+	}
+	if ((quadrant + 1) & 2) {
+		outCos = -outCos;
+	}
+
+}
+
+/// <summary>
+/// 複数のベクトルをまとめて近似正規化する関数 (SIMDで4個ずつ処理)
+/// </summary>
+/// <param name="v">正規化するベクトル配列</param>
+/// <param name="result">結果格納先配列 (v と同じでもよい)</param>
+/// <param name="count">個数</param>
+void MyMath::FastNormalizeMany(const Vector3* v, Vector3* result, size_t count) {
+
+	MYPERF_SCOPE("MyMath::FastNormalizeMany", count);
+
+	size_t i = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	// 4個ずつ成分ごとに並べ替えて計算する
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_setr_ps(v[i].x, v[i + 1].x, v[i + 2].x, v[i + 3].x);
+		__m128 y = _mm_setr_ps(v[i].y, v[i + 1].y, v[i + 2].y, v[i + 3].y);
+		__m128 z = _mm_setr_ps(v[i].z, v[i + 1].z, v[i + 2].z, v[i + 3].z);
+
+		// 長さの2乗
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+
+		// rsqrt + ニュートン法1回
+		__m128 inv = _mm_rsqrt_ps(lengthSq);
+		inv = _mm_mul_ps(inv, _mm_sub_ps(_mm_set1_ps(1.5f),
+			_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), lengthSq), _mm_mul_ps(inv, inv))));
+		// 長さ0の要素は0にする
+		inv = _mm_and_ps(inv, _mm_cmpgt_ps(lengthSq, _mm_setzero_ps()));
+
+		// 結果を書き戻す
+		alignas(16) float rx[4], ry[4], rz[4];
+		_mm_store_ps(rx, _mm_mul_ps(x, inv));
+		_mm_store_ps(ry, _mm_mul_ps(y, inv));
+		_mm_store_ps(rz, _mm_mul_ps(z, inv));
+		for (size_t j = 0; j < 4; j++) {
+			result[i + j] = { rx[j], ry[j], rz[j] };
+		}
+	}
+#endif
+
+	// 残りは1個ずつ計算する
+	for (; i < count; i++) {
+		result[i] = FastNormalize(v[i]);
+	}
+
+}
+
+/// <summary>
+/// 複数の角度のサインとコサインをまとめて近似で求める関数 (SIMDで4個ずつ処理)
+/// 誤差は FastSinCos と同じ
+/// </summary>
+/// <param name="radian">角度配列</param>
+/// <param name="outSin">サインの格納先配列</param>
+/// <param name="outCos">コサインの格納先配列</param>
+/// <param name="count">個数</param>
+void MyMath::FastSinCosMany(const float* radian, float* outSin, float* outCos, size_t count) {
+
+	size_t i = 0;
+
+#ifdef MYMATH_SIMD_SSE
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(radian + i);
+
+		// π/2 単位で何周目かを求める
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(kTwoOverPi)));
+		__m128 k = _mm_cvtepi32_ps(quadrant);
+
+		// [-π/4, π/4] の範囲に縮小する
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(kHalfPiPart1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(kHalfPiPart2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(kHalfPiPart3)));
+		__m128 z = _mm_mul_ps(r, r);
+
+		// サインの多項式
+		__m128 s = _mm_add_ps(_mm_set1_ps(kSinCoef2), _mm_mul_ps(z, _mm_set1_ps(kSinCoef3)));
+		s = _mm_add_ps(_mm_set1_ps(kSinCoef1), _mm_mul_ps(z, s));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), s));
+
+		// コサインの多項式
+		__m128 c = _mm_add_ps(_mm_set1_ps(kCosCoef2), _mm_mul_ps(z, _mm_set1_ps(kCosCoef3)));
+		c = _mm_add_ps(_mm_set1_ps(kCosCoef1), _mm_mul_ps(z, c));
+		c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), c));
+
+		// 奇数象限ではサインとコサインを入れ替える
+		__m128i one = _mm_set1_epi32(1);
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 sinValue = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		__m128 cosValue = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+		// 象限に応じて符号ビットを反転する
+		__m128i two = _mm_set1_epi32(2);
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+		_mm_storeu_ps(outSin + i, _mm_xor_ps(sinValue, sinSign));
+		_mm_storeu_ps(outCos + i, _mm_xor_ps(cosValue, cosSign));
+	}
+#endif
+
+	// 残りは1個ずつ計算する
+	for (; i < count; i++) {
+		FastSinCos(radian[i], outSin[i], outCos[i]);
+	}
+
+}
+
 #pragma endregion
 
 #pragma region Vector3系演算関数
@@ -120,32 +384,22 @@ Vector3 MyMath::Multiply(float scalar, const Vector3& v) {
 /// <returns>正規化されたベクトル</returns>
 Vector3 MyMath::Normalize(const Vector3& v) {
 
+#ifdef MYMATH_FAST_APPROX
+	// 近似版で計算
+	return FastNormalize(v);
+#else
 	// 正規化するベクトルの長さを求める
 	float length = Length(v);
-	// 結果格納用
-	Vector3 result;
 
-	// 計算処理
-	if (v.x != 0.0f) {
-		result.x = v.x / length;
-	}
-	else {
-		result.x = 0.0f;
-	}
-	if (v.y != 0.0f) {
-		result.y = v.y / length;
-	}
-	else {
-		result.y = 0.0f;
-	}
-	if (v.z != 0.0f) {
-		result.z = v.z / length;
-	}
-	else {
-		result.z = 0.0f;
+	// 長さが0の場合は0ベクトルを返す
+	if (length == 0.0f) {
+		return { 0.0f, 0.0f, 0.0f };
 	}
 
-	return result;
+	// 除算は1回だけ行い、各成分は乗算で求める
+	float inverseLength = 1.0f / length;
+	return Multiply(inverseLength, v);
+#endif
 
 }
 
@@ -197,6 +451,24 @@ Vector3 MyMath::Transform(const Vector3& vector, const Matrix4x4& matrix) {
 
 }
 
+/// <summary>
+/// スクリーン座標からワールド座標の半直線を求める関数 (マウスでの選択用)
+/// 始点は近平面上、終点 (origin + diff) は遠平面上の点になる
+/// </summary>
+/// <param name="screenX">スクリーン座標x</param>
+/// <param name="screenY">スクリーン座標y</param>
+/// <param name="unprojectMatrix">MakeUnprojectMatrix で作成した行列</param>
+/// <returns>半直線</returns>
+Ray MyMath::Unproject(float screenX, float screenY, const Matrix4x4& unprojectMatrix) {
+
+	// 深度0 (近平面) と深度1 (遠平面) の点をワールド座標に戻す
+	Vector3 nearPoint = Transform({ screenX, screenY, 0.0f }, unprojectMatrix);
+	Vector3 farPoint = Transform({ screenX, screenY, 1.0f }, unprojectMatrix);
+
+	return { nearPoint, Subtract(farPoint, nearPoint) };
+
+}
+
 /// <summary>
 /// 正射影ベクトルを求める関数
 /// </summary>
@@ -243,6 +515,152 @@ Vector3 MyMath::ClosestProject(const Vector3& point, const Segment& segment) {
 
 }
 
+/// <summary>
+/// 三角形上の最近接点を求める関数
+/// </summary>
+/// <param name="point">点</param>
+/// <param name="triangle">三角形</param>
+/// <returns>最近接点</returns>
+Vector3 MyMath::ClosestPointTriangle(const Vector3& point, const Triangle& triangle) {
+
+	const Vector3& a = triangle.vertex[0];
+	const Vector3& b = triangle.vertex[1];
+	const Vector3& c = triangle.vertex[2];
+	Vector3 ab = Subtract(b, a);
+	Vector3 ac = Subtract(c, a);
+
+	// 頂点aの外側の領域
+	Vector3 ap = Subtract(point, a);
+	float d1 = Dot(ab, ap);
+	float d2 = Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		return a;
+	}
+
+	// 頂点bの外側の領域
+	Vector3 bp = Subtract(point, b);
+	float d3 = Dot(ab, bp);
+	float d4 = Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) {
+		return b;
+	}
+
+	// 辺abの外側の領域
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return Add(a, Multiply(d1 / (d1 - d3), ab));
+	}
+
+	// 頂点cの外側の領域
+	Vector3 cp = Subtract(point, c);
+	float d5 = Dot(ab, cp);
+	float d6 = Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) {
+		return c;
+	}
+
+	// 辺acの外側の領域
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return Add(a, Multiply(d2 / (d2 - d6), ac));
+	}
+
+	// 辺bcの外側の領域
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return Add(b, Multiply((d4 - d3) / ((d4 - d3) + (d5 - d6)), Subtract(c, b)));
+	}
+
+	// 面の内側
+	float denom = 1.0f / (va + vb + vc);
+	return Add(a, Add(Multiply(vb * denom, ab), Multiply(vc * denom, ac)));
+
+}
+
+#ifdef MYMATH_SIMD_SSE
+/// <summary>
+/// 4つの三角形上の最近接点をまとめて求める関数 (ClosestPointTriangle のSIMD版)
+/// 領域判定を分岐なしで行う
+/// </summary>
+/// <param name="point">点 (x, y, z)</param>
+/// <param name="a">三角形の頂点a (x, y, z の各レーンが1つの三角形)</param>
+/// <param name="b">三角形の頂点b</param>
+/// <param name="c">三角形の頂点c</param>
+/// <param name="closest">最近接点の格納先</param>
+void MyMath::ClosestPointTriangle4(const __m128 point[3], const __m128 a[3], const __m128 b[3], const __m128 c[3], __m128 closest[3]) {
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	// 2つのベクトルの内積
+	auto dot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	};
+	// mask が立っている要素だけ a を選ぶ
+	auto select = [](__m128 mask, __m128 a, __m128 b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	};
+
+	const __m128 px = point[0], py = point[1], pz = point[2];
+	const __m128 ax = a[0], ay = a[1], az = a[2];
+	const __m128 bx = b[0], by = b[1], bz = b[2];
+	const __m128 cx = c[0], cy = c[1], cz = c[2];
+
+	__m128 abx = _mm_sub_ps(bx, ax), aby = _mm_sub_ps(by, ay), abz = _mm_sub_ps(bz, az);
+	__m128 acx = _mm_sub_ps(cx, ax), acy = _mm_sub_ps(cy, ay), acz = _mm_sub_ps(cz, az);
+
+	// ClosestPointTriangle と同じ領域判定を分岐なしで行う
+	__m128 d1 = dot(abx, aby, abz, _mm_sub_ps(px, ax), _mm_sub_ps(py, ay), _mm_sub_ps(pz, az));
+	__m128 d2 = dot(acx, acy, acz, _mm_sub_ps(px, ax), _mm_sub_ps(py, ay), _mm_sub_ps(pz, az));
+	__m128 d3 = dot(abx, aby, abz, _mm_sub_ps(px, bx), _mm_sub_ps(py, by), _mm_sub_ps(pz, bz));
+	__m128 d4 = dot(acx, acy, acz, _mm_sub_ps(px, bx), _mm_sub_ps(py, by), _mm_sub_ps(pz, bz));
+	__m128 d5 = dot(abx, aby, abz, _mm_sub_ps(px, cx), _mm_sub_ps(py, cy), _mm_sub_ps(pz, cz));
+	__m128 d6 = dot(acx, acy, acz, _mm_sub_ps(px, cx), _mm_sub_ps(py, cy), _mm_sub_ps(pz, cz));
+	__m128 va = _mm_sub_ps(_mm_mul_ps(d3, d6), _mm_mul_ps(d5, d4));
+	__m128 vb = _mm_sub_ps(_mm_mul_ps(d5, d2), _mm_mul_ps(d1, d6));
+	__m128 vc = _mm_sub_ps(_mm_mul_ps(d1, d4), _mm_mul_ps(d3, d2));
+
+	// 面の内側の場合の重心座標 (優先度の低い順に上書きしていく)
+	__m128 denom = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(va, vb), vc));
+	__m128 v = _mm_mul_ps(vb, denom);
+	__m128 w = _mm_mul_ps(vc, denom);
+
+	// 辺bc
+	__m128 d43 = _mm_sub_ps(d4, d3);
+	__m128 d56 = _mm_sub_ps(d5, d6);
+	__m128 region = _mm_and_ps(_mm_cmple_ps(va, zero), _mm_and_ps(_mm_cmpge_ps(d43, zero), _mm_cmpge_ps(d56, zero)));
+	__m128 t = _mm_div_ps(d43, _mm_add_ps(d43, d56));
+	v = select(region, _mm_sub_ps(one, t), v);
+	w = select(region, t, w);
+	// 辺ac
+	region = _mm_and_ps(_mm_cmple_ps(vb, zero), _mm_and_ps(_mm_cmpge_ps(d2, zero), _mm_cmple_ps(d6, zero)));
+	v = select(region, zero, v);
+	w = select(region, _mm_div_ps(d2, _mm_sub_ps(d2, d6)), w);
+	// 頂点c
+	region = _mm_and_ps(_mm_cmpge_ps(d6, zero), _mm_cmple_ps(d5, d6));
+	v = select(region, zero, v);
+	w = select(region, one, w);
+	// 辺ab
+	region = _mm_and_ps(_mm_cmple_ps(vc, zero), _mm_and_ps(_mm_cmpge_ps(d1, zero), _mm_cmple_ps(d3, zero)));
+	v = select(region, _mm_div_ps(d1, _mm_sub_ps(d1, d3)), v);
+	w = select(region, zero, w);
+	// 頂点b
+	region = _mm_and_ps(_mm_cmpge_ps(d3, zero), _mm_cmple_ps(d4, d3));
+	v = select(region, one, v);
+	w = select(region, zero, w);
+	// 頂点a
+	region = _mm_and_ps(_mm_cmple_ps(d1, zero), _mm_cmple_ps(d2, zero));
+	v = select(region, zero, v);
+	w = select(region, zero, w);
+
+	// 最近接点 = a + v * ab + w * ac
+	closest[0] = _mm_add_ps(ax, _mm_add_ps(_mm_mul_ps(v, abx), _mm_mul_ps(w, acx)));
+	closest[1] = _mm_add_ps(ay, _mm_add_ps(_mm_mul_ps(v, aby), _mm_mul_ps(w, acy)));
+	closest[2] = _mm_add_ps(az, _mm_add_ps(_mm_mul_ps(v, abz), _mm_mul_ps(w, acz)));
+
+}
+#endif
+
 #pragma endregion
 
 #pragma region Matrix4x4系演算関数
@@ -283,6 +701,168 @@ Matrix4x4 MyMath::Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
 
 }
 
+namespace {
+
+	/// <summary>
+	/// 1レーン (スカラー) の演算
+	/// </summary>
+	struct ScalarLane {
+		using Type = float;
+		static const uint32_t kWidth = 1;
+		static float Add(float a, float b) { return a + b; }
+		static float Sub(float a, float b) { return a - b; }
+		static float Mul(float a, float b) { return a * b; }
+		static float Negate(float a) { return -a; }
+		// 行列式の逆数を求め、0のレーンは逆数を0にしてマスクに立てる
+		static float Reciprocal(float d, uint32_t& singularMask) {
+			singularMask = d == 0.0f ? 1 : 0;
+			return d == 0.0f ? 0.0f : 1.0f / d;
+		}
+	};
+
+#ifdef MYMATH_SIMD_SSE
+	/// <summary>
+	/// SSE の4レーンの演算
+	/// </summary>
+	struct SseLane {
+		using Type = __m128;
+		static const uint32_t kWidth = 4;
+		static __m128 Add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+		static __m128 Sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+		static __m128 Mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+		static __m128 Negate(__m128 a) { return _mm_sub_ps(_mm_setzero_ps(), a); }
+		// 行列式の逆数を求め、0のレーンは逆数を0にしてマスクに立てる
+		static __m128 Reciprocal(__m128 d, uint32_t& singularMask) {
+			__m128 isRegular = _mm_cmpneq_ps(d, _mm_setzero_ps());
+			singularMask = ~uint32_t(_mm_movemask_ps(isRegular)) & 0xF;
+			return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), d), isRegular);
+		}
+	};
+#endif
+
+#ifdef __AVX__
+	/// <summary>
+	/// AVX の8レーンの演算
+	/// </summary>
+	struct AvxLane {
+		using Type = __m256;
+		static const uint32_t kWidth = 8;
+		static __m256 Add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+		static __m256 Sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+		static __m256 Mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+		static __m256 Negate(__m256 a) { return _mm256_sub_ps(_mm256_setzero_ps(), a); }
+		// 行列式の逆数を求め、0のレーンは逆数を0にしてマスクに立てる
+		static __m256 Reciprocal(__m256 d, uint32_t& singularMask) {
+			__m256 isRegular = _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+			singularMask = ~uint32_t(_mm256_movemask_ps(isRegular)) & 0xFF;
+			return _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), d), isRegular);
+		}
+	};
+#endif
+
+	/// <summary>
+	/// 要素ごとに並べた行列の逆行列を2x2の小行列式から求める関数
+	/// </summary>
+	/// <param name="a">行列 (a[行][列] の各レーンが1つの行列)</param>
+	/// <param name="b">逆行列の格納先</param>
+	/// <returns>行列式が0のレーンのマスク</returns>
+	template<typename Lane>
+	uint32_t InverseLanes(const typename Lane::Type a[4][4], typename Lane::Type b[4][4]) {
+
+		using T = typename Lane::Type;
+		// p * q - r * s
+		auto det2 = [](T p, T q, T r, T s) { return Lane::Sub(Lane::Mul(p, q), Lane::Mul(r, s)); };
+		// x * p - y * q + z * r
+		auto cof = [](T x, T p, T y, T q, T z, T r) {
+			return Lane::Add(Lane::Sub(Lane::Mul(x, p), Lane::Mul(y, q)), Lane::Mul(z, r));
+		};
+
+		// 上2行の小行列式
+		T s0 = det2(a[0][0], a[1][1], a[1][0], a[0][1]);
+		T s1 = det2(a[0][0], a[1][2], a[1][0], a[0][2]);
+		T s2 = det2(a[0][0], a[1][3], a[1][0], a[0][3]);
+		T s3 = det2(a[0][1], a[1][2], a[1][1], a[0][2]);
+		T s4 = det2(a[0][1], a[1][3], a[1][1], a[0][3]);
+		T s5 = det2(a[0][2], a[1][3], a[1][2], a[0][3]);
+		// 下2行の小行列式
+		T c0 = det2(a[2][0], a[3][1], a[3][0], a[2][1]);
+		T c1 = det2(a[2][0], a[3][2], a[3][0], a[2][2]);
+		T c2 = det2(a[2][0], a[3][3], a[3][0], a[2][3]);
+		T c3 = det2(a[2][1], a[3][2], a[3][1], a[2][2]);
+		T c4 = det2(a[2][1], a[3][3], a[3][1], a[2][3]);
+		T c5 = det2(a[2][2], a[3][3], a[3][2], a[2][3]);
+
+		// 行列式
+		T d = Lane::Mul(s0, c5);
+		d = Lane::Sub(d, Lane::Mul(s1, c4));
+		d = Lane::Add(d, Lane::Mul(s2, c3));
+		d = Lane::Add(d, Lane::Mul(s3, c2));
+		d = Lane::Sub(d, Lane::Mul(s4, c1));
+		d = Lane::Add(d, Lane::Mul(s5, c0));
+
+		uint32_t singularMask;
+		T inv = Lane::Reciprocal(d, singularMask);
+		T negInv = Lane::Negate(inv);
+
+		// 余因子行列の転置を行列式で割る
+		b[0][0] = Lane::Mul(cof(a[1][1], c5, a[1][2], c4, a[1][3], c3), inv);
+		b[0][1] = Lane::Mul(cof(a[0][1], c5, a[0][2], c4, a[0][3], c3), negInv);
+		b[0][2] = Lane::Mul(cof(a[3][1], s5, a[3][2], s4, a[3][3], s3), inv);
+		b[0][3] = Lane::Mul(cof(a[2][1], s5, a[2][2], s4, a[2][3], s3), negInv);
+
+		b[1][0] = Lane::Mul(cof(a[1][0], c5, a[1][2], c2, a[1][3], c1), negInv);
+		b[1][1] = Lane::Mul(cof(a[0][0], c5, a[0][2], c2, a[0][3], c1), inv);
+		b[1][2] = Lane::Mul(cof(a[3][0], s5, a[3][2], s2, a[3][3], s1), negInv);
+		b[1][3] = Lane::Mul(cof(a[2][0], s5, a[2][2], s2, a[2][3], s1), inv);
+
+		b[2][0] = Lane::Mul(cof(a[1][0], c4, a[1][1], c2, a[1][3], c0), inv);
+		b[2][1] = Lane::Mul(cof(a[0][0], c4, a[0][1], c2, a[0][3], c0), negInv);
+		b[2][2] = Lane::Mul(cof(a[3][0], s4, a[3][1], s2, a[3][3], s0), inv);
+		b[2][3] = Lane::Mul(cof(a[2][0], s4, a[2][1], s2, a[2][3], s0), negInv);
+
+		b[3][0] = Lane::Mul(cof(a[1][0], c3, a[1][1], c1, a[1][2], c0), negInv);
+		b[3][1] = Lane::Mul(cof(a[0][0], c3, a[0][1], c1, a[0][2], c0), inv);
+		b[3][2] = Lane::Mul(cof(a[3][0], s3, a[3][1], s1, a[3][2], s0), negInv);
+		b[3][3] = Lane::Mul(cof(a[2][0], s3, a[2][1], s1, a[2][2], s0), inv);
+
+		return singularMask;
+
+	}
+
+#ifdef MYMATH_SIMD_SSE
+	/// <summary>
+	/// 4個の行列を要素ごとに並べ替える関数
+	/// </summary>
+	/// <param name="m">行列 (4個)</param>
+	/// <param name="a">並べ替えた行列の格納先</param>
+	void TransposeToLanes(const Matrix4x4* m, __m128 a[4][4]) {
+		for (uint32_t row = 0; row < 4; row++) {
+			a[row][0] = _mm_loadu_ps(m[0].m[row]);
+			a[row][1] = _mm_loadu_ps(m[1].m[row]);
+			a[row][2] = _mm_loadu_ps(m[2].m[row]);
+			a[row][3] = _mm_loadu_ps(m[3].m[row]);
+			_MM_TRANSPOSE4_PS(a[row][0], a[row][1], a[row][2], a[row][3]);
+		}
+	}
+
+	/// <summary>
+	/// 要素ごとに並べた4個の行列を元に戻す関数
+	/// </summary>
+	/// <param name="a">並べ替えた行列</param>
+	/// <param name="m">行列の格納先 (4個)</param>
+	void TransposeFromLanes(__m128 a[4][4], Matrix4x4* m) {
+		for (uint32_t row = 0; row < 4; row++) {
+			_MM_TRANSPOSE4_PS(a[row][0], a[row][1], a[row][2], a[row][3]);
+			_mm_storeu_ps(m[0].m[row], a[row][0]);
+			_mm_storeu_ps(m[1].m[row], a[row][1]);
+			_mm_storeu_ps(m[2].m[row], a[row][2]);
+			_mm_storeu_ps(m[3].m[row], a[row][3]);
+		}
+	}
+#endif
+
+}
+
 /// <summary>
 /// 逆行列
 /// </summary>
@@ -393,6 +973,82 @@ Matrix4x4 MyMath::Inverse(const Matrix4x4& m) {
 
 }
 
+/// <summary>
+/// 複数の行列の逆行列をまとめて求める関数
+/// 4個 (AVX が使える場合は8個) ずつ要素ごとに並べ替えて並列に計算する
+/// 行列式が0の行列は結果を0行列にし、isSingular で知らせる
+/// </summary>
+/// <param name="m">計算する行列配列</param>
+/// <param name="result">結果の格納先 (m と同じ配列でもよい)</param>
+/// <param name="count">行列の数</param>
+/// <param name="isSingular">各行列が逆行列を持たないかの格納先 (nullptrなら使用しない)</param>
+/// <returns>逆行列を持たない行列の数</returns>
+size_t MyMath::InverseMany(const Matrix4x4* m, Matrix4x4* result, size_t count, bool* isSingular) {
+
+	MYPERF_SCOPE("MyMath::InverseMany", count);
+
+	size_t singularCount = 0;
+	size_t i = 0;
+
+	// レーンごとのマスクを行列ごとの結果に展開する
+	auto storeMask = [&](size_t begin, uint32_t width, uint32_t singularMask) {
+		for (uint32_t j = 0; j < width; j++) {
+			bool singular = (singularMask >> j) & 1;
+			singularCount += singular;
+			if (isSingular) {
+				isSingular[begin + j] = singular;
+			}
+		}
+	};
+
+#ifdef __AVX__
+	// 8個ずつ計算する (4個ずつ並べ替えたものを上下に詰める)
+	for (; i + 8 <= count; i += 8) {
+		__m128 lo[4][4], hi[4][4];
+		TransposeToLanes(m + i, lo);
+		TransposeToLanes(m + i + 4, hi);
+		__m256 a[4][4], b[4][4];
+		for (uint32_t row = 0; row < 4; row++) {
+			for (uint32_t column = 0; column < 4; column++) {
+				a[row][column] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[row][column]), hi[row][column], 1);
+			}
+		}
+		uint32_t singularMask = InverseLanes<AvxLane>(a, b);
+		for (uint32_t row = 0; row < 4; row++) {
+			for (uint32_t column = 0; column < 4; column++) {
+				lo[row][column] = _mm256_castps256_ps128(b[row][column]);
+				hi[row][column] = _mm256_extractf128_ps(b[row][column], 1);
+			}
+		}
+		TransposeFromLanes(lo, result + i);
+		TransposeFromLanes(hi, result + i + 4);
+		storeMask(i, AvxLane::kWidth, singularMask);
+	}
+#endif
+
+#ifdef MYMATH_SIMD_SSE
+	// 4個ずつ計算する
+	for (; i + 4 <= count; i += 4) {
+		__m128 a[4][4], b[4][4];
+		TransposeToLanes(m + i, a);
+		uint32_t singularMask = InverseLanes<SseLane>(a, b);
+		TransposeFromLanes(b, result + i);
+		storeMask(i, SseLane::kWidth, singularMask);
+	}
+#endif
+
+	// 残りは1個ずつ計算する
+	for (; i < count; i++) {
+		float b[4][4];
+		uint32_t singularMask = InverseLanes<ScalarLane>(m[i].m, b);
+		std::memcpy(result[i].m, b, sizeof(b));
+		storeMask(i, ScalarLane::kWidth, singularMask);
+	}
+
+	return singularCount;
+
+}
+
 /// <summary>
 /// 平行移動行列
 /// </summary>
@@ -473,19 +1129,23 @@ Matrix4x4 MyMath::MakeRotateXMatrix(float radian) {
 	// 結果格納用
 	Matrix4x4 result;
 
+	// サインとコサインを同時に求める
+	float sinValue, cosValue;
+	SinCos(radian, sinValue, cosValue);
+
 	result.m[0][0] = 1.0f;
 	result.m[0][1] = 0.0f;
 	result.m[0][2] = 0.0f;
 	result.m[0][3] = 0.0f;
 
 	result.m[1][0] = 0.0f;
-	result.m[1][1] = std::cosf(radian);
-	result.m[1][2] = std::sinf(radian);
+	result.m[1][1] = cosValue;
+	result.m[1][2] = sinValue;
 	result.m[1][3] = 0.0f;
 
 	result.m[2][0] = 0.0f;
-	result.m[2][1] = -(std::sinf(radian));
-	result.m[2][2] = std::cosf(radian);
+	result.m[2][1] = -sinValue;
+	result.m[2][2] = cosValue;
 	result.m[2][3] = 0.0f;
 
 	result.m[3][0] = 0.0f;
@@ -506,9 +1166,13 @@ Matrix4x4 MyMath::MakeRotateYMatrix(float radian) {
 	// 結果格納用
 	Matrix4x4 result;
 
-	result.m[0][0] = std::cosf(radian);
+	// サインとコサインを同時に求める
+	float sinValue, cosValue;
+	SinCos(radian, sinValue, cosValue);
+
+	result.m[0][0] = cosValue;
 	result.m[0][1] = 0.0f;
-	result.m[0][2] = -(std::sinf(radian));
+	result.m[0][2] = -sinValue;
 	result.m[0][3] = 0.0f;
 
 	result.m[1][0] = 0.0f;
@@ -516,9 +1180,9 @@ Matrix4x4 MyMath::MakeRotateYMatrix(float radian) {
 	result.m[1][2] = 0.0f;
 	result.m[1][3] = 0.0f;
 
-	result.m[2][0] = std::sinf(radian);
+	result.m[2][0] = sinValue;
 	result.m[2][1] = 0.0f;
-	result.m[2][2] = std::cosf(radian);
+	result.m[2][2] = cosValue;
 	result.m[2][3] = 0.0f;
 
 	result.m[3][0] = 0.0f;
@@ -539,13 +1203,17 @@ Matrix4x4 MyMath::MakeRotateZMatrix(float radian) {
 	// 結果格納用
 	Matrix4x4 result;
 
-	result.m[0][0] = std::cosf(radian);
-	result.m[0][1] = std::sinf(radian);
+	// サインとコサインを同時に求める
+	float sinValue, cosValue;
+	SinCos(radian, sinValue, cosValue);
+
+	result.m[0][0] = cosValue;
+	result.m[0][1] = sinValue;
 	result.m[0][2] = 0.0f;
 	result.m[0][3] = 0.0f;
 
-	result.m[1][0] = -(std::sinf(radian));
-	result.m[1][1] = std::cosf(radian);
+	result.m[1][0] = -sinValue;
+	result.m[1][1] = cosValue;
 	result.m[1][2] = 0.0f;
 	result.m[1][3] = 0.0f;
 
@@ -740,4 +1408,17 @@ Matrix4x4 MyMath::MakeViewPortMatrix(float left, float top, float width, float h
 
 }
 
+/// <summary>
+/// スクリーン座標をワールド座標に戻す行列を作成する関数
+/// 逆行列を求めるのでカメラが変わったときだけ作り直す
+/// </summary>
+/// <param name="viewProjection">ビュープロジェクション行列</param>
+/// <param name="viewport">ビューポート行列</param>
+/// <returns>(viewProjection * viewport) の逆行列</returns>
+Matrix4x4 MyMath::MakeUnprojectMatrix(const Matrix4x4& viewProjection, const Matrix4x4& viewport) {
+
+	return Inverse(Multiply(viewProjection, viewport));
+
+}
+
 #pragma endregion
@@ -1,12 +1,21 @@
 ﻿#pragma once
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <numbers>
 #include "Vector3.h"
 #include "Matrix4x4.h"
 #include "MyStruct.h"
 #include "MyConst.h"
 
+// SSE が使用できる環境ではSIMD版の処理を有効にする
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define MYMATH_SIMD_SSE
+#endif
+
 /// <summary>
 /// 数学系関数を管理するクラス
 /// </summary>
@@ -41,6 +50,68 @@ public:
 	/// <returns>範囲内の値</returns>
 	static float Clamp(float a, float min, float max);
 
+	/// <summary>
+	/// サインとコサインを同時に求める関数
+	/// MYMATH_FAST_APPROX 定義時は FastSinCos を使用する
+	/// </summary>
+	/// <param name="radian">角度(ラジアン)</param>
+	/// <param name="outSin">サインの格納先</param>
+	/// <param name="outCos">コサインの格納先</param>
+	static void SinCos(float radian, float& outSin, float& outCos);
+
+#pragma endregion
+
+#pragma region 高速近似演算関数
+
+	/// <summary>
+	/// 平方根の逆数を近似で求める関数
+	/// rsqrt の近似値にニュートン法を1回適用する (SSE を使わない場合はビット演算の初期値に2回適用する、最大相対誤差 5e-6 以下)
+	/// </summary>
+	/// <param name="x">値 (0より大きいこと)</param>
+	/// <returns>1 / sqrt(x) の近似値</returns>
+	static float FastInverseSqrt(float x);
+
+	/// <summary>
+	/// ベクトルの長さを近似で求める関数 (最大相対誤差 5e-6 以下)
+	/// </summary>
+	/// <param name="v">ベクトル</param>
+	/// <returns>長さの近似値</returns>
+	static float FastLength(const Vector3& v);
+
+	/// <summary>
+	/// ベクトルの正規化を近似で行う関数 (長さの最大相対誤差 5e-6 以下)
+	/// </summary>
+	/// <param name="v">ベクトル</param>
+	/// <returns>正規化されたベクトル (長さ0の場合は0ベクトル)</returns>
+	static Vector3 FastNormalize(const Vector3& v);
+
+	/// <summary>
+	/// サインとコサインを多項式近似で同時に求める関数
+	/// |radian| <= 8192 の範囲で最大絶対誤差 2e-6 以下
+	/// </summary>
+	/// <param name="radian">角度(ラジアン)</param>
+	/// <param name="outSin">サインの格納先</param>
+	/// <param name="outCos">コサインの格納先</param>
+	static void FastSinCos(float radian, float& outSin, float& outCos);
+
+	/// <summary>
+	/// 複数のベクトルをまとめて近似正規化する関数 (SIMDで4個ずつ処理)
+	/// </summary>
+	/// <param name="v">正規化するベクトル配列</param>
+	/// <param name="result">結果格納先配列 (v と同じでもよい)</param>
+	/// <param name="count">個数</param>
+	static void FastNormalizeMany(const Vector3* v, Vector3* result, size_t count);
+
+	/// <summary>
+	/// 複数の角度のサインとコサインをまとめて近似で求める関数 (SIMDで4個ずつ処理)
+	/// 誤差は FastSinCos と同じ
+	/// </summary>
+	/// <param name="radian">角度配列</param>
+	/// <param name="outSin">サインの格納先配列</param>
+	/// <param name="outCos">コサインの格納先配列</param>
+	/// <param name="count">個数</param>
+	static void FastSinCosMany(const float* radian, float* outSin, float* outCos, size_t count);
+
 #pragma endregion
 
 #pragma region Vector3系演算関数
@@ -92,6 +163,16 @@ public:
 	/// <returns></returns>
 	static Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix);
 
+	/// <summary>
+	/// スクリーン座標からワールド座標の半直線を求める関数 (マウスでの選択用)
+	/// 始点は近平面上、終点 (origin + diff) は遠平面上の点になる
+	/// </summary>
+	/// <param name="screenX">スクリーン座標x</param>
+	/// <param name="screenY">スクリーン座標y</param>
+	/// <param name="unprojectMatrix">MakeUnprojectMatrix で作成した行列</param>
+	/// <returns>半直線</returns>
+	static Ray Unproject(float screenX, float screenY, const Matrix4x4& unprojectMatrix);
+
 	/// <summary>
 	/// 正射影ベクトルを求める関数
 	/// </summary>
@@ -108,6 +189,27 @@ public:
 	/// <returns>最近頂点</returns>
 	static Vector3 ClosestProject(const Vector3& point, const Segment& segment);
 
+	/// <summary>
+	/// 三角形上の最近接点を求める関数
+	/// </summary>
+	/// <param name="point">点</param>
+	/// <param name="triangle">三角形</param>
+	/// <returns>最近接点</returns>
+	static Vector3 ClosestPointTriangle(const Vector3& point, const Triangle& triangle);
+
+#ifdef MYMATH_SIMD_SSE
+	/// <summary>
+	/// 4つの三角形上の最近接点をまとめて求める関数 (ClosestPointTriangle のSIMD版)
+	/// 領域判定を分岐なしで行う
+	/// </summary>
+	/// <param name="point">点 (x, y, z)</param>
+	/// <param name="a">三角形の頂点a (x, y, z の各レーンが1つの三角形)</param>
+	/// <param name="b">三角形の頂点b</param>
+	/// <param name="c">三角形の頂点c</param>
+	/// <param name="closest">最近接点の格納先</param>
+	static void ClosestPointTriangle4(const __m128 point[3], const __m128 a[3], const __m128 b[3], const __m128 c[3], __m128 closest[3]);
+#endif
+
 #pragma endregion
 
 #pragma region Matrix4x4系演算関数
@@ -127,6 +229,18 @@ public:
 	/// <returns></returns>
 	static Matrix4x4 Inverse(const Matrix4x4& m);
 
+	/// <summary>
+	/// 複数の行列の逆行列をまとめて求める関数
+	/// 4個 (AVX が使える場合は8個) ずつ要素ごとに並べ替えて並列に計算する
+	/// 行列式が0の行列は結果を0行列にし、isSingular で知らせる
+	/// </summary>
+	/// <param name="m">計算する行列配列</param>
+	/// <param name="result">結果の格納先 (m と同じ配列でもよい)</param>
+	/// <param name="count">行列の数</param>
+	/// <param name="isSingular">各行列が逆行列を持たないかの格納先 (nullptrなら使用しない)</param>
+	/// <returns>逆行列を持たない行列の数</returns>
+	static size_t InverseMany(const Matrix4x4* m, Matrix4x4* result, size_t count, bool* isSingular = nullptr);
+
 	/// <summary>
 	/// 平行移動行列
 	/// </summary>
@@ -212,6 +326,15 @@ public:
 	/// <returns>ビューポート行列</returns>
 	static Matrix4x4 MakeViewPortMatrix(float left, float top, float width, float height, float minDepth, float maxDepth);
 
+	/// <summary>
+	/// スクリーン座標をワールド座標に戻す行列を作成する関数
+	/// 逆行列を求めるのでカメラが変わったときだけ作り直す
+	/// </summary>
+	/// <param name="viewProjection">ビュープロジェクション行列</param>
+	/// <param name="viewport">ビューポート行列</param>
+	/// <returns>(viewProjection * viewport) の逆行列</returns>
+	static Matrix4x4 MakeUnprojectMatrix(const Matrix4x4& viewProjection, const Matrix4x4& viewport);
+
 #pragma endregion
 
 };
@@ -0,0 +1,355 @@
+﻿#include "MyMortonOrder.h"
+#include <algorithm>
+#include <barrier>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <thread>
+#include "MyAABBTree.h"
+#include "MyPerfCounter.h"
+
+namespace {
+
+	// 基数ソートの1桁のビット数
+	const uint32_t kRadixBits = 11;
+	const size_t kRadixSize = size_t(1) << kRadixBits;
+
+	/// <summary>
+	/// 10bit の値の各ビットの間に2bitの隙間を空ける関数
+	/// </summary>
+	uint32_t SpreadBits10(uint32_t value) {
+		value &= 0x3FF;
+		value = (value | (value << 16)) & 0x030000FF;
+		value = (value | (value << 8)) & 0x0300F00F;
+		value = (value | (value << 4)) & 0x030C30C3;
+		value = (value | (value << 2)) & 0x09249249;
+		return value;
+	}
+
+	/// <summary>
+	/// 21bit の値の各ビットの間に2bitの隙間を空ける関数
+	/// </summary>
+	uint64_t SpreadBits21(uint64_t value) {
+		value &= 0x1FFFFF;
+		value = (value | (value << 32)) & 0x001F00000000FFFFull;
+		value = (value | (value << 16)) & 0x001F0000FF0000FFull;
+		value = (value | (value << 8)) & 0x100F00F00F00F00Full;
+		value = (value | (value << 4)) & 0x10C30C30C30C30C3ull;
+		value = (value | (value << 2)) & 0x1249249249249249ull;
+		return value;
+	}
+
+	/// <summary>
+	/// 点を範囲内の格子の番号に量子化する関数
+	/// </summary>
+	/// <param name="point">点</param>
+	/// <param name="bounds">範囲</param>
+	/// <param name="maxValue">番号の最大値</param>
+	/// <param name="cell">各軸の番号の格納先</param>
+	void Quantize(const Vector3& point, const AABB& bounds, uint32_t maxValue, uint32_t cell[3]) {
+		const float* value = &point.x;
+		const float* min = &bounds.min.x;
+		const float* max = &bounds.max.x;
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			float extent = max[axis] - min[axis];
+			float normalized = extent > 0.0f ? (value[axis] - min[axis]) / extent : 0.0f;
+			normalized = std::clamp(normalized, 0.0f, 1.0f);
+			cell[axis] = uint32_t(normalized * float(maxValue));
+		}
+	}
+
+}
+
+/// <summary>
+/// コンストラクタ
+/// </summary>
+/// <param name="bits">Morton符号の精度</param>
+/// <param name="workerCount">基数ソートを行うスレッド数 (0ならCPUのスレッド数)</param>
+MyMortonOrder::MyMortonOrder(MortonBits bits, uint32_t workerCount) : bits_(bits), workerCount_(workerCount) {
+
+	if (workerCount_ == 0) {
+		workerCount_ = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+}
+
+/// <summary>
+/// 中心点の配列から並べ替えの順序を求める関数
+/// 要素数が前回と同じなら前回の順序から並べ直す
+/// </summary>
+/// <param name="centroids">中心点配列 (番号は毎回同じ要素を指すこと)</param>
+/// <param name="count">要素数</param>
+void MyMortonOrder::Update(const Vector3* centroids, size_t count) {
+
+	// 全ての中心点を囲む範囲を量子化の基準にする
+	AABB bounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	for (size_t i = 0; i < count; i++) {
+		bounds.min = { std::min(bounds.min.x, centroids[i].x), std::min(bounds.min.y, centroids[i].y), std::min(bounds.min.z, centroids[i].z) };
+		bounds.max = { std::max(bounds.max.x, centroids[i].x), std::max(bounds.max.y, centroids[i].y), std::max(bounds.max.z, centroids[i].z) };
+	}
+
+	// 要素数が同じなら前回の順序のまま符号を求め直す
+	bool isIncremental = keys_.size() == count && count != 0;
+	if (!isIncremental) {
+		keys_.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			keys_[i].index = uint32_t(i);
+		}
+	}
+	size_t inversionCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		const Vector3& centroid = centroids[keys_[i].index];
+		keys_[i].code = bits_ == MortonBits::k30 ? Encode30(centroid, bounds) : Encode63(centroid, bounds);
+		if (i != 0 && keys_[i].code < keys_[i - 1].code) {
+			inversionCount++;
+		}
+	}
+
+	// ほとんど動いていなければ挿入ソートの方が速い
+	// 隣り合う逆転の数では遠くへ動いた要素の移動の多さがわからないため、移動が上限を超えたら基数ソートに切り替える
+	bool isSorted = false;
+	if (isIncremental && inversionCount * kIncrementalRatio <= count) {
+		isSorted = InsertionSort(count * kMaxShiftPerElement);
+		if (isSorted) {
+			stats_.incrementalCount++;
+		}
+		else {
+			stats_.fallbackCount++;
+		}
+	}
+	if (!isSorted) {
+		RadixSort();
+		stats_.radixCount++;
+	}
+
+	order_.resize(count);
+	remap_.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		order_[i] = keys_[i].index;
+		remap_[keys_[i].index] = uint32_t(i);
+	}
+
+}
+
+/// <summary>
+/// 球配列から並べ替えの順序を求める関数 (中心を使う)
+/// </summary>
+/// <param name="spheres">球配列</param>
+/// <param name="count">球の数</param>
+void MyMortonOrder::Update(const Sphere* spheres, size_t count) {
+
+	static thread_local std::vector<Vector3> centroids;
+	centroids.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		centroids[i] = spheres[i].center;
+	}
+	Update(centroids.data(), count);
+
+}
+
+/// <summary>
+/// 三角形配列から並べ替えの順序を求める関数 (重心を使う)
+/// </summary>
+/// <param name="triangles">三角形配列</param>
+/// <param name="count">三角形の数</param>
+void MyMortonOrder::Update(const Triangle* triangles, size_t count) {
+
+	static thread_local std::vector<Vector3> centroids;
+	centroids.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		const Vector3* vertex = triangles[i].vertex;
+		centroids[i] = MyMath::Multiply(1.0f / 3.0f, vertex[0] + vertex[1] + vertex[2]);
+	}
+	Update(centroids.data(), count);
+
+}
+
+/// <summary>
+/// 30bit の Morton 符号を求める関数
+/// </summary>
+/// <param name="point">点</param>
+/// <param name="bounds">量子化の基準にする範囲</param>
+/// <returns>Morton符号</returns>
+uint32_t MyMortonOrder::Encode30(const Vector3& point, const AABB& bounds) {
+
+	uint32_t cell[3];
+	Quantize(point, bounds, (1u << 10) - 1, cell);
+	return (SpreadBits10(cell[0]) << 2) | (SpreadBits10(cell[1]) << 1) | SpreadBits10(cell[2]);
+
+}
+
+/// <summary>
+/// 63bit の Morton 符号を求める関数
+/// </summary>
+/// <param name="point">点</param>
+/// <param name="bounds">量子化の基準にする範囲</param>
+/// <returns>Morton符号</returns>
+uint64_t MyMortonOrder::Encode63(const Vector3& point, const AABB& bounds) {
+
+	uint32_t cell[3];
+	Quantize(point, bounds, (1u << 21) - 1, cell);
+	return (SpreadBits21(cell[0]) << 2) | (SpreadBits21(cell[1]) << 1) | SpreadBits21(cell[2]);
+
+}
+
+/// <summary>
+/// keys_ を符号の順に基数ソートする関数
+/// スレッドごとに範囲を分けて各桁の個数を数え、全スレッドの個数から書き込み先を決めて並べる
+/// </summary>
+void MyMortonOrder::RadixSort() {
+
+	size_t count = keys_.size();
+	if (count < 2) {
+		return;
+	}
+	scratch_.resize(count);
+
+	uint32_t passCount = bits_ == MortonBits::k30 ? 3 : 6;
+	uint32_t workerCount = uint32_t(std::clamp<size_t>(count / kMinPerWorker, 1, workerCount_));
+
+	// スレッドごとの各桁の個数 (数えた後は書き込み先に置き換える)
+	std::vector<size_t> offsets(size_t(workerCount) * kRadixSize);
+	KeyIndex* source = keys_.data();
+	KeyIndex* destination = scratch_.data();
+	uint32_t shift = 0;
+
+	// 全スレッドが数え終えたら書き込み先を求める
+	auto computeOffsets = [&]() noexcept {
+		size_t sum = 0;
+		for (size_t digit = 0; digit < kRadixSize; digit++) {
+			for (uint32_t worker = 0; worker < workerCount; worker++) {
+				size_t& offset = offsets[worker * kRadixSize + digit];
+				size_t digitCount = offset;
+				offset = sum;
+				sum += digitCount;
+			}
+		}
+	};
+	// 全スレッドが並べ終えたら次の桁に進む
+	auto nextPass = [&]() noexcept {
+		std::swap(source, destination);
+		shift += kRadixBits;
+	};
+	std::barrier countBarrier(workerCount, computeOffsets);
+	std::barrier scatterBarrier(workerCount, nextPass);
+
+	auto work = [&](uint32_t worker) {
+		size_t begin = count * worker / workerCount;
+		size_t end = count * (worker + 1) / workerCount;
+		size_t* offset = &offsets[worker * kRadixSize];
+
+		for (uint32_t pass = 0; pass < passCount; pass++) {
+			std::fill(offset, offset + kRadixSize, size_t(0));
+			for (size_t i = begin; i < end; i++) {
+				offset[(source[i].code >> shift) & (kRadixSize - 1)]++;
+			}
+			countBarrier.arrive_and_wait();
+
+			// 範囲内の順序を保って書き込むので安定ソートになる
+			for (size_t i = begin; i < end; i++) {
+				destination[offset[(source[i].code >> shift) & (kRadixSize - 1)]++] = source[i];
+			}
+			scatterBarrier.arrive_and_wait();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (uint32_t worker = 1; worker < workerCount; worker++) {
+		workers.emplace_back(work, worker);
+	}
+	work(0);
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+
+	// 奇数回の桁で終わった場合は作業用の配列に結果がある
+	if (source != keys_.data()) {
+		keys_.swap(scratch_);
+	}
+
+}
+
+/// <summary>
+/// keys_ を符号の順に挿入ソートする関数 (ほぼ揃っている場合に使う)
+/// 要素の移動の回数が上限を超えたら途中でやめる (keys_ は並べ替えの途中の状態になる)
+/// </summary>
+/// <param name="maxShiftCount">要素の移動の回数の上限</param>
+/// <returns>並べ終えたか</returns>
+bool MyMortonOrder::InsertionSort(size_t maxShiftCount) {
+
+	size_t shiftCount = 0;
+	for (size_t i = 1; i < keys_.size(); i++) {
+		KeyIndex key = keys_[i];
+		size_t j = i;
+		while (j > 0 && key.code < keys_[j - 1].code) {
+			keys_[j] = keys_[j - 1];
+			j--;
+			shiftCount++;
+		}
+		keys_[j] = key;
+
+		// 取り出した要素は戻してあるので、やめても全ての要素が1回ずつ残っている
+		if (shiftCount > maxShiftCount) {
+			return false;
+		}
+	}
+	return true;
+
+}
+
+/// <summary>
+/// 渡された順序のままの配列と Z順序に並べ替えた配列で、AABB木を使った球同士の判定の速度を比べる関数
+/// 各配置の判定は MyPerfCounter で計測するので、キャッシュミスの差は MyPerfCounter::MakeReport で確認できる
+/// </summary>
+/// <param name="spheres">球配列</param>
+/// <param name="count">球の数</param>
+/// <param name="queryCount">判定する球の数</param>
+/// <param name="result">結果の格納先</param>
+void MyMortonOrder::Benchmark(const Sphere* spheres, size_t count, size_t queryCount, MortonBenchmarkResult& result) {
+
+	result = {};
+	if (count == 0) {
+		return;
+	}
+
+	// 判定する球は配置によらず同じにする (番号を飛び飛びに選ぶ)
+	std::vector<Sphere> queries(queryCount);
+	for (size_t i = 0; i < queryCount; i++) {
+		queries[i] = spheres[(i * 7919) % count];
+	}
+
+	// 配列の順に木へ登録し、全ての判定する球と重なる球を調べる
+	auto run = [&](const Sphere* layout, const char* kernel, double& seconds) {
+		MyAABBTree tree(0.0f);
+		for (size_t i = 0; i < count; i++) {
+			tree.CreateProxy(MyCollision::MakeAABB(layout[i]), uint32_t(i));
+		}
+
+		uint64_t hitCount = 0;
+		auto start = std::chrono::steady_clock::now();
+		{
+			MyPerfCounter::Scope scope(kernel, queryCount);
+			for (const Sphere& query : queries) {
+				tree.Query(MyCollision::MakeAABB(query), [&](int32_t proxyId) {
+					if (MyCollision::IsCollisionSphere(query, layout[tree.GetUserData(proxyId)])) {
+						hitCount++;
+					}
+					return true;
+				});
+			}
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return hitCount;
+	};
+
+	result.hitCount = run(spheres, "MyMortonOrder/authoring", result.authoringSeconds);
+
+	MyMortonOrder order;
+	order.Update(spheres, count);
+	std::vector<Sphere> sorted(count);
+	order.Apply(spheres, sorted.data());
+	uint64_t mortonHitCount = run(sorted.data(), "MyMortonOrder/morton", result.mortonSeconds);
+	assert(mortonHitCount == result.hitCount);
+	(void)mortonHitCount;
+
+}
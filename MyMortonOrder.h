@@ -0,0 +1,184 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MyCollision.h"
+
+/// <summary>
+/// Morton符号の精度
+/// </summary>
+enum class MortonBits {
+	k30, // 1軸10bit (30bit)
+	k63, // 1軸21bit (63bit)
+};
+
+/// <summary>
+/// 並べ替えの統計
+/// </summary>
+struct MortonSortStats {
+	uint32_t radixCount; // 基数ソートで並べ直した回数
+	uint32_t incrementalCount; // 前回の順序から挿入ソートで並べ直した回数
+	uint32_t fallbackCount; // 挿入ソートの移動が上限を超えて基数ソートに切り替えた回数 (radixCount にも含む)
+};
+
+/// <summary>
+/// 配置の違いによる速度の比較結果
+/// </summary>
+struct MortonBenchmarkResult {
+	double authoringSeconds; // 渡された順序のままの配列での判定時間 (秒)
+	double mortonSeconds; // Z順序に並べ替えた配列での判定時間 (秒)
+	uint64_t hitCount; // 衝突した組の数 (どちらの配置でも同じ)
+};
+
+/// <summary>
+/// プリミティブ配列を中心点の Morton 符号 (Z曲線) の順に並べ替えるクラス
+/// 空間的に近いプリミティブがメモリ上でも近くなり、空間検索でのキャッシュミスが減る
+/// 基数ソートはスレッドごとに範囲を分けて並列に行う
+/// 毎フレーム Update を呼ぶ動的な配列では、前回の順序がほぼ揃っていれば挿入ソートで並べ直す
+/// (遠くへ動いた要素があって挿入ソートの移動が多くなる場合は途中で基数ソートに切り替える)
+/// </summary>
+class MyMortonOrder
+{
+public:
+
+	/// <summary>
+	/// コンストラクタ
+	/// </summary>
+	/// <param name="bits">Morton符号の精度</param>
+	/// <param name="workerCount">基数ソートを行うスレッド数 (0ならCPUのスレッド数)</param>
+	explicit MyMortonOrder(MortonBits bits = MortonBits::k30, uint32_t workerCount = 0);
+
+	/// <summary>
+	/// 中心点の配列から並べ替えの順序を求める関数
+	/// 要素数が前回と同じなら前回の順序から並べ直す
+	/// </summary>
+	/// <param name="centroids">中心点配列 (番号は毎回同じ要素を指すこと)</param>
+	/// <param name="count">要素数</param>
+	void Update(const Vector3* centroids, size_t count);
+
+	/// <summary>
+	/// 球配列から並べ替えの順序を求める関数 (中心を使う)
+	/// </summary>
+	/// <param name="spheres">球配列</param>
+	/// <param name="count">球の数</param>
+	void Update(const Sphere* spheres, size_t count);
+
+	/// <summary>
+	/// 三角形配列から並べ替えの順序を求める関数 (重心を使う)
+	/// </summary>
+	/// <param name="triangles">三角形配列</param>
+	/// <param name="count">三角形の数</param>
+	void Update(const Triangle* triangles, size_t count);
+
+	/// <summary>
+	/// 並べ替え後の位置から元の番号への表を取得する関数
+	/// </summary>
+	/// <returns>order[新しい位置] = 元の番号</returns>
+	const std::vector<uint32_t>& GetOrder() const { return order_; }
+
+	/// <summary>
+	/// 元の番号から並べ替え後の位置への表を取得する関数
+	/// </summary>
+	/// <returns>remap[元の番号] = 新しい位置</returns>
+	const std::vector<uint32_t>& GetRemap() const { return remap_; }
+
+	/// <summary>
+	/// 並べ替えの統計を取得する関数
+	/// </summary>
+	/// <returns>統計</returns>
+	const MortonSortStats& GetStats() const { return stats_; }
+
+	/// <summary>
+	/// 求めた順序で配列を並べ替えてコピーする関数
+	/// </summary>
+	/// <param name="source">元の配列</param>
+	/// <param name="destination">コピー先 (source と別の配列、GetOrder().size() 個)</param>
+	template<typename T>
+	void Apply(const T* source, T* destination) const;
+
+	/// <summary>
+	/// 30bit の Morton 符号を求める関数
+	/// </summary>
+	/// <param name="point">点</param>
+	/// <param name="bounds">量子化の基準にする範囲</param>
+	/// <returns>Morton符号</returns>
+	static uint32_t Encode30(const Vector3& point, const AABB& bounds);
+
+	/// <summary>
+	/// 63bit の Morton 符号を求める関数
+	/// </summary>
+	/// <param name="point">点</param>
+	/// <param name="bounds">量子化の基準にする範囲</param>
+	/// <returns>Morton符号</returns>
+	static uint64_t Encode63(const Vector3& point, const AABB& bounds);
+
+	/// <summary>
+	/// 渡された順序のままの配列と Z順序に並べ替えた配列で、AABB木を使った球同士の判定の速度を比べる関数
+	/// 各配置の判定は MyPerfCounter で計測するので、キャッシュミスの差は MyPerfCounter::MakeReport で確認できる
+	/// </summary>
+	/// <param name="spheres">球配列</param>
+	/// <param name="count">球の数</param>
+	/// <param name="queryCount">判定する球の数</param>
+	/// <param name="result">結果の格納先</param>
+	static void Benchmark(const Sphere* spheres, size_t count, size_t queryCount, MortonBenchmarkResult& result);
+
+private:
+
+	/// <summary>
+	/// 符号と元の番号の組
+	/// </summary>
+	struct KeyIndex {
+		uint64_t code; // Morton符号
+		uint32_t index; // 元の番号
+	};
+
+	/// <summary>
+	/// keys_ を符号の順に基数ソートする関数
+	/// </summary>
+	void RadixSort();
+
+	/// <summary>
+	/// keys_ を符号の順に挿入ソートする関数 (ほぼ揃っている場合に使う)
+	/// 要素の移動の回数が上限を超えたら途中でやめる (keys_ は並べ替えの途中の状態になる)
+	/// </summary>
+	/// <param name="maxShiftCount">要素の移動の回数の上限</param>
+	/// <returns>並べ終えたか</returns>
+	bool InsertionSort(size_t maxShiftCount);
+
+	// 挿入ソートで並べ直す、隣り合う要素の逆転の数の上限 (要素数に対する割合の逆数)
+	static const size_t kIncrementalRatio = 64;
+	// 挿入ソートで許す要素の移動の回数の上限 (要素数に対する倍率、基数ソートで全要素を読み書きする回数と同程度にする)
+	static const size_t kMaxShiftPerElement = 4;
+	// 1スレッドが受け持つ最小の要素数
+	static const size_t kMinPerWorker = 16384;
+
+	// Morton符号の精度
+	MortonBits bits_;
+	// 基数ソートを行うスレッド数
+	uint32_t workerCount_;
+	// 符号と元の番号の組 (並べ替え後の順)
+	std::vector<KeyIndex> keys_;
+	// 基数ソートの作業用
+	std::vector<KeyIndex> scratch_;
+	// 並べ替え後の位置から元の番号への表
+	std::vector<uint32_t> order_;
+	// 元の番号から並べ替え後の位置への表
+	std::vector<uint32_t> remap_;
+	// 並べ替えの統計
+	MortonSortStats stats_{};
+
+};
+
+/// <summary>
+/// 求めた順序で配列を並べ替えてコピーする関数
+/// </summary>
+/// <param name="source">元の配列</param>
+/// <param name="destination">コピー先 (source と別の配列、GetOrder().size() 個)</param>
+template<typename T>
+void MyMortonOrder::Apply(const T* source, T* destination) const {
+
+	for (size_t i = 0; i < order_.size(); i++) {
+		destination[i] = source[order_[i]];
+	}
+
+}
@@ -0,0 +1,44 @@
+﻿#include "MyPairCache.h"
+
+/// <summary>
+/// 要素のハンドルを作成する関数
+/// </summary>
+/// <returns>ハンドル</returns>
+uint32_t MyPairCache::CreateHandle() {
+
+	versions_.push_back(0);
+	return uint32_t(versions_.size() - 1);
+
+}
+
+/// <summary>
+/// フレームの開始 (統計をリセットする)
+/// </summary>
+void MyPairCache::BeginFrame() {
+
+	frame_++;
+	stats_ = {};
+
+}
+
+/// <summary>
+/// フレームの終了
+/// このフレームで判定されなかった組を破棄し、衝突していた組は kExit を報告する
+/// </summary>
+/// <param name="events">状態の変化の格納先 (末尾に追加される)</param>
+void MyPairCache::EndFrame(std::vector<PairEventRecord>& events) {
+
+	for (auto it = pairs_.begin(); it != pairs_.end();) {
+		if (it->second.frame == frame_) {
+			++it;
+			continue;
+		}
+
+		// 判定されなかった組 (ブロードフェーズで外れた、要素が削除されたなど)
+		if (it->second.isHit) {
+			events.push_back({ uint32_t(it->first >> 32), uint32_t(it->first), PairEvent::kExit });
+		}
+		it = pairs_.erase(it);
+	}
+
+}
@@ -0,0 +1,165 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// 組の状態の変化
+/// </summary>
+enum class PairEvent {
+	kNone, // 衝突していない状態が続いている
+	kEnter, // 衝突し始めた
+	kStay, // 衝突している状態が続いている
+	kExit, // 衝突しなくなった
+};
+
+/// <summary>
+/// 組の状態の変化の記録
+/// </summary>
+struct PairEventRecord {
+	uint32_t handleA; // 要素Aのハンドル (handleA < handleB)
+	uint32_t handleB; // 要素Bのハンドル
+	PairEvent event; // 状態の変化
+};
+
+/// <summary>
+/// 組の判定の統計
+/// </summary>
+struct PairCacheStats {
+	uint32_t tested; // 詳細な判定を行った組の数
+	uint32_t skipped; // 前回の結果を使い回した組の数
+};
+
+/// <summary>
+/// 要素の組の判定結果をフレーム間で保持するクラス
+/// 要素ごとに編集のたびに増える版数を持ち、組のどちらの版数も前回の判定から
+/// 変わっていなければ詳細な判定を省略して前回の結果を返す
+/// </summary>
+class MyPairCache
+{
+public:
+
+	/// <summary>
+	/// 要素のハンドルを作成する関数
+	/// </summary>
+	/// <returns>ハンドル</returns>
+	uint32_t CreateHandle();
+
+	/// <summary>
+	/// 要素が編集されたことを知らせる関数 (版数を増やす)
+	/// </summary>
+	/// <param name="handle">ハンドル</param>
+	void MarkDirty(uint32_t handle) { versions_[handle]++; }
+
+	/// <summary>
+	/// 要素の版数を取得する関数
+	/// </summary>
+	/// <param name="handle">ハンドル</param>
+	/// <returns>版数</returns>
+	uint32_t GetVersion(uint32_t handle) const { return versions_[handle]; }
+
+	/// <summary>
+	/// フレームの開始 (統計をリセットする)
+	/// </summary>
+	void BeginFrame();
+
+	/// <summary>
+	/// 組の判定を行う関数
+	/// どちらの要素も前回の判定から編集されていなければ narrowphase を呼ばない
+	/// </summary>
+	/// <param name="handleA">要素Aのハンドル</param>
+	/// <param name="handleB">要素Bのハンドル</param>
+	/// <param name="narrowphase">bool() 詳細な判定</param>
+	/// <returns>前回の判定からの状態の変化</returns>
+	template<typename Narrowphase>
+	PairEvent Test(uint32_t handleA, uint32_t handleB, Narrowphase&& narrowphase);
+
+	/// <summary>
+	/// フレームの終了
+	/// このフレームで判定されなかった組を破棄し、衝突していた組は kExit を報告する
+	/// </summary>
+	/// <param name="events">状態の変化の格納先 (末尾に追加される)</param>
+	void EndFrame(std::vector<PairEventRecord>& events);
+
+	/// <summary>
+	/// このフレームの統計を取得する関数
+	/// </summary>
+	/// <returns>統計</returns>
+	const PairCacheStats& GetStats() const { return stats_; }
+
+	/// <summary>
+	/// 保持している組の数を取得する関数
+	/// </summary>
+	/// <returns>組の数</returns>
+	size_t GetPairCount() const { return pairs_.size(); }
+
+private:
+
+	/// <summary>
+	/// 組の判定結果
+	/// </summary>
+	struct PairEntry {
+		uint32_t versionA; // 判定時の要素Aの版数
+		uint32_t versionB; // 判定時の要素Bの版数
+		uint32_t frame; // 最後に判定されたフレーム
+		bool isHit; // 衝突しているか
+	};
+
+	/// <summary>
+	/// 組のキーを作る関数
+	/// </summary>
+	static uint64_t MakeKey(uint32_t handleA, uint32_t handleB) { return (uint64_t(handleA) << 32) | handleB; }
+
+	// 要素ごとの版数
+	std::vector<uint32_t> versions_;
+	// 組ごとの判定結果
+	std::unordered_map<uint64_t, PairEntry> pairs_;
+	// 現在のフレーム
+	uint32_t frame_ = 0;
+	// このフレームの統計
+	PairCacheStats stats_{};
+
+};
+
+/// <summary>
+/// 組の判定を行う関数
+/// どちらの要素も前回の判定から編集されていなければ narrowphase を呼ばない
+/// </summary>
+/// <param name="handleA">要素Aのハンドル</param>
+/// <param name="handleB">要素Bのハンドル</param>
+/// <param name="narrowphase">bool() 詳細な判定</param>
+/// <returns>前回の判定からの状態の変化</returns>
+template<typename Narrowphase>
+PairEvent MyPairCache::Test(uint32_t handleA, uint32_t handleB, Narrowphase&& narrowphase) {
+
+	// 同じ組が同じキーになるように並べる
+	if (handleB < handleA) {
+		std::swap(handleA, handleB);
+	}
+	uint32_t versionA = versions_[handleA];
+	uint32_t versionB = versions_[handleB];
+
+	auto [it, isNew] = pairs_.try_emplace(MakeKey(handleA, handleB), PairEntry{ versionA, versionB, frame_, false });
+	PairEntry& entry = it->second;
+	bool wasHit = entry.isHit;
+
+	if (isNew || entry.versionA != versionA || entry.versionB != versionB) {
+		// 初めての組か、どちらかが編集されていれば判定し直す
+		entry.isHit = narrowphase();
+		entry.versionA = versionA;
+		entry.versionB = versionB;
+		stats_.tested++;
+	}
+	else {
+		stats_.skipped++;
+	}
+	entry.frame = frame_;
+
+	if (entry.isHit) {
+		return wasHit ? PairEvent::kStay : PairEvent::kEnter;
+	}
+	return wasHit ? PairEvent::kExit : PairEvent::kNone;
+
+}
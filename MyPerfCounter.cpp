@@ -0,0 +1,309 @@
+﻿#include "MyPerfCounter.h"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace {
+
+#ifdef __linux__
+	/// <summary>
+	/// スレッドごとに開く perf_event のカウンタの組
+	/// 先頭のサイクル数を親にして全ての種類を同時に計測し、1回の read でまとめて読み込む
+	/// </summary>
+	struct CounterGroup {
+		int fd[kPerfCounterCount]; // 種類ごとのファイル (開けなかった場合は-1)
+		uint64_t id[kPerfCounterCount]; // 種類ごとの識別番号 (read の結果との対応用)
+		uint32_t availableMask = 0; // 開けた種類
+
+		/// <summary>
+		/// コンストラクタ (カウンタを開いて計測を開始する)
+		/// </summary>
+		CounterGroup() {
+
+			// 種類ごとの perf_event の設定
+			const uint32_t types[kPerfCounterCount] = {
+				PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+			};
+			const uint64_t configs[kPerfCounterCount] = {
+				PERF_COUNT_HW_CPU_CYCLES,
+				PERF_COUNT_HW_INSTRUCTIONS,
+				PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+				PERF_COUNT_HW_CACHE_MISSES,
+				PERF_COUNT_HW_BRANCH_MISSES,
+			};
+
+			for (size_t i = 0; i < kPerfCounterCount; i++) {
+				fd[i] = -1;
+				id[i] = 0;
+
+				perf_event_attr attribute;
+				std::memset(&attribute, 0, sizeof(attribute));
+				attribute.size = sizeof(attribute);
+				attribute.type = types[i];
+				attribute.config = configs[i];
+				attribute.disabled = i == 0 ? 1 : 0;
+				// 権限の制限が厳しい環境でも開けるようにユーザー空間だけを計測する
+				attribute.exclude_kernel = 1;
+				attribute.exclude_hv = 1;
+				attribute.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				fd[i] = int(syscall(SYS_perf_event_open, &attribute, 0, -1, i == 0 ? -1 : fd[0], 0));
+				if (fd[i] == -1) {
+					// 親が開けなければ何も計測できない
+					if (i == 0) {
+						return;
+					}
+					continue;
+				}
+				ioctl(fd[i], PERF_EVENT_IOC_ID, &id[i]);
+				availableMask |= 1u << i;
+			}
+
+			ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+		}
+
+		/// <summary>
+		/// デストラクタ (スレッドの終了時にカウンタを閉じる)
+		/// </summary>
+		~CounterGroup() {
+			for (size_t i = 0; i < kPerfCounterCount; i++) {
+				if (fd[i] != -1) {
+					close(fd[i]);
+				}
+			}
+		}
+
+		/// <summary>
+		/// 現在値を読み込む関数
+		/// 値は補正せずに、有効だった時間と計測していた時間と一緒に返す
+		/// </summary>
+		/// <param name="sample">格納先</param>
+		/// <returns>取得できた種類</returns>
+		uint32_t Read(PerfSample& sample) const {
+
+			if (availableMask == 0) {
+				return 0;
+			}
+
+			// 個数、有効だった時間、計測していた時間、(値、識別番号) の組の順に並ぶ
+			uint64_t buffer[3 + 2 * kPerfCounterCount];
+			if (read(fd[0], buffer, sizeof(buffer)) < ssize_t(3 * sizeof(uint64_t))) {
+				return 0;
+			}
+
+			uint64_t count = buffer[0];
+			sample.timeEnabled = buffer[1];
+			sample.timeRunning = buffer[2];
+			for (uint64_t i = 0; i < count && i < kPerfCounterCount; i++) {
+				for (size_t type = 0; type < kPerfCounterCount; type++) {
+					if ((availableMask & (1u << type)) && id[type] == buffer[4 + 2 * i]) {
+						sample.value[type] = buffer[3 + 2 * i];
+					}
+				}
+			}
+			return availableMask;
+
+		}
+	};
+#endif
+
+	/// <summary>
+	/// 1要素あたりの値を表の1列として書き出す関数
+	/// </summary>
+	/// <param name="report">書き出し先</param>
+	/// <param name="record">計測結果</param>
+	/// <param name="type">値の種類</param>
+	void AppendPerQuery(std::string& report, const PerfRecord& record, PerfCounterType type) {
+
+		char text[32];
+		if (record.availableMask & (1u << uint32_t(type))) {
+			std::snprintf(text, sizeof(text), " %12.3f", double(record.value[uint32_t(type)]) / double(record.queryCount));
+		}
+		else {
+			std::snprintf(text, sizeof(text), " %12s", "-");
+		}
+		report += text;
+
+	}
+
+}
+
+std::mutex MyPerfCounter::mutex_;
+std::map<std::pair<std::string, uint32_t>, PerfRecord> MyPerfCounter::records_;
+
+/// <summary>
+/// コンストラクタ (計測を開始する)
+/// </summary>
+/// <param name="kernel">処理の名前 (文字列リテラルなど、集計の間は有効な文字列)</param>
+/// <param name="batchSize">処理する要素数</param>
+MyPerfCounter::Scope::Scope(const char* kernel, size_t batchSize) : kernel_(kernel), batchSize_(batchSize) {
+	availableMask_ = Read(start_);
+}
+
+/// <summary>
+/// デストラクタ (計測を終了して集計する)
+/// </summary>
+MyPerfCounter::Scope::~Scope() {
+
+	PerfSample end;
+	uint32_t availableMask = availableMask_ & Read(end);
+
+	// 他の計測と共有されて計測していなかった時間がある場合は、この区間で計測していた時間の割合で補正する
+	// 読み込みごとに補正してから差を取ると、2回の補正率の違いで差が負になることがあるため生の値の差を補正する
+	uint64_t enabled = end.timeEnabled - start_.timeEnabled;
+	uint64_t running = end.timeRunning - start_.timeRunning;
+	double scale = running > 0 ? double(enabled) / double(running) : 1.0;
+
+	uint64_t delta[kPerfCounterCount] = {};
+	for (size_t i = 0; i < kPerfCounterCount; i++) {
+		// 生の値は単調増加だが、念のため逆転していれば0にする
+		if ((availableMask & (1u << i)) && end.value[i] > start_.value[i]) {
+			delta[i] = uint64_t(double(end.value[i] - start_.value[i]) * scale);
+		}
+	}
+	Accumulate(kernel_, batchSize_, delta, availableMask);
+
+}
+
+/// <summary>
+/// 集計した結果を取得する関数 (処理の名前、要素数の順)
+/// </summary>
+/// <returns>計測結果</returns>
+std::vector<PerfRecord> MyPerfCounter::GetRecords() {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<PerfRecord> records;
+	records.reserve(records_.size());
+	for (const auto& [key, record] : records_) {
+		records.push_back(record);
+	}
+	return records;
+
+}
+
+/// <summary>
+/// 集計した結果を表にした文字列を作成する関数
+/// 1要素あたりのサイクル数、IPC (命令数 / サイクル数)、1要素あたりの各ミス数を並べる
+/// </summary>
+/// <returns>表の文字列</returns>
+std::string MyPerfCounter::MakeReport() {
+
+	std::string report;
+	char text[128];
+	std::snprintf(text, sizeof(text), "%-28s %8s %10s %12s %6s %12s %12s %12s\n",
+		"kernel", "batch", "calls", "cycles/q", "IPC", "L1miss/q", "LLCmiss/q", "brmiss/q");
+	report += text;
+
+	for (const PerfRecord& record : GetRecords()) {
+		if (record.queryCount == 0) {
+			continue;
+		}
+
+		std::snprintf(text, sizeof(text), "%-28s %8u %10llu", record.kernel.c_str(), record.batchSize, static_cast<unsigned long long>(record.callCount));
+		report += text;
+		AppendPerQuery(report, record, PerfCounterType::kCycles);
+
+		// IPC はサイクル数と命令数の両方が取れた場合だけ求める
+		const uint32_t ipcMask = (1u << uint32_t(PerfCounterType::kCycles)) | (1u << uint32_t(PerfCounterType::kInstructions));
+		uint64_t cycles = record.value[uint32_t(PerfCounterType::kCycles)];
+		if ((record.availableMask & ipcMask) == ipcMask && cycles > 0) {
+			std::snprintf(text, sizeof(text), " %6.2f", double(record.value[uint32_t(PerfCounterType::kInstructions)]) / double(cycles));
+		}
+		else {
+			std::snprintf(text, sizeof(text), " %6s", "-");
+		}
+		report += text;
+
+		AppendPerQuery(report, record, PerfCounterType::kL1Misses);
+		AppendPerQuery(report, record, PerfCounterType::kLLCMisses);
+		AppendPerQuery(report, record, PerfCounterType::kBranchMisses);
+		report += "\n";
+	}
+
+	return report;
+
+}
+
+/// <summary>
+/// 集計した結果を消去する関数
+/// </summary>
+void MyPerfCounter::Reset() {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	records_.clear();
+
+}
+
+/// <summary>
+/// 呼び出したスレッドのカウンタの現在値を読み込む関数
+/// </summary>
+/// <param name="sample">格納先</param>
+/// <returns>取得できた種類 (PerfCounterType のビット)</returns>
+uint32_t MyPerfCounter::Read(PerfSample& sample) {
+
+	std::memset(&sample, 0, sizeof(sample));
+
+	uint32_t availableMask = 0;
+
+#ifdef __linux__
+	// 最初に計測したときにスレッドごとに開く
+	// 親のサイクル数が開けなかった場合 (権限の制限や仮想環境) は何も取得できない
+	static thread_local CounterGroup group;
+	availableMask = group.Read(sample);
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+	// perf_event が使えない環境ではサイクル数の代わりに TSC を使う
+	if ((availableMask & (1u << uint32_t(PerfCounterType::kCycles))) == 0) {
+		sample.value[uint32_t(PerfCounterType::kCycles)] = __rdtsc();
+		availableMask |= 1u << uint32_t(PerfCounterType::kCycles);
+	}
+#endif
+
+	return availableMask;
+
+}
+
+/// <summary>
+/// 計測結果を集計に加える関数
+/// </summary>
+/// <param name="kernel">処理の名前</param>
+/// <param name="batchSize">処理した要素数</param>
+/// <param name="delta">計測した値</param>
+/// <param name="availableMask">取得できた種類</param>
+void MyPerfCounter::Accumulate(const char* kernel, size_t batchSize, const uint64_t delta[kPerfCounterCount], uint32_t availableMask) {
+
+	// 要素数は2の累乗に切り上げて区分する
+	uint32_t bucket = uint32_t(std::bit_ceil(batchSize > 0 ? batchSize : size_t(1)));
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto [it, isInserted] = records_.try_emplace({ kernel, bucket });
+	PerfRecord& record = it->second;
+	if (isInserted) {
+		record = { kernel, bucket, 0, 0, {}, availableMask };
+	}
+
+	record.callCount++;
+	record.queryCount += batchSize;
+	record.availableMask &= availableMask;
+	for (size_t i = 0; i < kPerfCounterCount; i++) {
+		record.value[i] += delta[i];
+	}
+
+}
@@ -0,0 +1,140 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// MYPERF_ENABLE を定義した場合だけ MYPERF_SCOPE で囲んだ処理のハードウェアカウンタを計測する
+// 定義しない場合 MYPERF_SCOPE は何もしない
+#ifdef MYPERF_ENABLE
+#define MYPERF_SCOPE(kernel, batchSize) MyPerfCounter::Scope myPerfScope(kernel, batchSize)
+#else
+#define MYPERF_SCOPE(kernel, batchSize) ((void)0)
+#endif
+
+/// <summary>
+/// 計測する値の種類
+/// </summary>
+enum class PerfCounterType {
+	kCycles, // サイクル数 (perf_event が使えない x64 環境では TSC のカウント)
+	kInstructions, // 命令数
+	kL1Misses, // L1データキャッシュの読み込みミス
+	kLLCMisses, // 最終レベルキャッシュのミス
+	kBranchMisses, // 分岐予測ミス
+	kCount, // 種類の数
+};
+
+// 計測する値の種類の数
+const size_t kPerfCounterCount = size_t(PerfCounterType::kCount);
+
+/// <summary>
+/// ある時点で読み込んだカウンタの値
+/// 値は補正前の生の値で、補正は2回の読み込みの差に対して行う
+/// </summary>
+struct PerfSample {
+	uint64_t value[kPerfCounterCount]; // 種類ごとの値
+	uint64_t timeEnabled; // 有効だった時間 (取得できない場合は0)
+	uint64_t timeRunning; // 実際に計測していた時間 (取得できない場合は0)
+};
+
+/// <summary>
+/// 処理と要素数の区分ごとに集計した計測結果
+/// </summary>
+struct PerfRecord {
+	std::string kernel; // 処理の名前
+	uint32_t batchSize; // 要素数の区分 (2の累乗に切り上げた値)
+	uint64_t callCount; // 計測した回数
+	uint64_t queryCount; // 処理した要素数の合計
+	uint64_t value[kPerfCounterCount]; // 種類ごとの合計
+	uint32_t availableMask; // 全ての計測で取得できた種類 (PerfCounterType のビット)
+};
+
+/// <summary>
+/// ハードウェアカウンタで処理を計測し、処理と要素数ごとに集計するクラス
+/// Linux では perf_event_open をスレッドごとに開いて計測し、それ以外の環境や perf_event_open が開けない場合は
+/// (x64 なら) サイクル数の代わりに TSC だけを計測する
+/// 計測自体にシステムコールが必要なため、1回の判定ではなく配列をまとめて処理する単位で囲むこと
+/// </summary>
+class MyPerfCounter
+{
+public:
+
+	/// <summary>
+	/// 生存期間の間の処理を計測するクラス (MYPERF_SCOPE から使う)
+	/// </summary>
+	class Scope
+	{
+	public:
+
+		/// <summary>
+		/// コンストラクタ (計測を開始する)
+		/// </summary>
+		/// <param name="kernel">処理の名前 (文字列リテラルなど、集計の間は有効な文字列)</param>
+		/// <param name="batchSize">処理する要素数</param>
+		Scope(const char* kernel, size_t batchSize);
+
+		/// <summary>
+		/// デストラクタ (計測を終了して集計する)
+		/// </summary>
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+
+		// 処理の名前
+		const char* kernel_;
+		// 処理する要素数
+		size_t batchSize_;
+		// 開始時の値
+		PerfSample start_;
+		// 取得できた種類
+		uint32_t availableMask_;
+
+	};
+
+	/// <summary>
+	/// 集計した結果を取得する関数 (処理の名前、要素数の順)
+	/// </summary>
+	/// <returns>計測結果</returns>
+	static std::vector<PerfRecord> GetRecords();
+
+	/// <summary>
+	/// 集計した結果を表にした文字列を作成する関数
+	/// 1要素あたりのサイクル数、IPC (命令数 / サイクル数)、1要素あたりの各ミス数を並べる
+	/// </summary>
+	/// <returns>表の文字列</returns>
+	static std::string MakeReport();
+
+	/// <summary>
+	/// 集計した結果を消去する関数
+	/// </summary>
+	static void Reset();
+
+private:
+
+	/// <summary>
+	/// 呼び出したスレッドのカウンタの現在値を読み込む関数
+	/// </summary>
+	/// <param name="sample">格納先</param>
+	/// <returns>取得できた種類 (PerfCounterType のビット)</returns>
+	static uint32_t Read(PerfSample& sample);
+
+	/// <summary>
+	/// 計測結果を集計に加える関数
+	/// </summary>
+	/// <param name="kernel">処理の名前</param>
+	/// <param name="batchSize">処理した要素数</param>
+	/// <param name="delta">計測した値</param>
+	/// <param name="availableMask">取得できた種類</param>
+	static void Accumulate(const char* kernel, size_t batchSize, const uint64_t delta[kPerfCounterCount], uint32_t availableMask);
+
+	// 集計結果の排他制御
+	static std::mutex mutex_;
+	// 処理の名前と要素数の区分ごとの集計結果
+	static std::map<std::pair<std::string, uint32_t>, PerfRecord> records_;
+
+};
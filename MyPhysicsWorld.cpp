@@ -0,0 +1,423 @@
+﻿#include "MyPhysicsWorld.h"
+#include "MyExpression.h"
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+
+/// <summary>
+/// コンストラクタ
+/// </summary>
+/// <param name="timeStep">1回の計算で進める時間 (秒)</param>
+/// <param name="iterationCount">接触を解決する反復回数</param>
+MyPhysicsWorld::MyPhysicsWorld(float timeStep, uint32_t iterationCount) : timeStep_(timeStep), iterationCount_(iterationCount), scheduler_(timeStep, kMaxSubStepCount) {
+}
+
+/// <summary>
+/// 剛体を追加する関数
+/// </summary>
+/// <param name="sphere">形状</param>
+/// <param name="mass">質量 (0なら動かない剛体)</param>
+/// <param name="velocity">初速度</param>
+/// <param name="restitution">反発係数</param>
+/// <param name="friction">摩擦係数</param>
+/// <returns>剛体の番号</returns>
+uint32_t MyPhysicsWorld::CreateBody(const Sphere& sphere, float mass, const Vector3& velocity, float restitution, float friction) {
+
+	uint32_t bodyId = uint32_t(bodies_.size());
+	bodies_.push_back({ sphere, velocity, mass > 0.0f ? 1.0f / mass : 0.0f, restitution, friction });
+	states_.push_back({ tree_.CreateProxy(MyCollision::MakeAABB(sphere), bodyId), kNullBody, kNullBody, 0.0f });
+
+	// 動かない剛体は起きている剛体の配列に入れない
+	if (mass > 0.0f) {
+		Activate(bodyId);
+	}
+
+	return bodyId;
+
+}
+
+/// <summary>
+/// 経過時間だけ時間を進める関数
+/// 経過時間を貯めておき、時間刻み分たまるごとに1回計算する (回数は MyFrameScheduler::Advance で求める)
+/// </summary>
+/// <param name="deltaTime">経過時間 (秒)</param>
+/// <returns>計算した回数</returns>
+uint32_t MyPhysicsWorld::Step(float deltaTime) {
+
+	// 追いつけない分は捨て、時間刻みに満たない残りは補間用に次回へ持ち越す
+	uint32_t subStepCount = scheduler_.Advance(deltaTime);
+	for (uint32_t subStep = 0; subStep < subStepCount; subStep++) {
+		SubStep();
+	}
+
+	return subStepCount;
+
+}
+
+/// <summary>
+/// 剛体の位置を設定する関数 (眠っていれば起こす)
+/// 動かない剛体でも、移動の前後で触れている剛体は起こす (載っていた剛体が宙に浮いたまま眠らないようにする)
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+/// <param name="center">中心座標</param>
+void MyPhysicsWorld::SetPosition(uint32_t bodyId, const Vector3& center) {
+
+	// 移動前に触れていた剛体 (上に載っていた剛体など) を起こす
+	WakeTouching(bodyId);
+
+	Vector3 displacement = center - bodies_[bodyId].sphere.center;
+	bodies_[bodyId].sphere.center = center;
+	MoveProxy(bodyId, displacement);
+	WakeBody(bodyId);
+
+	// 移動先で触れた剛体を起こす
+	WakeTouching(bodyId);
+
+}
+
+/// <summary>
+/// 剛体の速度を設定する関数 (眠っていれば起こす)
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+/// <param name="velocity">速度</param>
+void MyPhysicsWorld::SetVelocity(uint32_t bodyId, const Vector3& velocity) {
+
+	bodies_[bodyId].velocity = velocity;
+	WakeBody(bodyId);
+
+}
+
+/// <summary>
+/// 剛体に力積を加える関数 (眠っていれば起こす)
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+/// <param name="impulse">力積</param>
+void MyPhysicsWorld::ApplyImpulse(uint32_t bodyId, const Vector3& impulse) {
+
+	SphereBody& body = bodies_[bodyId];
+	MyExpr::Store(body.velocity, MyExpr::Ref(body.velocity) + body.inverseMass * MyExpr::Ref(impulse));
+	WakeBody(bodyId);
+
+}
+
+/// <summary>
+/// 時間刻み分だけ時間を進める関数
+/// </summary>
+void MyPhysicsWorld::SubStep() {
+
+	// 重力で速度を更新する
+	Vector3 gravityStep = MyMath::Multiply(timeStep_, gravity_);
+	for (uint32_t bodyId : activeBodies_) {
+		bodies_[bodyId].velocity = bodies_[bodyId].velocity + gravityStep;
+	}
+
+	CollectContacts();
+	SolveContacts();
+
+	// 速度で位置を更新する
+	for (uint32_t bodyId : activeBodies_) {
+		SphereBody& body = bodies_[bodyId];
+		Vector3 displacement = MyMath::Multiply(timeStep_, body.velocity);
+		body.sphere.center = body.sphere.center + displacement;
+		MoveProxy(bodyId, displacement);
+	}
+
+	UpdateIslands();
+
+}
+
+/// <summary>
+/// 起きている剛体と重なる剛体、平面の接触を集める関数
+/// 眠っている剛体に触れた場合はその島を起こす
+/// </summary>
+void MyPhysicsWorld::CollectContacts() {
+
+	contacts_.clear();
+
+	// 接触を追加する
+	auto addContact = [this](uint32_t bodyIdA, uint32_t bodyIdB, const Vector3& normal, float depth, float restitution, float friction) {
+		const SphereBody& a = bodies_[bodyIdA];
+		Vector3 velocityB = {};
+		float inverseMassB = 0.0f;
+		if (bodyIdB != kNullBody) {
+			velocityB = bodies_[bodyIdB].velocity;
+			inverseMassB = bodies_[bodyIdB].inverseMass;
+		}
+
+		ContactPoint contact{};
+		contact.bodyA = bodyIdA;
+		contact.bodyB = bodyIdB;
+		contact.normal = normal;
+		contact.normalMass = 1.0f / (a.inverseMass + inverseMassB);
+		contact.friction = friction;
+
+		// 十分な速さで近づいていれば反発させ、めり込みは数回に分けて押し戻す
+		float normalVelocity = MyMath::Dot(velocityB - a.velocity, normal);
+		float bounce = normalVelocity < -kRestitutionThreshold ? -restitution * normalVelocity : 0.0f;
+		float push = kBaumgarte / timeStep_ * std::max(depth - kLinearSlop, 0.0f);
+		contact.bias = std::max(bounce, push);
+
+		contacts_.push_back(contact);
+	};
+
+	// 処理中に起こされた剛体も末尾に追加されて同じように処理される
+	for (uint32_t activeIndex = 0; activeIndex < activeBodies_.size(); activeIndex++) {
+		uint32_t bodyIdA = activeBodies_[activeIndex];
+		const SphereBody& a = bodies_[bodyIdA];
+
+		// 平面との接触 (中心がある側に押し出す)
+		for (const Plane& plane : planes_) {
+			if (!MyCollision::IsCollisionPlane(a.sphere, plane)) {
+				continue;
+			}
+			float distance = MyMath::Dot(plane.normal, a.sphere.center) - plane.distance;
+			Vector3 normal = distance >= 0.0f ? MyMath::Multiply(-1.0f, plane.normal) : plane.normal;
+			addContact(bodyIdA, kNullBody, normal, a.sphere.radius - std::abs(distance), a.restitution, a.friction);
+		}
+
+		// 剛体との接触
+		tree_.Query(MyCollision::MakeAABB(a.sphere), [&](int32_t proxyId) {
+			uint32_t bodyIdB = tree_.GetUserData(proxyId);
+			if (bodyIdB == bodyIdA) {
+				return true;
+			}
+
+			// 両方起きている組は配列で先にある方だけが追加する
+			const BodyState& stateB = states_[bodyIdB];
+			if (stateB.activeIndex != kNullBody && stateB.activeIndex < activeIndex) {
+				return true;
+			}
+
+			const SphereBody& b = bodies_[bodyIdB];
+			if (!MyCollision::IsCollisionSphere(a.sphere, b.sphere)) {
+				return true;
+			}
+
+			// 眠っている剛体に触れたら島ごと起こす
+			WakeBody(bodyIdB);
+
+			Vector3 diff = b.sphere.center - a.sphere.center;
+			float distance = MyMath::Length(diff);
+			Vector3 normal = distance > 0.0f ? MyMath::Multiply(1.0f / distance, diff) : Vector3{ 0.0f, 1.0f, 0.0f };
+			addContact(bodyIdA, bodyIdB, normal, a.sphere.radius + b.sphere.radius - distance,
+				std::max(a.restitution, b.restitution), std::sqrt(a.friction * b.friction));
+			return true;
+		});
+	}
+
+}
+
+/// <summary>
+/// 逐次インパルス法で接触を解決する関数
+/// </summary>
+void MyPhysicsWorld::SolveContacts() {
+
+	for (uint32_t iteration = 0; iteration < iterationCount_; iteration++) {
+		for (ContactPoint& contact : contacts_) {
+			SphereBody& a = bodies_[contact.bodyA];
+			SphereBody* b = contact.bodyB != kNullBody ? &bodies_[contact.bodyB] : nullptr;
+			float inverseMassB = b != nullptr ? b->inverseMass : 0.0f;
+
+			// 力積を剛体の速度に反映する
+			auto apply = [&](const Vector3& impulse) {
+				MyExpr::Store(a.velocity, MyExpr::Ref(a.velocity) - a.inverseMass * MyExpr::Ref(impulse));
+				if (b != nullptr) {
+					MyExpr::Store(b->velocity, MyExpr::Ref(b->velocity) + inverseMassB * MyExpr::Ref(impulse));
+				}
+			};
+			auto relativeVelocity = [&]() {
+				return (b != nullptr ? b->velocity : Vector3{}) - a.velocity;
+			};
+
+			// 摩擦 (接線方向の相対速度を0にし、合計を法線方向の力積に比例する円の中に収める)
+			Vector3 velocity = relativeVelocity();
+			Vector3 tangentVelocity = MyExpr::Eval(MyExpr::Ref(velocity) - MyMath::Dot(velocity, contact.normal) * MyExpr::Ref(contact.normal));
+			Vector3 oldTangentImpulse = contact.tangentImpulse;
+			Vector3 tangentImpulse = MyExpr::Eval(MyExpr::Ref(oldTangentImpulse) - contact.normalMass * MyExpr::Ref(tangentVelocity));
+			float maxFriction = contact.friction * contact.normalImpulse;
+			float tangentLength = MyMath::Length(tangentImpulse);
+			if (tangentLength > maxFriction) {
+				tangentImpulse = tangentLength > 0.0f ? MyMath::Multiply(maxFriction / tangentLength, tangentImpulse) : Vector3{};
+			}
+			contact.tangentImpulse = tangentImpulse;
+			apply(tangentImpulse - oldTangentImpulse);
+
+			// 法線方向 (目標の速度で離れるようにし、合計は引き合わないように0以上に保つ)
+			float normalVelocity = MyMath::Dot(relativeVelocity(), contact.normal);
+			float oldNormalImpulse = contact.normalImpulse;
+			contact.normalImpulse = std::max(oldNormalImpulse + contact.normalMass * (contact.bias - normalVelocity), 0.0f);
+			apply(MyMath::Multiply(contact.normalImpulse - oldNormalImpulse, contact.normal));
+		}
+	}
+
+}
+
+/// <summary>
+/// 接触でつながった島を求め、静止している島を眠らせる関数
+/// </summary>
+void MyPhysicsWorld::UpdateIslands() {
+
+	uint32_t activeCount = uint32_t(activeBodies_.size());
+
+	// 動く剛体同士の接触でつなぐ (動かない剛体と平面は島をつながない)
+	islandParent_.resize(activeCount);
+	std::iota(islandParent_.begin(), islandParent_.end(), 0u);
+	for (const ContactPoint& contact : contacts_) {
+		if (contact.bodyB == kNullBody || bodies_[contact.bodyB].inverseMass == 0.0f) {
+			continue;
+		}
+		uint32_t rootA = FindRoot(states_[contact.bodyA].activeIndex);
+		uint32_t rootB = FindRoot(states_[contact.bodyB].activeIndex);
+		if (rootA != rootB) {
+			islandParent_[rootB] = rootA;
+		}
+	}
+
+	// 静止している時間を更新し、島ごとに最も短い時間を求める
+	islandSleepTime_.assign(activeCount, FLT_MAX);
+	for (uint32_t i = 0; i < activeCount; i++) {
+		uint32_t bodyId = activeBodies_[i];
+		const Vector3& velocity = bodies_[bodyId].velocity;
+		BodyState& state = states_[bodyId];
+		if (MyMath::Dot(velocity, velocity) > kSleepVelocity * kSleepVelocity) {
+			state.sleepTime = 0.0f;
+		}
+		else {
+			state.sleepTime += timeStep_;
+		}
+		uint32_t root = FindRoot(i);
+		islandSleepTime_[root] = std::min(islandSleepTime_[root], state.sleepTime);
+	}
+
+	// 島の全ての剛体が一定時間静止していれば眠らせる
+	islandOfRoot_.assign(activeCount, kNullBody);
+	bool isAnySleep = false;
+	for (uint32_t i = 0; i < activeCount; i++) {
+		uint32_t root = FindRoot(i);
+		if (islandSleepTime_[root] < kTimeToSleep) {
+			continue;
+		}
+
+		// 島ごとに眠っている島の番号を割り当てる
+		if (islandOfRoot_[root] == kNullBody) {
+			if (!freeIslands_.empty()) {
+				islandOfRoot_[root] = freeIslands_.back();
+				freeIslands_.pop_back();
+			}
+			else {
+				islandOfRoot_[root] = uint32_t(sleepingIslands_.size());
+				sleepingIslands_.emplace_back();
+			}
+		}
+
+		uint32_t bodyId = activeBodies_[i];
+		BodyState& state = states_[bodyId];
+		state.islandId = islandOfRoot_[root];
+		state.activeIndex = kNullBody;
+		state.sleepTime = 0.0f;
+		bodies_[bodyId].velocity = {};
+		sleepingIslands_[state.islandId].push_back(bodyId);
+		isAnySleep = true;
+	}
+
+	// 眠らせた剛体を起きている剛体の配列から取り除く
+	if (isAnySleep) {
+		uint32_t writeIndex = 0;
+		for (uint32_t i = 0; i < activeCount; i++) {
+			uint32_t bodyId = activeBodies_[i];
+			if (states_[bodyId].activeIndex == kNullBody) {
+				continue;
+			}
+			states_[bodyId].activeIndex = writeIndex;
+			activeBodies_[writeIndex++] = bodyId;
+		}
+		activeBodies_.resize(writeIndex);
+	}
+
+}
+
+/// <summary>
+/// 剛体を起こす関数 (眠っている島の剛体を全て起こす)
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+void MyPhysicsWorld::WakeBody(uint32_t bodyId) {
+
+	// 起きている剛体と動かない剛体は何もしない
+	const BodyState& state = states_[bodyId];
+	if (state.activeIndex != kNullBody || bodies_[bodyId].inverseMass == 0.0f) {
+		return;
+	}
+
+	uint32_t islandId = state.islandId;
+	std::vector<uint32_t>& island = sleepingIslands_[islandId];
+	for (uint32_t member : island) {
+		Activate(member);
+	}
+	island.clear();
+	freeIslands_.push_back(islandId);
+
+}
+
+/// <summary>
+/// 剛体に触れている (許容するめり込み量の範囲で接している) 剛体を起こす関数
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+void MyPhysicsWorld::WakeTouching(uint32_t bodyId) {
+
+	Sphere sphere = bodies_[bodyId].sphere;
+	sphere.radius += kLinearSlop;
+	tree_.Query(MyCollision::MakeAABB(sphere), [&](int32_t proxyId) {
+		uint32_t otherId = tree_.GetUserData(proxyId);
+		if (otherId != bodyId && MyCollision::IsCollisionSphere(sphere, bodies_[otherId].sphere)) {
+			WakeBody(otherId);
+		}
+		return true;
+	});
+
+}
+
+/// <summary>
+/// 剛体を起きている剛体の配列に追加する関数
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+void MyPhysicsWorld::Activate(uint32_t bodyId) {
+
+	BodyState& state = states_[bodyId];
+	state.activeIndex = uint32_t(activeBodies_.size());
+	state.islandId = kNullBody;
+	state.sleepTime = 0.0f;
+	activeBodies_.push_back(bodyId);
+
+}
+
+/// <summary>
+/// 剛体のAABB木の要素を更新する関数
+/// </summary>
+/// <param name="bodyId">剛体の番号</param>
+/// <param name="displacement">移動量</param>
+void MyPhysicsWorld::MoveProxy(uint32_t bodyId, const Vector3& displacement) {
+	tree_.MoveProxy(states_[bodyId].proxyId, MyCollision::MakeAABB(bodies_[bodyId].sphere), displacement);
+}
+
+/// <summary>
+/// 島の根を求める関数 (経路圧縮あり)
+/// </summary>
+/// <param name="index">起きている剛体の配列内の番号</param>
+/// <returns>根の番号</returns>
+uint32_t MyPhysicsWorld::FindRoot(uint32_t index) {
+
+	uint32_t root = index;
+	while (islandParent_[root] != root) {
+		root = islandParent_[root];
+	}
+
+	// 通った要素を根に直接つなぐ
+	while (islandParent_[index] != root) {
+		uint32_t next = islandParent_[index];
+		islandParent_[index] = root;
+		index = next;
+	}
+
+	return root;
+
+}
@@ -0,0 +1,253 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "MyAABBTree.h"
+#include "MyCollision.h"
+#include "MyFrameScheduler.h"
+
+/// <summary>
+/// 球の剛体
+/// </summary>
+struct SphereBody {
+	Sphere sphere; // 形状
+	Vector3 velocity; // 速度
+	float inverseMass; // 質量の逆数 (0なら動かない)
+	float restitution; // 反発係数
+	float friction; // 摩擦係数
+};
+
+/// <summary>
+/// 球の剛体を固定の時間刻みで動かすクラス
+/// 接触は逐次インパルス法で解決し、接触でつながった剛体の集まり (島) が
+/// 一定時間静止していれば島ごと眠らせて、以降は起こされるまで一切処理しない
+/// 1回の更新の処理量は起きている剛体とその接触の数だけで決まる
+/// </summary>
+class MyPhysicsWorld
+{
+public:
+
+	// 無効な剛体の番号
+	static constexpr uint32_t kNullBody = UINT32_MAX;
+	// 1回の Step で計算する最大回数 (処理落ちで計算が追いつかなくなるのを防ぐ)
+	static const uint32_t kMaxSubStepCount = 8;
+	// 島を眠らせるまでに静止している必要がある時間
+	static constexpr float kTimeToSleep = 0.5f;
+
+	/// <summary>
+	/// コンストラクタ
+	/// </summary>
+	/// <param name="timeStep">1回の計算で進める時間 (秒)</param>
+	/// <param name="iterationCount">接触を解決する反復回数</param>
+	MyPhysicsWorld(float timeStep = 1.0f / 60.0f, uint32_t iterationCount = 8);
+
+	/// <summary>
+	/// 剛体を追加する関数
+	/// </summary>
+	/// <param name="sphere">形状</param>
+	/// <param name="mass">質量 (0なら動かない剛体)</param>
+	/// <param name="velocity">初速度</param>
+	/// <param name="restitution">反発係数</param>
+	/// <param name="friction">摩擦係数</param>
+	/// <returns>剛体の番号</returns>
+	uint32_t CreateBody(const Sphere& sphere, float mass, const Vector3& velocity = {}, float restitution = 0.2f, float friction = 0.4f);
+
+	/// <summary>
+	/// 動かない平面を追加する関数 (両面で衝突する)
+	/// </summary>
+	/// <param name="plane">平面</param>
+	void AddPlane(const Plane& plane) { planes_.push_back(plane); }
+
+	/// <summary>
+	/// 重力加速度を設定する関数
+	/// </summary>
+	/// <param name="gravity">重力加速度</param>
+	void SetGravity(const Vector3& gravity) { gravity_ = gravity; }
+
+	/// <summary>
+	/// 経過時間だけ時間を進める関数
+	/// 経過時間を貯めておき、時間刻み分たまるごとに1回計算する (回数は MyFrameScheduler::Advance で求める)
+	/// </summary>
+	/// <param name="deltaTime">経過時間 (秒)</param>
+	/// <returns>計算した回数</returns>
+	uint32_t Step(float deltaTime);
+
+	/// <summary>
+	/// 剛体を取得する関数
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <returns>剛体</returns>
+	const SphereBody& GetBody(uint32_t bodyId) const { return bodies_[bodyId]; }
+
+	/// <summary>
+	/// 剛体の位置を設定する関数 (眠っていれば起こす)
+	/// 動かない剛体でも、移動の前後で触れている剛体は起こす (載っていた剛体が宙に浮いたまま眠らないようにする)
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <param name="center">中心座標</param>
+	void SetPosition(uint32_t bodyId, const Vector3& center);
+
+	/// <summary>
+	/// 剛体の速度を設定する関数 (眠っていれば起こす)
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <param name="velocity">速度</param>
+	void SetVelocity(uint32_t bodyId, const Vector3& velocity);
+
+	/// <summary>
+	/// 剛体に力積を加える関数 (眠っていれば起こす)
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <param name="impulse">力積</param>
+	void ApplyImpulse(uint32_t bodyId, const Vector3& impulse);
+
+	/// <summary>
+	/// 剛体が眠っているか取得する関数
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <returns>眠っているか (動かない剛体は常に true)</returns>
+	bool IsSleeping(uint32_t bodyId) const { return states_[bodyId].activeIndex == kNullBody; }
+
+	/// <summary>
+	/// 剛体の数を取得する関数
+	/// </summary>
+	/// <returns>剛体の数</returns>
+	uint32_t GetBodyCount() const { return uint32_t(bodies_.size()); }
+
+	/// <summary>
+	/// 起きている剛体の数を取得する関数
+	/// </summary>
+	/// <returns>起きている剛体の数</returns>
+	uint32_t GetActiveCount() const { return uint32_t(activeBodies_.size()); }
+
+	/// <summary>
+	/// 貯まっている経過時間の時間刻みに対する割合を取得する関数 (描画時の補間用)
+	/// </summary>
+	/// <returns>0以上1未満の割合</returns>
+	float GetInterpolationAlpha() const { return scheduler_.GetAlpha(); }
+
+	/// <summary>
+	/// 追いつけずに捨てた計算の回数を取得する関数
+	/// </summary>
+	/// <returns>捨てた計算の回数</returns>
+	uint64_t GetDroppedStepCount() const { return scheduler_.GetDroppedStepCount(); }
+
+private:
+
+	/// <summary>
+	/// 剛体の計算用の状態
+	/// </summary>
+	struct BodyState {
+		int32_t proxyId; // AABB木の要素の番号
+		uint32_t activeIndex; // 起きている剛体の配列内の番号 (眠っている場合は kNullBody)
+		uint32_t islandId; // 眠っている島の番号 (起きている場合は kNullBody)
+		float sleepTime; // 静止している時間
+	};
+
+	/// <summary>
+	/// 接触
+	/// </summary>
+	struct ContactPoint {
+		uint32_t bodyA; // 剛体A
+		uint32_t bodyB; // 剛体B (平面の場合は kNullBody)
+		Vector3 normal; // AからBへ向かう法線
+		float bias; // 目標とする法線方向の相対速度 (反発とめり込みの解消)
+		float normalMass; // 法線方向の有効質量
+		float normalImpulse; // 法線方向に加えた力積の合計
+		Vector3 tangentImpulse; // 接線方向に加えた力積の合計
+		float friction; // 摩擦係数
+	};
+
+	/// <summary>
+	/// 時間刻み分だけ時間を進める関数
+	/// </summary>
+	void SubStep();
+
+	/// <summary>
+	/// 起きている剛体と重なる剛体、平面の接触を集める関数
+	/// 眠っている剛体に触れた場合はその島を起こす
+	/// </summary>
+	void CollectContacts();
+
+	/// <summary>
+	/// 逐次インパルス法で接触を解決する関数
+	/// </summary>
+	void SolveContacts();
+
+	/// <summary>
+	/// 接触でつながった島を求め、静止している島を眠らせる関数
+	/// </summary>
+	void UpdateIslands();
+
+	/// <summary>
+	/// 剛体を起こす関数 (眠っている島の剛体を全て起こす)
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	void WakeBody(uint32_t bodyId);
+
+	/// <summary>
+	/// 剛体に触れている (許容するめり込み量の範囲で接している) 剛体を起こす関数
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	void WakeTouching(uint32_t bodyId);
+
+	/// <summary>
+	/// 剛体を起きている剛体の配列に追加する関数
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	void Activate(uint32_t bodyId);
+
+	/// <summary>
+	/// 剛体のAABB木の要素を更新する関数
+	/// </summary>
+	/// <param name="bodyId">剛体の番号</param>
+	/// <param name="displacement">移動量</param>
+	void MoveProxy(uint32_t bodyId, const Vector3& displacement);
+
+	/// <summary>
+	/// 島の根を求める関数 (経路圧縮あり)
+	/// </summary>
+	/// <param name="index">起きている剛体の配列内の番号</param>
+	/// <returns>根の番号</returns>
+	uint32_t FindRoot(uint32_t index);
+
+	// これより遅ければ静止しているとみなす速さ
+	static constexpr float kSleepVelocity = 0.05f;
+	// 反発させる最小の接近速度 (これより遅い接触は反発させずに止める)
+	static constexpr float kRestitutionThreshold = 0.5f;
+	// 許容するめり込み量
+	static constexpr float kLinearSlop = 0.005f;
+	// 1回の計算で解消するめり込みの割合
+	static constexpr float kBaumgarte = 0.2f;
+
+	// 時間刻み
+	float timeStep_;
+	// 接触を解決する反復回数
+	uint32_t iterationCount_;
+	// 経過時間を貯めて計算する回数を求める (描画側の MyFrameScheduler と同じ方法で追いつけない分を捨てる)
+	MyFrameScheduler scheduler_;
+	// 重力加速度
+	Vector3 gravity_ = { 0.0f, -9.8f, 0.0f };
+
+	// 剛体
+	std::vector<SphereBody> bodies_;
+	// 剛体の計算用の状態
+	std::vector<BodyState> states_;
+	// 平面
+	std::vector<Plane> planes_;
+	// 剛体を探すためのAABB木
+	MyAABBTree tree_;
+
+	// 起きている剛体の番号
+	std::vector<uint32_t> activeBodies_;
+	// 眠っている島ごとの剛体の番号 (空の要素は再利用する)
+	std::vector<std::vector<uint32_t>> sleepingIslands_;
+	// 空いている眠っている島の番号
+	std::vector<uint32_t> freeIslands_;
+
+	// 計算中に使う配列
+	std::vector<ContactPoint> contacts_;
+	std::vector<uint32_t> islandParent_;
+	std::vector<float> islandSleepTime_;
+	std::vector<uint32_t> islandOfRoot_;
+
+};
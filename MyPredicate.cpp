@@ -0,0 +1,308 @@
+﻿#include "MyPredicate.h"
+#include <cmath>
+
+namespace {
+
+	// double の丸め誤差の単位 (2^-53)
+	const double kEpsilon = 1.1102230246251565e-16;
+	// 誤差の上限の係数 (Shewchuk の o3derrboundA、ccwerrboundA)
+	const double kOrient3DErrorBound = (7.0 + 56.0 * kEpsilon) * kEpsilon;
+	const double kOrient2DErrorBound = (3.0 + 16.0 * kEpsilon) * kEpsilon;
+
+	// 展開の最大要素数 (Orient3D の最終結果)
+	const int kMaxExpansion = 192;
+
+	/// <summary>
+	/// 2つの値の和を誤差なしで求める関数 (x + y == a + b)
+	/// </summary>
+	inline void TwoSum(double a, double b, double& x, double& y) {
+		double sum = a + b;
+		double bVirtual = sum - a;
+		double aVirtual = sum - bVirtual;
+		y = (a - aVirtual) + (b - bVirtual);
+		x = sum;
+	}
+
+	/// <summary>
+	/// 2つの値の積を誤差なしで求める関数 (x + y == a * b)
+	/// </summary>
+	inline void TwoProduct(double a, double b, double& x, double& y) {
+		double product = a * b;
+		y = std::fma(a, b, -product);
+		x = product;
+	}
+
+	/// <summary>
+	/// 2つの値の差を展開で表す関数 (要素は絶対値の小さい順)
+	/// </summary>
+	/// <returns>要素数</returns>
+	inline int TwoDiffExpansion(double a, double b, double* h) {
+		double x, y;
+		TwoSum(a, -b, x, y);
+		int count = 0;
+		if (y != 0.0) {
+			h[count++] = y;
+		}
+		if (x != 0.0 || count == 0) {
+			h[count++] = x;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// 展開に値を足す関数 (0の要素は取り除く)
+	/// </summary>
+	/// <param name="e">展開 (絶対値の小さい順)</param>
+	/// <param name="eCount">要素数</param>
+	/// <param name="b">足す値</param>
+	/// <param name="h">結果の格納先 (e と別の配列)</param>
+	/// <returns>結果の要素数</returns>
+	int GrowExpansion(const double* e, int eCount, double b, double* h) {
+		double q = b;
+		int count = 0;
+		for (int i = 0; i < eCount; i++) {
+			double sum, error;
+			TwoSum(q, e[i], sum, error);
+			if (error != 0.0) {
+				h[count++] = error;
+			}
+			q = sum;
+		}
+		if (q != 0.0 || count == 0) {
+			h[count++] = q;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// 2つの展開の和を求める関数
+	/// </summary>
+	/// <returns>結果の要素数</returns>
+	int ExpansionSum(const double* e, int eCount, const double* f, int fCount, double* h) {
+		double buffer[2][kMaxExpansion];
+		const double* current = e;
+		int count = eCount;
+		for (int i = 0; i < fCount; i++) {
+			double* next = i + 1 == fCount ? h : buffer[i & 1];
+			count = GrowExpansion(current, count, f[i], next);
+			current = next;
+		}
+		if (fCount == 0) {
+			for (int i = 0; i < eCount; i++) {
+				h[i] = e[i];
+			}
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// 展開に値を掛ける関数
+	/// </summary>
+	/// <returns>結果の要素数</returns>
+	int ScaleExpansion(const double* e, int eCount, double b, double* h) {
+		double q, error;
+		TwoProduct(e[0], b, q, error);
+		int count = 0;
+		if (error != 0.0) {
+			h[count++] = error;
+		}
+		for (int i = 1; i < eCount; i++) {
+			double productHigh, productLow, sum;
+			TwoProduct(e[i], b, productHigh, productLow);
+			TwoSum(q, productLow, sum, error);
+			if (error != 0.0) {
+				h[count++] = error;
+			}
+			TwoSum(productHigh, sum, q, error);
+			if (error != 0.0) {
+				h[count++] = error;
+			}
+		}
+		if (q != 0.0 || count == 0) {
+			h[count++] = q;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// 2つの展開の積を求める関数
+	/// </summary>
+	/// <returns>結果の要素数</returns>
+	int ExpansionProduct(const double* e, int eCount, const double* f, int fCount, double* h) {
+		double scaled[kMaxExpansion];
+		double sum[2][kMaxExpansion];
+		int count = ScaleExpansion(e, eCount, f[0], sum[0]);
+		for (int i = 1; i < fCount; i++) {
+			int scaledCount = ScaleExpansion(e, eCount, f[i], scaled);
+			count = ExpansionSum(sum[(i - 1) & 1], count, scaled, scaledCount, sum[i & 1]);
+		}
+		const double* result = sum[(fCount - 1) & 1];
+		for (int i = 0; i < count; i++) {
+			h[i] = result[i];
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// 展開の符号を求める関数 (最も絶対値の大きい要素の符号)
+	/// </summary>
+	inline int Sign(const double* e, int eCount) {
+		double top = e[eCount - 1];
+		return top > 0.0 ? 1 : (top < 0.0 ? -1 : 0);
+	}
+
+	/// <summary>
+	/// 2x2 の小行列式 a * d - b * c を誤差なしで求める関数
+	/// </summary>
+	/// <returns>結果の要素数</returns>
+	int Minor2(const double* a, int aCount, const double* b, int bCount, const double* c, int cCount, const double* d, int dCount, double* h) {
+		double ad[kMaxExpansion], bc[kMaxExpansion];
+		int adCount = ExpansionProduct(a, aCount, d, dCount, ad);
+		int bcCount = ExpansionProduct(b, bCount, c, cCount, bc);
+		for (int i = 0; i < bcCount; i++) {
+			bc[i] = -bc[i];
+		}
+		return ExpansionSum(ad, adCount, bc, bcCount, h);
+	}
+
+	/// <summary>
+	/// Orient3D を誤差なしで求める関数
+	/// </summary>
+	int Orient3DExact(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d) {
+
+		// 各点から d への差
+		double diff[3][3][2];
+		int diffCount[3][3];
+		const Vector3* points[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; i++) {
+			diffCount[i][0] = TwoDiffExpansion(points[i]->x, d.x, diff[i][0]);
+			diffCount[i][1] = TwoDiffExpansion(points[i]->y, d.y, diff[i][1]);
+			diffCount[i][2] = TwoDiffExpansion(points[i]->z, d.z, diff[i][2]);
+		}
+
+		// 1行目で余因子展開する
+		double sum[2][kMaxExpansion];
+		int sumCount = 0;
+		for (int i = 0; i < 3; i++) {
+			int j = (i + 1) % 3;
+			int k = (i + 2) % 3;
+			double minor[kMaxExpansion];
+			int minorCount = Minor2(
+				diff[j][1], diffCount[j][1], diff[j][2], diffCount[j][2],
+				diff[k][1], diffCount[k][1], diff[k][2], diffCount[k][2], minor);
+			double term[kMaxExpansion];
+			int termCount = ExpansionProduct(minor, minorCount, diff[i][0], diffCount[i][0], term);
+			if (i == 0) {
+				for (int n = 0; n < termCount; n++) {
+					sum[0][n] = term[n];
+				}
+				sumCount = termCount;
+			}
+			else {
+				sumCount = ExpansionSum(sum[(i - 1) & 1], sumCount, term, termCount, sum[i & 1]);
+			}
+		}
+
+		return Sign(sum[0], sumCount);
+
+	}
+
+	/// <summary>
+	/// Orient2D を誤差なしで求める関数
+	/// </summary>
+	int Orient2DExact(double ax, double ay, double bx, double by, double cx, double cy) {
+
+		double acx[2], acy[2], bcx[2], bcy[2];
+		int acxCount = TwoDiffExpansion(ax, cx, acx);
+		int acyCount = TwoDiffExpansion(ay, cy, acy);
+		int bcxCount = TwoDiffExpansion(bx, cx, bcx);
+		int bcyCount = TwoDiffExpansion(by, cy, bcy);
+
+		double det[kMaxExpansion];
+		int detCount = Minor2(acx, acxCount, acy, acyCount, bcx, bcxCount, bcy, bcyCount, det);
+		return Sign(det, detCount);
+
+	}
+
+}
+
+/// <summary>
+/// 4点の向きを判定する関数
+/// (a - d)・((b - d) × (c - d)) の符号を返す
+/// d から見て a, b, c が反時計回りなら負、時計回りなら正、同じ平面上なら0
+/// </summary>
+/// <param name="a">点a</param>
+/// <param name="b">点b</param>
+/// <param name="c">点c</param>
+/// <param name="d">点d</param>
+/// <returns>符号 (-1, 0, 1)</returns>
+int MyPredicate::Orient3D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d) {
+
+	double adx = double(a.x) - d.x, ady = double(a.y) - d.y, adz = double(a.z) - d.z;
+	double bdx = double(b.x) - d.x, bdy = double(b.y) - d.y, bdz = double(b.z) - d.z;
+	double cdx = double(c.x) - d.x, cdy = double(c.y) - d.y, cdz = double(c.z) - d.z;
+
+	double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+	double cdxady = cdx * ady, adxcdy = adx * cdy;
+	double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+	double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+
+	// 誤差の上限より大きければ符号は正しい
+	double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+		(std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+		(std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+	double errorBound = kOrient3DErrorBound * permanent;
+	if (det > errorBound) {
+		return 1;
+	}
+	if (-det > errorBound) {
+		return -1;
+	}
+
+	// 境界に近い場合だけ誤差なしで計算し直す
+	return Orient3DExact(a, b, c, d);
+
+}
+
+/// <summary>
+/// 平面上の3点の向きを判定する関数
+/// (a - c) × (b - c) の符号を返す (a, b, c が反時計回りなら正)
+/// </summary>
+/// <returns>符号 (-1, 0, 1)</returns>
+int MyPredicate::Orient2D(float ax, float ay, float bx, float by, float cx, float cy) {
+
+	double detLeft = (double(ax) - cx) * (double(by) - cy);
+	double detRight = (double(ay) - cy) * (double(bx) - cx);
+	double det = detLeft - detRight;
+
+	// 2つの項の符号が異なれば打ち消し合わないので符号は正しい
+	double detSum;
+	if (detLeft > 0.0) {
+		if (detRight <= 0.0) {
+			return det > 0.0 ? 1 : (det < 0.0 ? -1 : 0);
+		}
+		detSum = detLeft + detRight;
+	}
+	else if (detLeft < 0.0) {
+		if (detRight >= 0.0) {
+			return det > 0.0 ? 1 : (det < 0.0 ? -1 : 0);
+		}
+		detSum = -detLeft - detRight;
+	}
+	else {
+		return det > 0.0 ? 1 : (det < 0.0 ? -1 : 0);
+	}
+
+	double errorBound = kOrient2DErrorBound * detSum;
+	if (det >= errorBound) {
+		return 1;
+	}
+	if (-det >= errorBound) {
+		return -1;
+	}
+
+	// 境界に近い場合だけ誤差なしで計算し直す
+	return Orient2DExact(ax, ay, bx, by, cx, cy);
+
+}
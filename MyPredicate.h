@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "Vector3.h"
+
+/// <summary>
+/// 点の位置関係を誤差なく判定する関数を管理するクラス (Shewchuk の適応精度述語)
+/// まず double で計算し、誤差の上限より結果の絶対値が大きければそのまま符号を返す
+/// 境界に近い場合だけ、誤差なしの多倍長 (double の和で表した展開) で計算し直す
+/// 入力は float なので double への変換と差、積の誤差は全て展開で表せる
+/// </summary>
+class MyPredicate
+{
+public:
+
+	/// <summary>
+	/// 4点の向きを判定する関数
+	/// (a - d)・((b - d) × (c - d)) の符号を返す
+	/// d から見て a, b, c が反時計回りなら負、時計回りなら正、同じ平面上なら0
+	/// </summary>
+	/// <param name="a">点a</param>
+	/// <param name="b">点b</param>
+	/// <param name="c">点c</param>
+	/// <param name="d">点d</param>
+	/// <returns>符号 (-1, 0, 1)</returns>
+	static int Orient3D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d);
+
+	/// <summary>
+	/// 平面上の3点の向きを判定する関数
+	/// (a - c) × (b - c) の符号を返す (a, b, c が反時計回りなら正)
+	/// </summary>
+	/// <returns>符号 (-1, 0, 1)</returns>
+	static int Orient2D(float ax, float ay, float bx, float by, float cx, float cy);
+
+};
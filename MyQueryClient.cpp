@@ -0,0 +1,159 @@
+﻿#include "MySocket.h"
+#include "MyQueryClient.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+/// <summary>
+/// デストラクタ
+/// </summary>
+MyQueryClient::~MyQueryClient() {
+	Close();
+}
+
+/// <summary>
+/// サーバーに接続する関数
+/// </summary>
+/// <param name="path">ソケットのパス</param>
+/// <returns>接続できたか</returns>
+bool MyQueryClient::Connect(const char* path) {
+
+	Close();
+
+	if (!MySocket::Startup()) {
+		return false;
+	}
+
+	SocketHandle socket = MySocket::Connect(path);
+	if (socket == MySocket::kInvalidSocket) {
+		MySocket::Cleanup();
+		return false;
+	}
+
+	socket_ = uintptr_t(socket);
+	isConnected_ = true;
+	return true;
+
+}
+
+/// <summary>
+/// 接続を閉じる関数
+/// </summary>
+void MyQueryClient::Close() {
+
+	if (!isConnected_) {
+		return;
+	}
+
+	MySocket::Close(SocketHandle(socket_));
+	MySocket::Cleanup();
+	isConnected_ = false;
+
+}
+
+/// <summary>
+/// 要求を送信する関数
+/// </summary>
+/// <param name="requestId">要求番号</param>
+/// <param name="type">問い合わせの種類</param>
+/// <param name="elements">要素配列 (種類に対応する Segment / Sphere / Ray の配列)</param>
+/// <param name="count">要素の数 (kMaxQueryCount 以下)</param>
+/// <returns>送信できたか</returns>
+bool MyQueryClient::Send(uint32_t requestId, QueryType type, const void* elements, uint32_t count) {
+
+	size_t elementSize = GetQueryElementSize(type);
+	if (!isConnected_ || elementSize == 0 || count > kMaxQueryCount) {
+		return false;
+	}
+
+	// 先頭と要素をまとめて1回で送信する
+	QueryRequestHeader header = { requestId, type, 0, count };
+	sendBuffer_.resize(sizeof(header) + elementSize * count);
+	std::memcpy(sendBuffer_.data(), &header, sizeof(header));
+	std::memcpy(sendBuffer_.data() + sizeof(header), elements, elementSize * count);
+
+	size_t sent = 0;
+	return MySocket::Send(SocketHandle(socket_), sendBuffer_.data(), sendBuffer_.size(), sent) == SocketResult::kDone;
+
+}
+
+/// <summary>
+/// 応答を1つ受信する関数 (届くまで待つ)
+/// </summary>
+/// <param name="header">応答の先頭の格納先</param>
+/// <param name="payload">結果の格納先</param>
+/// <returns>受信できたか</returns>
+bool MyQueryClient::Receive(QueryResponseHeader& header, std::vector<char>& payload) {
+
+	if (!isConnected_) {
+		return false;
+	}
+
+	size_t filled = 0;
+	if (MySocket::Receive(SocketHandle(socket_), &header, sizeof(header), filled) != SocketResult::kDone) {
+		return false;
+	}
+
+	payload.resize(header.byteSize);
+	filled = 0;
+	return MySocket::Receive(SocketHandle(socket_), payload.data(), payload.size(), filled) == SocketResult::kDone;
+
+}
+
+/// <summary>
+/// 線分とメッシュの問い合わせの処理速度を測定する関数
+/// 常に pipelineDepth 個の要求を送った状態を保ち、全ての応答が届くまでの時間を測る
+/// pipelineDepth はサーバーが読み込みを止めない数 (kMaxPendingQueryRequest) までに収める
+/// </summary>
+/// <param name="path">ソケットのパス</param>
+/// <param name="segments">線分配列</param>
+/// <param name="count">線分の数</param>
+/// <param name="batchSize">1回の要求に含める線分の数</param>
+/// <param name="pipelineDepth">応答を待たずに送る要求の最大数 (1 から kMaxPendingQueryRequest)</param>
+/// <param name="result">測定結果の格納先</param>
+/// <returns>最後まで測定できたか</returns>
+bool MyQueryClient::Benchmark(const char* path, const Segment* segments, size_t count, uint32_t batchSize, uint32_t pipelineDepth, QueryBenchmarkResult& result) {
+
+	batchSize = std::clamp(batchSize, 1u, kMaxQueryCount);
+	// 送信は応答を受け取らずに待つため、サーバーが読み込みを止める数を超えると止まってしまう
+	pipelineDepth = std::clamp(pipelineDepth, 1u, kMaxPendingQueryRequest);
+
+	MyQueryClient client;
+	if (!client.Connect(path)) {
+		return false;
+	}
+
+	size_t requestCount = (count + batchSize - 1) / batchSize;
+	size_t sentCount = 0;
+	size_t receivedCount = 0;
+	QueryResponseHeader header;
+	std::vector<char> payload;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (receivedCount < requestCount) {
+		// 送った要求が pipelineDepth 個になるまで送る
+		while (sentCount < requestCount && sentCount - receivedCount < pipelineDepth) {
+			size_t first = sentCount * batchSize;
+			uint32_t batchCount = uint32_t(std::min<size_t>(batchSize, count - first));
+			if (!client.Send(uint32_t(sentCount), QueryType::kSegmentMesh, segments + first, batchCount)) {
+				return false;
+			}
+			sentCount++;
+		}
+
+		// 1つ受け取ったら空いた分を送る
+		if (!client.Receive(header, payload) || header.status != QueryStatus::kOk) {
+			return false;
+		}
+		receivedCount++;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.queriesPerSecond = result.seconds > 0.0 ? double(count) / result.seconds : 0.0;
+	result.requestsPerSecond = result.seconds > 0.0 ? double(requestCount) / result.seconds : 0.0;
+	return true;
+
+}
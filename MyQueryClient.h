@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "MyQueryProtocol.h"
+
+/// <summary>
+/// 問い合わせの測定結果
+/// </summary>
+struct QueryBenchmarkResult {
+	double seconds; // かかった時間 (秒)
+	double queriesPerSecond; // 1秒あたりに処理した要素の数
+	double requestsPerSecond; // 1秒あたりに処理した要求の数
+};
+
+/// <summary>
+/// MyQueryServer に問い合わせを送るクライアントクラス
+/// 送信と受信は独立しているため、応答を待たずに複数の要求を送ってよい
+/// </summary>
+class MyQueryClient
+{
+public:
+
+	/// <summary>
+	/// デストラクタ
+	/// </summary>
+	~MyQueryClient();
+
+	/// <summary>
+	/// サーバーに接続する関数
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <returns>接続できたか</returns>
+	bool Connect(const char* path);
+
+	/// <summary>
+	/// 接続を閉じる関数
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// 要求を送信する関数
+	/// </summary>
+	/// <param name="requestId">要求番号</param>
+	/// <param name="type">問い合わせの種類</param>
+	/// <param name="elements">要素配列 (種類に対応する Segment / Sphere / Ray の配列)</param>
+	/// <param name="count">要素の数 (kMaxQueryCount 以下)</param>
+	/// <returns>送信できたか</returns>
+	bool Send(uint32_t requestId, QueryType type, const void* elements, uint32_t count);
+
+	/// <summary>
+	/// 応答を1つ受信する関数 (届くまで待つ)
+	/// </summary>
+	/// <param name="header">応答の先頭の格納先</param>
+	/// <param name="payload">結果の格納先</param>
+	/// <returns>受信できたか</returns>
+	bool Receive(QueryResponseHeader& header, std::vector<char>& payload);
+
+	/// <summary>
+	/// 線分とメッシュの問い合わせの処理速度を測定する関数
+	/// 常に pipelineDepth 個の要求を送った状態を保ち、全ての応答が届くまでの時間を測る
+	/// pipelineDepth はサーバーが読み込みを止めない数 (kMaxPendingQueryRequest) までに収める
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <param name="segments">線分配列</param>
+	/// <param name="count">線分の数</param>
+	/// <param name="batchSize">1回の要求に含める線分の数</param>
+	/// <param name="pipelineDepth">応答を待たずに送る要求の最大数 (1 から kMaxPendingQueryRequest)</param>
+	/// <param name="result">測定結果の格納先</param>
+	/// <returns>最後まで測定できたか</returns>
+	static bool Benchmark(const char* path, const Segment* segments, size_t count, uint32_t batchSize, uint32_t pipelineDepth, QueryBenchmarkResult& result);
+
+private:
+
+	// ソケット (環境ごとの型をヘッダに出さないために整数で持つ)
+	uintptr_t socket_ = 0;
+	// 接続中か
+	bool isConnected_ = false;
+	// 送信用の一時配列
+	std::vector<char> sendBuffer_;
+
+};
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MyStruct.h"
+
+// 問い合わせの通信形式
+// 要求: QueryRequestHeader に続けて count 個の要素 (Segment / Sphere / Ray) をそのまま並べる
+// 応答: QueryResponseHeader に続けて byteSize バイトの結果を並べる
+// 同じマシン上のプロセス間でのみ使用するため、バイト順や浮動小数点の形式は変換しない
+
+/// <summary>
+/// 問い合わせの種類
+/// </summary>
+enum class QueryType : uint16_t {
+	kSegmentMesh = 1, // 線分とメッシュの最も手前の交点 (要素: Segment、結果: SegmentMeshResult)
+	kSphereOverlap = 2, // 球と重なる三角形 (要素: Sphere、結果: 球ごとに uint32_t の個数と番号の配列)
+	kRaycast = 3, // 半直線と全プリミティブの最も手前の交点 (要素: Ray、結果: RaycastResult)
+};
+
+/// <summary>
+/// 応答の状態
+/// </summary>
+enum class QueryStatus : uint16_t {
+	kOk = 0, // 成功
+	kInvalidType = 1, // 不明な問い合わせの種類 (結果は空)
+};
+
+/// <summary>
+/// 要求の先頭に付ける構造体
+/// </summary>
+struct QueryRequestHeader {
+	uint32_t requestId; // 要求番号 (応答にそのまま返す)
+	QueryType type; // 問い合わせの種類
+	uint16_t reserved; // 予約 (0にすること)
+	uint32_t count; // 要素の数 (kMaxQueryCount 以下)
+};
+
+/// <summary>
+/// 応答の先頭に付ける構造体
+/// </summary>
+struct QueryResponseHeader {
+	uint32_t requestId; // 対応する要求番号
+	QueryType type; // 問い合わせの種類
+	QueryStatus status; // 状態
+	uint32_t byteSize; // 続く結果のバイト数
+};
+
+/// <summary>
+/// 線分とメッシュの問い合わせの結果
+/// </summary>
+struct SegmentMeshResult {
+	float t; // 交点の媒介変数 (当たらなかった場合は負の値)
+	uint32_t triangleIndex; // 当たった三角形の番号
+};
+
+/// <summary>
+/// レイキャストの問い合わせの結果
+/// </summary>
+struct RaycastResult {
+	float t; // 交点の媒介変数 (当たらなかった場合は負の値)
+	uint32_t type; // 当たったプリミティブの種類 (PrimitiveType)
+	uint32_t index; // 当たったプリミティブの配列内の番号
+	Vector3 normal; // 交点の法線
+};
+
+// 1回の要求に含められる要素の最大数
+const uint32_t kMaxQueryCount = 1 << 16;
+
+// 1つの接続で応答を受け取らずに送ってよい要求の最大数
+// サーバーはこれを超えると応答を送り終えるまで読み込みを止めるため、
+// 超えて送るとクライアントが送信で待っている間に双方のバッファが埋まり止まってしまう
+const uint32_t kMaxPendingQueryRequest = 64;
+
+static_assert(sizeof(QueryRequestHeader) == 12, "通信形式の大きさが変わっています");
+static_assert(sizeof(QueryResponseHeader) == 12, "通信形式の大きさが変わっています");
+static_assert(sizeof(Segment) == 24 && sizeof(Sphere) == 16 && sizeof(Ray) == 24, "通信形式の大きさが変わっています");
+
+/// <summary>
+/// 問い合わせの種類ごとの要素1個のバイト数を求める関数
+/// </summary>
+/// <param name="type">問い合わせの種類</param>
+/// <returns>バイト数 (不明な種類の場合は0)</returns>
+inline size_t GetQueryElementSize(QueryType type) {
+	switch (type) {
+	case QueryType::kSegmentMesh:
+		return sizeof(Segment);
+	case QueryType::kSphereOverlap:
+		return sizeof(Sphere);
+	case QueryType::kRaycast:
+		return sizeof(Ray);
+	default:
+		return 0;
+	}
+}
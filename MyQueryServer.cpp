@@ -0,0 +1,567 @@
+﻿#include "MySocket.h"
+#include "MyQueryServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+/// <summary>
+/// 接続
+/// 読み込み、書き込みのコルーチンと判定中の要求が共有し、全てが終わると解放されてソケットを閉じる
+/// イベントループのスレッドだけが触る
+/// </summary>
+struct MyQueryServer::Connection {
+	SocketHandle socket; // ソケット
+	std::coroutine_handle<> readWaiter; // 読み込み可能になるのを待つコルーチン
+	std::coroutine_handle<> writeWaiter; // 書き込み可能になるのを待つコルーチン
+	std::coroutine_handle<> drainWaiter; // 未送信の応答が減るのを待つコルーチン
+	std::deque<std::vector<char>> outbox; // 送信待ちの応答
+	uint32_t pendingCount = 0; // 応答を送り終えていない要求の数
+	bool isWriting = false; // 送信中か
+	bool isReadClosed = false; // 要求の読み込みを終えたか
+	bool isClosed = false; // 送受信に失敗して切断されたか
+
+	~Connection() { MySocket::Close(socket); }
+
+	/// <summary>
+	/// 待っているコルーチンを再開せずに破棄する関数 (切断時に呼ぶ)
+	/// </summary>
+	void DestroyWaiters() {
+		for (std::coroutine_handle<>* waiter : { &readWaiter, &writeWaiter, &drainWaiter }) {
+			if (*waiter) {
+				std::exchange(*waiter, {}).destroy();
+			}
+		}
+	}
+};
+
+/// <summary>
+/// ソケットが読み込み可能になるまで待つ
+/// </summary>
+struct MyQueryServer::ReadableAwaiter {
+	Connection& connection;
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) { connection.readWaiter = handle; }
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// ソケットが書き込み可能になるまで待つ
+/// </summary>
+struct MyQueryServer::WritableAwaiter {
+	Connection& connection;
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) { connection.writeWaiter = handle; }
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// 未送信の応答が減るまで待つ
+/// </summary>
+struct MyQueryServer::DrainAwaiter {
+	Connection& connection;
+	bool await_ready() const noexcept { return connection.pendingCount < kMaxPendingQueryRequest; }
+	void await_suspend(std::coroutine_handle<> handle) { connection.drainWaiter = handle; }
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// ワーカースレッドに移る
+/// </summary>
+struct MyQueryServer::WorkerAwaiter {
+	MyQueryServer& server;
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) {
+		// 追加した直後に別のスレッドで再開されて自身が解放される場合があるため、先に取り出しておく
+		MyQueryServer* target = &server;
+		{
+			std::lock_guard<std::mutex> lock(target->workMutex_);
+			target->workQueue_.push_back(handle);
+		}
+		target->workCondition_.notify_one();
+	}
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// イベントループのスレッドに戻る
+/// </summary>
+struct MyQueryServer::LoopAwaiter {
+	MyQueryServer& server;
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) {
+		// 追加した直後に別のスレッドで再開されて自身が解放される場合があるため、先に取り出しておく
+		MyQueryServer* target = &server;
+		bool isEmpty;
+		{
+			std::lock_guard<std::mutex> lock(target->readyMutex_);
+			isEmpty = target->readyQueue_.empty();
+			target->readyQueue_.push_back(handle);
+		}
+		// 空でなければ既に起こしてある
+		if (isEmpty) {
+			target->WakeLoop();
+		}
+	}
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// デストラクタ
+/// </summary>
+MyQueryServer::~MyQueryServer() {
+	Stop();
+}
+
+/// <summary>
+/// 受付を開始する関数
+/// scene の配列は Stop を呼ぶまで変更、解放しないこと
+/// scene.tree は使わず、球と三角形のAABB木はサーバー内で作成する
+/// </summary>
+/// <param name="path">ソケットのパス</param>
+/// <param name="scene">判定の対象となるシーン</param>
+/// <param name="workerCount">判定を行うスレッドの数 (0ならハードウェアのスレッド数)</param>
+/// <returns>開始できたか</returns>
+bool MyQueryServer::Start(const char* path, const RaycastScene& scene, uint32_t workerCount) {
+
+	// 開始済みなら何もしない
+	if (IsRunning() || !MySocket::Startup()) {
+		return false;
+	}
+
+	SocketHandle listenSocket = MySocket::Listen(path);
+	if (listenSocket == MySocket::kInvalidSocket) {
+		MySocket::Cleanup();
+		return false;
+	}
+
+	// イベントループを起こすための接続を自分自身に張る
+	SocketHandle wakeWriteSocket = MySocket::Connect(path);
+	SocketHandle wakeReadSocket = wakeWriteSocket == MySocket::kInvalidSocket ? MySocket::kInvalidSocket : MySocket::Accept(listenSocket);
+	if (wakeReadSocket == MySocket::kInvalidSocket ||
+		!MySocket::SetNonBlocking(wakeReadSocket) || !MySocket::SetNonBlocking(wakeWriteSocket)) {
+		if (wakeReadSocket != MySocket::kInvalidSocket) {
+			MySocket::Close(wakeReadSocket);
+		}
+		if (wakeWriteSocket != MySocket::kInvalidSocket) {
+			MySocket::Close(wakeWriteSocket);
+		}
+		MySocket::Close(listenSocket);
+		std::remove(path);
+		MySocket::Cleanup();
+		return false;
+	}
+
+	path_ = path;
+	listenSocket_ = uintptr_t(listenSocket);
+	wakeReadSocket_ = uintptr_t(wakeReadSocket);
+	wakeWriteSocket_ = uintptr_t(wakeWriteSocket);
+
+	// 判定に使うデータを作成する
+	// 要求ごとに全てのプリミティブを並べ替えないように、球と三角形はAABB木に登録しておく
+	scene_ = scene;
+	meshScene_ = { nullptr, 0, nullptr, 0, scene.triangles, scene.triangleCount, nullptr };
+	tree_ = MyAABBTree(0.0f);
+	meshTree_ = MyAABBTree(0.0f);
+	MyRaycast::BuildTree(scene_, tree_);
+	MyRaycast::BuildTree(meshScene_, meshTree_);
+	scene_.tree = &tree_;
+	meshScene_.tree = &meshTree_;
+	MyCollision::MakeTriangleSoA(scene.triangles, scene.triangleCount, triangleSoA_);
+
+	requestCount_ = 0;
+	queryCount_ = 0;
+	connectionCount_ = 0;
+	isExit_ = false;
+	isWorkerExit_ = false;
+
+	// スレッドを起動する
+	if (workerCount == 0) {
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (uint32_t i = 0; i < workerCount; i++) {
+		workers_.emplace_back(&MyQueryServer::WorkerMain, this);
+	}
+	loopThread_ = std::thread(&MyQueryServer::LoopMain, this);
+
+	return true;
+
+}
+
+/// <summary>
+/// 受付を終了する関数 (全ての接続を閉じ、スレッドを終了する)
+/// </summary>
+void MyQueryServer::Stop() {
+
+	if (!IsRunning()) {
+		return;
+	}
+
+	// イベントループを終了する
+	isExit_ = true;
+	WakeLoop();
+	loopThread_.join();
+
+	// 判定中の要求を終えてからワーカースレッドを終了する
+	{
+		std::lock_guard<std::mutex> lock(workMutex_);
+		isWorkerExit_ = true;
+	}
+	workCondition_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+
+	// 再開されずに残ったコルーチンを破棄する
+	for (std::coroutine_handle<> handle : readyQueue_) {
+		handle.destroy();
+	}
+	readyQueue_.clear();
+	std::vector<std::shared_ptr<Connection>> connections = std::move(connections_);
+	connections_.clear();
+	for (const std::shared_ptr<Connection>& connection : connections) {
+		connection->DestroyWaiters();
+	}
+	connections.clear();
+	connectionCount_ = 0;
+
+	MySocket::Close(SocketHandle(wakeReadSocket_));
+	MySocket::Close(SocketHandle(wakeWriteSocket_));
+	MySocket::Close(SocketHandle(listenSocket_));
+	std::remove(path_.c_str());
+	MySocket::Cleanup();
+
+}
+
+/// <summary>
+/// 統計情報を取得する関数
+/// </summary>
+/// <returns>統計情報</returns>
+QueryServerStats MyQueryServer::GetStats() const {
+	return { requestCount_.load(), queryCount_.load(), connectionCount_.load() };
+}
+
+/// <summary>
+/// 接続から要求を読み込み続けるコルーチン
+/// </summary>
+/// <param name="server">サーバー</param>
+/// <param name="connection">接続</param>
+MyQueryServer::Task MyQueryServer::ReadSession(MyQueryServer* server, std::shared_ptr<Connection> connection) {
+
+	while (!connection->isClosed) {
+		// 送り終えていない応答が多ければ、減るまで読み込みを止める
+		co_await DrainAwaiter{ *connection };
+
+		// 要求の先頭を読み込む
+		QueryRequestHeader header;
+		size_t filled = 0;
+		SocketResult result;
+		while ((result = MySocket::Receive(connection->socket, &header, sizeof(header), filled)) == SocketResult::kWouldBlock) {
+			co_await ReadableAwaiter{ *connection };
+		}
+		if (result == SocketResult::kClosed) {
+			break;
+		}
+
+		// 要素の大きさが分からないと続きを読めないため、応答を返して読み込みを終える
+		size_t elementSize = GetQueryElementSize(header.type);
+		if (elementSize == 0 || header.count > kMaxQueryCount) {
+			std::vector<char> response(sizeof(QueryResponseHeader));
+			QueryResponseHeader responseHeader = { header.requestId, header.type, QueryStatus::kInvalidType, 0 };
+			std::memcpy(response.data(), &responseHeader, sizeof(responseHeader));
+			connection->pendingCount++;
+			PushResponse(connection, std::move(response));
+			break;
+		}
+
+		// 要素を読み込む
+		std::vector<char> payload(elementSize * header.count);
+		filled = 0;
+		while ((result = MySocket::Receive(connection->socket, payload.data(), payload.size(), filled)) == SocketResult::kWouldBlock) {
+			co_await ReadableAwaiter{ *connection };
+		}
+		if (result == SocketResult::kClosed) {
+			break;
+		}
+
+		// 判定は別のコルーチンに任せ、すぐに次の要求を読み込む
+		connection->pendingCount++;
+		HandleRequest(server, connection, header, std::move(payload));
+	}
+
+	connection->isReadClosed = true;
+
+}
+
+/// <summary>
+/// 1つの要求を判定し、応答を送信待ちに追加するコルーチン
+/// </summary>
+/// <param name="server">サーバー</param>
+/// <param name="connection">接続</param>
+/// <param name="header">要求の先頭</param>
+/// <param name="payload">要求の要素</param>
+MyQueryServer::Task MyQueryServer::HandleRequest(MyQueryServer* server, std::shared_ptr<Connection> connection, QueryRequestHeader header, std::vector<char> payload) {
+
+	// 判定はワーカースレッドで行う
+	co_await WorkerAwaiter{ *server };
+
+	std::vector<char> response;
+	server->Execute(header, payload, response);
+	server->requestCount_++;
+	server->queryCount_ += header.count;
+
+	// 接続の状態はイベントループのスレッドで触る
+	co_await LoopAwaiter{ *server };
+
+	PushResponse(connection, std::move(response));
+
+}
+
+/// <summary>
+/// 送信待ちの応答がなくなるまで送信するコルーチン
+/// </summary>
+/// <param name="connection">接続</param>
+MyQueryServer::Task MyQueryServer::WriteSession(std::shared_ptr<Connection> connection) {
+
+	while (!connection->outbox.empty()) {
+		// 送信中に追加されても先頭の参照は無効にならない
+		const std::vector<char>& response = connection->outbox.front();
+		size_t sent = 0;
+		SocketResult result;
+		while ((result = MySocket::Send(connection->socket, response.data(), response.size(), sent)) == SocketResult::kWouldBlock) {
+			co_await WritableAwaiter{ *connection };
+		}
+		if (result == SocketResult::kClosed) {
+			connection->isClosed = true;
+			break;
+		}
+
+		connection->outbox.pop_front();
+		connection->pendingCount--;
+
+		// 読み込みが止まっていれば再開する
+		if (connection->drainWaiter && connection->pendingCount < kMaxPendingQueryRequest) {
+			std::exchange(connection->drainWaiter, {}).resume();
+		}
+	}
+
+	connection->isWriting = false;
+
+}
+
+/// <summary>
+/// 応答を送信待ちに追加し、送信中でなければ送信を開始する関数 (イベントループのスレッドで呼ぶ)
+/// </summary>
+/// <param name="connection">接続</param>
+/// <param name="response">応答 (先頭を含む)</param>
+void MyQueryServer::PushResponse(const std::shared_ptr<Connection>& connection, std::vector<char> response) {
+
+	// 切断済みなら捨てる
+	if (connection->isClosed) {
+		return;
+	}
+
+	connection->outbox.push_back(std::move(response));
+	if (!connection->isWriting) {
+		connection->isWriting = true;
+		WriteSession(connection);
+	}
+
+}
+
+/// <summary>
+/// イベントループのスレッドの処理
+/// </summary>
+void MyQueryServer::LoopMain() {
+
+	// 先頭2つは受付用ソケットと起こすための接続、以降は connections_ と同じ並び
+	std::vector<PollEntry> entries;
+	std::vector<std::coroutine_handle<>> ready;
+	char wakeBuffer[64];
+
+	while (!isExit_) {
+		entries.clear();
+		entries.push_back({ SocketHandle(listenSocket_), POLLIN, 0 });
+		entries.push_back({ SocketHandle(wakeReadSocket_), POLLIN, 0 });
+		for (const std::shared_ptr<Connection>& connection : connections_) {
+			short events = 0;
+			if (connection->readWaiter) {
+				events |= POLLIN;
+			}
+			if (connection->writeWaiter) {
+				events |= POLLOUT;
+			}
+			entries.push_back({ connection->socket, events, 0 });
+		}
+
+		if (MySocket::Poll(entries.data(), entries.size(), -1) < 0) {
+			continue;
+		}
+
+		// 読み込み、書き込みを待っていたコルーチンを再開する (切断も再開先で検出する)
+		for (size_t i = 0; i < connections_.size(); i++) {
+			std::shared_ptr<Connection> connection = connections_[i];
+			short revents = entries[i + 2].revents;
+			if ((revents & (POLLIN | POLLHUP | POLLERR)) && connection->readWaiter) {
+				std::exchange(connection->readWaiter, {}).resume();
+			}
+			if ((revents & (POLLOUT | POLLHUP | POLLERR)) && connection->writeWaiter) {
+				std::exchange(connection->writeWaiter, {}).resume();
+			}
+		}
+
+		// 判定を終えた要求を再開する
+		// 取り出す前に起こすための接続を空にしておけば、取り出した後に追加されたものは次の Poll で起こされる
+		if (entries[1].revents & POLLIN) {
+			size_t received = 0;
+			while (MySocket::Receive(SocketHandle(wakeReadSocket_), wakeBuffer, sizeof(wakeBuffer), received) == SocketResult::kDone) {
+				received = 0;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(readyMutex_);
+			ready.swap(readyQueue_);
+		}
+		for (std::coroutine_handle<> handle : ready) {
+			handle.resume();
+		}
+		ready.clear();
+
+		// 新しい接続を受け付ける
+		if (entries[0].revents & POLLIN) {
+			SocketHandle socket;
+			while ((socket = MySocket::Accept(SocketHandle(listenSocket_))) != MySocket::kInvalidSocket) {
+				std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+				connection->socket = socket;
+				if (!MySocket::SetNonBlocking(socket)) {
+					continue;
+				}
+				connections_.push_back(connection);
+				connectionCount_++;
+				ReadSession(this, connection);
+			}
+		}
+
+		// 終わった接続を取り除く (判定中の要求が残っていれば、それが終わった時点で解放される)
+		for (size_t i = 0; i < connections_.size();) {
+			std::shared_ptr<Connection> connection = connections_[i];
+			if (connection->isClosed || (connection->isReadClosed && connection->pendingCount == 0)) {
+				connection->DestroyWaiters();
+				connections_[i] = connections_.back();
+				connections_.pop_back();
+				connectionCount_--;
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+}
+
+/// <summary>
+/// ワーカースレッドの処理
+/// </summary>
+void MyQueryServer::WorkerMain() {
+
+	while (true) {
+		std::coroutine_handle<> handle;
+		{
+			std::unique_lock<std::mutex> lock(workMutex_);
+			workCondition_.wait(lock, [this] { return isWorkerExit_ || !workQueue_.empty(); });
+			// 終了時も残っている要求は全て処理する
+			if (workQueue_.empty()) {
+				return;
+			}
+			handle = workQueue_.front();
+			workQueue_.pop_front();
+		}
+		handle.resume();
+	}
+
+}
+
+/// <summary>
+/// 待ち状態のイベントループを起こす関数
+/// </summary>
+void MyQueryServer::WakeLoop() {
+
+	// 送信できなくても、未読のデータが残っていればイベントループは起きる
+	char wake = 0;
+	size_t sent = 0;
+	MySocket::Send(SocketHandle(wakeWriteSocket_), &wake, sizeof(wake), sent);
+
+}
+
+/// <summary>
+/// 要求を判定して応答を作成する関数 (ワーカースレッドで呼ばれる)
+/// </summary>
+/// <param name="header">要求の先頭</param>
+/// <param name="payload">要求の要素</param>
+/// <param name="response">応答の格納先 (先頭を含む)</param>
+void MyQueryServer::Execute(const QueryRequestHeader& header, const std::vector<char>& payload, std::vector<char>& response) const {
+
+	QueryResponseHeader responseHeader = { header.requestId, header.type, QueryStatus::kOk, 0 };
+	response.resize(sizeof(QueryResponseHeader));
+
+	switch (header.type) {
+	case QueryType::kSegmentMesh: {
+		// 線分は媒介変数を1までに制限した半直線として判定する
+		response.resize(sizeof(QueryResponseHeader) + sizeof(SegmentMeshResult) * header.count);
+		for (uint32_t i = 0; i < header.count; i++) {
+			Segment segment;
+			std::memcpy(&segment, payload.data() + sizeof(Segment) * i, sizeof(Segment));
+
+			RaycastHit hit;
+			SegmentMeshResult result = { -1.0f, 0 };
+			if (MyRaycast::ClosestHit({ segment.origin, segment.diff }, meshScene_, hit, 1.0f)) {
+				result = { hit.t, hit.index };
+			}
+			std::memcpy(response.data() + sizeof(QueryResponseHeader) + sizeof(SegmentMeshResult) * i, &result, sizeof(result));
+		}
+		break;
+	}
+	case QueryType::kSphereOverlap: {
+		// 球ごとに個数と番号の配列を続けて並べる
+		static thread_local std::vector<uint32_t> hitIndex;
+		hitIndex.resize(triangleSoA_.count);
+		for (uint32_t i = 0; i < header.count; i++) {
+			Sphere sphere;
+			std::memcpy(&sphere, payload.data() + sizeof(Sphere) * i, sizeof(Sphere));
+
+			uint32_t hitCount = 0;
+			if (triangleSoA_.count > 0) {
+				hitCount = uint32_t(MyCollision::IsCollisionTriangleMany(sphere, triangleSoA_, hitIndex.data()));
+			}
+			size_t offset = response.size();
+			response.resize(offset + sizeof(uint32_t) * (1 + hitCount));
+			std::memcpy(response.data() + offset, &hitCount, sizeof(uint32_t));
+			std::memcpy(response.data() + offset + sizeof(uint32_t), hitIndex.data(), sizeof(uint32_t) * hitCount);
+		}
+		break;
+	}
+	case QueryType::kRaycast: {
+		response.resize(sizeof(QueryResponseHeader) + sizeof(RaycastResult) * header.count);
+		for (uint32_t i = 0; i < header.count; i++) {
+			Ray ray;
+			std::memcpy(&ray, payload.data() + sizeof(Ray) * i, sizeof(Ray));
+
+			RaycastHit hit;
+			RaycastResult result = { -1.0f, 0, 0, {} };
+			if (MyRaycast::ClosestHit(ray, scene_, hit)) {
+				result = { hit.t, uint32_t(hit.type), hit.index, hit.normal };
+			}
+			std::memcpy(response.data() + sizeof(QueryResponseHeader) + sizeof(RaycastResult) * i, &result, sizeof(result));
+		}
+		break;
+	}
+	default:
+		responseHeader.status = QueryStatus::kInvalidType;
+		break;
+	}
+
+	responseHeader.byteSize = uint32_t(response.size() - sizeof(QueryResponseHeader));
+	std::memcpy(response.data(), &responseHeader, sizeof(responseHeader));
+
+}
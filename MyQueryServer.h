@@ -0,0 +1,192 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MyCollision.h"
+#include "MyRaycast.h"
+#include "MyQueryProtocol.h"
+
+/// <summary>
+/// 問い合わせサーバーの統計情報
+/// </summary>
+struct QueryServerStats {
+	uint64_t requestCount; // 処理した要求の数
+	uint64_t queryCount; // 処理した要素の数
+	uint32_t connectionCount; // 現在の接続数
+};
+
+/// <summary>
+/// 当たり判定の問い合わせに答えるサーバークラス
+/// ローカルのソケットで複数のプロセスから一括の問い合わせを受け付け、1つのシーンを共有して判定する
+/// 1つの接続で応答を待たずに続けて要求を送ってよく、応答は判定が終わった順に要求番号を付けて返す
+/// 接続ごとの読み込み、書き込みと要求ごとの判定をコルーチンで書き、
+/// 読み込みと書き込みはイベントループのスレッドで、判定はワーカースレッドで重ねて行う
+/// </summary>
+class MyQueryServer
+{
+public:
+
+	/// <summary>
+	/// デストラクタ
+	/// </summary>
+	~MyQueryServer();
+
+	/// <summary>
+	/// 受付を開始する関数
+	/// scene の配列は Stop を呼ぶまで変更、解放しないこと
+	/// scene.tree は使わず、球と三角形のAABB木はサーバー内で作成する
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <param name="scene">判定の対象となるシーン</param>
+	/// <param name="workerCount">判定を行うスレッドの数 (0ならハードウェアのスレッド数)</param>
+	/// <returns>開始できたか</returns>
+	bool Start(const char* path, const RaycastScene& scene, uint32_t workerCount = 0);
+
+	/// <summary>
+	/// 受付を終了する関数 (全ての接続を閉じ、スレッドを終了する)
+	/// </summary>
+	void Stop();
+
+	/// <summary>
+	/// 受付中か取得する関数
+	/// </summary>
+	/// <returns>受付中か</returns>
+	bool IsRunning() const { return loopThread_.joinable(); }
+
+	/// <summary>
+	/// 統計情報を取得する関数
+	/// </summary>
+	/// <returns>統計情報</returns>
+	QueryServerStats GetStats() const;
+
+private:
+
+	/// <summary>
+	/// 開始後は呼び出し元が終了を待たないコルーチン
+	/// 最後まで実行されるとフレームは自動で解放される
+	/// </summary>
+	struct Task {
+		struct promise_type {
+			Task get_return_object() { return {}; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	// 接続 (MyQueryServer.cpp で定義)
+	struct Connection;
+	// ソケットが読み込み可能になるまで待つ (イベントループで再開する)
+	struct ReadableAwaiter;
+	// ソケットが書き込み可能になるまで待つ (イベントループで再開する)
+	struct WritableAwaiter;
+	// 未送信の応答が減るまで待つ (イベントループで再開する)
+	struct DrainAwaiter;
+	// ワーカースレッドに移る
+	struct WorkerAwaiter;
+	// イベントループのスレッドに戻る
+	struct LoopAwaiter;
+
+	/// <summary>
+	/// 接続から要求を読み込み続けるコルーチン
+	/// </summary>
+	/// <param name="server">サーバー</param>
+	/// <param name="connection">接続</param>
+	static Task ReadSession(MyQueryServer* server, std::shared_ptr<Connection> connection);
+
+	/// <summary>
+	/// 1つの要求を判定し、応答を送信待ちに追加するコルーチン
+	/// </summary>
+	/// <param name="server">サーバー</param>
+	/// <param name="connection">接続</param>
+	/// <param name="header">要求の先頭</param>
+	/// <param name="payload">要求の要素</param>
+	static Task HandleRequest(MyQueryServer* server, std::shared_ptr<Connection> connection, QueryRequestHeader header, std::vector<char> payload);
+
+	/// <summary>
+	/// 送信待ちの応答がなくなるまで送信するコルーチン
+	/// </summary>
+	/// <param name="connection">接続</param>
+	static Task WriteSession(std::shared_ptr<Connection> connection);
+
+	/// <summary>
+	/// 応答を送信待ちに追加し、送信中でなければ送信を開始する関数 (イベントループのスレッドで呼ぶ)
+	/// </summary>
+	/// <param name="connection">接続</param>
+	/// <param name="response">応答 (先頭を含む)</param>
+	static void PushResponse(const std::shared_ptr<Connection>& connection, std::vector<char> response);
+
+	/// <summary>
+	/// イベントループのスレッドの処理
+	/// </summary>
+	void LoopMain();
+
+	/// <summary>
+	/// ワーカースレッドの処理
+	/// </summary>
+	void WorkerMain();
+
+	/// <summary>
+	/// 待ち状態のイベントループを起こす関数
+	/// </summary>
+	void WakeLoop();
+
+	/// <summary>
+	/// 要求を判定して応答を作成する関数 (ワーカースレッドで呼ばれる)
+	/// </summary>
+	/// <param name="header">要求の先頭</param>
+	/// <param name="payload">要求の要素</param>
+	/// <param name="response">応答の格納先 (先頭を含む)</param>
+	void Execute(const QueryRequestHeader& header, const std::vector<char>& payload, std::vector<char>& response) const;
+
+	// 判定の対象となるシーン
+	RaycastScene scene_{};
+	// 三角形だけを含むシーン (線分とメッシュの判定用)
+	RaycastScene meshScene_{};
+	// scene_ の球と三角形のAABB木 (レイキャスト用)
+	MyAABBTree tree_{ 0.0f };
+	// meshScene_ の三角形のAABB木 (線分とメッシュの判定用)
+	MyAABBTree meshTree_{ 0.0f };
+	// 球との一括判定用の三角形配列
+	TriangleSoA triangleSoA_{};
+
+	// ソケットのパス
+	std::string path_;
+	// 受付用ソケット (環境ごとの型をヘッダに出さないために整数で持つ)
+	uintptr_t listenSocket_ = 0;
+	// イベントループを起こすための接続 (自分自身に接続する)
+	uintptr_t wakeReadSocket_ = 0;
+	uintptr_t wakeWriteSocket_ = 0;
+	// 接続の配列 (イベントループのスレッドだけが触る)
+	std::vector<std::shared_ptr<Connection>> connections_;
+
+	// イベントループのスレッド
+	std::thread loopThread_;
+	// ワーカースレッド
+	std::vector<std::thread> workers_;
+	// ワーカースレッドで再開するコルーチン
+	std::mutex workMutex_;
+	std::condition_variable workCondition_;
+	std::deque<std::coroutine_handle<>> workQueue_;
+	bool isWorkerExit_ = false;
+	// イベントループのスレッドで再開するコルーチン
+	std::mutex readyMutex_;
+	std::vector<std::coroutine_handle<>> readyQueue_;
+	// イベントループの終了フラグ
+	std::atomic<bool> isExit_ = false;
+
+	// 統計情報
+	std::atomic<uint64_t> requestCount_ = 0;
+	std::atomic<uint64_t> queryCount_ = 0;
+	std::atomic<uint32_t> connectionCount_ = 0;
+
+};
@@ -0,0 +1,343 @@
+﻿#include "MyRaycast.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+	/// <summary>
+	/// 判定候補
+	/// </summary>
+	struct Candidate {
+		float lowerT; // 交点の媒介変数の下限
+		PrimitiveType type; // プリミティブの種類
+		uint32_t index; // プリミティブの番号
+	};
+
+	/// <summary>
+	/// 球と半直線の交点の媒介変数の下限を求める関数
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <param name="inverseLengthSq">半直線の方向ベクトルの長さの2乗の逆数</param>
+	/// <param name="center">球の中心</param>
+	/// <param name="radius">球の半径</param>
+	/// <param name="maxT">媒介変数の上限</param>
+	/// <param name="lowerT">下限の格納先</param>
+	/// <returns>当たる可能性があるか</returns>
+	bool SphereLowerBound(const Ray& ray, float inverseLengthSq, const Vector3& center, float radius, float maxT, float& lowerT) {
+
+		// 中心を半直線に射影する
+		Vector3 offset = center - ray.origin;
+		float tCenter = MyMath::Dot(offset, ray.diff) * inverseLengthSq;
+
+		// 半直線から中心までの距離が半径より大きければ当たらない
+		Vector3 closest = offset - MyMath::Multiply(tCenter, ray.diff);
+		if (MyMath::Dot(closest, closest) > radius * radius) {
+			return false;
+		}
+
+		// 媒介変数の単位での半径
+		float tRadius = radius * std::sqrt(inverseLengthSq);
+		if (tCenter + tRadius < 0.0f || tCenter - tRadius > maxT) {
+			return false;
+		}
+
+		lowerT = std::max(0.0f, tCenter - tRadius);
+		return true;
+
+	}
+
+	/// <summary>
+	/// 三角形を囲む球を求める関数
+	/// </summary>
+	/// <param name="triangle">三角形</param>
+	/// <param name="center">中心の格納先</param>
+	/// <param name="radius">半径の格納先</param>
+	void BoundingSphere(const Triangle& triangle, Vector3& center, float& radius) {
+
+		// 重心から最も遠い頂点までの距離を半径にする
+		center = MyMath::Multiply(1.0f / 3.0f,
+			MyMath::Add(triangle.vertex[0], MyMath::Add(triangle.vertex[1], triangle.vertex[2])));
+		float radiusSq = 0.0f;
+		for (uint32_t i = 0; i < 3; i++) {
+			Vector3 offset = triangle.vertex[i] - center;
+			radiusSq = std::max(radiusSq, MyMath::Dot(offset, offset));
+		}
+		radius = std::sqrt(radiusSq);
+
+	}
+
+}
+
+/// <summary>
+/// 最も手前で当たるプリミティブを求める関数
+/// AABB木があれば、木をたどりながら交点が見つかるたびに半直線を切り詰めて奥の枝を除外する
+/// なければ各プリミティブまでの距離の下限で並べ替えて手前から判定し、下限が確定した交点より奥になった時点で打ち切る
+/// </summary>
+/// <param name="ray">半直線</param>
+/// <param name="scene">対象のプリミティブ配列</param>
+/// <param name="hit">結果の格納先</param>
+/// <param name="maxT">判定する媒介変数の上限</param>
+/// <returns>当たったか</returns>
+bool MyRaycast::ClosestHit(const Ray& ray, const RaycastScene& scene, RaycastHit& hit, float maxT) {
+
+	float lengthSq = MyMath::Dot(ray.diff, ray.diff);
+	if (lengthSq == 0.0f) {
+		return false;
+	}
+	float inverseLengthSq = 1.0f / lengthSq;
+
+	// 確定した交点より手前なら結果を更新する
+	bool isHit = false;
+	float bestT = maxT;
+	auto tryHit = [&](PrimitiveType type, uint32_t index) {
+		HitInfo info{};
+		if (!Intersect(ray, scene, type, index, info) || info.t > bestT) {
+			return false;
+		}
+		isHit = true;
+		bestT = info.t;
+		hit.type = type;
+		hit.index = index;
+		hit.t = info.t;
+		hit.point = info.point;
+		hit.normal = info.normal;
+		return true;
+	};
+
+	if (scene.tree != nullptr) {
+
+		// 平面は木に入っていないので先に判定して半直線を短くしておく
+		for (size_t i = 0; i < scene.planeCount; i++) {
+			tryHit(PrimitiveType::kPlane, uint32_t(i));
+		}
+
+		// 木の範囲を囲む球より奥は調べなくてよいので、半直線をそこまでの線分にする
+		const AABB* bounds = scene.tree->GetBounds();
+		if (bounds == nullptr) {
+			return isHit;
+		}
+		Vector3 center = MyMath::Multiply(0.5f, bounds->min + bounds->max);
+		float boundsRadius = MyMath::Length(MyMath::Multiply(0.5f, bounds->max - bounds->min));
+		float limitT = std::min(bestT, (MyMath::Length(center - ray.origin) + boundsRadius) * std::sqrt(inverseLengthSq));
+		if (!(limitT > 0.0f)) {
+			return isHit;
+		}
+
+		// 当たるたびにその位置で線分を切り詰める (線分の媒介変数は limitT を1とした割合)
+		Segment segment = { ray.origin, MyMath::Multiply(limitT, ray.diff) };
+		scene.tree->RayCast(segment, [&](int32_t proxyId, float maxFraction) {
+			uint32_t userData = scene.tree->GetUserData(proxyId);
+			if (!tryHit(PrimitiveType(userData >> kTypeShift), userData & ((1u << kTypeShift) - 1))) {
+				return maxFraction;
+			}
+			return bestT / limitT;
+		});
+		return isHit;
+
+	}
+
+	// 判定候補を使い回す
+	static thread_local std::vector<Candidate> candidates;
+	candidates.clear();
+
+	// 球は囲む範囲から下限を求める
+	for (size_t i = 0; i < scene.sphereCount; i++) {
+		float lowerT;
+		if (SphereLowerBound(ray, inverseLengthSq, scene.spheres[i].center, scene.spheres[i].radius, maxT, lowerT)) {
+			candidates.push_back({ lowerT, PrimitiveType::kSphere, uint32_t(i) });
+		}
+	}
+
+	// 平面は交点をそのまま下限にする
+	for (size_t i = 0; i < scene.planeCount; i++) {
+		HitInfo planeHit{};
+		if (MyCollision::IntersectLine(ray, scene.planes[i], &planeHit) && planeHit.t <= maxT) {
+			candidates.push_back({ planeHit.t, PrimitiveType::kPlane, uint32_t(i) });
+		}
+	}
+
+	// 三角形は囲む球から下限を求める
+	for (size_t i = 0; i < scene.triangleCount; i++) {
+		Vector3 center;
+		float radius;
+		BoundingSphere(scene.triangles[i], center, radius);
+		float lowerT;
+		if (SphereLowerBound(ray, inverseLengthSq, center, radius, maxT, lowerT)) {
+			candidates.push_back({ lowerT, PrimitiveType::kTriangle, uint32_t(i) });
+		}
+	}
+
+	// 下限の小さい順に並べる
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Candidate& a, const Candidate& b) { return a.lowerT < b.lowerT; });
+
+	// 手前から判定する
+	for (const Candidate& candidate : candidates) {
+
+		// これより奥の候補は確定した交点より手前で当たることはない
+		if (candidate.lowerT > bestT) {
+			break;
+		}
+
+		tryHit(candidate.type, candidate.index);
+
+	}
+
+	return isHit;
+
+}
+
+/// <summary>
+/// いずれかのプリミティブに当たるかを求める関数 (最初に見つかった時点で打ち切る)
+/// 視線が通るかの判定などに使う
+/// </summary>
+/// <param name="ray">半直線</param>
+/// <param name="scene">対象のプリミティブ配列</param>
+/// <param name="maxT">判定する媒介変数の上限</param>
+/// <returns>当たったか</returns>
+bool MyRaycast::AnyHit(const Ray& ray, const RaycastScene& scene, float maxT) {
+
+	HitInfo info{};
+
+	// 平面は判定が軽いので先に調べる
+	for (size_t i = 0; i < scene.planeCount; i++) {
+		if (MyCollision::IntersectLine(ray, scene.planes[i], &info) && info.t <= maxT) {
+			return true;
+		}
+	}
+	for (size_t i = 0; i < scene.sphereCount; i++) {
+		if (MyCollision::IntersectLine(ray, scene.spheres[i], &info) && info.t <= maxT) {
+			return true;
+		}
+	}
+	for (size_t i = 0; i < scene.triangleCount; i++) {
+		if (MyCollision::IntersectLine(ray, scene.triangles[i], &info) && info.t <= maxT) {
+			return true;
+		}
+	}
+
+	return false;
+
+}
+
+/// <summary>
+/// 線分が遮られずに通るかを求める関数
+/// </summary>
+/// <param name="segment">線分</param>
+/// <param name="scene">対象のプリミティブ配列</param>
+/// <returns>遮るものがないか</returns>
+bool MyRaycast::IsLineOfSight(const Segment& segment, const RaycastScene& scene) {
+
+	return !AnyHit(Ray{ segment.origin, segment.diff }, scene, 1.0f);
+
+}
+
+/// <summary>
+/// 1つのプリミティブと半直線の交点を求める関数
+/// </summary>
+/// <param name="ray">半直線</param>
+/// <param name="scene">対象のプリミティブ配列</param>
+/// <param name="type">プリミティブの種類</param>
+/// <param name="index">プリミティブの番号</param>
+/// <param name="hit">交差情報の格納先</param>
+/// <returns>交差しているか</returns>
+bool MyRaycast::Intersect(const Ray& ray, const RaycastScene& scene, PrimitiveType type, uint32_t index, HitInfo& hit) {
+
+	bool isHit = false;
+	switch (type) {
+	case PrimitiveType::kSphere:
+		isHit = MyCollision::IntersectLine(ray, scene.spheres[index], &hit);
+		break;
+	case PrimitiveType::kPlane:
+		isHit = MyCollision::IntersectLine(ray, scene.planes[index], &hit);
+		break;
+	case PrimitiveType::kTriangle:
+		isHit = MyCollision::IntersectLine(ray, scene.triangles[index], &hit);
+		break;
+	}
+
+	// 法線を半直線と向かい合う向きにする (平面や三角形の裏側、球の内側から当たった場合)
+	if (isHit && MyMath::Dot(hit.normal, ray.diff) > 0.0f) {
+		hit.normal = MyMath::Multiply(-1.0f, hit.normal);
+	}
+	return isHit;
+
+}
+
+/// <summary>
+/// 球と三角形の配列から最も手前で当たるものを求める関数 (マウスでの選択用)
+/// 種類ごとに IntersectLineMany で4個ずつ判定し、最も手前のものだけ交点と法線を求める
+/// </summary>
+/// <param name="ray">半直線 (MyMath::Unproject で作成したもの)</param>
+/// <param name="spheres">球配列</param>
+/// <param name="triangles">三角形配列</param>
+/// <param name="hit">結果の格納先</param>
+/// <param name="maxT">判定する媒介変数の上限</param>
+/// <returns>当たったか</returns>
+bool MyRaycast::Pick(const Ray& ray, const SphereSoA& spheres, const TriangleSoA& triangles, RaycastHit& hit, float maxT) {
+
+	float sphereT = maxT;
+	uint32_t sphereIndex = 0;
+	bool isSphereHit = MyCollision::IntersectLineMany(ray, spheres, maxT, sphereT, sphereIndex);
+
+	// 三角形は球より手前のものだけを判定する (同じ距離なら球を優先する)
+	float triangleT = sphereT;
+	uint32_t triangleIndex = 0;
+	bool isTriangleHit = MyCollision::IntersectLineMany(ray, triangles, sphereT, triangleT, triangleIndex);
+	if (isTriangleHit && isSphereHit && !(triangleT < sphereT)) {
+		isTriangleHit = false;
+	}
+
+	if (!isSphereHit && !isTriangleHit) {
+		return false;
+	}
+
+	// 最も手前のものだけ交点と法線を求める
+	HitInfo info{};
+	if (isTriangleHit) {
+		Triangle triangle{};
+		for (uint32_t v = 0; v < 3; v++) {
+			triangle.vertex[v] = { triangles.x[v][triangleIndex], triangles.y[v][triangleIndex], triangles.z[v][triangleIndex] };
+		}
+		MyCollision::IntersectLine(ray, triangle, &info);
+		hit.type = PrimitiveType::kTriangle;
+		hit.index = triangleIndex;
+		hit.t = triangleT;
+	}
+	else {
+		Sphere sphere = { { spheres.x[sphereIndex], spheres.y[sphereIndex], spheres.z[sphereIndex] }, spheres.radius[sphereIndex] };
+		MyCollision::IntersectLine(ray, sphere, &info);
+		hit.type = PrimitiveType::kSphere;
+		hit.index = sphereIndex;
+		hit.t = sphereT;
+	}
+	hit.point = info.point;
+	hit.normal = info.normal;
+
+	// 法線を半直線と向かい合う向きにする (三角形の裏側、球の内側から当たった場合)
+	if (MyMath::Dot(hit.normal, ray.diff) > 0.0f) {
+		hit.normal = MyMath::Multiply(-1.0f, hit.normal);
+	}
+
+	return true;
+
+}
+
+/// <summary>
+/// シーンの球と三角形をAABB木に登録する関数 (平面は範囲がないので登録しない)
+/// 作成した木を RaycastScene::tree に設定すると ClosestHit で使われる
+/// </summary>
+/// <param name="scene">対象のプリミティブ配列</param>
+/// <param name="tree">登録先 (空の木、動かさないので余白は0でよい)</param>
+void MyRaycast::BuildTree(const RaycastScene& scene, MyAABBTree& tree) {
+
+	// 識別番号の上位ビットに種類を入れる
+	assert(scene.sphereCount < (size_t(1) << kTypeShift) && scene.triangleCount < (size_t(1) << kTypeShift));
+	for (size_t i = 0; i < scene.sphereCount; i++) {
+		tree.CreateProxy(MyCollision::MakeAABB(scene.spheres[i]), (uint32_t(PrimitiveType::kSphere) << kTypeShift) | uint32_t(i));
+	}
+	for (size_t i = 0; i < scene.triangleCount; i++) {
+		tree.CreateProxy(MyCollision::MakeAABB(scene.triangles[i]), (uint32_t(PrimitiveType::kTriangle) << kTypeShift) | uint32_t(i));
+	}
+
+}
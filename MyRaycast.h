@@ -0,0 +1,112 @@
+﻿#pragma once
+#include <cfloat>
+#include "MyAABBTree.h"
+#include "MyCollision.h"
+
+/// <summary>
+/// プリミティブの種類
+/// </summary>
+enum class PrimitiveType {
+	kSphere, // 球
+	kPlane, // 平面
+	kTriangle, // 三角形
+};
+
+/// <summary>
+/// レイキャストの対象となるプリミティブ配列をまとめた構造体
+/// </summary>
+struct RaycastScene {
+	const Sphere* spheres; // 球配列
+	size_t sphereCount; // 球の数
+	const Plane* planes; // 平面配列
+	size_t planeCount; // 平面の数
+	const Triangle* triangles; // 三角形配列
+	size_t triangleCount; // 三角形の数
+	const MyAABBTree* tree; // 球と三角形を登録したAABB木 (MyRaycast::BuildTree で作成、nullptrなら全て調べる)
+};
+
+/// <summary>
+/// レイキャストの結果構造体
+/// </summary>
+struct RaycastHit {
+	PrimitiveType type; // 当たったプリミティブの種類
+	uint32_t index; // 当たったプリミティブの配列内の番号
+	float t; // 交点の媒介変数 (origin + t * diff)
+	Vector3 point; // 交点
+	Vector3 normal; // 交点の法線 (半直線と向かい合う向き、球の内側から当たった場合も半直線と逆向きにする)
+};
+
+/// <summary>
+/// 種類の異なるプリミティブ配列に対してレイキャストを行うクラス
+/// </summary>
+class MyRaycast
+{
+public:
+
+	/// <summary>
+	/// 最も手前で当たるプリミティブを求める関数
+	/// AABB木があれば、木をたどりながら交点が見つかるたびに半直線を切り詰めて奥の枝を除外する
+	/// なければ各プリミティブまでの距離の下限で並べ替えて手前から判定し、下限が確定した交点より奥になった時点で打ち切る
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <param name="scene">対象のプリミティブ配列</param>
+	/// <param name="hit">結果の格納先</param>
+	/// <param name="maxT">判定する媒介変数の上限</param>
+	/// <returns>当たったか</returns>
+	static bool ClosestHit(const Ray& ray, const RaycastScene& scene, RaycastHit& hit, float maxT = FLT_MAX);
+
+	/// <summary>
+	/// いずれかのプリミティブに当たるかを求める関数 (最初に見つかった時点で打ち切る)
+	/// 視線が通るかの判定などに使う
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <param name="scene">対象のプリミティブ配列</param>
+	/// <param name="maxT">判定する媒介変数の上限</param>
+	/// <returns>当たったか</returns>
+	static bool AnyHit(const Ray& ray, const RaycastScene& scene, float maxT = FLT_MAX);
+
+	/// <summary>
+	/// 線分が遮られずに通るかを求める関数
+	/// </summary>
+	/// <param name="segment">線分</param>
+	/// <param name="scene">対象のプリミティブ配列</param>
+	/// <returns>遮るものがないか</returns>
+	static bool IsLineOfSight(const Segment& segment, const RaycastScene& scene);
+
+	/// <summary>
+	/// 球と三角形の配列から最も手前で当たるものを求める関数 (マウスでの選択用)
+	/// 種類ごとに IntersectLineMany で4個ずつ判定し、最も手前のものだけ交点と法線を求める
+	/// </summary>
+	/// <param name="ray">半直線 (MyMath::Unproject で作成したもの)</param>
+	/// <param name="spheres">球配列</param>
+	/// <param name="triangles">三角形配列</param>
+	/// <param name="hit">結果の格納先</param>
+	/// <param name="maxT">判定する媒介変数の上限</param>
+	/// <returns>当たったか</returns>
+	static bool Pick(const Ray& ray, const SphereSoA& spheres, const TriangleSoA& triangles, RaycastHit& hit, float maxT = FLT_MAX);
+
+	/// <summary>
+	/// シーンの球と三角形をAABB木に登録する関数 (平面は範囲がないので登録しない)
+	/// 作成した木を RaycastScene::tree に設定すると ClosestHit で使われる
+	/// </summary>
+	/// <param name="scene">対象のプリミティブ配列</param>
+	/// <param name="tree">登録先 (空の木、動かさないので余白は0でよい)</param>
+	static void BuildTree(const RaycastScene& scene, MyAABBTree& tree);
+
+private:
+
+	// AABB木の識別番号のうち種類を表すビットの位置 (残りが配列内の番号)
+	static const uint32_t kTypeShift = 30;
+
+	/// <summary>
+	/// 1つのプリミティブと半直線の交点を求める関数
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <param name="scene">対象のプリミティブ配列</param>
+	/// <param name="type">プリミティブの種類</param>
+	/// <param name="index">プリミティブの番号</param>
+	/// <param name="hit">交差情報の格納先</param>
+	/// <returns>交差しているか</returns>
+	static bool Intersect(const Ray& ray, const RaycastScene& scene, PrimitiveType type, uint32_t index, HitInfo& hit);
+
+};
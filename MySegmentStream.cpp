@@ -0,0 +1,332 @@
+﻿#include "MySegmentStream.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "MyAABBTree.h"
+#include "MyCollision.h"
+
+static_assert(sizeof(Segment) == sizeof(float) * 6, "Segment must be tightly packed");
+static_assert(sizeof(Triangle) == sizeof(float) * 9, "Triangle must be tightly packed");
+
+namespace {
+
+	// 1つのスレッドがまとめて判定する線分の数
+	const size_t kBlockSize = 4096;
+
+	/// <summary>
+	/// 読み込んだ線分の配列
+	/// </summary>
+	struct SegmentChunk {
+		std::vector<Segment> segments; // 線分配列 (chunkSize 個確保する)
+		size_t count; // 読み込んだ数
+		uint64_t firstIndex; // 先頭の線分の番号
+	};
+
+	/// <summary>
+	/// 書き出す衝突記録の配列
+	/// </summary>
+	struct HitChunk {
+		std::vector<SegmentHitRecord> hits; // 衝突記録
+	};
+
+	/// <summary>
+	/// スレッド間で配列を受け渡すキュー (nullptr は終了の合図)
+	/// </summary>
+	template<typename T>
+	class BufferQueue {
+	public:
+
+		void Push(T* buffer) {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				queue_.push_back(buffer);
+			}
+			condition_.notify_one();
+		}
+
+		T* Pop() {
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return !queue_.empty(); });
+			T* buffer = queue_.front();
+			queue_.pop_front();
+			return buffer;
+		}
+
+	private:
+
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::deque<T*> queue_;
+
+	};
+
+	/// <summary>
+	/// ファイルを開く関数
+	/// </summary>
+	/// <param name="path">ファイル</param>
+	/// <param name="mode">モード</param>
+	/// <returns>ファイル (開けなければ nullptr)</returns>
+	FILE* OpenFile(const char* path, const char* mode) {
+
+		FILE* file = nullptr;
+#ifdef _MSC_VER
+		if (fopen_s(&file, path, mode) != 0) {
+			return nullptr;
+		}
+#else
+		file = std::fopen(path, mode);
+#endif
+		return file;
+
+	}
+
+}
+
+/// <summary>
+/// 線分ファイルの全ての線分と三角形の衝突判定を行い、衝突記録をファイルに書き出す関数
+/// 線分ファイルは Segment、出力ファイルは SegmentHitRecord をそのまま並べた形式
+/// 記録は線分の番号順に並ぶ
+/// </summary>
+/// <param name="segmentPath">線分ファイル</param>
+/// <param name="triangles">三角形配列</param>
+/// <param name="triangleCount">三角形の数</param>
+/// <param name="outputPath">出力ファイル</param>
+/// <param name="options">設定</param>
+/// <param name="stats">統計の格納先</param>
+/// <returns>最後まで処理できたか (ファイルを開けない、サイズが線分の倍数でない場合など false)</returns>
+bool MySegmentStream::Run(const char* segmentPath, const Triangle* triangles, size_t triangleCount, const char* outputPath, const SegmentStreamOptions& options, SegmentStreamStats& stats) {
+
+	stats = {};
+
+	FILE* input = OpenFile(segmentPath, "rb");
+	if (input == nullptr) {
+		return false;
+	}
+	FILE* output = OpenFile(outputPath, "wb");
+	if (output == nullptr) {
+		std::fclose(input);
+		return false;
+	}
+
+	// 三角形は全てメモリに載せて木で絞り込む
+	MyAABBTree tree(0.0f);
+	for (size_t i = 0; i < triangleCount; i++) {
+		tree.CreateProxy(MyCollision::MakeAABB(triangles[i]), uint32_t(i));
+	}
+
+	size_t chunkSize = std::max<size_t>(options.chunkSize, 1);
+	uint32_t workerCount = options.workerCount;
+	if (workerCount == 0) {
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// 読み込み用と書き出し用の配列を2つずつ使い回す
+	SegmentChunk segmentChunks[2];
+	HitChunk hitChunks[2];
+	BufferQueue<SegmentChunk> freeSegments, filledSegments;
+	BufferQueue<HitChunk> freeHits, filledHits;
+	for (uint32_t i = 0; i < 2; i++) {
+		segmentChunks[i].segments.resize(chunkSize);
+		freeSegments.Push(&segmentChunks[i]);
+		freeHits.Push(&hitChunks[i]);
+	}
+
+	std::atomic<bool> isReadFailed = false;
+	std::atomic<bool> isWriteFailed = false;
+	std::atomic<bool> isCanceled = false;
+
+	// 読み込みスレッド (判定中に次の線分を読み込む)
+	std::thread reader([&]() {
+		uint64_t nextIndex = 0;
+		while (!isCanceled.load(std::memory_order_relaxed)) {
+			SegmentChunk* chunk = freeSegments.Pop();
+			if (chunk == nullptr) {
+				break;
+			}
+			size_t byteCount = std::fread(chunk->segments.data(), 1, chunkSize * sizeof(Segment), input);
+
+			// 途中で切れた線分があれば壊れたファイルとみなす
+			if (std::ferror(input) || byteCount % sizeof(Segment) != 0) {
+				isReadFailed = true;
+				break;
+			}
+			if (byteCount == 0) {
+				break;
+			}
+
+			chunk->count = byteCount / sizeof(Segment);
+			chunk->firstIndex = nextIndex;
+			nextIndex += chunk->count;
+			filledSegments.Push(chunk);
+		}
+		filledSegments.Push(nullptr);
+	});
+
+	// 書き出しスレッド (判定中に前の結果を書き出す)
+	std::thread writer([&]() {
+		while (HitChunk* chunk = filledHits.Pop()) {
+			if (!isWriteFailed && !chunk->hits.empty()) {
+				size_t writeCount = std::fwrite(chunk->hits.data(), sizeof(SegmentHitRecord), chunk->hits.size(), output);
+				if (writeCount != chunk->hits.size()) {
+					isWriteFailed = true;
+					isCanceled = true;
+				}
+			}
+			freeHits.Push(chunk);
+		}
+	});
+
+	// ブロックごとの衝突記録 (ブロックの順に連結して線分の番号順にする)
+	std::vector<std::vector<SegmentHitRecord>> blockHits((chunkSize + kBlockSize - 1) / kBlockSize);
+
+	while (SegmentChunk* chunk = filledSegments.Pop()) {
+		size_t blockCount = (chunk->count + kBlockSize - 1) / kBlockSize;
+		std::atomic<size_t> nextBlock = 0;
+
+		// 空いているスレッドが次のブロックを取って判定する
+		auto work = [&]() {
+			for (size_t block = nextBlock++; block < blockCount; block = nextBlock++) {
+				std::vector<SegmentHitRecord>& hits = blockHits[block];
+				hits.clear();
+				size_t end = std::min(chunk->count, (block + 1) * kBlockSize);
+				for (size_t i = block * kBlockSize; i < end; i++) {
+					const Segment& segment = chunk->segments[i];
+					uint64_t segmentIndex = chunk->firstIndex + i;
+					tree.RayCast(segment, [&](int32_t proxyId, float maxFraction) {
+						uint32_t triangleIndex = tree.GetUserData(proxyId);
+						if (MyCollision::IsCollisionTriangle(triangles[triangleIndex], segment)) {
+							hits.push_back({ segmentIndex, triangleIndex, 0 });
+						}
+						// 全ての三角形を調べるので線分は切り詰めない
+						return maxFraction;
+					});
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (uint32_t i = 1; i < std::min<size_t>(workerCount, blockCount); i++) {
+			workers.emplace_back(work);
+		}
+		work();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		// 線分の配列を読み込みスレッドに返してから結果をまとめる
+		stats.segmentCount += chunk->count;
+		stats.chunkCount++;
+		freeSegments.Push(chunk);
+
+		HitChunk* hitChunk = freeHits.Pop();
+		hitChunk->hits.clear();
+		for (size_t block = 0; block < blockCount; block++) {
+			hitChunk->hits.insert(hitChunk->hits.end(), blockHits[block].begin(), blockHits[block].end());
+		}
+		stats.hitCount += hitChunk->hits.size();
+		filledHits.Push(hitChunk);
+
+		if (isCanceled) {
+			break;
+		}
+	}
+
+	// 途中で終えた場合も読み込みスレッドが終わるまで配列を返し続ける
+	isCanceled = true;
+	freeSegments.Push(nullptr);
+	reader.join();
+	filledHits.Push(nullptr);
+	writer.join();
+
+	std::fclose(input);
+	bool isSucceeded = std::fclose(output) == 0;
+
+	return isSucceeded && !isReadFailed && !isWriteFailed;
+
+}
+
+/// <summary>
+/// 三角形ファイル (Triangle をそのまま並べた形式) を読み込む関数
+/// </summary>
+/// <param name="path">三角形ファイル</param>
+/// <param name="triangles">格納先</param>
+/// <returns>読み込めたか</returns>
+bool MySegmentStream::LoadTriangles(const char* path, std::vector<Triangle>& triangles) {
+
+	FILE* file = OpenFile(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	triangles.clear();
+	Triangle buffer[1024];
+	size_t byteCount;
+	bool isSucceeded = true;
+	while ((byteCount = std::fread(buffer, 1, sizeof(buffer), file)) != 0) {
+		if (byteCount % sizeof(Triangle) != 0) {
+			isSucceeded = false;
+			break;
+		}
+		triangles.insert(triangles.end(), buffer, buffer + byteCount / sizeof(Triangle));
+	}
+	isSucceeded = isSucceeded && !std::ferror(file);
+	std::fclose(file);
+
+	return isSucceeded;
+
+}
+
+/// <summary>
+/// コマンドラインで一括判定が指定されていれば実行する関数
+/// 形式: -segmentquery 三角形ファイル 線分ファイル 出力ファイル [スレッド数]
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+/// <returns>一括判定が指定されていたか</returns>
+bool MySegmentStream::RunCommandLine(const char* commandLine, int& exitCode) {
+
+	if (commandLine == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(commandLine);
+	std::string command;
+	if (!(stream >> command) || command != "-segmentquery") {
+		return false;
+	}
+
+	std::string trianglePath, segmentPath, outputPath;
+	SegmentStreamOptions options;
+	if (!(stream >> trianglePath >> segmentPath >> outputPath)) {
+		std::fprintf(stderr, "usage: -segmentquery <triangles> <segments> <output> [workers]\n");
+		exitCode = 1;
+		return true;
+	}
+	stream >> options.workerCount;
+
+	std::vector<Triangle> triangles;
+	if (!LoadTriangles(trianglePath.c_str(), triangles)) {
+		std::fprintf(stderr, "failed to load triangles: %s\n", trianglePath.c_str());
+		exitCode = 1;
+		return true;
+	}
+
+	SegmentStreamStats stats;
+	if (!Run(segmentPath.c_str(), triangles.data(), triangles.size(), outputPath.c_str(), options, stats)) {
+		std::fprintf(stderr, "segment query failed after %llu segments\n", (unsigned long long)stats.segmentCount);
+		exitCode = 1;
+		return true;
+	}
+
+	std::fprintf(stderr, "segments: %llu hits: %llu chunks: %llu\n",
+		(unsigned long long)stats.segmentCount, (unsigned long long)stats.hitCount, (unsigned long long)stats.chunkCount);
+	exitCode = 0;
+	return true;
+
+}
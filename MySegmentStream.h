@@ -0,0 +1,74 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MyStruct.h"
+
+/// <summary>
+/// 線分と三角形の衝突記録 (出力ファイルの1要素)
+/// </summary>
+struct SegmentHitRecord {
+	uint64_t segmentIndex; // 入力ファイル内の線分の番号
+	uint32_t triangleIndex; // 三角形の番号
+	uint32_t reserved; // 予約 (0)
+};
+static_assert(sizeof(SegmentHitRecord) == 16, "SegmentHitRecord size");
+
+/// <summary>
+/// 一括判定の設定
+/// </summary>
+struct SegmentStreamOptions {
+	size_t chunkSize = size_t(1) << 20; // 一度に読み込む線分の数
+	uint32_t workerCount = 0; // 判定を行うスレッド数 (0ならCPUのスレッド数)
+};
+
+/// <summary>
+/// 一括判定の統計
+/// </summary>
+struct SegmentStreamStats {
+	uint64_t segmentCount; // 判定した線分の数
+	uint64_t hitCount; // 書き出した衝突記録の数
+	uint64_t chunkCount; // 読み込んだ回数
+};
+
+/// <summary>
+/// メモリに収まらない数の線分と三角形の集合の判定をファイルから順に行うクラス
+/// 線分を一定数ずつ読み込み、読み込み、判定、書き出しを別のスレッドで重ねて行う
+/// 読み込み用と書き出し用の配列をそれぞれ2つずつ使い回すので、使用メモリは線分の数によらない
+/// </summary>
+class MySegmentStream
+{
+public:
+
+	/// <summary>
+	/// 線分ファイルの全ての線分と三角形の衝突判定を行い、衝突記録をファイルに書き出す関数
+	/// 線分ファイルは Segment、出力ファイルは SegmentHitRecord をそのまま並べた形式
+	/// 記録は線分の番号順に並ぶ
+	/// </summary>
+	/// <param name="segmentPath">線分ファイル</param>
+	/// <param name="triangles">三角形配列</param>
+	/// <param name="triangleCount">三角形の数</param>
+	/// <param name="outputPath">出力ファイル</param>
+	/// <param name="options">設定</param>
+	/// <param name="stats">統計の格納先</param>
+	/// <returns>最後まで処理できたか (ファイルを開けない、サイズが線分の倍数でない場合など false)</returns>
+	static bool Run(const char* segmentPath, const Triangle* triangles, size_t triangleCount, const char* outputPath, const SegmentStreamOptions& options, SegmentStreamStats& stats);
+
+	/// <summary>
+	/// 三角形ファイル (Triangle をそのまま並べた形式) を読み込む関数
+	/// </summary>
+	/// <param name="path">三角形ファイル</param>
+	/// <param name="triangles">格納先</param>
+	/// <returns>読み込めたか</returns>
+	static bool LoadTriangles(const char* path, std::vector<Triangle>& triangles);
+
+	/// <summary>
+	/// コマンドラインで一括判定が指定されていれば実行する関数
+	/// 形式: -segmentquery 三角形ファイル 線分ファイル 出力ファイル [スレッド数]
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (成功なら0)</param>
+	/// <returns>一括判定が指定されていたか</returns>
+	static bool RunCommandLine(const char* commandLine, int& exitCode);
+
+};
@@ -0,0 +1,1269 @@
+﻿#include "MySelfTest.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "MyEventStream.h"
+#include "MyGJK.h"
+#include "MyIntersect.h"
+#include "MyMath.h"
+#include "MyMortonOrder.h"
+#include "MyPhysicsWorld.h"
+#include "MyPredicate.h"
+
+namespace {
+
+	// MyMath.h に記載した誤差の上限
+	constexpr double kInverseSqrtMaxRelativeError = 5e-6;
+	constexpr double kSinCosMaxAbsoluteError = 2e-6;
+	constexpr float kSinCosMaxRadian = 8192.0f;
+
+	/// <summary>
+	/// 誤差が上限を超えていれば表示する関数
+	/// </summary>
+	/// <param name="name">確認の名前</param>
+	/// <param name="maxError">最大誤差</param>
+	/// <param name="worstInput">最大誤差となった入力</param>
+	/// <param name="bound">上限</param>
+	/// <returns>失敗した数 (0 か 1)</returns>
+	int CheckBound(const char* name, double maxError, double worstInput, double bound) {
+
+		if (maxError <= bound) {
+			std::fprintf(stderr, "  ok   %-24s max error %.3g (bound %.3g)\n", name, maxError, bound);
+			return 0;
+		}
+		std::fprintf(stderr, "  FAIL %-24s max error %.3g at %.9g (bound %.3g)\n", name, maxError, worstInput, bound);
+		return 1;
+
+	}
+
+	/// <summary>
+	/// サインとコサインの誤差を記録する関数
+	/// </summary>
+	void AccumulateSinCosError(float radian, float sinValue, float cosValue, double& maxError, double& worstInput) {
+
+		double error = std::fmax(std::fabs(sinValue - std::sin(double(radian))), std::fabs(cosValue - std::cos(double(radian))));
+		if (!(error <= maxError)) {
+			maxError = error;
+			worstInput = radian;
+		}
+
+	}
+
+	/// <summary>
+	/// 判定結果が期待通りでなければ表示する関数
+	/// </summary>
+	/// <param name="name">確認の名前</param>
+	/// <param name="result">判定結果</param>
+	/// <param name="expected">期待する結果</param>
+	/// <returns>失敗した数 (0 か 1)</returns>
+	int CheckResult(const char* name, bool result, bool expected) {
+
+		if (result == expected) {
+			return 0;
+		}
+		std::fprintf(stderr, "  FAIL %s: expected %s\n", name, expected ? "hit" : "miss");
+		return 1;
+
+	}
+
+	/// <summary>
+	/// 整数の格子上の4点の向きを誤差なしで求める関数 (比較用)
+	/// 各座標の差が 2^20 以下なら int64_t で桁あふれしない
+	/// </summary>
+	/// <returns>(a - d)・((b - d) × (c - d)) の符号</returns>
+	int ReferenceOrient3D(const int64_t a[3], const int64_t b[3], const int64_t c[3], const int64_t d[3]) {
+
+		int64_t ad[3], bd[3], cd[3];
+		for (uint32_t i = 0; i < 3; i++) {
+			ad[i] = a[i] - d[i];
+			bd[i] = b[i] - d[i];
+			cd[i] = c[i] - d[i];
+		}
+		int64_t det = ad[0] * (bd[1] * cd[2] - bd[2] * cd[1]) + ad[1] * (bd[2] * cd[0] - bd[0] * cd[2]) + ad[2] * (bd[0] * cd[1] - bd[1] * cd[0]);
+		return det > 0 ? 1 : (det < 0 ? -1 : 0);
+
+	}
+
+	/// <summary>
+	/// 2つの積の大小を誤差なしで比べる関数 (比較用)
+	/// 積を32bitずつに分けて128bitで求める
+	/// </summary>
+	/// <returns>x * y - z * w の符号</returns>
+	int CompareProduct(int64_t x, int64_t y, int64_t z, int64_t w) {
+
+		// 積の絶対値を上位と下位の64bitで求める
+		auto magnitude = [](int64_t p, int64_t q, uint64_t& high, uint64_t& low) {
+			uint64_t u = p < 0 ? 0 - uint64_t(p) : uint64_t(p);
+			uint64_t v = q < 0 ? 0 - uint64_t(q) : uint64_t(q);
+			uint64_t u0 = u & 0xFFFFFFFF, u1 = u >> 32, v0 = v & 0xFFFFFFFF, v1 = v >> 32;
+			uint64_t p00 = u0 * v0, p01 = u0 * v1, p10 = u1 * v0, p11 = u1 * v1;
+			uint64_t middle = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+			low = (p00 & 0xFFFFFFFF) | (middle << 32);
+			high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+		};
+		auto sign = [](int64_t p, int64_t q) { return p == 0 || q == 0 ? 0 : ((p < 0) == (q < 0) ? 1 : -1); };
+
+		int signLeft = sign(x, y), signRight = sign(z, w);
+		if (signLeft != signRight) {
+			return signLeft > signRight ? 1 : -1;
+		}
+		uint64_t highLeft, lowLeft, highRight, lowRight;
+		magnitude(x, y, highLeft, lowLeft);
+		magnitude(z, w, highRight, lowRight);
+		int compare = highLeft != highRight ? (highLeft > highRight ? 1 : -1) : (lowLeft != lowRight ? (lowLeft > lowRight ? 1 : -1) : 0);
+		return signLeft * compare;
+
+	}
+
+	/// <summary>
+	/// 整数の格子上の3点の向きを誤差なしで求める関数 (比較用)
+	/// 各座標の差が 2^62 以下なら桁あふれしない
+	/// </summary>
+	/// <returns>(a - c) × (b - c) の符号</returns>
+	int ReferenceOrient2D(const int64_t a[2], const int64_t b[2], const int64_t c[2]) {
+		return CompareProduct(a[0] - c[0], b[1] - c[1], a[1] - c[1], b[0] - c[0]);
+	}
+
+	/// <summary>
+	/// 整数を float で誤差なく表せるか (有効桁が24bit以下か) を調べる関数
+	/// </summary>
+	bool IsExactFloat(int64_t value) {
+		return int64_t(double(float(value))) == value;
+	}
+
+	/// <summary>
+	/// 線 (origin + t * diff, t >= minT) と箱の判定を倍精度のスラブ法で求める関数 (比較用)
+	/// </summary>
+	bool ReferenceLinearBox(const Vector3& origin, const Vector3& diff, double minT, const Vector3& center, const Vector3 axis[3], const Vector3& halfSize) {
+
+		double t0 = minT, t1 = std::numeric_limits<double>::infinity();
+		const float* size = &halfSize.x;
+		for (uint32_t i = 0; i < 3; i++) {
+			double p = double(origin.x - center.x) * axis[i].x + double(origin.y - center.y) * axis[i].y + double(origin.z - center.z) * axis[i].z;
+			double d = double(diff.x) * axis[i].x + double(diff.y) * axis[i].y + double(diff.z) * axis[i].z;
+			if (d == 0.0) {
+				if (std::fabs(p) > size[i]) {
+					return false;
+				}
+				continue;
+			}
+			double a = (-size[i] - p) / d, b = (size[i] - p) / d;
+			t0 = std::fmax(t0, std::fmin(a, b));
+			t1 = std::fmin(t1, std::fmax(a, b));
+		}
+		return t0 <= t1;
+
+	}
+
+	/// <summary>
+	/// 線 (origin + t * diff, t >= minT) とカプセルの判定を倍精度で求める関数 (比較用)
+	/// 中心線上の点から線までの距離は凸なので三分探索で最小値を求める
+	/// </summary>
+	bool ReferenceLinearCapsule(const Vector3& origin, const Vector3& diff, double minT, const Capsule& capsule) {
+
+		auto distance = [&](double u) {
+			double p[3] = {
+				capsule.segment.origin.x + u * capsule.segment.diff.x - origin.x,
+				capsule.segment.origin.y + u * capsule.segment.diff.y - origin.y,
+				capsule.segment.origin.z + u * capsule.segment.diff.z - origin.z };
+			double d[3] = { diff.x, diff.y, diff.z };
+			double t = std::fmax((p[0] * d[0] + p[1] * d[1] + p[2] * d[2]) / (d[0] * d[0] + d[1] * d[1] + d[2] * d[2]), minT);
+			double q[3] = { p[0] - t * d[0], p[1] - t * d[1], p[2] - t * d[2] };
+			return std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+		};
+		double low = 0.0, high = 1.0;
+		for (uint32_t i = 0; i < 200; i++) {
+			double m1 = low + (high - low) / 3.0, m2 = high - (high - low) / 3.0;
+			if (distance(m1) < distance(m2)) {
+				high = m2;
+			}
+			else {
+				low = m1;
+			}
+		}
+		return distance(0.5 * (low + high)) <= capsule.radius;
+
+	}
+
+	/// <summary>
+	/// 直線、半直線と凸形状の判定を切り取りを使わずに求める関数 (比較用)
+	/// </summary>
+	/// <param name="result">結果の格納先</param>
+	/// <returns>比較用の判定があるか</returns>
+	template<typename A, typename B>
+	bool ReferenceIntersect(const A& a, const B& b, bool& result) {
+
+		constexpr double kMinT = std::is_same_v<A, Line> ? -std::numeric_limits<double>::infinity() : 0.0;
+		if constexpr (std::is_same_v<B, OBB>) {
+			result = ReferenceLinearBox(a.origin, a.diff, kMinT, b.center, b.orientations, b.size);
+			return true;
+		}
+		else if constexpr (std::is_same_v<B, AABB>) {
+			const Vector3 kAxis[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+			result = ReferenceLinearBox(a.origin, a.diff, kMinT, MyMath::Multiply(0.5f, b.min + b.max), kAxis, MyMath::Multiply(0.5f, b.max - b.min));
+			return true;
+		}
+		else if constexpr (std::is_same_v<B, Capsule>) {
+			result = ReferenceLinearCapsule(a.origin, a.diff, kMinT, b);
+			return true;
+		}
+		else if constexpr (std::is_same_v<A, Line> && std::is_same_v<B, Triangle>) {
+			// 直線は逆向きの2本の半直線
+			result = MyCollision::IntersectLine(Ray{ a.origin, a.diff }, b) || MyCollision::IntersectLine(Ray{ a.origin, MyMath::Multiply(-1.0f, a.diff) }, b);
+			return true;
+		}
+		return false;
+
+	}
+
+	/// <summary>
+	/// Morton符号から各軸の格子の番号を取り出す関数 (比較用、1ビットずつ取り出す)
+	/// </summary>
+	/// <param name="code">Morton符号</param>
+	/// <param name="bitCount">1軸のビット数</param>
+	/// <param name="cell">各軸の番号の格納先</param>
+	void ReferenceDecodeMorton(uint64_t code, uint32_t bitCount, uint32_t cell[3]) {
+
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			cell[axis] = 0;
+			for (uint32_t bit = 0; bit < bitCount; bit++) {
+				cell[axis] |= uint32_t((code >> (bit * 3 + 2 - axis)) & 1) << bit;
+			}
+		}
+
+	}
+
+	/// <summary>
+	/// 中心点の符号を MyMortonOrder::Update と同じ範囲で求める関数 (比較用)
+	/// </summary>
+	/// <param name="centroids">中心点配列</param>
+	/// <param name="bits">Morton符号の精度</param>
+	/// <returns>符号配列</returns>
+	std::vector<uint64_t> ReferenceMortonCodes(const std::vector<Vector3>& centroids, MortonBits bits) {
+
+		AABB bounds = { centroids[0], centroids[0] };
+		for (const Vector3& centroid : centroids) {
+			bounds.min = { std::min(bounds.min.x, centroid.x), std::min(bounds.min.y, centroid.y), std::min(bounds.min.z, centroid.z) };
+			bounds.max = { std::max(bounds.max.x, centroid.x), std::max(bounds.max.y, centroid.y), std::max(bounds.max.z, centroid.z) };
+		}
+		std::vector<uint64_t> codes(centroids.size());
+		for (size_t i = 0; i < centroids.size(); i++) {
+			codes[i] = bits == MortonBits::k30 ? MyMortonOrder::Encode30(centroids[i], bounds) : MyMortonOrder::Encode63(centroids[i], bounds);
+		}
+		return codes;
+
+	}
+
+}
+
+/// <summary>
+/// 高速近似演算 (FastInverseSqrt, FastSinCos とその一括版) の誤差が
+/// MyMath.h に記載した上限以下であることを確認する関数
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestFastMath() {
+
+	int failCount = 0;
+
+	// 仮数部の全ての値 ([1, 4) の全ての float) と、指数部の範囲全体を調べる
+	// (1 / sqrt(x) の相対誤差は x を4倍しても変わらないので、これで正の正規化数を網羅する)
+	{
+		double maxError = 0.0, worstInput = 0.0;
+		auto accumulate = [&](float x) {
+			double error = std::fabs(double(MyMath::FastInverseSqrt(x)) * std::sqrt(double(x)) - 1.0);
+			if (!(error <= maxError)) {
+				maxError = error;
+				worstInput = x;
+			}
+		};
+		for (float x = 1.0f; x < 4.0f; x = std::nextafter(x, 5.0f)) {
+			accumulate(x);
+		}
+		for (float x = 1e-30f; x < 1e30f; x *= 1.0001f) {
+			accumulate(x);
+		}
+		failCount += CheckBound("FastInverseSqrt", maxError, worstInput, kInverseSqrtMaxRelativeError);
+	}
+
+	// 一括正規化は SIMD で4個ずつ処理する部分と残りを1個ずつ処理する部分の両方を通す (個数を4の倍数にしない)
+	{
+		std::vector<Vector3> v;
+		for (float x = -4.0f; x <= 4.0f; x += 0.37f) {
+			for (float y = -4.0f; y <= 4.0f; y += 0.41f) {
+				for (float z = -4.0f; z <= 4.0f; z += 0.43f) {
+					v.push_back({ x, y, z });
+				}
+			}
+		}
+		if (v.size() % 4 == 0) {
+			v.push_back({ 1.0f, 2.0f, 3.0f });
+		}
+		std::vector<Vector3> result(v.size());
+		MyMath::FastNormalizeMany(v.data(), result.data(), v.size());
+
+		double maxError = 0.0, worstInput = 0.0;
+		for (size_t i = 0; i < v.size(); i++) {
+			double lengthSq = double(v[i].x) * v[i].x + double(v[i].y) * v[i].y + double(v[i].z) * v[i].z;
+			if (lengthSq == 0.0) {
+				continue;
+			}
+			double length = std::sqrt(double(result[i].x) * result[i].x + double(result[i].y) * result[i].y + double(result[i].z) * result[i].z);
+			double error = std::fabs(length - 1.0);
+			if (!(error <= maxError)) {
+				maxError = error;
+				worstInput = double(i);
+			}
+		}
+		failCount += CheckBound("FastNormalizeMany", maxError, worstInput, kInverseSqrtMaxRelativeError);
+	}
+
+	// 記載した範囲 |radian| <= 8192 を細かく調べる (範囲の端と象限の境目を含む)
+	std::vector<float> radian;
+	for (float x = -kSinCosMaxRadian; x <= kSinCosMaxRadian; x += 0.000731f * (1.0f + std::fabs(x) * 0.01f)) {
+		radian.push_back(x);
+	}
+	for (int32_t k = -5215; k <= 5215; k++) {
+		float boundary = float(k * std::numbers::pi / 4.0);
+		radian.push_back(std::nextafter(boundary, -kSinCosMaxRadian));
+		radian.push_back(boundary);
+		radian.push_back(std::nextafter(boundary, kSinCosMaxRadian));
+	}
+	radian.push_back(kSinCosMaxRadian);
+	radian.push_back(-kSinCosMaxRadian);
+	if (radian.size() % 4 == 0) {
+		radian.push_back(1.0f);
+	}
+
+	{
+		double maxError = 0.0, worstInput = 0.0;
+		for (float x : radian) {
+			float s, c;
+			MyMath::FastSinCos(x, s, c);
+			AccumulateSinCosError(x, s, c, maxError, worstInput);
+		}
+		failCount += CheckBound("FastSinCos", maxError, worstInput, kSinCosMaxAbsoluteError);
+	}
+
+	{
+		std::vector<float> s(radian.size()), c(radian.size());
+		MyMath::FastSinCosMany(radian.data(), s.data(), c.data(), radian.size());
+		double maxError = 0.0, worstInput = 0.0;
+		for (size_t i = 0; i < radian.size(); i++) {
+			AccumulateSinCosError(radian[i], s[i], c[i], maxError, worstInput);
+		}
+		failCount += CheckBound("FastSinCosMany", maxError, worstInput, kSinCosMaxAbsoluteError);
+	}
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyIntersect の判定を確認する関数
+/// 各軸に沿った直線と球、半直線とAABBなどの既知の結果と、
+/// 直線、半直線と凸形状の判定が十分長い線分との判定と一致することを確認する
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestIntersect() {
+
+	int failCount = 0;
+
+	// 各軸に沿って球の中心を通る直線、半直線は当たり、半径より離すと外れる
+	const Vector3 kAxis[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+	Sphere sphere{ { 1.0f, -2.0f, 3.0f }, 0.5f };
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		Vector3 origin = sphere.center - MyMath::Multiply(4.0f, kAxis[axis]);
+		Vector3 diff = MyMath::Multiply(2.0f, kAxis[axis]);
+		Vector3 side = MyMath::Multiply(0.6f, kAxis[(axis + 1) % 3]);
+		std::string name = "line/sphere axis " + std::to_string(axis);
+		failCount += CheckResult(name.c_str(), MyIntersect::Intersect(Line{ origin, diff }, sphere), true);
+		failCount += CheckResult((name + " offset").c_str(), MyIntersect::Intersect(Line{ origin + side, diff }, sphere), false);
+		name = "ray/sphere axis " + std::to_string(axis);
+		failCount += CheckResult(name.c_str(), MyIntersect::Intersect(Ray{ origin, diff }, sphere), true);
+		failCount += CheckResult((name + " backward").c_str(), MyIntersect::Intersect(Ray{ origin, MyMath::Multiply(-1.0f, diff) }, sphere), false);
+	}
+
+	// 半直線、直線と箱や三角形、直線同士
+	AABB box{ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+	Triangle triangle{ { { 0.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { -1.0f, -1.0f, 0.0f } } };
+	failCount += CheckResult("ray/aabb through", MyIntersect::Intersect(Ray{ { -5.0f, 0.2f, 0.3f }, { 1.0f, 0.0f, 0.0f } }, box), true);
+	failCount += CheckResult("ray/aabb away", MyIntersect::Intersect(Ray{ { -5.0f, 0.2f, 0.3f }, { -1.0f, 0.0f, 0.0f } }, box), false);
+	failCount += CheckResult("line/aabb behind", MyIntersect::Intersect(Line{ { -5.0f, 0.2f, 0.3f }, { -1.0f, 0.0f, 0.0f } }, box), true);
+	failCount += CheckResult("line/triangle", MyIntersect::Intersect(Line{ { 0.0f, 0.0f, 7.0f }, { 0.0f, 0.0f, 1.0f } }, triangle), true);
+	failCount += CheckResult("line/line cross", MyIntersect::Intersect(Line{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } }, Line{ { 3.0f, 5.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } }), true);
+	failCount += CheckResult("line/line skew", MyIntersect::Intersect(Line{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } }, Line{ { 3.0f, 5.0f, 0.1f }, { 0.0f, 1.0f, 0.0f } }), false);
+	failCount += CheckResult("ray/ray behind", MyIntersect::Intersect(Ray{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } }, Ray{ { 3.0f, 5.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } }), false);
+	failCount += CheckResult("ray/segment", MyIntersect::Intersect(Ray{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } }, Segment{ { 3.0f, -1.0f, 0.0f }, { 0.0f, 2.0f, 0.0f } }), true);
+
+	// 直線、半直線と凸形状の判定が、切り取りを使わない倍精度の判定と一致する
+	// また IntersectMany が全ての組み合わせで Intersect と一致する
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> size(0.2f, 1.5f);
+	auto randomVector = [&]() { return Vector3{ position(random), position(random), position(random) }; };
+	std::vector<MyIntersect::Primitive> primitives;
+	for (uint32_t i = 0; i < 20 * MyIntersect::kTypeCount; i++) {
+		Vector3 center = randomVector();
+		Vector3 diff = MyMath::Multiply(0.5f, randomVector());
+		switch (i % MyIntersect::kTypeCount) {
+		case 0: primitives.push_back(Sphere{ center, size(random) }); break;
+		case 1: primitives.push_back(Plane{ MyMath::Normalize(randomVector()), position(random) }); break;
+		case 2: primitives.push_back(Line{ center, diff }); break;
+		case 3: primitives.push_back(Ray{ center, diff }); break;
+		case 4: primitives.push_back(Segment{ center, diff }); break;
+		case 5: primitives.push_back(Triangle{ { center, center + diff, center + MyMath::Multiply(0.5f, randomVector()) } }); break;
+		case 6: {
+			OBB obb{};
+			obb.center = center;
+			obb.orientations[0] = MyMath::Normalize(diff);
+			obb.orientations[1] = MyMath::Normalize(MyMath::Cross(obb.orientations[0], randomVector()));
+			obb.orientations[2] = MyMath::Cross(obb.orientations[0], obb.orientations[1]);
+			obb.size = { size(random), size(random), size(random) };
+			primitives.push_back(obb);
+			break;
+		}
+		case 7: primitives.push_back(Capsule{ { center, diff }, size(random) * 0.5f }); break;
+		default: primitives.push_back(AABB{ center, center + Vector3{ size(random), size(random), size(random) } }); break;
+		}
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	for (uint32_t i = 0; i < uint32_t(primitives.size()); i++) {
+		for (uint32_t j = 0; j < uint32_t(primitives.size()); j++) {
+			pairs.push_back({ i, j });
+		}
+	}
+	std::vector<uint8_t> results(pairs.size());
+	MyIntersect::IntersectMany(primitives.data(), pairs.data(), pairs.size(), reinterpret_cast<bool*>(results.data()));
+
+	int mismatchCount = 0, referenceMismatchCount = 0;
+	for (size_t i = 0; i < pairs.size(); i++) {
+		const MyIntersect::Primitive& a = primitives[pairs[i].first];
+		const MyIntersect::Primitive& b = primitives[pairs[i].second];
+		bool expected = std::visit([](const auto& x, const auto& y) { return MyIntersect::Intersect(x, y); }, a, b);
+		mismatchCount += (results[i] != 0) != expected;
+
+		std::visit([&](const auto& x, const auto& y) {
+			if constexpr (UnboundedPrimitive<std::decay_t<decltype(x)>>) {
+				bool reference;
+				if (ReferenceIntersect(x, y, reference)) {
+					referenceMismatchCount += expected != reference;
+				}
+			}
+		}, a, b);
+	}
+	failCount += CheckResult("IntersectMany matches Intersect", mismatchCount == 0, true);
+	failCount += CheckResult("line/ray clip matches reference", referenceMismatchCount == 0, true);
+	std::fprintf(stderr, "  %zu pairs, %d mismatches, %d clip mismatches\n", pairs.size(), mismatchCount, referenceMismatchCount);
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyPredicate の向きの判定が、整数の格子上の点で誤差なしに求めた符号と一致することを確認する関数
+/// 同じ平面上、同じ直線上、同じ円周上の点と、そこから格子1つ分だけずらした点を含む
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestPredicate() {
+
+	// 格子の間隔 (2の累乗なので float への変換と符号は変わらない)
+	const float kOrient3DGrid = 1.0f / 128.0f;
+	const float kOrient2DGrid = 1.0f / 1024.0f;
+
+	int failCount = 0;
+	std::mt19937 random(48);
+
+	// roundedCount は double で素直に計算すると符号を誤る (誤差なしの計算が必要な) 数
+	int mismatchCount = 0, degenerateCount = 0, roundedCount = 0, caseCount = 0;
+	auto sign = [](double value) { return value > 0.0 ? 1 : (value < 0.0 ? -1 : 0); };
+	auto check3 = [&](const int64_t a[3], const int64_t b[3], const int64_t c[3], const int64_t d[3]) {
+		auto toVector = [&](const int64_t p[3]) { return Vector3{ float(p[0]) * kOrient3DGrid, float(p[1]) * kOrient3DGrid, float(p[2]) * kOrient3DGrid }; };
+		int expected = ReferenceOrient3D(a, b, c, d);
+		double ad[3], bd[3], cd[3];
+		for (uint32_t i = 0; i < 3; i++) {
+			ad[i] = double(a[i] - d[i]);
+			bd[i] = double(b[i] - d[i]);
+			cd[i] = double(c[i] - d[i]);
+		}
+		roundedCount += sign(ad[2] * (bd[0] * cd[1] - cd[0] * bd[1]) + bd[2] * (cd[0] * ad[1] - ad[0] * cd[1]) + cd[2] * (ad[0] * bd[1] - bd[0] * ad[1])) != expected;
+		int result = MyPredicate::Orient3D(toVector(a), toVector(b), toVector(c), toVector(d));
+		// 2点を入れ替えると符号が反転する
+		int swapped = MyPredicate::Orient3D(toVector(b), toVector(a), toVector(c), toVector(d));
+		if (result != expected || swapped != -expected) {
+			if (mismatchCount < 5) {
+				std::fprintf(stderr, "  FAIL Orient3D (%lld %lld %lld) (%lld %lld %lld) (%lld %lld %lld) (%lld %lld %lld): %d, expected %d\n",
+					(long long)a[0], (long long)a[1], (long long)a[2], (long long)b[0], (long long)b[1], (long long)b[2],
+					(long long)c[0], (long long)c[1], (long long)c[2], (long long)d[0], (long long)d[1], (long long)d[2], result, expected);
+			}
+			mismatchCount++;
+		}
+		degenerateCount += expected == 0;
+		caseCount++;
+	};
+	auto check2 = [&](const int64_t a[2], const int64_t b[2], const int64_t c[2], float grid) {
+		int expected = ReferenceOrient2D(a, b, c);
+		roundedCount += sign(double(a[0] - c[0]) * double(b[1] - c[1]) - double(a[1] - c[1]) * double(b[0] - c[0])) != expected;
+		auto orient = [&](const int64_t p[2], const int64_t q[2], const int64_t r[2]) {
+			return MyPredicate::Orient2D(float(p[0]) * grid, float(p[1]) * grid, float(q[0]) * grid, float(q[1]) * grid, float(r[0]) * grid, float(r[1]) * grid);
+		};
+		int result = orient(a, b, c);
+		int swapped = orient(b, a, c);
+		if (result != expected || swapped != -expected) {
+			if (mismatchCount < 5) {
+				std::fprintf(stderr, "  FAIL Orient2D (%lld %lld) (%lld %lld) (%lld %lld): %d, expected %d\n",
+					(long long)a[0], (long long)a[1], (long long)b[0], (long long)b[1], (long long)c[0], (long long)c[1], result, expected);
+			}
+			mismatchCount++;
+		}
+		degenerateCount += expected == 0;
+		caseCount++;
+	};
+
+	// 同じ平面上の点 d = a + i(b - a) + j(c - a) と、そこから格子1つ分ずらした点
+	// 差が 2^20 近くになり積が double で丸められるので、誤差なしの計算まで進む (roundedCount で確認する)
+	{
+		std::uniform_int_distribution<int64_t> base(-(int64_t(1) << 17), int64_t(1) << 17);
+		std::uniform_int_distribution<int64_t> edge(-(int64_t(1) << 17), int64_t(1) << 17);
+		std::uniform_int_distribution<int64_t> factor(-3, 3);
+		std::uniform_int_distribution<int> nudge(-1, 1);
+		for (uint32_t n = 0; n < 20000; n++) {
+			int64_t a[3], b[3], c[3], d[3];
+			int64_t i = factor(random), j = factor(random);
+			bool isNudged = n % 2 == 1;
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				int64_t u = edge(random), v = edge(random);
+				a[axis] = base(random);
+				b[axis] = a[axis] + u;
+				c[axis] = a[axis] + v;
+				d[axis] = a[axis] + i * u + j * v + (isNudged ? nudge(random) : 0);
+			}
+			check3(a, b, c, d);
+			// 同じ直線上の3点を含む場合 (d が a と b を結ぶ直線上)
+			if (n % 8 == 0) {
+				int64_t e[3];
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					e[axis] = a[axis] + i * (b[axis] - a[axis]);
+				}
+				check3(a, b, c, e);
+				check3(a, b, e, c);
+			}
+		}
+	}
+
+	// 同じ円周上の12点 ((5, -3, -2) の並べ替えと符号の反転、x + y + z = 0 の平面上で原点から √38) から選んだ4点は同じ平面上
+	// 平面から格子1つ分ずらした点も混ぜる
+	{
+		std::vector<std::array<int64_t, 3>> circle;
+		const int64_t kCoordinate[3] = { 5, -3, -2 };
+		const uint32_t kPermutation[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+		const int64_t kScale = 20011;
+		const int64_t kOffset[3] = { 70001, -90007, 30011 };
+		for (int64_t sign : { 1, -1 }) {
+			for (const uint32_t* permutation : kPermutation) {
+				std::array<int64_t, 3> point;
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					point[axis] = sign * kCoordinate[permutation[axis]] * kScale + kOffset[axis];
+				}
+				circle.push_back(point);
+			}
+		}
+		std::array<int64_t, 3> offPlane = { kOffset[0] + 1, kOffset[1], kOffset[2] };
+		circle.push_back(offPlane);
+		for (size_t i = 0; i < circle.size(); i++) {
+			for (size_t j = i + 1; j < circle.size(); j++) {
+				for (size_t k = j + 1; k < circle.size(); k++) {
+					for (size_t l = k + 1; l < circle.size(); l++) {
+						check3(circle[i].data(), circle[j].data(), circle[k].data(), circle[l].data());
+					}
+				}
+			}
+		}
+	}
+
+	// 平面上の同じ直線上の点 c = a + k(b - a) と、そこから格子1つ分ずらした点
+	// 指数の異なる値を混ぜ、差の積が double で丸められるようにする (float で表せない点は使わない)
+	{
+		std::uniform_int_distribution<int64_t> mantissa(-(int64_t(1) << 23), int64_t(1) << 23);
+		std::uniform_int_distribution<int> exponent(0, 5);
+		std::uniform_int_distribution<int64_t> factor(-2, 3);
+		std::uniform_int_distribution<int> nudge(-1, 1);
+		auto value = [&]() { return mantissa(random) * (int64_t(1) << exponent(random)); };
+		for (uint32_t n = 0; n < 20000; n++) {
+			int64_t a[2] = { value(), value() };
+			int64_t b[2] = { value(), value() };
+			int64_t k = factor(random);
+			int64_t c[2];
+			for (uint32_t axis = 0; axis < 2; axis++) {
+				c[axis] = a[axis] + k * (b[axis] - a[axis]) + (n % 2 == 1 ? nudge(random) : 0);
+			}
+			bool isValid = true;
+			for (const int64_t* p : { a, b, c }) {
+				for (uint32_t axis = 0; axis < 2; axis++) {
+					isValid &= IsExactFloat(p[axis]);
+				}
+			}
+			if (isValid) {
+				check2(a, b, c, kOrient2DGrid);
+			}
+		}
+	}
+
+	// 直線 y = x 上の大きな2点 (1/8 刻み、2^20 程度) と、原点近くの小さな点 (1/2^31 刻み、1/256 程度) を格子1つ分ずらした点
+	// 差の有効桁が 50bit 程度になって積が double で丸められるため、素直に計算すると符号を誤る点が混ざる
+	{
+		const float kFineGrid = 1.0f / float(int64_t(1) << 31);
+		std::uniform_int_distribution<int64_t> large(-(int64_t(1) << 23), int64_t(1) << 23);
+		std::uniform_int_distribution<int64_t> gap(1, 64);
+		std::uniform_int_distribution<int64_t> small(1, (int64_t(1) << 23) - 2);
+		std::uniform_int_distribution<int64_t> nudge(-1, 1);
+		for (uint32_t n = 0; n < 20000; n++) {
+			int64_t x = large(random), y = x + gap(random);
+			const int64_t a[2] = { x << 28, x << 28 };
+			const int64_t b[2] = { y << 28, y << 28 };
+			int64_t t = (int64_t(1) << 23) + small(random);
+			const int64_t c[2] = { t, t + nudge(random) };
+			check2(a, b, c, kFineGrid);
+			check2(c, a, b, kFineGrid);
+		}
+	}
+
+	// 同じ円周上の格子点 (x² + y² = 65²) の向き
+	{
+		const int64_t kCircle[][2] = { { 65, 0 }, { 63, 16 }, { 60, 25 }, { 56, 33 }, { 52, 39 }, { 39, 52 }, { 33, 56 }, { 25, 60 }, { 16, 63 }, { 0, 65 },
+			{ -63, 16 }, { -52, -39 }, { 33, -56 } };
+		const int64_t kScale = 1 << 16;
+		const int64_t kOffset[2] = { 300007, -200003 };
+		std::vector<std::array<int64_t, 2>> circle;
+		for (const int64_t* point : kCircle) {
+			circle.push_back({ point[0] * kScale + kOffset[0], point[1] * kScale + kOffset[1] });
+		}
+		for (size_t i = 0; i < circle.size(); i++) {
+			for (size_t j = 0; j < circle.size(); j++) {
+				for (size_t k = 0; k < circle.size(); k++) {
+					check2(circle[i].data(), circle[j].data(), circle[k].data(), kOrient2DGrid);
+				}
+			}
+		}
+	}
+
+	failCount += CheckResult("Orient2D/Orient3D match exact reference", mismatchCount == 0, true);
+	// 誤差なしの計算が必要な入力を含んでいなければ確認になっていない
+	failCount += CheckResult("cases that need exact arithmetic", roundedCount > 0, true);
+	std::fprintf(stderr, "  %d cases, %d exactly degenerate, %d rounded in double, %d mismatches\n", caseCount, degenerateCount, roundedCount, mismatchCount);
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyEventStream を書き手1つ、読み手複数のスレッドで動かし、
+/// 読み手ごとに書いた順に重複なく届き、届いた数と捨てた数の和が書いた数と一致することを確認する関数
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestEventStream() {
+
+	const uint32_t kEventCount = 400000;
+	const size_t kCapacity = 256;
+	const uint32_t kConsumerCount = 3;
+
+	int failCount = 0;
+	MyEventStream stream(kCapacity);
+
+	// 読み手ごとの結果 (各スレッドだけが書き込む)
+	struct ConsumerResult {
+		uint32_t id; // 読み手の番号
+		uint64_t receivedCount; // 受け取った数
+		uint32_t orderErrorCount; // 前に受け取ったもの以前の番号が届いた数 (順序の逆転と重複)
+		uint32_t payloadErrorCount; // 中身が書いたものと異なる数
+	};
+	ConsumerResult results[kConsumerCount] = {};
+	for (uint32_t i = 0; i < kConsumerCount; i++) {
+		results[i].id = stream.AddConsumer();
+	}
+
+	// 書き手が書き終えたか、半分まで書き終えたか
+	std::atomic<bool> isFinished = false;
+	std::atomic<bool> isHalfway = false;
+
+	// 読み手0は書き手が半分書き終えるまで読まないので必ずリングがあふれる
+	// 読み手1は少しずつ読み、読み手2はまとめて読む
+	auto consume = [&](uint32_t index) {
+		ConsumerResult& result = results[index];
+		const size_t kDrainCount[kConsumerCount] = { 64, 7, kCapacity };
+		if (index == 0) {
+			while (!isHalfway.load()) {
+				std::this_thread::yield();
+			}
+		}
+
+		CollisionEvent events[kCapacity];
+		int64_t last = -1;
+		while (true) {
+			// 書き終えたことを先に確認してから読み、何も無ければ全て受け取っている
+			bool isDone = isFinished.load();
+			size_t count = stream.Drain(result.id, events, kDrainCount[index]);
+			for (size_t i = 0; i < count; i++) {
+				uint32_t sequence = events[i].frame;
+				result.orderErrorCount += int64_t(sequence) <= last;
+				result.payloadErrorCount += events[i].pair.handleA != sequence * 3u || events[i].pair.handleB != ~sequence;
+				last = sequence;
+			}
+			result.receivedCount += count;
+			if (count == 0) {
+				if (isDone) {
+					break;
+				}
+				std::this_thread::yield();
+			}
+		}
+	};
+
+	std::vector<std::thread> consumers;
+	for (uint32_t i = 0; i < kConsumerCount; i++) {
+		consumers.emplace_back(consume, i);
+	}
+
+	// 1から50個ずつ、時々リングより多い数をまとめて書き込む
+	std::vector<CollisionEvent> batch(kCapacity + 64);
+	uint32_t sequence = 0;
+	for (uint32_t n = 0; sequence < kEventCount; n++) {
+		uint32_t count = n % 97 == 0 ? uint32_t(batch.size()) : 1 + n % 50;
+		count = std::min(count, kEventCount - sequence);
+		for (uint32_t i = 0; i < count; i++, sequence++) {
+			batch[i] = { sequence, { sequence * 3u, ~sequence, PairEvent::kEnter } };
+		}
+		stream.Publish(batch.data(), count);
+		if (sequence >= kEventCount / 2) {
+			isHalfway.store(true);
+		}
+		// CPU が少ない環境でも読み手が並行して動くように譲る
+		std::this_thread::yield();
+	}
+	isFinished.store(true);
+	for (std::thread& consumer : consumers) {
+		consumer.join();
+	}
+
+	for (uint32_t i = 0; i < kConsumerCount; i++) {
+		const ConsumerResult& result = results[i];
+		uint64_t droppedCount = stream.GetDroppedCount(result.id);
+		std::string name = "consumer " + std::to_string(i);
+		failCount += CheckResult((name + " in order without duplicates").c_str(), result.orderErrorCount == 0, true);
+		failCount += CheckResult((name + " payload intact").c_str(), result.payloadErrorCount == 0, true);
+		failCount += CheckResult((name + " received + dropped == published").c_str(), result.receivedCount + droppedCount == kEventCount, true);
+		std::fprintf(stderr, "  consumer %u: received %llu dropped %llu\n", i, static_cast<unsigned long long>(result.receivedCount), static_cast<unsigned long long>(droppedCount));
+	}
+	// 読み手0のリングがあふれていなければ捨てる処理を確認できていない
+	failCount += CheckResult("consumer 0 overflowed", stream.GetDroppedCount(results[0].id) > 0, true);
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyPhysicsWorld の動作を確認する関数
+/// 平面に落とした球が静止して kTimeToSleep 後に眠ること、力積、速度の設定、他の剛体の衝突、
+/// 動かない剛体の移動で起きること、反発係数どおりに跳ね返ること、Step の計算回数の上限を確認する
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestPhysics() {
+
+	const float kTimeStep = 1.0f / 60.0f;
+	const float kRadius = 0.5f;
+	// 静止した位置の許容誤差 (めり込みの許容量より十分大きく、球の大きさより十分小さい)
+	const float kRestTolerance = 0.02f;
+
+	int failCount = 0;
+
+	// 指定した時間だけ時間刻みずつ進める
+	auto run = [&](MyPhysicsWorld& world, float seconds) {
+		for (uint32_t i = 0; i < uint32_t(seconds / kTimeStep + 0.5f); i++) {
+			world.Step(kTimeStep);
+		}
+	};
+	// 眠るまで進め、眠るまでの時間を返す (眠らなければ負の値)
+	auto runUntilSleep = [&](MyPhysicsWorld& world, uint32_t bodyId, float maxSeconds) {
+		for (uint32_t i = 0; i < uint32_t(maxSeconds / kTimeStep); i++) {
+			world.Step(kTimeStep);
+			if (world.IsSleeping(bodyId)) {
+				return float(i + 1) * kTimeStep;
+			}
+		}
+		return -1.0f;
+	};
+	auto isResting = [&](const MyPhysicsWorld& world, uint32_t bodyId, float height) {
+		return std::fabs(world.GetBody(bodyId).sphere.center.y - height) <= kRestTolerance;
+	};
+
+	// 平面に落とした球は平面上で静止して眠り、眠っている間は動かない
+	{
+		MyPhysicsWorld world(kTimeStep);
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		uint32_t ball = world.CreateBody({ { 0.0f, 3.0f, 0.0f }, kRadius }, 1.0f);
+		float sleepTime = runUntilSleep(world, ball, 10.0f);
+		failCount += CheckResult("dropped ball sleeps", sleepTime > 0.0f, true);
+		failCount += CheckResult("dropped ball rests on plane", isResting(world, ball, kRadius), true);
+		Vector3 restCenter = world.GetBody(ball).sphere.center;
+		run(world, 1.0f);
+		failCount += CheckResult("sleeping ball does not move", world.IsSleeping(ball) && world.GetBody(ball).sphere.center.y == restCenter.y, true);
+
+		// 速度の設定と力積で起きる
+		world.SetVelocity(ball, { 0.0f, 3.0f, 0.0f });
+		failCount += CheckResult("SetVelocity wakes", world.IsSleeping(ball), false);
+		run(world, 0.1f);
+		failCount += CheckResult("woken ball moves", world.GetBody(ball).sphere.center.y > restCenter.y, true);
+		failCount += CheckResult("ball sleeps again", runUntilSleep(world, ball, 10.0f) > 0.0f, true);
+		world.ApplyImpulse(ball, { 0.5f, 0.0f, 0.0f });
+		failCount += CheckResult("ApplyImpulse wakes", world.IsSleeping(ball), false);
+	}
+
+	// 平面上に置いた球は kTimeToSleep の間は起きていて、過ぎたら眠る
+	{
+		MyPhysicsWorld world(kTimeStep);
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		uint32_t ball = world.CreateBody({ { 0.0f, kRadius, 0.0f }, kRadius }, 1.0f);
+		run(world, MyPhysicsWorld::kTimeToSleep - 0.1f);
+		failCount += CheckResult("awake before kTimeToSleep", world.IsSleeping(ball), false);
+		run(world, 0.2f);
+		failCount += CheckResult("asleep after kTimeToSleep", world.IsSleeping(ball), true);
+	}
+
+	// 眠っている球に別の球が当たると起き、離れた球は眠ったまま
+	{
+		MyPhysicsWorld world(kTimeStep);
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		uint32_t target = world.CreateBody({ { 0.0f, kRadius, 0.0f }, kRadius }, 1.0f);
+		uint32_t bystander = world.CreateBody({ { 10.0f, kRadius, 0.0f }, kRadius }, 1.0f);
+		run(world, 1.0f);
+		failCount += CheckResult("target sleeps", world.IsSleeping(target) && world.IsSleeping(bystander), true);
+
+		world.CreateBody({ { 0.2f, 4.0f, 0.0f }, kRadius }, 1.0f);
+		bool isWoken = false;
+		for (uint32_t i = 0; i < 120 && !isWoken; i++) {
+			world.Step(kTimeStep);
+			isWoken = !world.IsSleeping(target);
+		}
+		failCount += CheckResult("hit wakes target", isWoken, true);
+		failCount += CheckResult("bystander keeps sleeping", world.IsSleeping(bystander), true);
+	}
+
+	// 動かない剛体を動かすと、載っていた球と移動先で触れた球が起きる
+	{
+		MyPhysicsWorld world(kTimeStep);
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		uint32_t pedestal = world.CreateBody({ { 0.0f, 1.0f, 0.0f }, 1.0f }, 0.0f);
+		uint32_t rider = world.CreateBody({ { 0.0f, 2.0f + kRadius, 0.0f }, kRadius }, 1.0f);
+		uint32_t neighbour = world.CreateBody({ { 10.0f, kRadius, 0.0f }, kRadius }, 1.0f);
+		run(world, 2.0f);
+		failCount += CheckResult("rider sleeps on pedestal", world.IsSleeping(rider) && isResting(world, rider, 2.0f + kRadius), true);
+
+		world.SetPosition(pedestal, { 10.0f, 1.0f, 0.0f });
+		failCount += CheckResult("moving support wakes rider", world.IsSleeping(rider), false);
+		failCount += CheckResult("moving into body wakes it", world.IsSleeping(neighbour), false);
+		run(world, 2.0f);
+		failCount += CheckResult("rider falls to plane", isResting(world, rider, kRadius), true);
+	}
+
+	// 反発係数 e の球を高さ h から落とすと、最初に跳ね返った高さは e²h 程度になる
+	for (float restitution : { 0.0f, 0.5f, 0.8f }) {
+		const float kDropHeight = 4.5f;
+		MyPhysicsWorld world(kTimeStep);
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		uint32_t ball = world.CreateBody({ { 0.0f, kRadius + kDropHeight, 0.0f }, kRadius }, 1.0f, {}, restitution);
+
+		// 最初に上向きになってから下向きになるまでの最高点
+		bool isBounced = false;
+		float peak = kRadius;
+		for (uint32_t i = 0; i < 300; i++) {
+			world.Step(kTimeStep);
+			const SphereBody& body = world.GetBody(ball);
+			if (body.velocity.y > 0.0f) {
+				isBounced = true;
+			}
+			if (isBounced) {
+				if (body.velocity.y < 0.0f) {
+					break;
+				}
+				peak = std::fmax(peak, body.sphere.center.y);
+			}
+		}
+		float expected = restitution * restitution * kDropHeight;
+		float bounceHeight = peak - kRadius;
+		char name[64];
+		std::snprintf(name, sizeof(name), "bounce e=%.1f height %.2f (expected %.2f)", restitution, bounceHeight, expected);
+		// めり込みの押し戻しで速度が加わる分 (数 cm) は跳ね返りとみなさない
+		failCount += CheckResult(name, std::fabs(bounceHeight - expected) <= 0.1f * kDropHeight * restitution + 0.05f, true);
+	}
+
+	// 大きな経過時間でも kMaxSubStepCount 回だけ計算し、残りは捨てた数に数える
+	{
+		MyPhysicsWorld world(kTimeStep);
+		world.CreateBody({ { 0.0f, 100.0f, 0.0f }, kRadius }, 1.0f);
+		uint32_t stepCount = world.Step(1.0f);
+		failCount += CheckResult("large deltaTime capped at kMaxSubStepCount", stepCount == MyPhysicsWorld::kMaxSubStepCount, true);
+		failCount += CheckResult("large deltaTime drops steps", world.GetDroppedStepCount() > 0, true);
+		float alpha = world.GetInterpolationAlpha();
+		failCount += CheckResult("alpha stays in [0, 1)", alpha >= 0.0f && alpha < 1.0f, true);
+		uint64_t droppedCount = world.GetDroppedStepCount();
+		failCount += CheckResult("small deltaTime runs one step", world.Step(kTimeStep) == 1 && world.GetDroppedStepCount() == droppedCount, true);
+	}
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyMortonOrder の動作を確認する関数
+/// 符号の各軸のビットの配置と範囲の角の符号、並べ替えの結果が符号の安定ソートと一致することを
+/// 全体の並べ直し、挿入ソートでの並べ直し、挿入ソートから基数ソートに切り替えた場合で確認する
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestMortonOrder() {
+
+	int failCount = 0;
+
+	for (MortonBits bits : { MortonBits::k30, MortonBits::k63 }) {
+		const uint32_t kBitCount = bits == MortonBits::k30 ? 10 : 21;
+		const uint32_t kMaxValue = (1u << kBitCount) - 1;
+		const uint64_t kAllBits = (uint64_t(1) << (kBitCount * 3)) - 1;
+		const char* bitsName = bits == MortonBits::k30 ? "30" : "63";
+		auto encode = [&](const Vector3& point, const AABB& bounds) {
+			return bits == MortonBits::k30 ? uint64_t(MyMortonOrder::Encode30(point, bounds)) : MyMortonOrder::Encode63(point, bounds);
+		};
+		char name[96];
+
+		// 格子の番号がそのまま座標になる範囲で、各軸の各ビットが 3bit ごとの決まった位置に入って取り出せる
+		// (格子の中央の座標を渡して、量子化の丸めの誤差で隣の番号にならないようにする)
+		AABB cellBounds = { { 0.0f, 0.0f, 0.0f }, { float(kMaxValue), float(kMaxValue), float(kMaxValue) } };
+		uint32_t bitMismatchCount = 0;
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			for (uint32_t bit = 0; bit < kBitCount; bit++) {
+				Vector3 point = { 0.5f, 0.5f, 0.5f };
+				(&point.x)[axis] = float(1u << bit) + 0.5f;
+				uint64_t code = encode(point, cellBounds);
+				uint32_t cell[3];
+				ReferenceDecodeMorton(code, kBitCount, cell);
+				uint32_t expected[3] = { 0, 0, 0 };
+				expected[axis] = 1u << bit;
+				if (code != uint64_t(1) << (bit * 3 + 2 - axis) || cell[0] != expected[0] || cell[1] != expected[1] || cell[2] != expected[2]) {
+					bitMismatchCount++;
+				}
+			}
+		}
+		std::snprintf(name, sizeof(name), "Encode%s axis bits", bitsName);
+		failCount += CheckResult(name, bitMismatchCount == 0, true);
+
+		std::mt19937 random(49);
+		std::uniform_int_distribution<uint32_t> cellDistribution(0, kMaxValue);
+		uint32_t roundTripMismatchCount = 0;
+		for (uint32_t i = 0; i < 10000; i++) {
+			uint32_t expected[3] = { cellDistribution(random), cellDistribution(random), cellDistribution(random) };
+			uint32_t cell[3];
+			ReferenceDecodeMorton(encode({ float(expected[0]) + 0.5f, float(expected[1]) + 0.5f, float(expected[2]) + 0.5f }, cellBounds), kBitCount, cell);
+			if (cell[0] != expected[0] || cell[1] != expected[1] || cell[2] != expected[2]) {
+				roundTripMismatchCount++;
+			}
+		}
+		std::snprintf(name, sizeof(name), "Encode%s round trip", bitsName);
+		failCount += CheckResult(name, roundTripMismatchCount == 0, true);
+
+		// 範囲の角は全て0、全て1、x軸だけ1、範囲の外は角に丸められる
+		AABB bounds = { { -3.0f, 2.0f, -1.0f }, { 5.0f, 7.0f, 4.0f } };
+		const uint64_t kXBits = kAllBits / 7 * 4;
+		std::snprintf(name, sizeof(name), "Encode%s corners", bitsName);
+		failCount += CheckResult(name,
+			encode(bounds.min, bounds) == 0 && encode(bounds.max, bounds) == kAllBits &&
+			encode({ bounds.max.x, bounds.min.y, bounds.min.z }, bounds) == kXBits &&
+			encode({ -100.0f, -100.0f, -100.0f }, bounds) == 0 && encode({ 100.0f, 100.0f, 100.0f }, bounds) == kAllBits, true);
+
+		// 並べ替えの結果を、前回の順序を符号で安定ソートしたものと比べる
+		// (基数ソートも挿入ソートも安定なので、同じ符号の要素は前回の順序のまま並ぶ)
+		for (uint32_t workerCount : { 1u, 4u }) {
+			// 2スレッド以上で基数ソートするには1スレッドあたり 16384 個より多く必要
+			const size_t kCount = workerCount == 1 ? 5000 : 40000;
+			MyMortonOrder morton(bits, workerCount);
+
+			// 同じ符号の要素ができるように粗い格子の上に置く
+			std::uniform_int_distribution<int> gridDistribution(0, 63);
+			std::vector<Vector3> centroids(kCount);
+			for (Vector3& centroid : centroids) {
+				centroid = { float(gridDistribution(random)), float(gridDistribution(random)), float(gridDistribution(random)) };
+			}
+			// 範囲が変わらないように角に2点を固定する
+			centroids[0] = { 0.0f, 0.0f, 0.0f };
+			centroids[1] = { 63.0f, 63.0f, 63.0f };
+
+			std::vector<uint32_t> previousOrder(kCount);
+			for (size_t i = 0; i < kCount; i++) {
+				previousOrder[i] = uint32_t(i);
+			}
+			auto check = [&](const char* caseName) {
+				std::vector<uint64_t> codes = ReferenceMortonCodes(centroids, bits);
+				std::vector<uint32_t> expected = previousOrder;
+				std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+				const std::vector<uint32_t>& order = morton.GetOrder();
+				const std::vector<uint32_t>& remap = morton.GetRemap();
+				bool isMatched = order == expected && remap.size() == kCount;
+				for (size_t i = 0; isMatched && i < kCount; i++) {
+					isMatched = remap[order[i]] == i;
+				}
+				std::snprintf(name, sizeof(name), "Morton%s %u worker %s", bitsName, workerCount, caseName);
+				previousOrder = order;
+				return CheckResult(name, isMatched, true);
+			};
+
+			morton.Update(centroids.data(), kCount);
+			failCount += check("full sort");
+
+			// 少しの要素を少しだけ動かすと挿入ソートで並べ直す
+			for (size_t i = 2; i < kCount; i += 500) {
+				centroids[i].x = std::min(centroids[i].x + 1.0f, 63.0f);
+			}
+			MortonSortStats before = morton.GetStats();
+			morton.Update(centroids.data(), kCount);
+			failCount += check("incremental");
+			std::snprintf(name, sizeof(name), "Morton%s %u worker uses insertion sort", bitsName, workerCount);
+			failCount += CheckResult(name, morton.GetStats().incrementalCount == before.incrementalCount + 1 && morton.GetStats().fallbackCount == before.fallbackCount, true);
+
+			// 並びの先頭の要素を反対の角へ動かすと、隣り合う逆転は少ないが移動が多いので基数ソートに切り替える
+			for (size_t i = 0; i < 16; i++) {
+				uint32_t index = previousOrder[i + 1];
+				if (index > 1) {
+					centroids[index] = { 63.0f, 63.0f, 62.0f };
+				}
+			}
+			before = morton.GetStats();
+			morton.Update(centroids.data(), kCount);
+			failCount += check("fallback");
+			std::snprintf(name, sizeof(name), "Morton%s %u worker falls back to radix sort", bitsName, workerCount);
+			failCount += CheckResult(name, morton.GetStats().fallbackCount == before.fallbackCount + 1 && morton.GetStats().radixCount == before.radixCount + 1, true);
+		}
+	}
+
+	return failCount;
+
+}
+
+/// <summary>
+/// MyGJK の動作を確認する関数
+/// 箱、カプセル、球の組を離れた位置、接する位置、めり込んだ位置に置いて距離とめり込みを解析解と比べ、
+/// 中心が一致する場合や平らな点群などの退化した単体でも結果が求まることを確認する
+/// </summary>
+/// <returns>失敗した数</returns>
+int MySelfTest::TestGJK() {
+
+	// 距離とめり込み量の許容誤差
+	const float kTolerance = 1.0e-3f;
+	// 法線の向きの許容誤差 (期待する向きとの内積の下限)
+	const float kMinNormalDot = 0.999f;
+
+	int failCount = 0;
+	char name[128];
+
+	// 回転していない配置と、全体を回転した配置で確かめる
+	const Vector3 kRotations[] = { { 0.0f, 0.0f, 0.0f }, { 0.3f, 1.1f, -0.7f }, { -2.0f, 0.4f, 2.5f } };
+	for (const Vector3& rotation : kRotations) {
+		Matrix4x4 rotateMatrix = MyMath::MakeRotateXYZMatrix(rotation);
+		const Vector3 kAxis[3] = {
+			MyMath::Transform({ 1.0f, 0.0f, 0.0f }, rotateMatrix),
+			MyMath::Transform({ 0.0f, 1.0f, 0.0f }, rotateMatrix),
+			MyMath::Transform({ 0.0f, 0.0f, 1.0f }, rotateMatrix),
+		};
+
+		// x軸方向に offset だけ離した、x軸方向の半径がどれも1の形状
+		// (カプセルは y軸方向の芯なので、x軸方向の最近点は側面になる)
+		const char* kShapeNames[] = { "box", "capsule", "sphere" };
+		auto makeShape = [&](uint32_t type, float offset) -> ConvexShape {
+			Vector3 center = MyMath::Multiply(offset, kAxis[0]);
+			if (type == 0) {
+				return OBB{ center, { kAxis[0], kAxis[1], kAxis[2] }, { 1.0f, 1.0f, 1.0f } };
+			}
+			if (type == 1) {
+				return Capsule{ { center - kAxis[1], MyMath::Multiply(2.0f, kAxis[1]) }, 1.0f };
+			}
+			return Sphere{ center, 1.0f };
+		};
+
+		// 中心の間隔と、期待する距離 (負ならめり込み量)
+		// 間隔 0.5 では芯の形状も重なるので、球と球以外は EPA で求める
+		const float kOffsets[] = { 3.0f, 2.0f, 1.5f, 0.5f };
+		for (uint32_t typeA = 0; typeA < 3; typeA++) {
+			for (uint32_t typeB = typeA; typeB < 3; typeB++) {
+				for (float offset : kOffsets) {
+					ConvexShape a = makeShape(typeA, 0.0f);
+					ConvexShape b = makeShape(typeB, offset);
+					float expected = offset - 2.0f;
+
+					GJKResult distance = MyGJK::Distance(a, b);
+					PenetrationResult penetration = MyGJK::Penetration(a, b);
+					bool isPassed = false;
+					if (expected > 0.0f) {
+						// 離れている: 距離と最近点の間の長さが一致し、めり込んでいない
+						isPassed = !distance.isIntersect && std::fabs(distance.distance - expected) <= kTolerance &&
+							std::fabs(MyMath::Length(distance.closestB - distance.closestA) - expected) <= kTolerance &&
+							!penetration.isIntersect;
+					}
+					else if (expected == 0.0f) {
+						// 接している: 距離もめり込み量もほぼ0
+						isPassed = distance.distance <= kTolerance && (!penetration.isIntersect || penetration.depth <= kTolerance);
+					}
+					else {
+						// めり込んでいる: めり込み量と法線 (AからB) が x軸方向の解析解と一致する
+						isPassed = distance.isIntersect && distance.distance == 0.0f && penetration.isIntersect &&
+							std::fabs(penetration.depth + expected) <= kTolerance &&
+							MyMath::Dot(penetration.normal, kAxis[0]) >= kMinNormalDot;
+					}
+					std::snprintf(name, sizeof(name), "%s-%s offset %.1f rotation %.1f: distance %.4f depth %.4f",
+						kShapeNames[typeA], kShapeNames[typeB], offset, rotation.x, distance.distance, penetration.depth);
+					failCount += CheckResult(name, isPassed, true);
+				}
+			}
+		}
+
+		// 球と球のめり込みを、中心を結ぶ向きがさまざまな場合に解析解と比べる
+		std::mt19937 random(27);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		uint32_t sphereMismatchCount = 0;
+		for (uint32_t i = 0; i < 200; i++) {
+			Sphere sphereA = { { distribution(random), distribution(random), distribution(random) }, 0.5f + 0.5f * std::fabs(distribution(random)) };
+			Sphere sphereB = { { distribution(random), distribution(random), distribution(random) }, 0.5f + 0.5f * std::fabs(distribution(random)) };
+			Vector3 diff = sphereB.center - sphereA.center;
+			float centerDistance = MyMath::Length(diff);
+			if (centerDistance < 0.01f || centerDistance >= sphereA.radius + sphereB.radius) {
+				continue;
+			}
+			PenetrationResult penetration = MyGJK::Penetration(sphereA, sphereB);
+			if (!penetration.isIntersect || std::fabs(penetration.depth - (sphereA.radius + sphereB.radius - centerDistance)) > kTolerance ||
+				MyMath::Dot(penetration.normal, MyMath::Multiply(1.0f / centerDistance, diff)) < kMinNormalDot) {
+				sphereMismatchCount++;
+			}
+		}
+		std::snprintf(name, sizeof(name), "sphere-sphere random rotation %.1f", rotation.x);
+		failCount += CheckResult(name, sphereMismatchCount == 0, true);
+
+		// 箱と箱のめり込みを、重なりが最も小さい軸の解析解と比べる (EPA)
+		uint32_t boxMismatchCount = 0;
+		uint32_t boxCaseCount = 0;
+		for (uint32_t i = 0; i < 200; i++) {
+			Vector3 sizeA = { 0.5f + 0.5f * std::fabs(distribution(random)), 0.5f + 0.5f * std::fabs(distribution(random)), 0.5f + 0.5f * std::fabs(distribution(random)) };
+			Vector3 sizeB = { 0.5f + 0.5f * std::fabs(distribution(random)), 0.5f + 0.5f * std::fabs(distribution(random)), 0.5f + 0.5f * std::fabs(distribution(random)) };
+			Vector3 local = { distribution(random), distribution(random), distribution(random) };
+
+			// 各軸の重なりのうち最も小さいものが解析解 (2番目との差が小さい場合は法線が定まらないので除く)
+			float overlap[3];
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				overlap[axis] = (&sizeA.x)[axis] + (&sizeB.x)[axis] - std::fabs((&local.x)[axis]);
+			}
+			uint32_t minAxis = 0;
+			for (uint32_t axis = 1; axis < 3; axis++) {
+				if (overlap[axis] < overlap[minAxis]) {
+					minAxis = axis;
+				}
+			}
+			float secondOverlap = std::min(overlap[(minAxis + 1) % 3], overlap[(minAxis + 2) % 3]);
+			if (overlap[minAxis] <= 0.0f || secondOverlap - overlap[minAxis] < 0.05f) {
+				continue;
+			}
+			boxCaseCount++;
+
+			Vector3 centerB = MyMath::Multiply(local.x, kAxis[0]) + MyMath::Multiply(local.y, kAxis[1]) + MyMath::Multiply(local.z, kAxis[2]);
+			OBB boxA = { { 0.0f, 0.0f, 0.0f }, { kAxis[0], kAxis[1], kAxis[2] }, sizeA };
+			OBB boxB = { centerB, { kAxis[0], kAxis[1], kAxis[2] }, sizeB };
+			Vector3 expectedNormal = MyMath::Multiply((&local.x)[minAxis] < 0.0f ? -1.0f : 1.0f, kAxis[minAxis]);
+			PenetrationResult penetration = MyGJK::Penetration(boxA, boxB);
+			if (!penetration.isIntersect || std::fabs(penetration.depth - overlap[minAxis]) > kTolerance ||
+				MyMath::Dot(penetration.normal, expectedNormal) < kMinNormalDot) {
+				boxMismatchCount++;
+			}
+		}
+		std::snprintf(name, sizeof(name), "box-box EPA %u cases rotation %.1f", boxCaseCount, rotation.x);
+		failCount += CheckResult(name, boxCaseCount != 0 && boxMismatchCount == 0, true);
+	}
+
+	// 退化した単体: 中心が一致する球同士は芯が1点で重なるので方向が決まらないが、めり込み量は半径の和になる
+	{
+		PenetrationResult penetration = MyGJK::Penetration(Sphere{ { 1.0f, 2.0f, 3.0f }, 1.0f }, Sphere{ { 1.0f, 2.0f, 3.0f }, 0.5f });
+		failCount += CheckResult("coincident spheres", penetration.isIntersect && std::fabs(penetration.depth - 1.5f) <= kTolerance &&
+			std::fabs(MyMath::Length(penetration.normal) - 1.0f) <= kTolerance, true);
+	}
+	// 中心が一致する箱同士は、どの面の向きに押し出しても同じめり込み量になる
+	{
+		OBB box = { { 1.0f, 2.0f, 3.0f }, { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, { 1.0f, 1.0f, 1.0f } };
+		PenetrationResult penetration = MyGJK::Penetration(box, box);
+		float maxComponent = std::max({ std::fabs(penetration.normal.x), std::fabs(penetration.normal.y), std::fabs(penetration.normal.z) });
+		failCount += CheckResult("coincident boxes", penetration.isIntersect && std::fabs(penetration.depth - 2.0f) <= kTolerance && maxComponent >= kMinNormalDot, true);
+	}
+	// 平らな点群 (厚さ0の正方形) が箱に埋まっている場合は、面に垂直な向きに押し出す
+	{
+		const Vector3 kSquare[] = { { 0.0f, -0.5f, -0.5f }, { 0.0f, 0.5f, -0.5f }, { 0.0f, 0.5f, 0.5f }, { 0.0f, -0.5f, 0.5f } };
+		PointCloud square = { kSquare, 4 };
+		OBB box = { { 0.5f, 0.0f, 0.0f }, { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, { 1.0f, 1.0f, 1.0f } };
+		PenetrationResult penetration = MyGJK::Penetration(square, box);
+		failCount += CheckResult("flat point cloud in box", penetration.isIntersect && std::fabs(penetration.depth - 0.5f) <= kTolerance &&
+			penetration.normal.x >= kMinNormalDot, true);
+	}
+	// 1点だけの点群同士が一致する場合も結果が求まる
+	{
+		const Vector3 kPoint = { 1.0f, 1.0f, 1.0f };
+		PointCloud point = { &kPoint, 1 };
+		GJKResult distance = MyGJK::Distance(point, point);
+		PenetrationResult penetration = MyGJK::Penetration(point, point);
+		failCount += CheckResult("coincident points", distance.isIntersect && distance.distance == 0.0f && penetration.isIntersect &&
+			penetration.depth <= kTolerance && std::isfinite(penetration.normal.x), true);
+	}
+
+	return failCount;
+
+}
+
+/// <summary>
+/// コマンドラインで動作確認が指定されていれば実行する関数
+/// 形式: -selftest
+/// </summary>
+/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+/// <param name="exitCode">終了コードの格納先 (全て成功なら0)</param>
+/// <returns>動作確認が指定されていたか</returns>
+bool MySelfTest::RunCommandLine(const char* commandLine, int& exitCode) {
+
+	if (commandLine == nullptr) {
+		return false;
+	}
+
+	std::istringstream stream(commandLine);
+	std::string command;
+	if (!(stream >> command) || command != "-selftest") {
+		return false;
+	}
+
+	int failCount = 0;
+	std::fprintf(stderr, "fast math\n");
+	failCount += TestFastMath();
+	std::fprintf(stderr, "intersect\n");
+	failCount += TestIntersect();
+	std::fprintf(stderr, "predicate\n");
+	failCount += TestPredicate();
+	std::fprintf(stderr, "event stream\n");
+	failCount += TestEventStream();
+	std::fprintf(stderr, "physics\n");
+	failCount += TestPhysics();
+	std::fprintf(stderr, "morton order\n");
+	failCount += TestMortonOrder();
+	std::fprintf(stderr, "gjk\n");
+	failCount += TestGJK();
+
+	std::fprintf(stderr, "%s (%d failed)\n", failCount == 0 ? "passed" : "FAILED", failCount);
+	exitCode = failCount == 0 ? 0 : 1;
+	return true;
+
+}
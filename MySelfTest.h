@@ -0,0 +1,73 @@
+﻿#pragma once
+
+/// <summary>
+/// ウィンドウを開かずに実行できる動作確認をまとめたクラス
+/// 各関数は確認に失敗した数を返し、失敗した内容を標準エラー出力に表示する
+/// </summary>
+class MySelfTest
+{
+public:
+
+	/// <summary>
+	/// 高速近似演算 (FastInverseSqrt, FastSinCos とその一括版) の誤差が
+	/// MyMath.h に記載した上限以下であることを確認する関数
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestFastMath();
+
+	/// <summary>
+	/// MyIntersect の判定を確認する関数
+	/// 各軸に沿った直線と球、半直線とAABBなどの既知の結果と、
+	/// 直線、半直線と凸形状の判定が十分長い線分との判定と一致することを確認する
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestIntersect();
+
+	/// <summary>
+	/// MyPredicate の向きの判定が、整数の格子上の点で誤差なしに求めた符号と一致することを確認する関数
+	/// 同じ平面上、同じ直線上、同じ円周上の点と、そこから格子1つ分だけずらした点を含む
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestPredicate();
+
+	/// <summary>
+	/// MyEventStream を書き手1つ、読み手複数のスレッドで動かし、
+	/// 読み手ごとに書いた順に重複なく届き、届いた数と捨てた数の和が書いた数と一致することを確認する関数
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestEventStream();
+
+	/// <summary>
+	/// MyPhysicsWorld の動作を確認する関数
+	/// 平面に落とした球が静止して kTimeToSleep 後に眠ること、力積、速度の設定、他の剛体の衝突、
+	/// 動かない剛体の移動で起きること、反発係数どおりに跳ね返ること、Step の計算回数の上限を確認する
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestPhysics();
+
+	/// <summary>
+	/// MyMortonOrder の動作を確認する関数
+	/// 符号の各軸のビットの配置と範囲の角の符号、並べ替えの結果が符号の安定ソートと一致することを
+	/// 全体の並べ直し、挿入ソートでの並べ直し、挿入ソートから基数ソートに切り替えた場合で確認する
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestMortonOrder();
+
+	/// <summary>
+	/// MyGJK の動作を確認する関数
+	/// 箱、カプセル、球の組を離れた位置、接する位置、めり込んだ位置に置いて距離とめり込みを解析解と比べ、
+	/// 中心が一致する場合や平らな点群などの退化した単体でも結果が求まることを確認する
+	/// </summary>
+	/// <returns>失敗した数</returns>
+	static int TestGJK();
+
+	/// <summary>
+	/// コマンドラインで動作確認が指定されていれば実行する関数
+	/// 形式: -selftest
+	/// </summary>
+	/// <param name="commandLine">コマンドライン (プログラム名を含まない)</param>
+	/// <param name="exitCode">終了コードの格納先 (全て成功なら0)</param>
+	/// <returns>動作確認が指定されていたか</returns>
+	static bool RunCommandLine(const char* commandLine, int& exitCode);
+
+};
@@ -0,0 +1,249 @@
+﻿#include "MySocket.h"
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	/// <summary>
+	/// 直前の送受信が待ちで止まったか判定する関数
+	/// </summary>
+	/// <returns>待ちで止まったか</returns>
+	bool IsWouldBlock() {
+#ifdef _WIN32
+		return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+	}
+
+	/// <summary>
+	/// パスからソケットのアドレスを作成する関数
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <param name="address">格納先</param>
+	/// <returns>パスが長すぎないか</returns>
+	bool MakeAddress(const char* path, sockaddr_un& address) {
+
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		size_t length = std::strlen(path);
+		if (length >= sizeof(address.sun_path)) {
+			return false;
+		}
+		std::memcpy(address.sun_path, path, length);
+		return true;
+
+	}
+
+}
+
+#ifdef _WIN32
+const SocketHandle MySocket::kInvalidSocket = INVALID_SOCKET;
+#else
+const SocketHandle MySocket::kInvalidSocket = -1;
+#endif
+
+/// <summary>
+/// ソケットを使用する前に呼ぶ関数 (Windows 以外では何もしない)
+/// </summary>
+/// <returns>成功したか</returns>
+bool MySocket::Startup() {
+#ifdef _WIN32
+	WSADATA data;
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+	return true;
+#endif
+}
+
+/// <summary>
+/// ソケットを使い終わったら呼ぶ関数 (Startup と対にする)
+/// </summary>
+void MySocket::Cleanup() {
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+/// <summary>
+/// 指定したパスで接続の受付を開始する関数
+/// 同じパスのファイルが残っている場合は削除してから作成する
+/// </summary>
+/// <param name="path">ソケットのパス</param>
+/// <returns>受付用ソケット (失敗した場合は kInvalidSocket)</returns>
+SocketHandle MySocket::Listen(const char* path) {
+
+	sockaddr_un address;
+	if (!MakeAddress(path, address)) {
+		return kInvalidSocket;
+	}
+
+	SocketHandle listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket == kInvalidSocket) {
+		return kInvalidSocket;
+	}
+
+	// 前回の実行で残ったファイルがあると bind に失敗する
+	std::remove(path);
+
+	if (bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+		listen(listenSocket, SOMAXCONN) != 0 || !SetNonBlocking(listenSocket)) {
+		Close(listenSocket);
+		return kInvalidSocket;
+	}
+
+	return listenSocket;
+
+}
+
+/// <summary>
+/// 指定したパスに接続する関数
+/// </summary>
+/// <param name="path">ソケットのパス</param>
+/// <returns>接続したソケット (失敗した場合は kInvalidSocket)</returns>
+SocketHandle MySocket::Connect(const char* path) {
+
+	sockaddr_un address;
+	if (!MakeAddress(path, address)) {
+		return kInvalidSocket;
+	}
+
+	SocketHandle connectSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connectSocket == kInvalidSocket) {
+		return kInvalidSocket;
+	}
+
+	if (connect(connectSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		Close(connectSocket);
+		return kInvalidSocket;
+	}
+
+	return connectSocket;
+
+}
+
+/// <summary>
+/// 接続を受け付ける関数
+/// </summary>
+/// <param name="listenSocket">受付用ソケット</param>
+/// <returns>接続したソケット (待ちがない場合は kInvalidSocket)</returns>
+SocketHandle MySocket::Accept(SocketHandle listenSocket) {
+	return accept(listenSocket, nullptr, nullptr);
+}
+
+/// <summary>
+/// ソケットを閉じる関数
+/// </summary>
+/// <param name="socket">ソケット</param>
+void MySocket::Close(SocketHandle socket) {
+#ifdef _WIN32
+	closesocket(socket);
+#else
+	close(socket);
+#endif
+}
+
+/// <summary>
+/// ソケットを非ブロッキングにする関数
+/// </summary>
+/// <param name="socket">ソケット</param>
+/// <returns>成功したか</returns>
+bool MySocket::SetNonBlocking(SocketHandle socket) {
+#ifdef _WIN32
+	u_long isNonBlocking = 1;
+	return ioctlsocket(socket, FIONBIO, &isNonBlocking) == 0;
+#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/// <summary>
+/// 受信を進める関数
+/// 非ブロッキングのソケットでは受信できるだけ受信して kWouldBlock を返す
+/// </summary>
+/// <param name="socket">ソケット</param>
+/// <param name="buffer">格納先</param>
+/// <param name="size">受信するバイト数</param>
+/// <param name="filled">受信済みのバイト数 (受信した分だけ進める)</param>
+/// <returns>結果</returns>
+SocketResult MySocket::Receive(SocketHandle socket, void* buffer, size_t size, size_t& filled) {
+
+	char* bytes = static_cast<char*>(buffer);
+	while (filled < size) {
+#ifdef _WIN32
+		int result = recv(socket, bytes + filled, int(size - filled), 0);
+#else
+		ssize_t result = recv(socket, bytes + filled, size - filled, 0);
+#endif
+		if (result > 0) {
+			filled += size_t(result);
+		}
+		else if (result < 0 && IsWouldBlock()) {
+			return SocketResult::kWouldBlock;
+		}
+		else {
+			return SocketResult::kClosed;
+		}
+	}
+
+	return SocketResult::kDone;
+
+}
+
+/// <summary>
+/// 送信を進める関数
+/// 非ブロッキングのソケットでは送信できるだけ送信して kWouldBlock を返す
+/// </summary>
+/// <param name="socket">ソケット</param>
+/// <param name="buffer">送信するデータ</param>
+/// <param name="size">送信するバイト数</param>
+/// <param name="sent">送信済みのバイト数 (送信した分だけ進める)</param>
+/// <returns>結果</returns>
+SocketResult MySocket::Send(SocketHandle socket, const void* buffer, size_t size, size_t& sent) {
+
+	const char* bytes = static_cast<const char*>(buffer);
+	while (sent < size) {
+#ifdef _WIN32
+		int result = send(socket, bytes + sent, int(size - sent), 0);
+#else
+		// 切断済みの相手に送っても SIGPIPE で終了しないようにする
+		ssize_t result = send(socket, bytes + sent, size - sent, MSG_NOSIGNAL);
+#endif
+		if (result > 0) {
+			sent += size_t(result);
+		}
+		else if (result < 0 && IsWouldBlock()) {
+			return SocketResult::kWouldBlock;
+		}
+		else {
+			return SocketResult::kClosed;
+		}
+	}
+
+	return SocketResult::kDone;
+
+}
+
+/// <summary>
+/// 複数のソケットの状態の変化を待つ関数
+/// </summary>
+/// <param name="entries">待つソケットと状態の配列</param>
+/// <param name="count">配列の要素数</param>
+/// <param name="timeout">最大待ち時間 (ミリ秒、-1なら無制限)</param>
+/// <returns>状態が変化したソケットの数 (エラーの場合は負の値)</returns>
+int MySocket::Poll(PollEntry* entries, size_t count, int timeout) {
+#ifdef _WIN32
+	return WSAPoll(entries, ULONG(count), timeout);
+#else
+	return poll(entries, nfds_t(count), timeout);
+#endif
+}
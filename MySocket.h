@@ -0,0 +1,119 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ソケットの環境差をまとめるヘッダ
+// Windows のヘッダは Windows.h より先に読み込む必要があるため、.cpp からのみ読み込むこと
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+using SocketHandle = SOCKET;
+using PollEntry = WSAPOLLFD;
+#else
+#include <poll.h>
+using SocketHandle = int;
+using PollEntry = pollfd;
+#endif
+
+/// <summary>
+/// 送受信の結果
+/// </summary>
+enum class SocketResult {
+	kDone, // 指定したバイト数を全て送受信した
+	kWouldBlock, // 途中で待ちが必要になった
+	kClosed, // 切断された (エラーを含む)
+};
+
+/// <summary>
+/// ローカルのソケット (Unix ドメインソケット) を扱う関数を保持するクラス
+/// Windows 10 以降では afunix.h の AF_UNIX を使用する
+/// </summary>
+class MySocket
+{
+public:
+
+	// 無効なソケット
+	static const SocketHandle kInvalidSocket;
+
+	/// <summary>
+	/// ソケットを使用する前に呼ぶ関数 (Windows 以外では何もしない)
+	/// </summary>
+	/// <returns>成功したか</returns>
+	static bool Startup();
+
+	/// <summary>
+	/// ソケットを使い終わったら呼ぶ関数 (Startup と対にする)
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// 指定したパスで接続の受付を開始する関数
+	/// 同じパスのファイルが残っている場合は削除してから作成する
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <returns>受付用ソケット (失敗した場合は kInvalidSocket)</returns>
+	static SocketHandle Listen(const char* path);
+
+	/// <summary>
+	/// 指定したパスに接続する関数
+	/// </summary>
+	/// <param name="path">ソケットのパス</param>
+	/// <returns>接続したソケット (失敗した場合は kInvalidSocket)</returns>
+	static SocketHandle Connect(const char* path);
+
+	/// <summary>
+	/// 接続を受け付ける関数
+	/// </summary>
+	/// <param name="listenSocket">受付用ソケット</param>
+	/// <returns>接続したソケット (待ちがない場合は kInvalidSocket)</returns>
+	static SocketHandle Accept(SocketHandle listenSocket);
+
+	/// <summary>
+	/// ソケットを閉じる関数
+	/// </summary>
+	/// <param name="socket">ソケット</param>
+	static void Close(SocketHandle socket);
+
+	/// <summary>
+	/// ソケットを非ブロッキングにする関数
+	/// </summary>
+	/// <param name="socket">ソケット</param>
+	/// <returns>成功したか</returns>
+	static bool SetNonBlocking(SocketHandle socket);
+
+	/// <summary>
+	/// 受信を進める関数
+	/// 非ブロッキングのソケットでは受信できるだけ受信して kWouldBlock を返す
+	/// </summary>
+	/// <param name="socket">ソケット</param>
+	/// <param name="buffer">格納先</param>
+	/// <param name="size">受信するバイト数</param>
+	/// <param name="filled">受信済みのバイト数 (受信した分だけ進める)</param>
+	/// <returns>結果</returns>
+	static SocketResult Receive(SocketHandle socket, void* buffer, size_t size, size_t& filled);
+
+	/// <summary>
+	/// 送信を進める関数
+	/// 非ブロッキングのソケットでは送信できるだけ送信して kWouldBlock を返す
+	/// </summary>
+	/// <param name="socket">ソケット</param>
+	/// <param name="buffer">送信するデータ</param>
+	/// <param name="size">送信するバイト数</param>
+	/// <param name="sent">送信済みのバイト数 (送信した分だけ進める)</param>
+	/// <returns>結果</returns>
+	static SocketResult Send(SocketHandle socket, const void* buffer, size_t size, size_t& sent);
+
+	/// <summary>
+	/// 複数のソケットの状態の変化を待つ関数
+	/// </summary>
+	/// <param name="entries">待つソケットと状態の配列</param>
+	/// <param name="count">配列の要素数</param>
+	/// <param name="timeout">最大待ち時間 (ミリ秒、-1なら無制限)</param>
+	/// <returns>状態が変化したソケットの数 (エラーの場合は負の値)</returns>
+	static int Poll(PollEntry* entries, size_t count, int timeout);
+
+};
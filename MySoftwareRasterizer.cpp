@@ -0,0 +1,293 @@
+﻿#include "MySoftwareRasterizer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <execution>
+
+namespace {
+
+	/// <summary>
+	/// 主軸 (変化量の大きい軸) をuとした線の情報
+	/// </summary>
+	struct LineSteps {
+		bool isMajorX; // 主軸がxか
+		int u1; // 始点の主軸座標 (u が増える向きにそろえる)
+		int v1; // 始点の副軸座標
+		int du; // 主軸方向の変化量 (0以上)
+		int dv; // 副軸方向の変化量
+
+		/// <summary>
+		/// 主軸の位置から副軸の位置を四捨五入で求める関数 (整数演算)
+		/// </summary>
+		int GetV(int u) const {
+			if (du == 0) {
+				return v1;
+			}
+			long long numerator = 2LL * dv * (u - u1) + du;
+			long long denominator = 2LL * du;
+			long long quotient = numerator / denominator;
+			if (numerator < 0 && numerator % denominator != 0) {
+				quotient--;
+			}
+			return v1 + int(quotient);
+		}
+	};
+
+	/// <summary>
+	/// 2点から主軸をそろえた線の情報を作る関数
+	/// </summary>
+	LineSteps MakeLineSteps(int x1, int y1, int x2, int y2) {
+		LineSteps line{};
+		int dx = x2 - x1;
+		int dy = y2 - y1;
+		line.isMajorX = std::abs(dx) >= std::abs(dy);
+		line.u1 = line.isMajorX ? x1 : y1;
+		line.v1 = line.isMajorX ? y1 : x1;
+		line.du = line.isMajorX ? dx : dy;
+		line.dv = line.isMajorX ? dy : dx;
+		if (line.du < 0) {
+			line.u1 += line.du;
+			line.v1 += line.dv;
+			line.du = -line.du;
+			line.dv = -line.dv;
+		}
+		return line;
+	}
+
+	/// <summary>
+	/// 色を画像の色にアルファで合成する関数 (source-over)
+	/// </summary>
+	/// <param name="source">描画する色 (0xRRGGBBAA)</param>
+	/// <param name="destination">画像の色 (0xRRGGBBAA)</param>
+	/// <returns>合成後の色</returns>
+	uint32_t BlendColor(uint32_t source, uint32_t destination) {
+		uint32_t alpha = source & 0xFF;
+		if (alpha == 0xFF) {
+			return source;
+		}
+		if (alpha == 0) {
+			return destination;
+		}
+		// RGB は (source * alpha + destination * (255 - alpha)) / 255 を四捨五入する
+		uint32_t result = 0;
+		for (uint32_t shift = 8; shift < 32; shift += 8) {
+			uint32_t s = (source >> shift) & 0xFF;
+			uint32_t d = (destination >> shift) & 0xFF;
+			result |= ((s * alpha + d * (0xFF - alpha) + 0x7F) / 0xFF) << shift;
+		}
+		// アルファは alpha + destinationAlpha * (1 - alpha)
+		uint32_t destinationAlpha = destination & 0xFF;
+		return result | (alpha + (destinationAlpha * (0xFF - alpha) + 0x7F) / 0xFF);
+	}
+
+}
+
+/// <summary>
+/// 初期化
+/// </summary>
+/// <param name="width">画像の幅</param>
+/// <param name="height">画像の高さ</param>
+void MySoftwareRasterizer::Initialize(int width, int height) {
+
+	width_ = width;
+	height_ = height;
+	tileCountX_ = (width + kTileSize - 1) / kTileSize;
+	tileCountY_ = (height + kTileSize - 1) / kTileSize;
+	pixels_.assign(size_t(width) * height, 0x000000FF);
+	bins_.assign(size_t(tileCountX_) * tileCountY_, {});
+
+}
+
+/// <summary>
+/// 画像を1色で塗りつぶす関数
+/// </summary>
+/// <param name="color">色 (0xRRGGBBAA)</param>
+void MySoftwareRasterizer::Clear(uint32_t color) {
+
+	std::fill(pixels_.begin(), pixels_.end(), color);
+
+}
+
+/// <summary>
+/// 描画命令を実行する関数
+/// </summary>
+/// <param name="list">描画命令の配列</param>
+void MySoftwareRasterizer::Submit(const DrawCommandList& list) {
+
+	// 描画命令を線が通るタイルに振り分ける
+	for (uint32_t tile : activeTiles_) {
+		bins_[tile].clear();
+	}
+	activeTiles_.clear();
+
+	for (uint32_t i = 0; i < uint32_t(list.size()); i++) {
+		const DrawCommand& command = list[i];
+		switch (command.type) {
+		case DrawCommandType::kLine:
+			BinLine(command.x[0], command.y[0], command.x[1], command.y[1], i);
+			break;
+		case DrawCommandType::kTriangle:
+			for (int edge = 0; edge < 3; edge++) {
+				int next = (edge + 1) % 3;
+				BinLine(command.x[edge], command.y[edge], command.x[next], command.y[next], i);
+			}
+			break;
+		}
+	}
+
+	// タイルは互いに重ならないため並列に描画できる
+	std::for_each(std::execution::par, activeTiles_.begin(), activeTiles_.end(), [&](uint32_t tile) {
+		DrawTile(list, tile);
+	});
+
+}
+
+/// <summary>
+/// 画像をPPM形式 (P6) で書き出す関数 (アルファは無視する)
+/// </summary>
+/// <param name="filePath">書き出し先</param>
+/// <returns>書き出せたか</returns>
+bool MySoftwareRasterizer::SavePPM(const char* filePath) const {
+
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, filePath, "wb") != 0) {
+		return false;
+	}
+#else
+	file = std::fopen(filePath, "wb");
+#endif
+	if (file == nullptr) {
+		return false;
+	}
+
+	std::fprintf(file, "P6\n%d %d\n255\n", width_, height_);
+
+	// 1行ずつRGBに変換して書き出す
+	std::vector<uint8_t> row(size_t(width_) * 3);
+	bool isSucceeded = true;
+	for (int y = 0; y < height_ && isSucceeded; y++) {
+		for (int x = 0; x < width_; x++) {
+			uint32_t color = pixels_[size_t(y) * width_ + x];
+			row[x * 3 + 0] = uint8_t(color >> 24);
+			row[x * 3 + 1] = uint8_t(color >> 16);
+			row[x * 3 + 2] = uint8_t(color >> 8);
+		}
+		isSucceeded = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+	}
+
+	std::fclose(file);
+	return isSucceeded;
+
+}
+
+/// <summary>
+/// 1つのタイルに振り分けられた描画命令を描画する関数
+/// </summary>
+/// <param name="list">描画命令の配列</param>
+/// <param name="tile">タイル番号</param>
+void MySoftwareRasterizer::DrawTile(const DrawCommandList& list, uint32_t tile) {
+
+	int left = int(tile % tileCountX_) * kTileSize;
+	int top = int(tile / tileCountX_) * kTileSize;
+	int right = std::min(left + kTileSize, width_);
+	int bottom = std::min(top + kTileSize, height_);
+
+	for (uint32_t index : bins_[tile]) {
+		const DrawCommand& command = list[index];
+		switch (command.type) {
+		case DrawCommandType::kLine:
+			DrawLineInTile(command.x[0], command.y[0], command.x[1], command.y[1], command.color, left, top, right, bottom);
+			break;
+		case DrawCommandType::kTriangle:
+			// ワイヤーフレームなので3辺を引く
+			for (int i = 0; i < 3; i++) {
+				int j = (i + 1) % 3;
+				DrawLineInTile(command.x[i], command.y[i], command.x[j], command.y[j], command.color, left, top, right, bottom);
+			}
+			break;
+		}
+	}
+
+}
+
+/// <summary>
+/// 線が通るタイルに描画命令を振り分ける関数
+/// </summary>
+/// <param name="x1">始点のx座標</param>
+/// <param name="y1">始点のy座標</param>
+/// <param name="x2">終点のx座標</param>
+/// <param name="y2">終点のy座標</param>
+/// <param name="index">描画命令の番号</param>
+void MySoftwareRasterizer::BinLine(int x1, int y1, int x2, int y2, uint32_t index) {
+
+	LineSteps line = MakeLineSteps(x1, y1, x2, y2);
+	int uSize = line.isMajorX ? width_ : height_;
+	int vSize = line.isMajorX ? height_ : width_;
+
+	// 主軸方向に画面内の範囲だけを見る
+	int begin = std::max(line.u1, 0);
+	int end = std::min(line.u1 + line.du, uSize - 1);
+
+	// 主軸方向にタイル1つ分ずつ進め、その間に副軸方向に通るタイルを追加する
+	for (int u = begin; u <= end; u = (u / kTileSize + 1) * kTileSize) {
+		int uLast = std::min(end, (u / kTileSize + 1) * kTileSize - 1);
+		int vFirst = line.GetV(u);
+		int vLast = line.GetV(uLast);
+		int vMin = std::max(std::min(vFirst, vLast), 0);
+		int vMax = std::min(std::max(vFirst, vLast), vSize - 1);
+		for (int v = vMin / kTileSize * kTileSize; v <= vMax; v += kTileSize) {
+			int tileU = u / kTileSize;
+			int tileV = v / kTileSize;
+			uint32_t tile = uint32_t(line.isMajorX ? tileV * tileCountX_ + tileU : tileU * tileCountX_ + tileV);
+
+			// 同じ命令を2回追加しない (三角形の辺が同じタイルを通る場合)
+			if (bins_[tile].empty()) {
+				activeTiles_.push_back(tile);
+			}
+			else if (bins_[tile].back() == index) {
+				continue;
+			}
+			bins_[tile].push_back(index);
+		}
+	}
+
+}
+
+/// <summary>
+/// 線のうちタイルに含まれる部分を描画する関数
+/// どのタイルから描画しても同じピクセルになるように、主軸方向の位置から副軸方向の位置を求める
+/// </summary>
+/// <param name="x1">始点のx座標</param>
+/// <param name="y1">始点のy座標</param>
+/// <param name="x2">終点のx座標</param>
+/// <param name="y2">終点のy座標</param>
+/// <param name="color">色 (アルファで画像の色と合成する)</param>
+/// <param name="left">タイルの左端</param>
+/// <param name="top">タイルの上端</param>
+/// <param name="right">タイルの右端の次</param>
+/// <param name="bottom">タイルの下端の次</param>
+void MySoftwareRasterizer::DrawLineInTile(int x1, int y1, int x2, int y2, uint32_t color, int left, int top, int right, int bottom) {
+
+	LineSteps line = MakeLineSteps(x1, y1, x2, y2);
+
+	// 主軸方向のタイルの範囲に絞る
+	int uMin = line.isMajorX ? left : top;
+	int uMax = line.isMajorX ? right : bottom;
+	int vMin = line.isMajorX ? top : left;
+	int vMax = line.isMajorX ? bottom : right;
+	int begin = std::max(line.u1, uMin);
+	int end = std::min(line.u1 + line.du, uMax - 1);
+
+	for (int u = begin; u <= end; u++) {
+		int v = line.GetV(u);
+		if (v < vMin || v >= vMax) {
+			continue;
+		}
+		int x = line.isMajorX ? u : v;
+		int y = line.isMajorX ? v : u;
+		uint32_t& pixel = pixels_[size_t(y) * width_ + x];
+		pixel = BlendColor(color, pixel);
+	}
+
+}
@@ -0,0 +1,110 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "MyDrawBackend.h"
+
+/// <summary>
+/// CPUで描画命令をメモリ上の画像に描画するクラス (Novice もウィンドウも使わない)
+/// 画面をタイルに分割して描画命令を線が通るタイルに振り分け、タイルごとに並列に線を引く
+/// 各タイルでは描画命令の順に描画するため、結果は1スレッドで描画した場合と一致する
+/// 色のアルファで画像の色と合成する (0xFF なら上書き、0 なら描画しない)
+/// </summary>
+class MySoftwareRasterizer : public MyDrawBackend
+{
+public:
+
+	// タイルの一辺のピクセル数
+	static const int kTileSize = 64;
+
+	/// <summary>
+	/// 初期化
+	/// </summary>
+	/// <param name="width">画像の幅</param>
+	/// <param name="height">画像の高さ</param>
+	void Initialize(int width, int height);
+
+	/// <summary>
+	/// 画像を1色で塗りつぶす関数
+	/// </summary>
+	/// <param name="color">色 (0xRRGGBBAA)</param>
+	void Clear(uint32_t color);
+
+	/// <summary>
+	/// 描画命令を実行する関数
+	/// </summary>
+	/// <param name="list">描画命令の配列</param>
+	void Submit(const DrawCommandList& list) override;
+
+	/// <summary>
+	/// 画像をPPM形式 (P6) で書き出す関数 (アルファは無視する)
+	/// </summary>
+	/// <param name="filePath">書き出し先</param>
+	/// <returns>書き出せたか</returns>
+	bool SavePPM(const char* filePath) const;
+
+	/// <summary>
+	/// 画像を取得する関数
+	/// </summary>
+	/// <returns>ピクセル配列 (0xRRGGBBAA、左上から行ごと)</returns>
+	const std::vector<uint32_t>& GetPixels() const { return pixels_; }
+
+	/// <summary>
+	/// 画像の幅を取得する関数
+	/// </summary>
+	int GetWidth() const { return width_; }
+
+	/// <summary>
+	/// 画像の高さを取得する関数
+	/// </summary>
+	int GetHeight() const { return height_; }
+
+private:
+
+	/// <summary>
+	/// 線が通るタイルに描画命令を振り分ける関数
+	/// </summary>
+	/// <param name="x1">始点のx座標</param>
+	/// <param name="y1">始点のy座標</param>
+	/// <param name="x2">終点のx座標</param>
+	/// <param name="y2">終点のy座標</param>
+	/// <param name="index">描画命令の番号</param>
+	void BinLine(int x1, int y1, int x2, int y2, uint32_t index);
+
+	/// <summary>
+	/// 1つのタイルに振り分けられた描画命令を描画する関数
+	/// </summary>
+	/// <param name="list">描画命令の配列</param>
+	/// <param name="tile">タイル番号</param>
+	void DrawTile(const DrawCommandList& list, uint32_t tile);
+
+	/// <summary>
+	/// 線のうちタイルに含まれる部分を描画する関数
+	/// どのタイルから描画しても同じピクセルになるように、主軸方向の位置から副軸方向の位置を求める
+	/// </summary>
+	/// <param name="x1">始点のx座標</param>
+	/// <param name="y1">始点のy座標</param>
+	/// <param name="x2">終点のx座標</param>
+	/// <param name="y2">終点のy座標</param>
+	/// <param name="color">色 (アルファで画像の色と合成する)</param>
+	/// <param name="left">タイルの左端</param>
+	/// <param name="top">タイルの上端</param>
+	/// <param name="right">タイルの右端の次</param>
+	/// <param name="bottom">タイルの下端の次</param>
+	void DrawLineInTile(int x1, int y1, int x2, int y2, uint32_t color, int left, int top, int right, int bottom);
+
+	// 画像の幅
+	int width_ = 0;
+	// 画像の高さ
+	int height_ = 0;
+	// 横方向のタイル数
+	int tileCountX_ = 0;
+	// 縦方向のタイル数
+	int tileCountY_ = 0;
+	// ピクセル配列
+	std::vector<uint32_t> pixels_;
+	// タイルごとに振り分けた描画命令の番号
+	std::vector<std::vector<uint32_t>> bins_;
+	// 描画命令が振り分けられたタイルの番号
+	std::vector<uint32_t> activeTiles_;
+
+};
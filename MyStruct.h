@@ -46,4 +46,38 @@ struct Segment {
 /// </summary>
 struct Triangle {
 	Vector3 vertex[3]; // 頂点
+};
+
+/// <summary>
+/// 有向境界箱構造体
+/// </summary>
+struct OBB {
+	Vector3 center; // 中心座標
+	Vector3 orientations[3]; // 座標軸 (正規化、直交していること)
+	Vector3 size; // 座標軸方向の長さの半分
+};
+
+/// <summary>
+/// カプセル構造体
+/// </summary>
+struct Capsule {
+	Segment segment; // 中心線
+	float radius; // 半径
+};
+
+/// <summary>
+/// 軸並行境界箱構造体
+/// </summary>
+struct AABB {
+	Vector3 min; // 最小座標
+	Vector3 max; // 最大座標
+};
+
+/// <summary>
+/// 拡縮、回転、平行移動構造体
+/// </summary>
+struct Transform {
+	Vector3 scale; // 拡縮
+	Vector3 rotate; // 回転角
+	Vector3 translate; // 座標
 };
\ No newline at end of file
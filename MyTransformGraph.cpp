@@ -0,0 +1,221 @@
+﻿#include "MyTransformGraph.h"
+#include <algorithm>
+#include <execution>
+
+/// <summary>
+/// ノードを作成する関数
+/// </summary>
+/// <param name="parent">親ノード (kNullNode なら根)</param>
+/// <param name="local">ローカル変換</param>
+/// <returns>ノード番号 (並び替えても変わらない)</returns>
+uint32_t MyTransformGraph::CreateNode(uint32_t parent, const Transform& local) {
+
+	uint32_t node = uint32_t(indexOf_.size());
+	uint32_t index = uint32_t(parent_.size());
+	uint32_t parentIndex = parent == kNullNode ? kNullNode : indexOf_[parent];
+
+	// 末尾に追加すれば親より後ろになるが、親の部分木が連続でなくなる場合は並べ替えが必要
+	if (parentIndex != kNullNode && subtreeEnd_[parentIndex] != index) {
+		isOrderDirty_ = true;
+	}
+
+	parent_.push_back(parentIndex);
+	subtreeEnd_.push_back(index + 1);
+	local_.push_back(local);
+	world_.push_back({});
+	dirty_.push_back(0);
+	isChanged_.push_back(0);
+	nodeOf_.push_back(node);
+	indexOf_.push_back(index);
+
+	// 祖先の部分木を広げる
+	for (uint32_t i = parentIndex; i != kNullNode; i = parent_[i]) {
+		if (subtreeEnd_[i] == index) {
+			subtreeEnd_[i] = index + 1;
+		}
+	}
+
+	SetLocal(node, local);
+
+	return node;
+
+}
+
+/// <summary>
+/// ローカル変換を設定する関数
+/// </summary>
+/// <param name="node">ノード番号</param>
+/// <param name="local">ローカル変換</param>
+void MyTransformGraph::SetLocal(uint32_t node, const Transform& local) {
+
+	uint32_t index = indexOf_[node];
+	local_[index] = local;
+	dirty_[index] |= kDirtyLocal;
+
+	// 祖先に編集されたノードがあることを伝える (既に伝わっていればそこで止める)
+	for (uint32_t i = parent_[index]; i != kNullNode && !(dirty_[i] & kDirtyDescendant); i = parent_[i]) {
+		dirty_[i] |= kDirtyDescendant;
+	}
+
+}
+
+/// <summary>
+/// 編集されたノードとその子孫のワールド行列を計算し直す関数
+/// 根の子ごとの部分木は互いに独立しているため、ノード数が多い場合は並列に計算する
+/// </summary>
+void MyTransformGraph::Update() {
+
+	if (isOrderDirty_) {
+		Reorder();
+	}
+
+	uint32_t count = uint32_t(parent_.size());
+	if (count < kParallelThreshold) {
+		UpdateRange(0, count);
+		return;
+	}
+
+	// 根だけを先に計算し、根の子ごとの部分木を独立した範囲として集める
+	static thread_local std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	ranges.clear();
+	for (uint32_t root = 0; root < count; root = subtreeEnd_[root]) {
+		if (!dirty_[root]) {
+			isChanged_[root] = 0;
+			// 部分木全体に編集がなければ変化なしにするだけでよい
+			std::fill(isChanged_.begin() + root + 1, isChanged_.begin() + subtreeEnd_[root], uint8_t(0));
+			continue;
+		}
+		UpdateRange(root, root + 1);
+		for (uint32_t child = root + 1; child < subtreeEnd_[root]; child = subtreeEnd_[child]) {
+			ranges.push_back({ child, subtreeEnd_[child] });
+		}
+	}
+
+	std::for_each(std::execution::par, ranges.begin(), ranges.end(), [this](const std::pair<uint32_t, uint32_t>& range) {
+		UpdateRange(range.first, range.second);
+	});
+
+}
+
+/// <summary>
+/// 配列を深さ優先順に並べ替える関数
+/// </summary>
+void MyTransformGraph::Reorder() {
+
+	uint32_t count = uint32_t(parent_.size());
+
+	// 子の一覧を作る (作成順を保つ)
+	std::vector<uint32_t> childOffset(count + 1, 0);
+	for (uint32_t i = 0; i < count; i++) {
+		if (parent_[i] != kNullNode) {
+			childOffset[parent_[i] + 1]++;
+		}
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		childOffset[i + 1] += childOffset[i];
+	}
+	std::vector<uint32_t> children(childOffset[count]);
+	std::vector<uint32_t> cursor(childOffset.begin(), childOffset.end() - 1);
+	for (uint32_t i = 0; i < count; i++) {
+		if (parent_[i] != kNullNode) {
+			children[cursor[parent_[i]]++] = i;
+		}
+	}
+
+	// 根から深さ優先でたどった順を求める
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> stack;
+	for (uint32_t root = count; root-- > 0;) {
+		if (parent_[root] == kNullNode) {
+			stack.push_back(root);
+		}
+	}
+	while (!stack.empty()) {
+		uint32_t i = stack.back();
+		stack.pop_back();
+		order.push_back(i);
+		for (uint32_t c = childOffset[i + 1]; c-- > childOffset[i];) {
+			stack.push_back(children[c]);
+		}
+	}
+
+	// 新しい順に詰め直す
+	std::vector<uint32_t> newIndex(count);
+	for (uint32_t i = 0; i < count; i++) {
+		newIndex[order[i]] = i;
+	}
+	std::vector<uint32_t> parent(count);
+	std::vector<Transform> local(count);
+	std::vector<Matrix4x4> world(count);
+	std::vector<uint8_t> dirty(count);
+	std::vector<uint8_t> isChanged(count);
+	std::vector<uint32_t> nodeOf(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t oldIndex = order[i];
+		parent[i] = parent_[oldIndex] == kNullNode ? kNullNode : newIndex[parent_[oldIndex]];
+		local[i] = local_[oldIndex];
+		world[i] = world_[oldIndex];
+		dirty[i] = dirty_[oldIndex];
+		isChanged[i] = isChanged_[oldIndex];
+		nodeOf[i] = nodeOf_[oldIndex];
+		indexOf_[nodeOf[i]] = i;
+	}
+	parent_.swap(parent);
+	local_.swap(local);
+	world_.swap(world);
+	dirty_.swap(dirty);
+	isChanged_.swap(isChanged);
+	nodeOf_.swap(nodeOf);
+
+	// 部分木の範囲を子から親へ集める
+	for (uint32_t i = 0; i < count; i++) {
+		subtreeEnd_[i] = i + 1;
+	}
+	for (uint32_t i = count; i-- > 0;) {
+		if (parent_[i] != kNullNode) {
+			subtreeEnd_[parent_[i]] = std::max(subtreeEnd_[parent_[i]], subtreeEnd_[i]);
+		}
+	}
+
+	isOrderDirty_ = false;
+
+}
+
+/// <summary>
+/// 連続した範囲のワールド行列を計算し直す関数
+/// 範囲の先頭の親は計算済みであること
+/// </summary>
+/// <param name="begin">範囲の先頭</param>
+/// <param name="end">範囲の末尾の次</param>
+void MyTransformGraph::UpdateRange(uint32_t begin, uint32_t end) {
+
+	uint32_t i = begin;
+	while (i < end) {
+		uint32_t parent = parent_[i];
+		bool isParentChanged = parent != kNullNode && isChanged_[parent];
+
+		// 自身も子孫も編集されておらず親も変わっていなければ部分木ごと飛ばす
+		if (!dirty_[i] && !isParentChanged) {
+			std::fill(isChanged_.begin() + i, isChanged_.begin() + subtreeEnd_[i], uint8_t(0));
+			i = subtreeEnd_[i];
+			continue;
+		}
+
+		if ((dirty_[i] & kDirtyLocal) || isParentChanged) {
+			// 親のワールド行列にローカル行列を掛ける
+			const Transform& local = local_[i];
+			Matrix4x4 localMatrix = MyMath::MakeAffineMatrix(local.scale, local.rotate, local.translate);
+			world_[i] = parent == kNullNode ? localMatrix : MyMath::Multiply(localMatrix, world_[parent]);
+			isChanged_[i] = 1;
+		}
+		else {
+			// 子孫だけが編集されている
+			isChanged_[i] = 0;
+		}
+
+		dirty_[i] = 0;
+		i++;
+	}
+
+}
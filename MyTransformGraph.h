@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "MyStruct.h"
+#include "MyMath.h"
+
+/// <summary>
+/// 親子関係を持つ変換の階層を管理するクラス
+/// ノードは親が必ず子より前にある順序 (深さ優先順) で配列に並べ、各部分木が連続した範囲になる
+/// ローカル変換を編集したノードとその子孫だけワールド行列を計算し直す
+/// </summary>
+class MyTransformGraph
+{
+public:
+
+	// 無効なノード番号
+	static const uint32_t kNullNode = UINT32_MAX;
+
+	/// <summary>
+	/// ノードを作成する関数
+	/// </summary>
+	/// <param name="parent">親ノード (kNullNode なら根)</param>
+	/// <param name="local">ローカル変換</param>
+	/// <returns>ノード番号 (並び替えても変わらない)</returns>
+	uint32_t CreateNode(uint32_t parent, const Transform& local);
+
+	/// <summary>
+	/// ローカル変換を設定する関数
+	/// </summary>
+	/// <param name="node">ノード番号</param>
+	/// <param name="local">ローカル変換</param>
+	void SetLocal(uint32_t node, const Transform& local);
+
+	/// <summary>
+	/// ローカル変換を取得する関数
+	/// </summary>
+	/// <param name="node">ノード番号</param>
+	/// <returns>ローカル変換</returns>
+	const Transform& GetLocal(uint32_t node) const { return local_[indexOf_[node]]; }
+
+	/// <summary>
+	/// ワールド行列を取得する関数 (Update 後の値)
+	/// </summary>
+	/// <param name="node">ノード番号</param>
+	/// <returns>ワールド行列</returns>
+	const Matrix4x4& GetWorldMatrix(uint32_t node) const { return world_[indexOf_[node]]; }
+
+	/// <summary>
+	/// 直前の Update でワールド行列が変わったかを取得する関数
+	/// </summary>
+	/// <param name="node">ノード番号</param>
+	/// <returns>変わったか</returns>
+	bool IsWorldChanged(uint32_t node) const { return isChanged_[indexOf_[node]] != 0; }
+
+	/// <summary>
+	/// ノード数を取得する関数
+	/// </summary>
+	/// <returns>ノード数</returns>
+	size_t GetNodeCount() const { return parent_.size(); }
+
+	/// <summary>
+	/// 編集されたノードとその子孫のワールド行列を計算し直す関数
+	/// 根の子ごとの部分木は互いに独立しているため、ノード数が多い場合は並列に計算する
+	/// </summary>
+	void Update();
+
+private:
+
+	/// <summary>
+	/// 配列を深さ優先順に並べ替える関数
+	/// </summary>
+	void Reorder();
+
+	/// <summary>
+	/// 連続した範囲のワールド行列を計算し直す関数
+	/// 範囲の先頭の親は計算済みであること
+	/// </summary>
+	/// <param name="begin">範囲の先頭</param>
+	/// <param name="end">範囲の末尾の次</param>
+	void UpdateRange(uint32_t begin, uint32_t end);
+
+	// ローカル変換が編集されたフラグ
+	static const uint8_t kDirtyLocal = 1;
+	// 子孫に編集されたノードがあるフラグ
+	static const uint8_t kDirtyDescendant = 2;
+	// 並列に計算するノード数の下限
+	static const size_t kParallelThreshold = 1024;
+
+	// 親ノードの配列の番号 (根なら kNullNode)
+	std::vector<uint32_t> parent_;
+	// 部分木の末尾の次の配列の番号
+	std::vector<uint32_t> subtreeEnd_;
+	// ローカル変換
+	std::vector<Transform> local_;
+	// ワールド行列
+	std::vector<Matrix4x4> world_;
+	// 編集フラグ
+	std::vector<uint8_t> dirty_;
+	// 直前の Update でワールド行列が変わったか
+	std::vector<uint8_t> isChanged_;
+	// 配列の番号からノード番号への対応
+	std::vector<uint32_t> nodeOf_;
+	// ノード番号から配列の番号への対応
+	std::vector<uint32_t> indexOf_;
+	// 深さ優先順になっていないか
+	bool isOrderDirty_ = false;
+
+};
@@ -1,11 +1,24 @@
-#include <Novice.h>
+﻿#include <Novice.h>
 #include <imgui.h>
 #include "MyConst.h"
 #include "MyDebug.h"
 #include "MyCollision.h"
+#include "MyRaycast.h"
+#include "MyFramePipeline.h"
+#include "MyPairCache.h"
+#include "MyEventStream.h"
+#include "MyCommandLine.h"
+#include "MyFrameScheduler.h"
+#include "MyExpression.h"
 
 // Windowsアプリでのエントリーポイント(main関数)
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int) {
+
+	// 一括判定や動作確認が指定されていればウィンドウを開かずに実行して終了する
+	int exitCode = 0;
+	if (MyCommandLine::Run(commandLine, exitCode)) {
+		return exitCode;
+	}
 
 	// ライブラリの初期化
 	Novice::Initialize(kWindowTitle, kWindowWidth, kWindowHeight);
@@ -19,20 +32,63 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// 座標
 	Vector3 translate{};
 
-	Triangle triangle{};
-	triangle.vertex[0] = { 0.0f, 1.0f, 0.0f };
-	triangle.vertex[1] = { 1.0f, 0.0f, 0.0f };
-	triangle.vertex[2] = { -1.0f, 0.0f, 0.0f };
+	Triangle triangle = kInitialTriangle;
 
 	// 線分
-	Segment segment{ {-0.45, 0.35, 0.0f}, {0.0f, 0.5f, 0.0f} };
-	// 色
-	int32_t segmentColor = WHITE;
+	Segment segment = kInitialSegment;
 
 	// カメラ座標
-	Vector3 cameraTranslate{ 0.0f, 1.9f, -6.49f };
+	Vector3 cameraTranslate = kInitialCameraTranslate;
 	// カメラ回転角
-	Vector3 cameraRotate{ 0.26f, 0.0f, 0.0f };
+	Vector3 cameraRotate = kInitialCameraRotate;
+	// カメラが編集されて行列を作り直す必要があるか (最初のフレームで作成する)
+	bool isCameraEdited = true;
+
+	// カメラから作成する行列 (カメラが編集されたときだけ作り直す)
+	Matrix4x4 worldViewProjectionMatrix{};
+	Matrix4x4 viewPortmatrix{};
+	// マウス座標から半直線を求める行列 (逆行列を求めるため毎フレームは作らない)
+	Matrix4x4 unprojectMatrix{};
+
+	// 更新処理と描画処理を並列に行うパイプライン
+	MyFramePipeline pipeline;
+	pipeline.Initialize();
+
+	// 三角形と線分の判定結果を保持するキャッシュ (ワーカースレッドからのみ使用する)
+	MyPairCache pairCache;
+	uint32_t triangleHandle = pairCache.CreateHandle();
+	uint32_t segmentHandle = pairCache.CreateHandle();
+	// 前回の更新処理から編集されたか
+	bool isTriangleEdited = false;
+	bool isSegmentEdited = false;
+
+	// 描画とは別に一定の間隔で更新処理を行う
+	MyFrameScheduler scheduler;
+
+	// 更新処理の結果 (ワーカースレッドからのみ使用する)
+	struct SimulationState {
+		Triangle triangle;
+		Segment segment;
+		bool isHit;
+	};
+	// 直前の2回の更新処理の結果 (描画時にこの間を補間する)
+	SimulationState previousState{ triangle, segment, false };
+	SimulationState currentState = previousState;
+
+	// マウスでの選択の対象 (ワーカースレッドからのみ使用する)
+	SphereSoA pickSpheres;
+	MyCollision::MakeSphereSoA(nullptr, 0, pickSpheres);
+	TriangleSoA pickTriangles;
+
+	// 衝突イベントをワーカースレッドからメインスレッドに受け渡すストリーム
+	MyEventStream eventStream;
+	uint32_t debugConsumer = eventStream.AddConsumer();
+	// 行った更新処理の回数
+	uint32_t frame = 0;
+	// メインスレッドで受け取った衝突イベント
+	CollisionEvent lastEvent{};
+	uint32_t enterCount = 0;
+	uint32_t exitCount = 0;
 
 	// ウィンドウの×ボタンが押されるまでループ
 	while (Novice::ProcessMessage() == 0) {
@@ -43,38 +99,108 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		memcpy(preKeys, keys, 256);
 		Novice::GetHitKeyStateAll(keys);
 
+		// マウス座標を受け取る
+		int mouseX = 0;
+		int mouseY = 0;
+		Novice::GetMousePosition(&mouseX, &mouseY);
+
 		///
 		/// ↓更新処理ここから
 		///
 
-		// スクリーン座標系に変換
-		
-		// ワールド行列生成
-		Matrix4x4 worldMatrix = MyMath::MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, rotate, translate);
+		// 経過時間からこのフレームで行う更新処理の回数と補間の割合を求める
+		uint32_t stepCount = scheduler.BeginFrame();
+		float alpha = scheduler.GetAlpha();
 
-		// カメラ用行列生成
-		Matrix4x4 cameraMatrix = MyMath::MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, cameraRotate, cameraTranslate);
+		// カメラが編集されたら行列を作り直す (ウィンドウの大きさは変わらないのでビューポートはカメラと一緒に作る)
+		if (isCameraEdited) {
+			// ワールド行列生成
+			Matrix4x4 worldMatrix = MyMath::MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, rotate, translate);
 
-		// ビュー行列生成
-		Matrix4x4 viewMatrix = MyMath::Inverse(cameraMatrix);
-		Matrix4x4 projectionMatrix = MyMath::MakePerspectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
-		Matrix4x4 worldViewProjectionMatrix = MyMath::Multiply(worldMatrix, MyMath::Multiply(viewMatrix, projectionMatrix));
+			// カメラ用行列生成
+			Matrix4x4 cameraMatrix = MyMath::MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, cameraRotate, cameraTranslate);
 
-		// ビューポート行列生成
-		Matrix4x4 viewPortmatrix = MyMath::MakeViewPortMatrix(0, 0, float(kWindowWidth), float(kWindowHeight), 0.0f, 1.0f);
+			// ビュー行列生成
+			Matrix4x4 viewMatrix = MyMath::Inverse(cameraMatrix);
+			Matrix4x4 projectionMatrix = MyMath::MakePerspectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
+			worldViewProjectionMatrix = MyMath::Multiply(worldMatrix, MyMath::Multiply(viewMatrix, projectionMatrix));
 
-		// 開始地点
-		Vector3 start = MyMath::Transform(MyMath::Transform(segment.origin, worldViewProjectionMatrix), viewPortmatrix);
-		// 終端地点
-		Vector3 end = MyMath::Transform(MyMath::Transform(MyMath::Add(segment.origin, segment.diff), worldViewProjectionMatrix), viewPortmatrix);
+			// ビューポート行列生成
+			viewPortmatrix = MyMath::MakeViewPortMatrix(0, 0, float(kWindowWidth), float(kWindowHeight), 0.0f, 1.0f);
 
-		if (MyCollision::IsCollisionTriangle(triangle, segment)) {
-			segmentColor = RED;
-		}
-		else {
-			segmentColor = WHITE;
+			// マウス座標を三角形と同じ座標系の半直線に戻す行列
+			unprojectMatrix = MyMath::MakeUnprojectMatrix(worldViewProjectionMatrix, viewPortmatrix);
+
+			isCameraEdited = false;
 		}
 
+		// 今フレームの値をコピーしてワーカースレッドで更新処理を行う
+		uint32_t firstFrame = frame;
+		frame += stepCount;
+		pipeline.Kick([=, &pairCache, &eventStream, &previousState, &currentState, &pickSpheres, &pickTriangles](DrawCommandList& list) {
+
+			// 一定の間隔の更新処理 (描画の頻度によって0回のことも複数回のこともある)
+			for (uint32_t step = 0; step < stepCount; step++) {
+				previousState = currentState;
+				currentState.triangle = triangle;
+				currentState.segment = segment;
+
+				// 編集された要素の版数を増やす (編集は最初の更新処理で反映される)
+				pairCache.BeginFrame();
+				if (step == 0 && isTriangleEdited) {
+					pairCache.MarkDirty(triangleHandle);
+				}
+				if (step == 0 && isSegmentEdited) {
+					pairCache.MarkDirty(segmentHandle);
+				}
+
+				// 衝突判定 (どちらも編集されていなければ前回の結果を使う)
+				PairEvent event = pairCache.Test(triangleHandle, segmentHandle, [&]() {
+					return MyCollision::IsCollisionTriangle(currentState.triangle, currentState.segment);
+				});
+				currentState.isHit = event == PairEvent::kEnter || event == PairEvent::kStay;
+
+				// 判定されなかった組を破棄する
+				std::vector<PairEventRecord> events;
+				if (event != PairEvent::kNone) {
+					events.push_back({ triangleHandle, segmentHandle, event });
+				}
+				pairCache.EndFrame(events);
+
+				// 衝突イベントを他のスレッドに知らせる (受け取りを待たない)
+				std::vector<CollisionEvent> collisionEvents;
+				for (const PairEventRecord& record : events) {
+					collisionEvents.push_back({ firstFrame + step + 1, record });
+				}
+				eventStream.Publish(collisionEvents.data(), collisionEvents.size());
+			}
+
+			// 直前の2回の更新処理の結果を補間して描画する
+			Triangle drawTriangle;
+			MyExpr::Store(drawTriangle.vertex, 3, MyExpr::Ref(previousState.triangle.vertex, 3) + alpha * (MyExpr::Ref(currentState.triangle.vertex, 3) - MyExpr::Ref(previousState.triangle.vertex, 3)));
+			Segment drawSegment;
+			drawSegment.origin = MyExpr::Eval(MyExpr::Ref(previousState.segment.origin) + alpha * (MyExpr::Ref(currentState.segment.origin) - MyExpr::Ref(previousState.segment.origin)));
+			drawSegment.diff = MyExpr::Eval(MyExpr::Ref(previousState.segment.diff) + alpha * (MyExpr::Ref(currentState.segment.diff) - MyExpr::Ref(previousState.segment.diff)));
+
+			// マウスカーソルの下で最も手前にあるものを選択し、三角形なら青くする (三角形と同じ座標系の半直線で判定する)
+			uint32_t triangleColor = WHITE;
+			MyCollision::MakeTriangleSoA(&drawTriangle, 1, pickTriangles);
+			Ray mouseRay = MyMath::Unproject(float(mouseX), float(mouseY), unprojectMatrix);
+			RaycastHit pickHit;
+			if (MyRaycast::Pick(mouseRay, pickSpheres, pickTriangles, pickHit) && pickHit.type == PrimitiveType::kTriangle) {
+				triangleColor = BLUE;
+			}
+
+			// 衝突していれば線分を赤くする
+			uint32_t segmentColor = currentState.isHit ? RED : WHITE;
+
+			// グリッド、三角形、線分の描画命令を作成する
+			MyDebug::DrawGrid(worldViewProjectionMatrix, viewPortmatrix, list);
+			MyDebug::DrawTriangle(drawTriangle, worldViewProjectionMatrix, viewPortmatrix, triangleColor, list);
+			MyDebug::DrawSegment(drawSegment, worldViewProjectionMatrix, viewPortmatrix, segmentColor, list);
+
+		});
+
 		///
 		/// ↑更新処理ここまで
 		///
@@ -83,16 +209,8 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		/// ↓描画処理ここから
 		///
 
-		// グリッドを描画する
-		MyDebug::DrawGrid(worldViewProjectionMatrix, viewPortmatrix);
-
-		MyDebug::DrawTriangle(triangle, worldViewProjectionMatrix, viewPortmatrix, WHITE);
-
-		// 線分描画
-		Novice::DrawLine(
-			int(start.x), int(start.y),
-			int(end.x), int(end.y),
-			segmentColor);
+		// 前フレームまでに作成された描画命令を実行する
+		MyDebug::Submit(pipeline.Acquire());
 
 		///
 		/// ↑描画処理ここまで
@@ -102,22 +220,48 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		/// ↓デバック処理ここから
 		///
 
+		// ワーカースレッドから届いた衝突イベントを受け取る
+		CollisionEvent receivedEvents[64];
+		size_t receivedCount;
+		while ((receivedCount = eventStream.Drain(debugConsumer, receivedEvents, 64)) != 0) {
+			for (size_t i = 0; i < receivedCount; i++) {
+				if (receivedEvents[i].pair.event == PairEvent::kEnter) {
+					enterCount++;
+				}
+				else if (receivedEvents[i].pair.event == PairEvent::kExit) {
+					exitCount++;
+				}
+				lastEvent = receivedEvents[i];
+			}
+		}
+
 		// デバックウィンドウ表示
 		ImGui::Begin("Debug");
 
+		// 受け取った衝突イベントを表示する
+		ImGui::Text("enter: %u exit: %u last: %d (frame %u)", enterCount, exitCount, int(lastEvent.pair.event), lastEvent.frame);
+		// 更新処理の回数と追いつけずに捨てた回数を表示する
+		ImGui::Text("step: %llu dropped: %llu", (unsigned long long)scheduler.GetStepCount(), (unsigned long long)scheduler.GetDroppedStepCount());
+
 		// カメラ座標をいじる
-		ImGui::DragFloat3("cameraTranslate", &cameraTranslate.x, 0.01f);
+		isCameraEdited |= ImGui::DragFloat3("cameraTranslate", &cameraTranslate.x, 0.01f);
 		// カメラの回転角をいじる
-		ImGui::DragFloat3("cameraRotate", &cameraRotate.x, 0.01f);
+		isCameraEdited |= ImGui::DragFloat3("cameraRotate", &cameraRotate.x, 0.01f);
+
+		// 更新処理が行われたら編集の記録を消す (行われなかったフレームの編集は次の更新処理まで貯めておく)
+		if (stepCount != 0) {
+			isTriangleEdited = false;
+			isSegmentEdited = false;
+		}
 
 		// 3角形の頂点をいじる
-		ImGui::DragFloat3("TriangleV0", &triangle.vertex[0].x, 0.01f);
-		ImGui::DragFloat3("TriangleV1", &triangle.vertex[1].x, 0.01f);
-		ImGui::DragFloat3("TriangleV2", &triangle.vertex[2].x, 0.01f);
+		isTriangleEdited |= ImGui::DragFloat3("TriangleV0", &triangle.vertex[0].x, 0.01f);
+		isTriangleEdited |= ImGui::DragFloat3("TriangleV1", &triangle.vertex[1].x, 0.01f);
+		isTriangleEdited |= ImGui::DragFloat3("TriangleV2", &triangle.vertex[2].x, 0.01f);
 
 		// 線分の座標をいじる
-		ImGui::DragFloat3("origin", &segment.origin.x, 0.01f);
-		ImGui::DragFloat3("diff", &segment.diff.x, 0.01f);
+		isSegmentEdited |= ImGui::DragFloat3("origin", &segment.origin.x, 0.01f);
+		isSegmentEdited |= ImGui::DragFloat3("diff", &segment.diff.x, 0.01f);
 
 		ImGui::End();
 
@@ -134,6 +278,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		}
 	}
 
+	// パイプラインの終了
+	pipeline.Finalize();
+
 	// ライブラリの終了
 	Novice::Finalize();
 	return 0;